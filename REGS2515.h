@@ -200,6 +200,16 @@
 #define WAKIF           0x40
 #define MERRF           0x80
 
+/* EFLG */
+#define RX1OVR          0x80
+#define RX0OVR          0x40
+#define TXBO            0x20
+#define TXEP            0x10
+#define RXEP            0x08
+#define TXWAR           0x04
+#define RXWAR           0x02
+#define EWARN           0x01
+
 /* BFPCTRL */
 #define B1BFS           0x20
 #define B0BFS           0x10
@@ -428,5 +438,56 @@
 #define RXB1            0x71
 #define EXIDE_SET       0x08
 #define EXIDE_RESET     0x00
+#define SIDL_SRR        0x10    // RXBnSIDL: standard frame remote request
+#define DLC_RTR         0x40    // TXBnDLC/RXBnDLC: remote transmission request
+
+
+/*******************************************************************
+ *                  Buffer register map                            *
+ *******************************************************************/
+
+/* The three Tx buffers and two Rx buffers share the same layout,
+ * 16 bytes apart. Buffer numbers are 0..2 (Tx) and 0..1 (Rx); with a
+ * constant buffer number every expression below folds at compile time. */
+#define TXB_BASE(n)         (TXB0CTRL + ((n) << 4))
+#define RXB_BASE(n)         (RXB0CTRL + ((n) << 4))
+
+#define BUF_CTRL            0x00
+#define BUF_SIDH            0x01
+#define BUF_SIDL            0x02
+#define BUF_EID8            0x03
+#define BUF_EID0            0x04
+#define BUF_DLC             0x05
+#define BUF_D0              0x06
+
+#define TXBnCTRL(n)         (TXB_BASE(n) + BUF_CTRL)
+#define TXBnSIDH(n)         (TXB_BASE(n) + BUF_SIDH)
+#define TXBnDLC(n)          (TXB_BASE(n) + BUF_DLC)
+#define TXBnD0(n)           (TXB_BASE(n) + BUF_D0)
+#define RXFn_BASE(n)        ((n) < 3 ? ((n) << 2) : (RXF3SIDH + (((n) - 3) << 2)))
+#define RXMn_BASE(n)        (RXM0SIDH + ((n) << 2))
+#define RXBnCTRL(n)         (RXB_BASE(n) + BUF_CTRL)
+#define RXBnSIDH(n)         (RXB_BASE(n) + BUF_SIDH)
+#define RXBnDLC(n)          (RXB_BASE(n) + BUF_DLC)
+#define RXBnD0(n)           (RXB_BASE(n) + BUF_D0)
+
+/* Buffer specific SPI instructions (datasheet table 12-1) */
+#define CAN_LOAD_TXB_SIDH(n)    (CAN_LOAD_TX | ((n) << 1))          // 0x40, 0x42, 0x44
+#define CAN_LOAD_TXB_D0(n)      (CAN_LOAD_TX | ((n) << 1) | 0x01)   // 0x41, 0x43, 0x45
+#define CAN_RTS_TXB(n)          (CAN_RTS | (1 << (n)))              // 0x81, 0x82, 0x84
+#define CAN_RD_RXB_SIDH(n)      (CAN_RD_RX_BUFF | ((n) << 2))       // 0x90, 0x94
+#define CAN_RD_RXB_D0(n)        (CAN_RD_RX_BUFF | ((n) << 2) | 0x02)// 0x92, 0x96
+
+/* READ STATUS instruction answer */
+#define STAT_RX0IF      0x01
+#define STAT_RX1IF      0x02
+#define STAT_TX0REQ     0x04
+#define STAT_TX0IF      0x08
+#define STAT_TX1REQ     0x10
+#define STAT_TX1IF      0x20
+#define STAT_TX2REQ     0x40
+#define STAT_TX2IF      0x80
+#define STAT_TXnREQ(n)  (STAT_TX0REQ << ((n) << 1))
+#define STAT_RXnIF(n)   (STAT_RX0IF << (n))
 //#define CS   PORTAbits.RA2
 
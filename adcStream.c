@@ -0,0 +1,256 @@
+/* File:  adcStream.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: ADC to CAN streaming (see adcStream.h). The sample frames are filled by the A/D
+ * interrupt (low priority) and sent by the main loop; the frames alternate between the two
+ * buffers, so they go out in the order they were filled.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "adcStream.h"
+#include "timer.h"
+
+#define ADC_STREAM_ADCON0(ch)   (((ch) << 2) | 0x01)    // CHS = ch, ADON = 1
+#define ADC_STREAM_GO           0x02
+
+adcStreamStats adcStreamCount;
+
+static uint8_t adcStreamFrame[2][8];
+static volatile uint8_t adcStreamFull;  // Bit n: adcStreamFrame[n] waits for adcStreamService()
+static uint8_t adcStreamNext;           // Buffer of the frame being filled
+static uint8_t adcStreamStore;          // 0: the frame being filled is dropped (no free buffer)
+static uint8_t adcStreamSend;           // Buffer of the next frame to send
+static uint8_t adcStreamIndex;          // Next byte of the frame being filled
+static uint8_t adcStreamSequence;
+static uint8_t adcStreamChannel;        // Channel being converted
+static uint8_t adcStreamSets;           // Sets in adcStreamSum
+static uint16_t adcStreamValue[ADC_STREAM_CHANNELS];  // Set being converted
+static uint16_t adcStreamSum[ADC_STREAM_CHANNELS];
+
+static uint16_t adcStreamLast;          // timerMillisTick()
+static uint16_t adcStreamMs;
+static uint32_t adcStreamReportSets;    // adcStreamCount.sets at the last report
+static uint8_t adcStreamReportDue;
+static uint8_t adcStreamReportData[8];
+
+
+/*******************************************************************************
+ * FUNCTION: void adcStreamStart(void)
+ * Description: Starts the sampling. Timer3 counts 4 us ticks and CCP2 in special event trigger
+ * mode resets it every ADC_STREAM_PERIOD ticks and starts a conversion of AN0.
+ *******************************************************************************/
+void adcStreamStart(void)
+{
+    adcStreamFull = 0;
+    adcStreamNext = 0;
+    adcStreamStore = 1;
+    adcStreamSend = 0;
+    adcStreamIndex = 0;
+    adcStreamSequence = 0;
+    adcStreamChannel = 0;
+    adcStreamSets = 0;
+    for (uint8_t i = 0; i < ADC_STREAM_CHANNELS; i++)
+        adcStreamSum[i] = 0;
+    adcStreamMs = 0;
+    adcStreamReportSets = adcStreamCount.sets;
+    adcStreamReportDue = 0;
+    adcStreamLast = timerMicros();
+    
+    ADCON2 = 0x91;  // 0b1 0 010 001 ADFM = 1 (right justified); ACQT = 4 TAD; ADCS = FOSC/8 (TAD = 1 us). Pg. 263
+    ADCON0 = ADC_STREAM_ADCON0(0);
+    PIR2bits.CCP2IF = 0;
+    
+    TMR3H = 0;
+    TMR3L = 0;
+    CCPR2H = (uint8_t)((ADC_STREAM_PERIOD - 1) >> 8);
+    CCPR2L = (uint8_t)(ADC_STREAM_PERIOD - 1);
+    CCP2CON = 0x0B; // Compare, special event trigger: resets Timer3, starts the A/D. Pg. 143
+    
+    PIR1bits.ADIF = 0;
+    PIE1bits.ADIE = 1;
+    T3CON = 0xB9;   // 0b1 0 11 1 0 0 1 RD16; Timer3 for CCP2, Timer1 for CCP1; 1:8; FOSC/4; TMR3ON. Pg. 135
+    
+} // end void adcStreamStart(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void adcStreamStop(void)
+ * Description: Stops the trigger and the A/D interrupt. Frames already full are still sent.
+ *******************************************************************************/
+void adcStreamStop(void)
+{
+    T3CON = 0x00;
+    CCP2CON = 0x00;
+    PIE1bits.ADIE = 0;
+    
+} // end void adcStreamStop(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void adcStreamInterrupt(void)
+ * Description: A/D interrupt, from isrLow(): takes the result, starts the next channel and, at the
+ * end of a set, publishes every ADC_STREAM_DECIMATE sets. A frame without a free buffer is still
+ * counted through, so the frame count of the next one shows the gap.
+ *******************************************************************************/
+void adcStreamInterrupt(void)
+{
+    uint8_t *frame = adcStreamFrame[adcStreamNext];
+    uint16_t value;
+    
+    PIR1bits.ADIF = 0;
+    
+    // isrLow() kept out for a sample period: the trigger came between two channels of the set and
+    // converts the channel still selected (GO set), or came after the first one. The set is
+    // dropped (missed) and the next trigger starts over from AN0; GO = 0 aborts the conversion.
+    if ((ADCON0 & ADC_STREAM_GO) || (adcStreamChannel && PIR2bits.CCP2IF))
+    {
+        ADCON0 = ADC_STREAM_ADCON0(0);
+        PIR1bits.ADIF = 0;
+        PIR2bits.CCP2IF = 0;
+        adcStreamChannel = 0;
+        return;
+    }
+    if (!adcStreamChannel)
+        PIR2bits.CCP2IF = 0;
+    
+    adcStreamValue[adcStreamChannel] = ((uint16_t)ADRESH << 8) | ADRESL;
+    
+    // The next channel is acquired (ACQT) and converted without waiting for the trigger.
+    if (++adcStreamChannel < ADC_STREAM_CHANNELS)
+    {
+        ADCON0 = ADC_STREAM_ADCON0(adcStreamChannel) | ADC_STREAM_GO;
+        return;
+    }
+    adcStreamChannel = 0;
+    ADCON0 = ADC_STREAM_ADCON0(0);
+    adcStreamCount.sets++;
+    
+    for (uint8_t i = 0; i < ADC_STREAM_CHANNELS; i++)
+    {
+#if ADC_STREAM_AVERAGE
+        adcStreamSum[i] += adcStreamValue[i];
+#else
+        adcStreamSum[i] = adcStreamValue[i];
+#endif
+    }
+    
+    if (++adcStreamSets < ADC_STREAM_DECIMATE)
+        return;
+    adcStreamSets = 0;
+    
+    for (uint8_t i = 0; i < ADC_STREAM_CHANNELS; i++)
+    {
+#if ADC_STREAM_AVERAGE
+        value = adcStreamSum[i] / ADC_STREAM_DECIMATE;
+        adcStreamSum[i] = 0;
+#else
+        value = adcStreamSum[i];
+#endif
+        if (adcStreamStore)
+        {
+            frame[adcStreamIndex] = (uint8_t)value;
+            frame[adcStreamIndex + 1] = (uint8_t)(value >> 8);
+        }
+        adcStreamIndex += 2;
+    }
+    if (!adcStreamStore)
+        adcStreamCount.dropped += ADC_STREAM_CHANNELS;
+    
+    if (adcStreamIndex < 8)
+        return;
+    adcStreamIndex = 0;
+    
+    if (adcStreamStore)
+    {
+        frame[1] |= (uint8_t)(adcStreamSequence << (ADC_STREAM_SEQUENCE_SHIFT - 8));
+        adcStreamFull |= (uint8_t)(1 << adcStreamNext);
+        adcStreamNext ^= 1;
+    }
+    adcStreamSequence = (adcStreamSequence + 1) & 0x0F;
+    adcStreamStore = !(adcStreamFull & (1 << adcStreamNext));
+    
+} // end void adcStreamInterrupt(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void adcStreamReport(void)
+ * Description: Closes a report interval: rates and the report frame.
+ *******************************************************************************/
+static void adcStreamReport(void)
+{
+    uint32_t sets;
+    uint32_t dropped;
+    uint16_t rate;
+    
+    PIE1bits.ADIE = 0;
+    sets = adcStreamCount.sets;
+    dropped = adcStreamCount.dropped;
+    PIE1bits.ADIE = 1;
+    
+    rate = (uint16_t)((sets - adcStreamReportSets) * 1000 / ADC_STREAM_REPORT_MS);
+    adcStreamReportSets = sets;
+    adcStreamCount.rateHz = rate;
+    adcStreamCount.missedHz = (rate < ADC_STREAM_RATE_HZ) ? (uint16_t)(ADC_STREAM_RATE_HZ - rate) : 0;
+    
+    adcStreamReportData[0] = (uint8_t)rate;
+    adcStreamReportData[1] = (uint8_t)(rate >> 8);
+    adcStreamReportData[2] = (uint8_t)adcStreamCount.missedHz;
+    adcStreamReportData[3] = (uint8_t)(adcStreamCount.missedHz >> 8);
+    adcStreamReportData[4] = (uint8_t)dropped;
+    adcStreamReportData[5] = (uint8_t)(dropped >> 8);
+    adcStreamReportData[6] = (uint8_t)adcStreamCount.frames;
+    adcStreamReportData[7] = (uint8_t)(adcStreamCount.frames >> 8);
+    adcStreamReportDue = 1;
+    
+} // end static void adcStreamReport(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void adcStreamService(void)
+ * Description: Main loop side: queues the oldest full frame, or the report when one is due, on
+ * ADC_STREAM_TXB once the previous one has left it. canSendAsync() copies the frame, so its
+ * buffer is free again at once. Only a READ STATUS is waited for, and only with a frame ready.
+ * Call it at least every 65 ms.
+ *******************************************************************************/
+void adcStreamService(void)
+{
+    while (timerMillisTick(&adcStreamLast))
+    {
+        if (++adcStreamMs >= ADC_STREAM_REPORT_MS)
+        {
+            adcStreamMs = 0;
+            adcStreamReport();
+        }
+    }
+    
+    if (!adcStreamReportDue && !(adcStreamFull & (1 << adcStreamSend)))
+        return;
+    if (mcp2515ReadStatus() & STAT_TXnREQ(ADC_STREAM_TXB))
+        return;
+    
+    if (adcStreamReportDue)
+    {
+        if (canSendAsync(ADC_STREAM_TXB, ADC_STREAM_REPORT_IDH, 8, adcStreamReportData) == MCP2515_OK)
+            adcStreamReportDue = 0;
+        return;
+    }
+    
+    if (canSendAsync(ADC_STREAM_TXB, ADC_STREAM_IDH, 8, adcStreamFrame[adcStreamSend]) != MCP2515_OK)
+        return;
+    
+    PIE1bits.ADIE = 0;
+    adcStreamFull &= (uint8_t)~(1 << adcStreamSend);
+    PIE1bits.ADIE = 1;
+    adcStreamSend ^= 1;
+    adcStreamCount.frames++;
+    
+} // end void adcStreamService(void) function
+
@@ -0,0 +1,99 @@
+/* File:  adcStream.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: ADC to CAN streaming. Timer3 and the CCP2 special event trigger start a conversion
+ * of AN0 at a fixed rate, with no software in the timing; the A/D interrupt converts the other
+ * channels back to back, averages or decimates the sample sets and packs the results straight into
+ * a frame of a double buffer. adcStreamService(), in the main loop, hands each full frame to the
+ * SPI engine (canSendAsync()) and frees the buffer at once, so the sampling never waits for the
+ * SPI or the bus: when both buffers still wait for the bus, the samples are dropped and counted.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef ADC_STREAM_H
+#define	ADC_STREAM_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// ADC_STREAM = 1: main.c runs adcStreamStart() and a loop around adcStreamService(), and isrLow()
+// takes the A/D interrupt. Timer3 runs as the time base (reset by CCP2 before it overflows, so
+// isrDefer() keeps working), CCP2 is taken and ADCON1 (SPI_ini()) must enable AN0..AN3.
+// Use SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h): at FOSC/64 a frame takes about 1 ms of SPI to load,
+// as long as the sample period at the default rate.
+#ifndef ADC_STREAM
+    #define ADC_STREAM              0
+#endif
+#ifndef ADC_STREAM_CHANNELS
+    #define ADC_STREAM_CHANNELS     4       // AN0..AN(n - 1): 1, 2 or 4
+#endif
+// Sample sets per second (every channel once), in steps of the 4 us Timer3 tick. A set takes
+// about 15 us of conversion plus the interrupt per channel: a set still running at the next
+// trigger (isrLow() kept out) is missed.
+#ifndef ADC_STREAM_RATE_HZ
+    #define ADC_STREAM_RATE_HZ      1000
+#endif
+// Sets per published sample (1..64). ADC_STREAM_AVERAGE = 1 publishes their mean, a boxcar filter
+// ahead of the decimation; 0 only the last one.
+#ifndef ADC_STREAM_DECIMATE
+    #define ADC_STREAM_DECIMATE     1
+#endif
+#ifndef ADC_STREAM_AVERAGE
+    #define ADC_STREAM_AVERAGE      1
+#endif
+#ifndef ADC_STREAM_IDH
+    #define ADC_STREAM_IDH          0x60    // 0x300: samples
+#endif
+#ifndef ADC_STREAM_REPORT_IDH
+    #define ADC_STREAM_REPORT_IDH   0x61    // 0x308: adcStreamReport
+#endif
+#ifndef ADC_STREAM_REPORT_MS
+    #define ADC_STREAM_REPORT_MS    1000
+#endif
+#ifndef ADC_STREAM_TXB
+    #define ADC_STREAM_TXB          1
+#endif
+
+/* Frames, multi-byte fields little endian.
+ * Samples, ADC_STREAM_IDH, 8 bytes: four 16 bit words, the published samples in channel order,
+ *   4 / ADC_STREAM_CHANNELS sets per frame. Bits 9..0 hold the 10 bit result; bits 15..12 of the
+ *   first word count the frames (0..15), so a receiver sees a frame missing.
+ * Report, ADC_STREAM_REPORT_IDH, 8 bytes, every ADC_STREAM_REPORT_MS: [0] sets per second,
+ *   [2] sets missed per second, [4] samples dropped, [6] frames sent, the last two as totals
+ *   (16 bits, wrapping). */
+#define ADC_STREAM_SETS_PER_FRAME   (4 / ADC_STREAM_CHANNELS)
+#define ADC_STREAM_SEQUENCE_SHIFT   12
+
+// Timer3: FOSC/4 with prescaler 1:8, 4 us ticks.
+#define ADC_STREAM_TICK_US      4
+#define ADC_STREAM_PERIOD       (1000000 / ADC_STREAM_TICK_US / ADC_STREAM_RATE_HZ)
+
+typedef struct
+{
+    uint32_t sets;                      // Sample sets converted
+    uint32_t dropped;                   // Published samples lost, both buffers waiting for the bus
+    uint32_t frames;                    // Sample frames handed to the SPI engine
+    uint16_t rateHz;                    // Sets per second, last report interval
+    uint16_t missedHz;                  // Sets missed per second (ADC_STREAM_RATE_HZ - rateHz)
+}adcStreamStats;
+
+extern adcStreamStats adcStreamCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void adcStreamStart(void);
+void adcStreamStop(void);
+void adcStreamInterrupt(void);
+void adcStreamService(void);
+
+#endif	/* ADC_STREAM_H */
+
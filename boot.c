@@ -0,0 +1,488 @@
+/* File:  boot.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: CAN bootloader (see boot.h for the protocol). It runs polled, with the interrupts
+ * off: every erase or write stalls the CPU, so an interrupt would gain nothing. Each 64 byte
+ * block is compared with the flash first, an unchanged block is neither erased nor written, and
+ * each written block is read back. While one block is programmed the next one is received in
+ * the other buffer. An end-to-end simulated update is in host/bootHost.c.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "boot.h"
+#include "can.h"
+#include "flash.h"
+#include "hardware.h"
+#include "timer.h"
+
+#define BOOT_TX_TIMEOUT_MS      10      // A reply that is not sent by then is overwritten
+
+// Programming steps of a block.
+#define BOOT_STEP_COMPARE       0
+#define BOOT_STEP_ERASE         1
+#define BOOT_STEP_WRITE_LOW     2
+#define BOOT_STEP_WRITE_HIGH    3
+#define BOOT_STEP_VERIFY        4
+
+// bootFlags
+#define BOOT_SESSION            0x01    // The marker is erased, the session CRC runs
+#define BOOT_SEGMENT            0x02    // A segment is being received
+#define BOOT_REWOUND            0x04    // A frame was missed, CREDIT with BOOT_CREDIT_REWIND sent
+
+// CRC-16/CCITT-FALSE of the high nibble of the index, with a zero low nibble.
+static const uint16_t bootCrcTable[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+static __persistent volatile uint16_t bootRequest __at(BOOT_REQUEST_ADDRESS);
+
+static uint8_t bootBuffer[2][FLASH_ERASE_SIZE];     // Block (n) of the segment in bootBuffer[n & 1]
+static uint8_t bootRead[FLASH_WRITE_SIZE];
+static uint8_t bootTx[8];
+static uint16_t bootAddress;            // Segment
+static uint16_t bootFrames;
+static uint16_t bootReceived;           // Frames of the segment taken, in order
+static uint16_t bootCredit;             // Frames of the segment granted
+static uint16_t bootBlock;              // Block of the segment being programmed
+static uint8_t bootStep;
+static uint8_t bootFlags;
+static uint16_t bootSum;                // Session CRC
+
+
+/*******************************************************************************
+ * FUNCTION: uint16_t bootCrc(uint16_t crc, const uint8_t *data, uint8_t count)
+ * Description: CRC-16/CCITT-FALSE (polynomial 0x1021, start 0xFFFF) of (count) bytes of (data),
+ * continued from (crc). Two table lookups per byte.
+ *******************************************************************************/
+uint16_t bootCrc(uint16_t crc, const uint8_t *data, uint8_t count)
+{
+    for (; count; count--, data++)
+    {
+        crc = (uint16_t)(crc << 4) ^ bootCrcTable[(uint8_t)(crc >> 12) ^ (*data >> 4)];
+        crc = (uint16_t)(crc << 4) ^ bootCrcTable[(uint8_t)(crc >> 12) ^ (*data & 0x0F)];
+    }
+    
+    return crc;
+    
+} // end uint16_t bootCrc(uint16_t crc, const uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t bootAppValid(void)
+ * Description: Returns 1 when the marker of a committed application is in place.
+ *******************************************************************************/
+uint8_t bootAppValid(void)
+{
+    uint8_t marker[2];
+    
+    flashRead(BOOT_MARKER, marker, 2);
+    
+    return (marker[0] == (uint8_t)BOOT_MARKER_VALUE) && (marker[1] == (uint8_t)(BOOT_MARKER_VALUE >> 8));
+    
+} // end uint8_t bootAppValid(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t bootTxWait(void)
+ * Description: Waits, up to BOOT_TX_TIMEOUT_MS, for TXB0 to be sent. Returns 1 when it is free.
+ *******************************************************************************/
+static uint8_t bootTxWait(void)
+{
+    uint16_t start = timerMillis();
+    
+    while (mcp2515ReadStatus() & STAT_TXnREQ(0))
+    {
+        if ((uint16_t)(timerMillis() - start) >= BOOT_TX_TIMEOUT_MS)
+            return 0;
+    }
+    
+    return 1;
+    
+} // end static uint8_t bootTxWait(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void bootReply(uint8_t reply, uint16_t first, uint16_t second, uint8_t flags)
+ * Description: Sends (reply) with the fields [2] (first), [4] (second) and [6] (flags) through
+ * TXB0, once the previous reply is out.
+ *******************************************************************************/
+static void bootReply(uint8_t reply, uint16_t first, uint16_t second, uint8_t flags)
+{
+    bootTx[0] = reply;
+    bootTx[1] = BOOT_NODE;
+    bootTx[2] = (uint8_t)first;
+    bootTx[3] = (uint8_t)(first >> 8);
+    bootTx[4] = (uint8_t)second;
+    bootTx[5] = (uint8_t)(second >> 8);
+    bootTx[6] = flags;
+    bootTx[7] = 0;
+    
+    bootTxWait();
+    canSend(0, BOOT_IDH_REPLY, 8, bootTx);
+    
+} // end static void bootReply(uint8_t reply, uint16_t first, uint16_t second, uint8_t flags) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void bootDone(uint8_t status, uint8_t command)
+ * Description: DONE reply: (status) of (command).
+ *******************************************************************************/
+static void bootDone(uint8_t status, uint8_t command)
+{
+    bootReply(BOOT_REPLY_DONE, (uint16_t)(command << 8) | status, 0, 0);
+    
+} // end static void bootDone(uint8_t status, uint8_t command) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void bootGrant(uint16_t credit)
+ * Description: Raises the credit up to (credit), bounded by the frames that fit in the two block
+ * buffers and by the segment, and sends it when TXB0 is free; otherwise the next call does.
+ *******************************************************************************/
+static void bootGrant(uint16_t credit)
+{
+    uint16_t room = (bootBlock + 2) * BOOT_FRAMES_PER_BLOCK;
+    
+    if (credit > room)
+        credit = room;
+    if (credit > bootFrames)
+        credit = bootFrames;
+    
+    if ((credit > bootCredit) && !(mcp2515ReadStatus() & STAT_TXnREQ(0)))
+    {
+        bootCredit = credit;
+        bootReply(BOOT_REPLY_CREDIT, bootReceived, bootCredit, 0);
+    }
+    
+} // end static void bootGrant(uint16_t credit) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t bootBlank(const uint8_t *data)
+ * Description: Returns 1 when the write block (data) is all FLASH_ERASED.
+ *******************************************************************************/
+static uint8_t bootBlank(const uint8_t *data)
+{
+    for (uint8_t i = 0; i < FLASH_WRITE_SIZE; i++)
+    {
+        if (data[i] != FLASH_ERASED)
+            return 0;
+    }
+    
+    return 1;
+    
+} // end static uint8_t bootBlank(const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t bootSame(uint16_t address, const uint8_t *data)
+ * Description: Returns 1 when the flash write block at (address) holds (data).
+ *******************************************************************************/
+static uint8_t bootSame(uint16_t address, const uint8_t *data)
+{
+    flashRead(address, bootRead, FLASH_WRITE_SIZE);
+    for (uint8_t i = 0; i < FLASH_WRITE_SIZE; i++)
+    {
+        if (bootRead[i] != data[i])
+            return 0;
+    }
+    
+    return 1;
+    
+} // end static uint8_t bootSame(uint16_t address, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void bootProgram(void)
+ * Description: Runs one programming step of the oldest complete block of the segment. A step that
+ * stalls the CPU waits until at most BOOT_STALL_FRAMES granted frames are still to come, and
+ * grants that many just before, so the tool keeps the bus busy during the stall. With no block
+ * to program it only grants. The last block verified ends the segment with DONE.
+ *******************************************************************************/
+static void bootProgram(void)
+{
+    uint8_t *block = bootBuffer[bootBlock & 1];
+    uint16_t address = bootAddress + bootBlock * FLASH_ERASE_SIZE;
+    
+    if (bootReceived < (bootBlock + 1) * BOOT_FRAMES_PER_BLOCK)
+    {
+        bootGrant(0xFFFF);
+        return;
+    }
+    
+    if ((bootStep >= BOOT_STEP_ERASE) && (bootStep <= BOOT_STEP_WRITE_HIGH))
+    {
+        if (bootCredit - bootReceived > BOOT_STALL_FRAMES)
+            return;
+        bootGrant(bootReceived + BOOT_STALL_FRAMES);
+    }
+    
+    switch (bootStep)
+    {
+        case BOOT_STEP_COMPARE:
+            if (bootSame(address, block) && bootSame(address + FLASH_WRITE_SIZE, block + FLASH_WRITE_SIZE))
+                bootStep = BOOT_STEP_VERIFY;
+            else
+            {
+                flashRead(address, bootRead, FLASH_WRITE_SIZE);
+                bootStep = BOOT_STEP_ERASE;
+                if (bootBlank(bootRead))
+                {
+                    flashRead(address + FLASH_WRITE_SIZE, bootRead, FLASH_WRITE_SIZE);
+                    if (bootBlank(bootRead))
+                        bootStep = BOOT_STEP_WRITE_LOW;     // Already erased
+                }
+            }
+            break;
+    
+        case BOOT_STEP_ERASE:
+            flashErase(address);
+            bootStep = BOOT_STEP_WRITE_LOW;
+            break;
+    
+        case BOOT_STEP_WRITE_LOW:
+            if (!bootBlank(block))
+                flashWrite(address, block);
+            bootStep = BOOT_STEP_WRITE_HIGH;
+            break;
+    
+        case BOOT_STEP_WRITE_HIGH:
+            if (!bootBlank(block + FLASH_WRITE_SIZE))
+                flashWrite(address + FLASH_WRITE_SIZE, block + FLASH_WRITE_SIZE);
+            bootStep = BOOT_STEP_VERIFY;
+            break;
+    
+        default:
+            if (!bootSame(address, block) || !bootSame(address + FLASH_WRITE_SIZE, block + FLASH_WRITE_SIZE))
+            {
+                bootFlags = 0;                  // The session is lost, COMMIT is refused
+                bootDone(BOOT_ERR_VERIFY, BOOT_CMD_SEGMENT);
+                return;
+            }
+            bootBlock++;
+            bootStep = BOOT_STEP_COMPARE;
+            if (bootBlock * BOOT_FRAMES_PER_BLOCK == bootFrames)
+            {
+                bootFlags &= ~BOOT_SEGMENT;
+                bootDone(BOOT_OK, BOOT_CMD_SEGMENT);
+            }
+            break;
+    }
+    
+} // end static void bootProgram(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void bootData(const dataFrame *frame)
+ * Description: Takes a data frame when it is the next one of the segment. The first frame out
+ * of order is answered with a rewinding CREDIT, the ones after it are dropped until the tool
+ * goes back. Frame indexes are 4 bits: no more than 16 frames are ever granted ahead.
+ *******************************************************************************/
+static void bootData(const dataFrame *frame)
+{
+    uint8_t index = (uint8_t)((frame->idh & 0x01) << 3) | (frame->idl >> 5);
+    uint8_t *data;
+    
+    if (!(bootFlags & BOOT_SEGMENT) || (bootReceived == bootCredit))
+        return;
+    
+    if ((index != (bootReceived & 0x0F)) || ((frame->dlc & CAN_DLC_MASK) != 8))
+    {
+        if (!(bootFlags & BOOT_REWOUND))
+        {
+            bootFlags |= BOOT_REWOUND;
+            bootReply(BOOT_REPLY_CREDIT, bootReceived, bootCredit, BOOT_CREDIT_REWIND);
+        }
+        return;
+    }
+    
+    data = &bootBuffer[(bootReceived / BOOT_FRAMES_PER_BLOCK) & 1][(bootReceived % BOOT_FRAMES_PER_BLOCK) * 8];
+    for (uint8_t i = 0; i < 8; i++)
+        data[i] = frame->data[i];
+    bootSum = bootCrc(bootSum, frame->data, 8);
+    bootReceived++;
+    bootFlags &= ~BOOT_REWOUND;
+    
+} // end static void bootData(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t bootCommand(const dataFrame *frame)
+ * Description: Runs a SEGMENT, STATUS or COMMIT command. Returns 1 when the application was
+ * committed.
+ *******************************************************************************/
+static uint8_t bootCommand(const dataFrame *frame)
+{
+    uint16_t first = frame->data[2] | ((uint16_t)frame->data[3] << 8);
+    uint16_t second = frame->data[4] | ((uint16_t)frame->data[5] << 8);
+    uint8_t marker[FLASH_WRITE_SIZE];
+    
+    switch (frame->data[0])
+    {
+        case BOOT_CMD_SEGMENT:
+            if (bootFlags & BOOT_SEGMENT)
+                bootDone(BOOT_ERR_STATE, BOOT_CMD_SEGMENT);
+            else if ((first < BOOT_APP_START) || (first >= BOOT_APP_END) || !second || (second > BOOT_APP_END - first)
+                     || ((first | second) & (FLASH_ERASE_SIZE - 1)))
+                bootDone(BOOT_ERR_ADDRESS, BOOT_CMD_SEGMENT);
+            else
+            {
+                if (!(bootFlags & BOOT_SESSION))
+                {
+                    flashErase(BOOT_MARKER);
+                    bootSum = 0xFFFF;
+                }
+                bootFlags = BOOT_SESSION | BOOT_SEGMENT;
+                bootAddress = first;
+                bootFrames = second / 8;
+                bootReceived = 0;
+                bootCredit = 0;
+                bootBlock = 0;
+                bootStep = BOOT_STEP_COMPARE;
+                bootTxWait();
+                bootGrant(0xFFFF);
+            }
+            break;
+    
+        case BOOT_CMD_STATUS:
+            bootReply(BOOT_REPLY_CREDIT, bootReceived, bootCredit, (bootFlags & BOOT_REWOUND) ? BOOT_CREDIT_REWIND : 0);
+            break;
+    
+        case BOOT_CMD_COMMIT:
+            if ((bootFlags & (BOOT_SESSION | BOOT_SEGMENT)) != BOOT_SESSION)
+                bootDone(BOOT_ERR_STATE, BOOT_CMD_COMMIT);
+            else if (first != bootSum)
+            {
+                bootFlags = 0;
+                bootDone(BOOT_ERR_CRC, BOOT_CMD_COMMIT);
+            }
+            else
+            {
+                for (uint8_t i = 0; i < FLASH_WRITE_SIZE; i++)
+                    marker[i] = FLASH_ERASED;
+                marker[0] = (uint8_t)BOOT_MARKER_VALUE;
+                marker[1] = (uint8_t)(BOOT_MARKER_VALUE >> 8);
+                flashWrite(BOOT_MARKER, marker);
+                bootFlags = 0;
+                if (!bootAppValid())
+                {
+                    bootDone(BOOT_ERR_VERIFY, BOOT_CMD_COMMIT);
+                    break;
+                }
+                bootDone(BOOT_OK, BOOT_CMD_COMMIT);
+                bootTxWait();
+                return 1;
+            }
+            break;
+    
+        default:
+            break;
+    }
+    
+    return 0;
+    
+} // end static uint8_t bootCommand(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t bootRun(void)
+ * Description: Bootloader main loop, called from the reset vector. The driver is started as in the
+ * application, then the interrupts are turned off and the filters set to the bootloader frames:
+ * data in RXB0 with rollover to RXB1, commands in RXB1. With a valid application and no request
+ * from bootEnter(), BOOT_CMD_ENTER is waited for BOOT_WAIT_MS. Returns 1 after a committed
+ * update, 0 on the timeout; the caller then starts the application.
+ *******************************************************************************/
+uint8_t bootRun(void)
+{
+    dataFrame frame;
+    uint16_t start;
+    uint8_t stay;
+    
+    hardware_ini();
+    INTCONbits.GIEH = 0;
+    INTCONbits.GIEL = 0;
+    INTCON3bits.INT2IE = 0;
+    canIntEnabled = 0;
+    
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(BOOT_BITRATE);
+    mcp2515SetMask(0, 0xFE);
+    mcp2515SetFilter(0, BOOT_IDH_DATA);
+    mcp2515SetFilter(1, BOOT_IDH_DATA);
+    mcp2515SetMask(1, 0xFF);
+    for (uint8_t filter = 2; filter < 6; filter++)
+        mcp2515SetFilter(filter, BOOT_IDH_COMMAND);
+    mcp2515SetRxMode(0, RXM_VALID_ALL);
+    mcp2515SetRxMode(1, RXM_VALID_ALL);
+    mcp2515BitChange(RXB0CTRL, BUKT, BUKT_ROLLOVER);
+    mcp2515ConfigEnd();
+    
+    bootFlags = 0;
+    stay = !bootAppValid() || (bootRequest == BOOT_REQUEST_VALUE);
+    bootRequest = 0;
+    if (stay)
+        bootReply(BOOT_REPLY_HELLO, BOOT_APP_START, BOOT_APP_END, 0);
+    
+    start = timerMillis();
+    while (stay || ((uint16_t)(timerMillis() - start) < BOOT_WAIT_MS))
+    {
+        CLRWDT();
+    
+        if (!canReceive(&frame))
+        {
+            if (bootFlags & BOOT_SEGMENT)
+                bootProgram();
+        }
+        else if ((frame.idh & 0xFE) == BOOT_IDH_DATA)
+            bootData(&frame);
+        else if (frame.data[0] == BOOT_CMD_ENTER)
+        {
+            if ((frame.data[1] == BOOT_NODE) || (frame.data[1] == BOOT_NODE_ALL))
+            {
+                stay = 1;
+                bootReply(BOOT_REPLY_HELLO, BOOT_APP_START, BOOT_APP_END, 0);
+            }
+        }
+        else if (stay && (frame.data[1] == BOOT_NODE) && bootCommand(&frame))
+            return 1;
+    }
+    
+    return 0;
+    
+} // end uint8_t bootRun(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void bootEnter(void)
+ * Description: Application side: resets into the bootloader, which then stays for an update.
+ *******************************************************************************/
+void bootEnter(void)
+{
+    bootRequest = BOOT_REQUEST_VALUE;
+    RESET();
+    
+} // end void bootEnter(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void bootCommandHandler(const dataFrame *frame)
+ * Description: Application side handler of the command identifier (canDispatch.def): ENTER
+ * for this node calls bootEnter().
+ *******************************************************************************/
+void bootCommandHandler(const dataFrame *frame)
+{
+    if ((frame->data[0] == BOOT_CMD_ENTER) && ((frame->data[1] == BOOT_NODE) || (frame->data[1] == BOOT_NODE_ALL)))
+        bootEnter();
+    
+} // end void bootCommandHandler(const dataFrame *frame) function
+
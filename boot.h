@@ -0,0 +1,105 @@
+/* File:  boot.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: CAN bootloader. It lives in the boot block and block 0 (0x0000-0x1FFF, write
+ * protected by WRTB and WRT0 in config_bits.h) and programs the application, linked from
+ * BOOT_APP_START, with the firmware the update tool sends over CAN.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef BOOT_H
+#define	BOOT_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+#include "flash.h"
+
+// Defines and Macros
+// BOOTLOADER = 1 builds the bootloader (main.c) instead of the demo. The application is built with
+// BOOTLOADER = 0 and the linker options --codeoffset=0x2000 --rom=2000-7FBF, so its reset and
+// interrupt vectors move to 0x2000/0x2008/0x2018 and the marker block stays free. The bootloader
+// needs SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h): at FOSC/64 reading a frame takes about as long as the
+// frame on a 125 Kbps bus.
+#ifndef BOOTLOADER
+    #define BOOTLOADER              0
+#endif
+#ifndef BOOT_NODE
+    #define BOOT_NODE               0x01    // Node number in the commands
+#endif
+#ifndef BOOT_BITRATE
+    #define BOOT_BITRATE            CAN_BITRATE_125K
+#endif
+#ifndef BOOT_WAIT_MS
+    #define BOOT_WAIT_MS            100     // After a reset, BOOT_CMD_ENTER is waited for this long
+#endif
+#ifndef BOOT_COMMAND
+    #define BOOT_COMMAND            1       // Application: BOOT_CMD_ENTER answered (canDispatch.def)
+#endif
+
+#define BOOT_APP_START          0x2000
+#define BOOT_MARKER             0x7FC0  // Last erase block: the application is valid
+#define BOOT_APP_END            BOOT_MARKER
+#define BOOT_MARKER_VALUE       0x5AA5
+#define BOOT_REQUEST_ADDRESS    0x03FE  // RAM word kept over RESET() by bootEnter()
+#define BOOT_REQUEST_VALUE      0xB007
+
+/* Protocol. Multi-byte fields are little endian, every frame has 8 data bytes.
+ * 0x7C0 command, tool -> node: [0] command, [1] node (BOOT_NODE, 0xFF every node for ENTER).
+ *   BOOT_CMD_ENTER:   the application resets into the bootloader, which answers HELLO.
+ *   BOOT_CMD_SEGMENT: [2] address, [4] lenght, multiples of 64 inside BOOT_APP_START-END. The
+ *                     first one of a session erases the marker. Answered by CREDIT.
+ *   BOOT_CMD_STATUS:  answered by CREDIT (the tool lost a reply).
+ *   BOOT_CMD_COMMIT:  [2] CRC-16/CCITT-FALSE of the data of every segment, in the order sent.
+ *                     On a match the marker is written and the application started.
+ * 0x7D0-0x7DF data, tool -> node: frame (index & 15) of the segment, 8 bytes.
+ * 0x7C8 reply, node -> tool: [0] reply, [1] node.
+ *   BOOT_REPLY_HELLO:  [2] BOOT_APP_START, [4] BOOT_APP_END.
+ *   BOOT_REPLY_CREDIT: [2] frames received, [4] credit: the tool may send the frames below it.
+ *                      [6] BOOT_CREDIT_REWIND: a frame was missed, go back to [2].
+ *   BOOT_REPLY_DONE:   [2] BOOT_OK or BOOT_ERR_xxx, [3] the command: SEGMENT (programmed and
+ *                      verified) or COMMIT.
+ * Flow control: the CPU stalls about 2 ms per erase or write, and only the two receive buffers
+ * of the MCP2515 take frames meanwhile. The node starts a flash operation only when no more
+ * than two granted frames are still to come, and grants two more just before, so the next
+ * frames arrive during the stall; between stalls it grants as far as its two block buffers go. */
+#define BOOT_IDH_COMMAND        0xF8    // 0x7C0
+#define BOOT_IDH_REPLY          0xF9    // 0x7C8
+#define BOOT_IDH_DATA           0xFA    // 0x7D0-0x7DF: SIDH 0xFA/0xFB, index bits 2..0 in SIDL
+
+#define BOOT_CMD_ENTER          0x01
+#define BOOT_CMD_SEGMENT        0x02
+#define BOOT_CMD_STATUS         0x03
+#define BOOT_CMD_COMMIT         0x04
+#define BOOT_REPLY_HELLO        0x81
+#define BOOT_REPLY_CREDIT       0x82
+#define BOOT_REPLY_DONE         0x83
+#define BOOT_NODE_ALL           0xFF
+#define BOOT_CREDIT_REWIND      0x01
+
+#define BOOT_OK                 0x00
+#define BOOT_ERR_ADDRESS        0x01    // Segment outside the application or not aligned
+#define BOOT_ERR_VERIFY         0x02    // Read back differs from the data written
+#define BOOT_ERR_CRC            0x03    // COMMIT CRC differs, the application stays invalid
+#define BOOT_ERR_STATE          0x04    // Command out of order (data pending, nothing sent)
+
+#define BOOT_FRAMES_PER_BLOCK   (FLASH_ERASE_SIZE / 8)
+#define BOOT_STALL_FRAMES       2       // Frames the MCP2515 holds while the CPU is stalled
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint16_t bootCrc(uint16_t crc, const uint8_t *data, uint8_t count);
+uint8_t bootAppValid(void);
+uint8_t bootRun(void);
+void bootEnter(void);
+void bootCommandHandler(const dataFrame *frame);
+
+#endif	/* BOOT_H */
+
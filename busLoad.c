@@ -0,0 +1,508 @@
+/* File:  busLoad.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Bus load meter (see busLoad.h). busLoadFrame() runs in the receive path, inside the
+ * INT2 interrupt: it only queues the frame and defers the rest to the low priority interrupt, where
+ * busLoadService() adds the frame length, taken from tables, to the open bucket and to the table
+ * of identifiers. busLoadPoll() closes the buckets from the main program, and the load is the sum
+ * of the closed buckets over the bus time they cover, at the bit rate read from CNF1-CNF3.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "busLoad.h"
+#include "can.h"
+#include "hardware.h"
+
+typedef struct
+{
+    uint16_t id;
+    uint32_t bits;
+}busLoadEntry;
+
+typedef struct
+{
+    uint8_t header[5];                  // RXBnSIDH..RXBnDLC
+    uint8_t data[8];
+}busLoadRaw;
+
+/* Bits of a frame without stuff bits, from SOF to the end of the intermission, and the most stuff
+ * bits it can carry, by format (standard, extended) and data length. Stuffing covers SOF to CRC, 
+ * 34 + 8n bits in a standard frame and 54 + 8n in an extended one, with at most one stuff bit for 
+ * every 4 bits after the first. */
+static const uint8_t busLoadBitsTable[2][9] =
+{
+    { 47, 55, 63, 71, 79, 87, 95, 103, 111 },
+    { 67, 75, 83, 91, 99, 107, 115, 123, 131 },
+};
+static const uint8_t busLoadWorstTable[2][9] =
+{
+    { 8, 10, 12, 14, 16, 18, 20, 22, 24 },
+    { 13, 15, 17, 19, 21, 23, 25, 27, 29 },
+};
+
+// Frames queued by busLoadFrame() (INT2) for busLoadService() (low priority).
+static CAN_QUEUE_RAM busLoadRaw busLoadQueue[BUS_LOAD_QUEUE_SIZE];
+static volatile CAN_QUEUE_INDEX_RAM uint8_t busLoadHead;
+static volatile CAN_QUEUE_INDEX_RAM uint8_t busLoadTail;
+
+// Open bucket, written by busLoadService().
+static volatile uint32_t busLoadBits;
+static volatile uint32_t busLoadStuff;
+static volatile uint16_t busLoadFrames;
+
+// Frames that found the queue full, counted by busLoadFrame() itself with the worst case stuffing
+// and without their identifiers.
+static volatile uint32_t busLoadLateBits;
+static volatile uint32_t busLoadLateStuff;
+static volatile uint16_t busLoadLateFrames;
+
+// Closed buckets.
+static uint32_t busLoadBucketBits[BUS_LOAD_BUCKETS];
+static uint32_t busLoadBucketStuff[BUS_LOAD_BUCKETS];
+static uint16_t busLoadBucketFrames[BUS_LOAD_BUCKETS];
+static uint8_t busLoadNext;
+static uint8_t busLoadFilled;
+static uint8_t busLoadMs;
+static uint16_t busLoadLast;
+static uint8_t busLoadStarted;
+
+#if BUS_LOAD_IDS
+// Identifiers: busLoadFrame() fills busLoadIdTable[busLoadIdSide] during a window, the other side
+// holds the previous window.
+static busLoadEntry busLoadIdTable[2][BUS_LOAD_IDS];
+static volatile uint8_t busLoadIdSide;
+static uint8_t busLoadIdBuckets;
+#endif
+
+/* Stuffing of 4 bits: busLoadStuffTable[state << 4 | bits], state = last level << 2 | (run - 1).
+ * Each entry is the new state, plus 0x08 when a stuff bit was inserted (never more than one: the
+ * stuff bit starts a new run). */
+static const uint8_t busLoadStuffTable[128] =
+{
+    0x0C, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,   // level 0, run 1
+    0x08, 0x0D, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,   // level 0, run 2
+    0x09, 0x0C, 0x08, 0x0E, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,   // level 0, run 3
+    0x0A, 0x0C, 0x08, 0x0D, 0x09, 0x0C, 0x08, 0x0F, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x07,   // level 0, run 4
+    0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x08,   // level 1, run 1
+    0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x01, 0x04, 0x09, 0x0C,   // level 1, run 2
+    0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x02, 0x04, 0x00, 0x05, 0x0A, 0x0C, 0x08, 0x0D,   // level 1, run 3
+    0x03, 0x04, 0x00, 0x05, 0x01, 0x04, 0x00, 0x06, 0x0B, 0x0C, 0x08, 0x0D, 0x09, 0x0C, 0x08, 0x0E,   // level 1, run 4
+};
+
+// CRC-15 (x^15 + x^14 + x^10 + x^8 + x^7 + x^4 + x^3 + 1, 0x4599) of 4 bits.
+static const uint16_t busLoadCrcTable[16] =
+{
+    0x0000, 0x4599, 0x4EAB, 0x0B32, 0x58CF, 0x1D56, 0x1664, 0x53FD,
+    0x7407, 0x319E, 0x3AAC, 0x7F35, 0x2CC8, 0x6951, 0x6263, 0x27FA,
+};
+
+static uint16_t busLoadCrc;
+static uint8_t busLoadState;
+static uint8_t busLoadStuffed;
+
+
+/*******************************************************************************
+ * FUNCTION: static void busLoadFeed(uint8_t value, uint8_t count, uint8_t crc)
+ * Description: Passes the (count, up to 8) low bits of (value), most significant first, through
+ * the stuffing and, when (crc) is set, through the CRC. Whole nibbles go through the tables.
+ *******************************************************************************/
+static void busLoadFeed(uint8_t value, uint8_t count, uint8_t crc)
+{
+    while (count >= 4)
+    {
+        uint8_t nibble;
+    
+        count -= 4;
+        nibble = (value >> count) & 0x0F;
+        if (crc)
+            busLoadCrc = ((busLoadCrc << 4) & 0x7FFF) ^ busLoadCrcTable[((uint8_t)(busLoadCrc >> 11) ^ nibble) & 0x0F];
+        nibble = busLoadStuffTable[(uint8_t)(busLoadState << 4) | nibble];
+        busLoadState = nibble & 0x07;
+        busLoadStuffed += nibble >> 3;
+    }
+    
+    while (count)
+    {
+        uint8_t bit;
+    
+        count--;
+        bit = (value >> count) & 0x01;
+        if (crc)
+        {
+            uint8_t next = bit ^ (uint8_t)((busLoadCrc >> 14) & 0x01);
+    
+            busLoadCrc = (busLoadCrc << 1) & 0x7FFF;
+            if (next)
+                busLoadCrc ^= 0x4599;
+        }
+        if (bit != (busLoadState >> 2))
+            busLoadState = (uint8_t)(bit << 2);
+        else if ((busLoadState & 0x03) != 0x03)
+            busLoadState++;
+        else
+        {
+            // Fifth equal bit: the stuff bit, of the other level, starts the next run.
+            busLoadStuffed++;
+            busLoadState = (uint8_t)((bit ^ 0x01) << 2);
+        }
+    }
+    
+} // end static void busLoadFeed(uint8_t value, uint8_t count, uint8_t crc) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t busLoadStuffing(const uint8_t *header, const uint8_t *data, uint8_t lenght,
+ *                                          uint8_t rtr)
+ * Description: Stuff bits of the frame, rebuilt from SOF to the CRC. The fields after the
+ * identifier are the same in both formats: RTR, IDE or r1, r0 and the DLC.
+ *******************************************************************************/
+static uint8_t busLoadStuffing(const uint8_t *header, const uint8_t *data, uint8_t lenght, uint8_t rtr)
+{
+    uint16_t crc;
+    
+    busLoadCrc = 0;
+    busLoadState = 0x04;                                    // Recessive bus before SOF
+    busLoadStuffed = 0;
+    
+    busLoadFeed(0x00, 1, 1);                                // SOF
+    busLoadFeed(header[0], 8, 1);                           // Identifier 10..3 (28..21)
+    if (header[1] & EXIDE_SET)
+    {
+        // Identifier 20..18, SRR, IDE, identifier 17..0
+        busLoadFeed((uint8_t)((header[1] & 0xE0) >> 1) | 0x0C | (header[1] & 0x03), 7, 1);
+        busLoadFeed(header[2], 8, 1);
+        busLoadFeed(header[3], 8, 1);
+    }
+    else
+        busLoadFeed(header[1] >> 5, 3, 1);                  // Identifier 2..0
+    busLoadFeed((rtr ? 0x40 : 0x00) | (header[4] & 0x0F), 7, 1);
+    for (uint8_t i = 0; i < lenght; i++)
+    {
+        busLoadFeed(data[i], 8, 1);
+    }
+    
+    crc = busLoadCrc;
+    busLoadFeed((uint8_t)(crc >> 7), 8, 0);
+    busLoadFeed((uint8_t)crc & 0x7F, 7, 0);
+    
+    return busLoadStuffed;
+    
+} // end static uint8_t busLoadStuffing() function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t busLoadLenght(const uint8_t *header, uint8_t *extended, uint8_t *rtr)
+ * Description: Data bytes on the wire of the frame with registers (header); sets (extended) and
+ * (rtr) from them.
+ *******************************************************************************/
+static uint8_t busLoadLenght(const uint8_t *header, uint8_t *extended, uint8_t *rtr)
+{
+    uint8_t lenght = header[4] & 0x0F;
+    
+    *extended = (header[1] & EXIDE_SET) ? 1 : 0;
+    *rtr = *extended ? (header[4] & DLC_RTR) : (header[1] & SIDL_SRR);
+    if (*rtr)
+        return 0;
+    
+    return (lenght > 8) ? 8 : lenght;
+    
+} // end static uint8_t busLoadLenght() function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t busLoadFrameBits(const uint8_t *header, const uint8_t *data)
+ * Description: Bits the frame with registers (header), as in busLoadFrame(), and data bytes (data)
+ * takes on the bus, SOF to the end of the intermission, with its stuff bits: the length a
+ * bus analyser shows. For the main program (canGen.c): GIEL = 0 holds busLoadService() off, which
+ * shares the CRC and stuffing state.
+ *******************************************************************************/
+uint8_t busLoadFrameBits(const uint8_t *header, const uint8_t *data)
+{
+    uint8_t extended;
+    uint8_t rtr;
+    uint8_t lenght = busLoadLenght(header, &extended, &rtr);
+    uint8_t bits = busLoadBitsTable[extended][lenght];
+    uint8_t giel = INTCONbits.GIEL;
+    
+    INTCONbits.GIEL = 0;
+    bits += busLoadStuffing(header, data, lenght, rtr);
+    INTCONbits.GIEL = giel;
+    
+    return bits;
+    
+} // end uint8_t busLoadFrameBits(const uint8_t *header, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void busLoadFrame(const uint8_t *header, const uint8_t *data)
+ * Description: Takes a received frame: (header) holds its RXBnSIDH..RXBnDLC registers and (data)
+ * its data bytes. Called from the receive path (canService(), canRxDone()), in isr(): the frame is
+ * copied to the queue and counted later by busLoadService(), or counted here, in the worst case,
+ * when the queue is full.
+ *******************************************************************************/
+void busLoadFrame(const uint8_t *header, const uint8_t *data)
+{
+    uint8_t head = busLoadHead;
+    uint8_t next = (head + 1) & (BUS_LOAD_QUEUE_SIZE - 1);
+    uint8_t extended;
+    uint8_t rtr;
+    uint8_t lenght = busLoadLenght(header, &extended, &rtr);
+    uint8_t i;
+    
+    if (next == busLoadTail)
+    {
+        busLoadLateBits += busLoadBitsTable[extended][lenght];
+        busLoadLateStuff += busLoadWorstTable[extended][lenght];
+        busLoadLateFrames++;
+        return;
+    }
+    
+    for (i = 0; i < 5; i++)
+        busLoadQueue[head].header[i] = header[i];
+    for (i = 0; i < lenght; i++)
+        busLoadQueue[head].data[i] = data[i];
+    busLoadHead = next;
+    isrDefer(ISR_DEFER_BUS_LOAD);
+    
+} // end void busLoadFrame(const uint8_t *header, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void busLoadCount(const uint8_t *header, const uint8_t *data)
+ * Description: Adds a frame to the open bucket and to the table of identifiers.
+ *******************************************************************************/
+static void busLoadCount(const uint8_t *header, const uint8_t *data)
+{
+    uint8_t extended;
+    uint8_t rtr;
+    uint8_t lenght = busLoadLenght(header, &extended, &rtr);
+    uint8_t bits;
+    uint8_t stuff;
+    
+    bits = busLoadBitsTable[extended][lenght];
+#if BUS_LOAD_EXACT
+    stuff = busLoadStuffing(header, data, lenght, rtr);
+#else
+    (void)data;
+    stuff = busLoadWorstTable[extended][lenght];
+#endif
+    busLoadBits += bits;
+    busLoadStuff += stuff;
+    busLoadFrames++;
+    
+#if BUS_LOAD_IDS
+    {
+        busLoadEntry *table = busLoadIdTable[busLoadIdSide];
+        uint16_t id = ((uint16_t)header[0] << 3) | (header[1] >> 5);
+        uint8_t least = 0;
+    
+        if (extended)
+            id |= BUS_LOAD_ID_EXTENDED;
+    
+        // An identifier not followed takes the place of the least loaded one and keeps its count,
+        // so the heaviest ones stay in the table; the counts of the newer ones are upper bounds.
+        for (uint8_t i = 0; i < BUS_LOAD_IDS; i++)
+        {
+            if (table[i].id == id)
+            {
+                least = i;
+                break;
+            }
+            if (table[i].bits < table[least].bits)
+                least = i;
+        }
+        table[least].id = id;
+        table[least].bits += (uint8_t)(bits + stuff);
+    }
+#endif
+    
+} // end static void busLoadCount(const uint8_t *header, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void busLoadService(void)
+ * Description: Counts the frames queued by busLoadFrame(). Called from isrLow() (ISR_DEFER_BUS_LOAD).
+ *******************************************************************************/
+void busLoadService(void)
+{
+    uint8_t tail = busLoadTail;
+    
+    while (tail != busLoadHead)
+    {
+        busLoadCount(busLoadQueue[tail].header, busLoadQueue[tail].data);
+        tail = (tail + 1) & (BUS_LOAD_QUEUE_SIZE - 1);
+        busLoadTail = tail;
+    }
+    
+} // end void busLoadService(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void busLoadPoll(void)
+ * Description: Closes the open bucket every BUS_LOAD_BUCKET_MS, and the window of the identifiers
+ * every BUS_LOAD_BUCKETS buckets. Call it at least every 65 ms.
+ *******************************************************************************/
+void busLoadPoll(void)
+{
+    if (!busLoadStarted)
+    {
+        busLoadLast = timerMicros();
+        busLoadStarted = 1;
+    }
+    
+    while (timerMillisTick(&busLoadLast))
+    {
+        uint8_t gie;
+    
+        if (++busLoadMs < BUS_LOAD_BUCKET_MS)
+            continue;
+        busLoadMs = 0;
+    
+        gie = INTCONbits.GIE;
+        INTCONbits.GIE = 0;
+        busLoadBucketBits[busLoadNext] = busLoadBits + busLoadLateBits;
+        busLoadBucketStuff[busLoadNext] = busLoadStuff + busLoadLateStuff;
+        busLoadBucketFrames[busLoadNext] = busLoadFrames + busLoadLateFrames;
+        busLoadBits = 0;
+        busLoadStuff = 0;
+        busLoadFrames = 0;
+        busLoadLateBits = 0;
+        busLoadLateStuff = 0;
+        busLoadLateFrames = 0;
+        INTCONbits.GIE = gie;
+    
+        busLoadNext = (busLoadNext + 1) % BUS_LOAD_BUCKETS;
+        if (busLoadFilled < BUS_LOAD_BUCKETS)
+            busLoadFilled++;
+    
+#if BUS_LOAD_IDS
+        if (++busLoadIdBuckets == BUS_LOAD_BUCKETS)
+        {
+            busLoadEntry *table = busLoadIdTable[busLoadIdSide ^ 1];
+    
+            busLoadIdBuckets = 0;
+            for (uint8_t i = 0; i < BUS_LOAD_IDS; i++)
+            {
+                table[i].id = 0;
+                table[i].bits = 0;
+            }
+            busLoadIdSide ^= 1;
+        }
+#endif
+    }
+    
+} // end void busLoadPoll(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint16_t busLoadKbps(void)
+ * Description: Bit rate in Kbps from the bit timing in CNF1-CNF3 (shadow copy, no SPI): BRP, and
+ * the time quanta of a bit.
+ *******************************************************************************/
+uint16_t busLoadKbps(void)
+{
+    uint8_t cnf1 = mcp2515ReadRegister(CNF1);
+    uint8_t cnf2 = mcp2515ReadRegister(CNF2);
+    uint8_t cnf3 = mcp2515ReadRegister(CNF3);
+    uint8_t ps1 = ((cnf2 & PHSEG1) >> 3) + 1;
+    uint8_t ps2 = (cnf2 & BTLMODE) ? ((cnf3 & PHSEG2) + 1) : (ps1 > 2 ? ps1 : 2);
+    uint8_t quanta = 1 + (cnf2 & PRSEG) + 1 + ps1 + ps2;
+    
+    return BUS_LOAD_OSC_KHZ / (2 * ((cnf1 & BRP) + 1) * quanta);
+    
+} // end uint16_t busLoadKbps(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint16_t busLoadCapacity(uint16_t windowMs)
+ * Description: Bits the bus carries in (windowMs), divided by 100.
+ *******************************************************************************/
+static uint16_t busLoadCapacity(uint16_t windowMs)
+{
+    return (uint16_t)(((uint32_t)busLoadKbps() * windowMs) / 100);
+    
+} // end static uint16_t busLoadCapacity(uint16_t windowMs) function
+
+
+/*******************************************************************************
+ * FUNCTION: void busLoadGet(busLoadReport *report)
+ * Description: Load over the closed buckets, the last BUS_LOAD_BUCKETS * BUS_LOAD_BUCKET_MS.
+ *******************************************************************************/
+void busLoadGet(busLoadReport *report)
+{
+    uint32_t bits = 0;
+    uint32_t stuff = 0;
+    uint32_t frames = 0;
+    uint16_t capacity;
+    
+    for (uint8_t i = 0; i < busLoadFilled; i++)
+    {
+        bits += busLoadBucketBits[i];
+        stuff += busLoadBucketStuff[i];
+        frames += busLoadBucketFrames[i];
+    }
+    
+    report->windowMs = busLoadFilled * BUS_LOAD_BUCKET_MS;
+    capacity = busLoadCapacity(report->windowMs);
+    if (capacity == 0)
+    {
+        report->permille = 0;
+        report->permilleMin = 0;
+        report->framesPerSecond = 0;
+        return;
+    }
+    
+    report->permilleMin = (uint16_t)((bits * 10) / capacity);
+    report->permille = (uint16_t)(((bits + stuff) * 10) / capacity);
+    report->framesPerSecond = (uint16_t)((frames * 1000) / report->windowMs);
+    
+} // end void busLoadGet(busLoadReport *report) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t busLoadTop(busLoadId *ids)
+ * Description: Fills (ids, BUS_LOAD_IDS entries) with the identifiers of the last complete window,
+ * the most loaded first. Returns how many there are.
+ *******************************************************************************/
+uint8_t busLoadTop(busLoadId *ids)
+{
+    uint8_t count = 0;
+    
+#if BUS_LOAD_IDS
+    const busLoadEntry *table = busLoadIdTable[busLoadIdSide ^ 1];
+    uint16_t capacity = busLoadCapacity(BUS_LOAD_BUCKETS * BUS_LOAD_BUCKET_MS);
+    
+    if (capacity == 0)
+        return 0;
+    
+    for (uint8_t i = 0; i < BUS_LOAD_IDS; i++)
+    {
+        uint16_t permille;
+        uint8_t j;
+    
+        if (table[i].bits == 0)
+            continue;
+    
+        // Insertion in descending order.
+        permille = (uint16_t)((table[i].bits * 10) / capacity);
+        for (j = count; (j > 0) && (ids[j - 1].permille < permille); j--)
+        {
+            ids[j] = ids[j - 1];
+        }
+        ids[j].id = table[i].id;
+        ids[j].permille = permille;
+        count++;
+    }
+#endif
+    
+    return count;
+    
+} // end uint8_t busLoadTop(busLoadId *ids) function
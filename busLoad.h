@@ -0,0 +1,76 @@
+/* File:  busLoad.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Bus load meter. Every received frame is converted to its length on the wire and
+ * summed in buckets; the load is reported over the last BUS_LOAD_BUCKETS buckets, overall and for
+ * the identifiers that used most of the bus.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef BUS_LOAD_H
+#define	BUS_LOAD_H
+
+// Includes
+#include <xc.h>
+
+// Defines and Macros
+// BUS_LOAD = 1 feeds the meter from the receive path (can.c); busLoadPoll() must then run at least
+// every 65 ms. Only the frames received are seen: the ones this node sends, the ones rejected by
+// the acceptance filters and the ones lost in an overflow are not counted.
+#ifndef BUS_LOAD
+    #define BUS_LOAD                0
+#endif
+// BUS_LOAD_EXACT = 1 counts the stuff bits each frame really had (CRC and stuffing computed with
+// nibble tables, a few hundred instructions per frame); 0 takes the worst case from a table.
+// busLoadFrameBits(), used by the traffic generator (CAN_GEN), always counts them.
+#ifndef BUS_LOAD_EXACT
+    #define BUS_LOAD_EXACT          0
+#endif
+#ifndef BUS_LOAD_BUCKET_MS
+    #define BUS_LOAD_BUCKET_MS      100
+#endif
+#ifndef BUS_LOAD_BUCKETS
+    #define BUS_LOAD_BUCKETS        10      // Window: 1 s
+#endif
+#ifndef BUS_LOAD_IDS
+    #define BUS_LOAD_IDS            8       // Identifiers followed, 0: none
+#endif
+#ifndef BUS_LOAD_QUEUE_SIZE
+    #define BUS_LOAD_QUEUE_SIZE     8       // Frames waiting for busLoadService() (power of 2)
+#endif
+
+#define BUS_LOAD_OSC_KHZ        8000    // MCP2515 oscillator, for the bit rate read from CNF1-CNF3
+#define BUS_LOAD_ID_EXTENDED    0x8000  // busLoadId.id: extended frame, with its 11 upper identifier bits
+
+typedef struct
+{
+    uint16_t permille;                  // Bus time used, stuff bits included (exact or worst case)
+    uint16_t permilleMin;               // Same without stuff bits: the lower bound
+    uint16_t framesPerSecond;
+    uint16_t windowMs;                  // Time covered, shorter than the window after the start
+}busLoadReport;
+
+typedef struct
+{
+    uint16_t id;                        // 11 bit identifier, BUS_LOAD_ID_EXTENDED for extended frames
+    uint16_t permille;
+}busLoadId;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+void busLoadFrame(const uint8_t *header, const uint8_t *data);
+uint8_t busLoadFrameBits(const uint8_t *header, const uint8_t *data);
+void busLoadService(void);
+void busLoadPoll(void);
+void busLoadGet(busLoadReport *report);
+uint8_t busLoadTop(busLoadId *ids);
+uint16_t busLoadKbps(void);
+
+#endif	/* BUS_LOAD_H */
@@ -14,6 +14,15 @@
 // Includes
 #include <xc.h>
 #include "can.h"
+#include "canQueue.h"
+#include "busLoad.h"
+#include "timeSync.h"
+#include "canOpen.h"
+#include "canWatch.h"
+
+// Asynchronous SPI path (see below): transmit buffers loaded and not yet seen sent.
+static volatile uint8_t canTxPending;          // CAN_BUSY_TXB bits
+static void canTxSeen(uint8_t loaded, uint8_t status);
 
 
 /*******************************************************************************
@@ -24,10 +33,10 @@
  *******************************************************************************/
 void mcp2515Reset(void)
 {
-    CS = 0;
+    MCP2515_SELECT();
     SPI_send(CAN_RESET);
     delayUS(20);
-    CS = 1 ;
+    MCP2515_DESELECT();
     
 } // end void mcp2515Reset(void) function
 
@@ -46,34 +55,320 @@ To use this function it is necessary to specify a registration address before
 } // end void mcp2515Send() function
 */
 
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515ReadStatus(void)
+ * Description: Reads the TXREQ and RXnIF flags of all buffers with the READ STATUS instruction
+ * (see STAT_xxx in REGS2515.h), a single 3 byte SPI transaction. The asynchronous loads it shows
+ * sent free their buffer for canSendAsyncId().
+ *******************************************************************************/
+uint8_t mcp2515ReadStatus(void)
+{
+    uint8_t status;
+    uint8_t loaded = canTxPending;              // Queued before the read: done when it starts
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_RD_STATUS);
+    status = SPI_receive();
+    MCP2515_DESELECT();
+    canTxSeen(loaded, status);
+    
+    return status;
+    
+} // end uint8_t mcp2515ReadStatus(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515RequestToSend(uint8_t txb)
+ * Description: Starts the transmission of the transmit buffer (txb, 0..2): a pulse on its TXnRTS
+ * pin with MCP2515_PIN_ASSIST, otherwise the RTS instruction.
+ *******************************************************************************/
+void mcp2515RequestToSend(uint8_t txb)
+{
+#if MCP2515_PIN_ASSIST
+    switch (txb)
+    {
+        case 1:
+            MCP_TX1RTS = 0;
+            MCP_TX1RTS = 1;
+            break;
+        case 2:
+            MCP_TX2RTS = 0;
+            MCP_TX2RTS = 1;
+            break;
+        default:
+            MCP_TX0RTS = 0;
+            MCP_TX0RTS = 1;
+            break;
+    }
+#else
+    MCP2515_SELECT();
+    SPI_send(CAN_RTS_TXB(txb));
+    MCP2515_DESELECT();
+#endif
+    
+} // end void mcp2515RequestToSend(uint8_t txb) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515RxPending(void)
+ * Description: Returns the receive buffers holding a message, as STAT_RX0IF | STAT_RX1IF. With 
+ * MCP2515_PIN_ASSIST they are read from the RX0BF/RX1BF pins instead of the READ STATUS instruction.
+ *******************************************************************************/
+uint8_t mcp2515RxPending(void)
+{
+#if MCP2515_PIN_ASSIST
+    uint8_t pending = 0;
+    
+    if (!MCP_RX0BF)
+        pending |= STAT_RX0IF;
+    if (!MCP_RX1BF)
+        pending |= STAT_RX1IF;
+    
+    return pending;
+#else
+    return (mcp2515ReadStatus() & (STAT_RX0IF | STAT_RX1IF));
+#endif
+    
+} // end uint8_t mcp2515RxPending(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data)
+ * Description: Loads a standard frame in the transmit buffer (txb, 0..2) and requests its
+ * transmission, identifier (id) << 3 (see mcp2515TxLoadId()).
+ *******************************************************************************/
+void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data)
+{
+    mcp2515TxLoadId(txb, id, 0x00, dlc, data);
+    
+} // end void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+ * Description: Loads a standard frame with the whole 11 bit identifier, (idh) << 3 | (idl) >> 5,
+ * in the transmit buffer (txb, 0..2) and requests its transmission. The LOAD TX BUFFER 
+ * instruction points straight at TXBnSIDH, so the header and the data go out in one 
+ * auto-increment burst, and RTS starts the transmission without a BIT MODIFY of TXBnCTRL.
+ * With CAN_RTR set in (dlc) a remote frame is sent: the DLC is kept but no data is loaded.
+ *******************************************************************************/
+void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+{
+    uint8_t lenght = dlc & CAN_DLC_MASK;
+    
+    if (lenght > DLC_8)
+        lenght = DLC_8;
+    dlc = (dlc & CAN_RTR) | lenght;
+    if (dlc & CAN_RTR)
+        lenght = 0;
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_LOAD_TXB_SIDH(txb));
+    SPI_send(idh);            // TXBnSIDH
+    SPI_send(idl & 0xE0);     // TXBnSIDL: standard identifier
+    SPI_send(0x00);           // TXBnEID8
+    SPI_send(0x00);           // TXBnEID0
+    SPI_send(dlc);            // TXBnDLC
+    for (uint8_t i = 0; i < lenght; i++)
+    {
+        SPI_send(data[i]);
+    }
+    MCP2515_DESELECT();
+    
+    mcp2515RequestToSend(txb);
+    
+} // end void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t mcp2515RxDlc(uint8_t sidl, uint8_t dlc)
+ * Description: Builds dataFrame.dlc from the RXBnSIDL and RXBnDLC registers: the data length
+ * (at most 8) and CAN_RTR for a remote frame (SIDL.SRR, or DLC.RTR for extended frames).
+ *******************************************************************************/
+static uint8_t mcp2515RxDlc(uint8_t sidl, uint8_t dlc)
+{
+    uint8_t lenght = dlc & CAN_DLC_MASK;
+    
+    if (lenght > DLC_8)
+        lenght = DLC_8;
+    
+    if ((sidl & EXIDE_SET) ? (dlc & DLC_RTR) : (sidl & SIDL_SRR))
+        lenght |= CAN_RTR;
+    
+    return lenght;
+    
+} // end static uint8_t mcp2515RxDlc(uint8_t sidl, uint8_t dlc) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515RxUnload(uint8_t rxb, dataFrame *frame)
+ * Description: Reads the message of the receive buffer (rxb, 0..1) in one READ RX BUFFER burst.
+ * Raising CS at the end clears RXnIF, releasing the buffer for the next message.
+ * A remote frame (SIDL.SRR, or DLC.RTR for extended frames) is returned with CAN_RTR set in 
+ * frame->dlc and no data.
+ *******************************************************************************/
+void mcp2515RxUnload(uint8_t rxb, dataFrame *frame)
+{
+    uint8_t header[5];                          // RXBnSIDH, SIDL, EID8, EID0, DLC
+    uint8_t lenght;
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_RD_RXB_SIDH(rxb));
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        header[i] = SPI_receive();
+    }
+    frame->idh = header[0];
+    frame->idl = header[1] & 0xE0;
+    lenght = header[4] & CAN_DLC_MASK;
+    if (lenght > DLC_8)
+        lenght = DLC_8;
+    
+    frame->dlc = mcp2515RxDlc(header[1], header[4]);
+    if (!(frame->dlc & CAN_RTR))
+    {
+        for (uint8_t i = 0; i < lenght; i++)
+        {
+            frame->data[i] = SPI_receive();
+        }
+    }
+    MCP2515_DESELECT();
+    
+#if BUS_LOAD
+    busLoadFrame(header, frame->data);
+#endif
+    
+} // end void mcp2515RxUnload(uint8_t rxb, dataFrame *frame) function
+
+
 /*******************************************************************************
  * FUNCTION: void mcp2515MessageSend(struct dataFrame *data);
- * Description: Sends a message to MCP2515 buffer 0.
+ * Description: Sends a message through the first free MCP2515 transmit buffer, waiting while all
+ * of them are pending. CAN_RTR_TXB is skipped while remote answers are registered.
  * The message is a data structure (dataFrame data) defined in can.h.
  *******************************************************************************/
 void mcp2515MessageSend(dataFrame *data)
 {
-    //TODO: Rewrite function to use all available buffers in MCP2515
+    uint8_t txb = 0xFF;
     
-    CS = 0;
-    SPI_send(CAN_WRITE);
-    SPI_send(TXB0SIDH);
-    SPI_send(data->idh);
-    SPI_send(TXB0DLC);
-    SPI_send(data->dlc);
-    for (uint8_t i=0; i < (data->dlc); i++)
+    while (txb == 0xFF)
     {
-        SPI_send(data->data[i]);
+        uint8_t status = mcp2515ReadStatus();
+        
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if (!(status & STAT_TXnREQ(i)) && !((i == CAN_RTR_TXB) && canRtrCount))
+            {
+                txb = i;
+                break;
+            }
+        }
     }
     
-    SPI_send(CAN_RTS);
-    mcp2515BitChange(TXB0CTRL, 0b00001000, 0b00001000);
-    
-    CS = 1;
+    mcp2515TxLoadId(txb, data->idh, data->idl, data->dlc, data->data);
     
 } // end void mcp2515MessageSend(struct dataFrame *data); function
 
 
+/*******************************************************************************
+ * Shadow copy of the MCP2515 configuration registers.
+ * Index 0x00..0x2F is the register address; 0x30..0x34 are TXB0CTRL..TXB2CTRL, RXB0CTRL and
+ * RXB1CTRL. mcp2515ShadowBits holds the bits only changed by this driver: 0xFF registers are read
+ * from RAM, partial ones (control registers with status bits) only save redundant BIT MODIFYs.
+ * Every write goes through to the chip.
+ *******************************************************************************/
+#define MCP2515_SHADOW_SIZE     0x35
+
+static const uint8_t mcp2515ShadowBits[MCP2515_SHADOW_SIZE] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF,   0xFF, 0xFF, 0xFF, 0xFF,   0xFF, 0xFF, 0xFF, 0xFF,   // RXF0-RXF2
+    0xFF, 0x07, 0x00, 0xFF,                                                     // BFPCTRL, TXRTSCTRL, CANSTAT, CANCTRL
+    0xFF, 0xFF, 0xFF, 0xFF,   0xFF, 0xFF, 0xFF, 0xFF,   0xFF, 0xFF, 0xFF, 0xFF,   // RXF3-RXF5
+    0x00, 0x00, 0x00, 0x00,                                                     // TEC, REC, CANSTAT, CANCTRL
+    0xFF, 0xFF, 0xFF, 0xFF,   0xFF, 0xFF, 0xFF, 0xFF,                           // RXM0-RXM1
+    0xFF, 0xFF, 0xFF, 0xFF,   0x00, 0x00, 0x00, 0x00,                           // CNF3-CNF1, CANINTE, CANINTF, EFLG
+    TXP, TXP, TXP,                                                              // TXBnCTRL
+    (RXM | BUKT), RXM                                                           // RXBnCTRL
+};
+
+static uint8_t mcp2515Shadow[MCP2515_SHADOW_SIZE];
+
+uint8_t mcp2515OpMode = OPMODE_CONFIG;          // Last operation mode confirmed by CANSTAT
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t mcp2515ShadowIndex(uint8_t address)
+ * Description: Returns the shadow index of a register address, or MCP2515_SHADOW_SIZE when the
+ * register has no shadow.
+ *******************************************************************************/
+static uint8_t mcp2515ShadowIndex(uint8_t address)
+{
+    if (address < TXB0CTRL)
+        return address;
+    
+    if (((address & 0x0F) == BUF_CTRL) && (address <= RXB1CTRL))
+        return (TXB0CTRL + (address >> 4) - 3);
+    
+    return MCP2515_SHADOW_SIZE;
+    
+} // end static uint8_t mcp2515ShadowIndex(uint8_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515ShadowSync(void)
+ * Description: Reloads the shadow registers from the chip. Needed after anything that changes the
+ * configuration behind the driver (a hardware reset, error recovery); mcp2515Start() rewrites every
+ * shadowed register and does not need it.
+ *******************************************************************************/
+void mcp2515ShadowSync(void)
+{
+    mcp2515ReadBurst(RXF0SIDH, mcp2515Shadow, TXB0CTRL);
+    for (uint8_t i = TXB0CTRL; i < MCP2515_SHADOW_SIZE; i++)
+    {
+        MCP2515_SELECT();
+        SPI_send(CAN_READ);
+        SPI_send((uint8_t)((i - TXB0CTRL + 3) << 4));
+        mcp2515Shadow[i] = SPI_receive();
+        MCP2515_DESELECT();
+    }
+    mcp2515OpMode = mcp2515Shadow[CANSTAT] & REQOP;
+    
+} // end void mcp2515ShadowSync(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515ShadowVerify(void)
+ * Description: Debug check (MCP2515_SHADOW_VERIFY): compares the shadowed bits with the chip.
+ * Returns the number of registers that differ.
+ *******************************************************************************/
+uint8_t mcp2515ShadowVerify(void)
+{
+    uint8_t errors = 0;
+    
+    for (uint8_t i = 0; i < MCP2515_SHADOW_SIZE; i++)
+    {
+        uint8_t address = (i < TXB0CTRL) ? i : (uint8_t)((i - TXB0CTRL + 3) << 4);
+        uint8_t bits = mcp2515ShadowBits[i];
+        uint8_t value;
+        
+        if (bits == 0)
+            continue;
+        
+        MCP2515_SELECT();
+        SPI_send(CAN_READ);
+        SPI_send(address);
+        value = SPI_receive();
+        MCP2515_DESELECT();
+        
+        if ((value ^ mcp2515Shadow[i]) & bits)
+            errors++;
+    }
+    
+    return errors;
+    
+} // end uint8_t mcp2515ShadowVerify(void) function
+
+
 /*******************************************************************************
  * FUNCTION: void mcp2515WriteRegister(uint8_t address, uint8_t value)
  * Description: It sends data (value) to a specific register (address) of the MCP2515 
@@ -81,11 +376,16 @@ void mcp2515MessageSend(dataFrame *data)
  *******************************************************************************/
 void mcp2515WriteRegister(uint8_t address, uint8_t value)
 {
-    CS = 0;
+    uint8_t index = mcp2515ShadowIndex(address);
+    
+    if (index < MCP2515_SHADOW_SIZE)
+        mcp2515Shadow[index] = value;
+    
+    MCP2515_SELECT();
     SPI_send(CAN_WRITE);
     SPI_send(address);
     SPI_send(value);
-    CS = 1;
+    MCP2515_DESELECT();
     
 } // end void mcp2515WriteRegister(uint8_t address, uint8_t value) function
 
@@ -93,25 +393,230 @@ void mcp2515WriteRegister(uint8_t address, uint8_t value)
 /***********************************************************************************************************************************************
  * FUNCTION: uint8_t mcp2515ReadRegister(uint8_t address)
  * Description: It reads and returns data (buffer variable) from a specific register (address) 
- * of the MCP2515.
+ * of the MCP2515. Configuration registers come from the shadow copy, without SPI.
  **********************************************************************************************************************************************/
 uint8_t mcp2515ReadRegister(uint8_t address)
 {
     uint8_t buffer;
-    CS  = 0;
+    uint8_t index = mcp2515ShadowIndex(address);
+    
+    if ((index < MCP2515_SHADOW_SIZE) && (mcp2515ShadowBits[index] == 0xFF))
+        return mcp2515Shadow[index];
+    
+    MCP2515_SELECT();
     SPI_send(CAN_READ);  //0x03   0b0000 0011
      
     SPI_send(address);
     buffer = SPI_receive();
-    CS = 1;
+    MCP2515_DESELECT();
     
     return buffer;
 }
 
 
 /***********************************************************************************************************************************************
- * FUNCTION: void mcp2515Start(void)
- * Description: Configures the MCP2515 module.
+ * Initialization table used by mcp2515Start().
+ * Each range is: start address, number of registers, register values. A range with 0 registers ends 
+ * the table. Every range is written with one auto-increment WRITE burst, so the ranges follow the 
+ * register map: RXF0-RXF2 run straight into BFPCTRL, and CNF3-CNF1 into CANINTE and CANINTF.
+ * TXRTSCTRL is written apart by mcp2515Start(): its upper bits read the pin levels and would fail
+ * the read-back.
+ **********************************************************************************************************************************************/
+static const uint8_t mcp2515InitTable[] =
+{
+    // RXF0SIDH..RXF2EID0 cleared, BFPCTRL: RXnBF pins as buffer full outputs or unused.
+    RXF0SIDH, 13,   0x00, 0x00, 0x00, 0x00,   0x00, 0x00, 0x00, 0x00,   0x00, 0x00, 0x00, 0x00,
+#if MCP2515_PIN_ASSIST
+                    (B1BFE | B0BFE | B1BFM | B0BFM),
+#else
+                    0x00,
+#endif
+    // RXF3SIDH..RXF5EID0 cleared.
+    RXF3SIDH, 12,   0x00, 0x00, 0x00, 0x00,   0x00, 0x00, 0x00, 0x00,   0x00, 0x00, 0x00, 0x00,
+    // RXM0SIDH..RXM1EID0 cleared.
+    RXM0SIDH, 8,    0x00, 0x00, 0x00, 0x00,   0x00, 0x00, 0x00, 0x00,
+    // Bit timing (125 Kbps, see mcp2515Start()), CANINTE and CANINTF.
+    CNF3, 5,        0xC5, 0xF1, 0x01, 0x00, 0x00,
+    // Transmit buffers priority.
+    TXB0CTRL, 1,    0x00,
+    TXB1CTRL, 1,    0x00,
+    TXB2CTRL, 1,    0x00,
+    // Turns mask/filters off; receives any message.
+    RXB0CTRL, 1,    0x60,
+    RXB1CTRL, 1,    0x60,
+    0x00, 0
+};
+
+#define MCP2515_INIT_RANGE_MAX  13      // Longest range of mcp2515InitTable
+
+// Registers held by an mcp2515Setup, in the order of the structure: address, number of registers.
+static const uint8_t mcp2515SetupMap[][2] =
+{
+    { RXF0SIDH, 12 },
+    { RXF3SIDH, 12 },
+    { RXM0SIDH, 8 },
+    { CNF3, 3 },
+    { RXB0CTRL, 1 },
+    { RXB1CTRL, 1 },
+};
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count)
+ * Description: Writes (count) consecutive registers, starting at (address), in one WRITE instruction.
+ **********************************************************************************************************************************************/
+void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        uint8_t index = mcp2515ShadowIndex(address + i);
+        
+        if (index < MCP2515_SHADOW_SIZE)
+            mcp2515Shadow[index] = values[i];
+    }
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_WRITE);
+    SPI_send(address);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        SPI_send(values[i]);
+    }
+    MCP2515_DESELECT();
+    
+} // end void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count)
+ * Description: Reads (count) consecutive registers, starting at (address), in one READ instruction.
+ **********************************************************************************************************************************************/
+void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count)
+{
+    MCP2515_SELECT();
+    SPI_send(CAN_READ);
+    SPI_send(address);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        values[i] = SPI_receive();
+    }
+    MCP2515_DESELECT();
+    
+} // end void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count)
+ * Description: Reads back (count) consecutive registers and compares them with (values).
+ * Returns MCP2515_OK or MCP2515_ERR_VERIFY.
+ **********************************************************************************************************************************************/
+uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count)
+{
+    uint8_t result = MCP2515_OK;
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_READ);
+    SPI_send(address);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (SPI_receive() != values[i])
+            result = MCP2515_ERR_VERIFY;
+    }
+    MCP2515_DESELECT();
+    
+    return result;
+    
+} // end uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515WaitMode(uint8_t opmode)
+ * Description: Polls CANSTAT until the MCP2515 reports the operation mode (opmode, OPMODE_xxx).
+ * The mode change only completes at the end of a bus frame, so the wait is bounded by 
+ * MCP2515_MODE_TIMEOUT polls instead of a fixed delay.
+ * Returns MCP2515_OK or MCP2515_ERR_MODE on timeout.
+ **********************************************************************************************************************************************/
+uint8_t mcp2515WaitMode(uint8_t opmode)
+{
+    for (uint16_t i = 0; i < MCP2515_MODE_TIMEOUT; i++)
+    {
+        if ((mcp2515ReadRegister(CANSTAT) & REQOP) == opmode)
+        {
+            mcp2515OpMode = opmode;
+            return MCP2515_OK;
+        }
+    }
+    
+    return MCP2515_ERR_MODE;
+    
+} // end uint8_t mcp2515WaitMode(uint8_t opmode) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515SetMode(uint8_t opmode)
+ * Description: Requests the operation mode (opmode, OPMODE_xxx) and waits for it (mcp2515WaitMode()).
+ * Returns MCP2515_OK or MCP2515_ERR_MODE.
+ **********************************************************************************************************************************************/
+uint8_t mcp2515SetMode(uint8_t opmode)
+{
+    mcp2515BitChange(CANCTRL, REQOP, opmode);
+    
+    return mcp2515WaitMode(opmode);
+    
+} // end uint8_t mcp2515SetMode(uint8_t opmode) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void mcp2515SetupApply(const mcp2515Setup *setup, uint8_t address, uint8_t *values, uint8_t count)
+ * Description: Replaces, in the (count) register values starting at (address), the ones held by (setup).
+ **********************************************************************************************************************************************/
+static void mcp2515SetupApply(const mcp2515Setup *setup, uint8_t address, uint8_t *values, uint8_t count)
+{
+    const uint8_t *source = (const uint8_t *)setup;
+    
+    for (uint8_t i = 0; i < sizeof(mcp2515SetupMap) / sizeof(mcp2515SetupMap[0]); i++)
+    {
+        for (uint8_t j = 0; j < mcp2515SetupMap[i][1]; j++)
+        {
+            uint8_t offset = (uint8_t)(mcp2515SetupMap[i][0] + j - address);
+            
+            if (offset < count)
+                values[offset] = *source;
+            source++;
+        }
+    }
+    
+} // end static void mcp2515SetupApply(const mcp2515Setup *setup, uint8_t address, uint8_t *values, uint8_t count) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515SetupRead(mcp2515Setup *setup)
+ * Description: Copies the bit timing, filters, masks and receive modes in use to (setup), from the
+ * shadow copy (no SPI). Used to store the configuration after it was worked out (canAutobaud(),
+ * mcp2515SetFilter(), ...).
+ **********************************************************************************************************************************************/
+void mcp2515SetupRead(mcp2515Setup *setup)
+{
+    uint8_t *target = (uint8_t *)setup;
+    
+    for (uint8_t i = 0; i < sizeof(mcp2515SetupMap) / sizeof(mcp2515SetupMap[0]); i++)
+    {
+        for (uint8_t j = 0; j < mcp2515SetupMap[i][1]; j++)
+            *target++ = mcp2515Shadow[mcp2515ShadowIndex(mcp2515SetupMap[i][0] + j)];
+    }
+    
+} // end void mcp2515SetupRead(mcp2515Setup *setup) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515StartWith(const mcp2515Setup *setup)
+ * Description: Configures the MCP2515 module from mcp2515InitTable, with the registers held by 
+ * (setup) in place of the table values when (setup) is given (not 0): a stored configuration
+ * (eeConfig.h) goes in with the same bursts as the defaults, without a second pass. The defaults
+ * are read back; a setup is not, which halves the SPI traffic of the start: it was CRC checked
+ * when loaded, and a missing MCP2515 already fails the wait for configuration mode.
+ * Returns MCP2515_OK, MCP2515_ERR_MODE if a mode change timed out or MCP2515_ERR_VERIFY if a 
+ * register did not read back as written.
  * 
  * Based on MCP2515 CAN Controller IC and TJA1050 CAN Transceiver IC Datasheet.
  * FOSC  8 MHz                                                       * Tfosc =  /  MHz = 1.25 us
@@ -135,106 +640,294 @@ uint8_t mcp2515ReadRegister(uint8_t address)
  *	CNF3 => 0xC5 // 0b1 1 000 101 SOF = 1; WAKFIL = 1; PHSEG2 [PS2] = 5.
  * 
  **********************************************************************************************************************************************/
-void mcp2515Start(void)
+uint8_t mcp2515StartWith(const mcp2515Setup *setup)
 {
     //TODO: Redo the settings for 250 or 500 Kbps, according to the SAE J1939 standard.
     
-    delayMS(20);
+    // The PIC power-up timer (PWRT = ON) already covers the MCP2515 oscillator start-up, so
+    // there is no fixed delay here: the reset is followed by polling CANSTAT.
     mcp2515Reset();
-    delayUS(20);
-    mcp2515BitChange(CANCTRL, (0b11100000), (0b01000000));
-    delayUS(20);
-    
-    while (getMode() != 0x02);
-   
-    // Bit timing set. CNF1, CNF2, CNF3 registers
-    mcp2515WriteRegister(CNF1, 0x01);
-    mcp2515WriteRegister(CNF2, 0xF1);
-    mcp2515WriteRegister(CNF3, 0xC5); 
-    
-    // TXRTSCTRL register
-    mcp2515WriteRegister(TXB0CTRL, 0x00);
-    mcp2515WriteRegister(TXB1CTRL, 0x00);
-    mcp2515WriteRegister(TXB2CTRL, 0x00);
     
-    // Filter registers control
-    mcp2515WriteRegister(RXB0CTRL, 0x60); // Turns mask/filters off; receives any message.
-    mcp2515WriteRegister(RXB1CTRL, 0x60); // Turns mask/filters off; receives any message.
-    mcp2515WriteRegister(BFPCTRL, 0x00);  
+    if (mcp2515WaitMode(OPMODE_CONFIG) != MCP2515_OK)
+        return MCP2515_ERR_MODE;
     
-    // Clear filters registers
-    for (uint8_t i =0; i < 12; i++)
-        mcp2515WriteRegister((RXF0SIDH + i), 0x00);
-    
-    for (uint8_t i = 0; i < 12; i++)
-        mcp2515WriteRegister((RXF3SIDH + i), 0x00);
+    // The table rewrites every shadowed register, which also brings the shadow copy in step
+    // with the reset chip.
+    for (const uint8_t *range = mcp2515InitTable; range[1] != 0; range += range[1] + 2)
+    {
+        uint8_t values[MCP2515_INIT_RANGE_MAX];
+        
+        for (uint8_t i = 0; i < range[1]; i++)
+            values[i] = range[2 + i];
+        if (setup)
+            mcp2515SetupApply(setup, range[0], values, range[1]);
+        
+        mcp2515WriteBurst(range[0], values, range[1]);
+        
+        if (!setup && (mcp2515VerifyBurst(range[0], values, range[1]) != MCP2515_OK))
+            return MCP2515_ERR_VERIFY;
+    }
     
-    // Mask registers            
-    for (uint8_t i = 0; i < 8; i++)
-         mcp2515WriteRegister((RXM0SIDH + i), 0x00);
+#if MCP2515_PIN_ASSIST
+    // TX0RTS-TX2RTS request the transmission of their buffer.
+    mcp2515WriteRegister(TXRTSCTRL, (TXB2RTS | TXB1RTS | TXB0RTS));
+#endif
     
     // Set Operation Mode, mask = 1110 0000 = 0xE0
     // Loopback mode 0100 0000 0x40
     // Normal mode 00000100
-    mcp2515BitChange(CANCTRL, (0b11111111), (0b00000100));
-    while (getMode() != 0x00);
+    mcp2515WriteRegister(CANCTRL, (REQOP_NORMAL | CLKOUT_ENABLED));
+    if (mcp2515WaitMode(OPMODE_NORMAL) != MCP2515_OK)
+        return MCP2515_ERR_MODE;
+    
     LATBbits.LATB7 = 0;
     
-} // end void mcp2515Start(void); function
+    return MCP2515_OK;
+    
+} // end uint8_t mcp2515StartWith(const mcp2515Setup *setup) function
 
 
-/*******************************************************************************
- * FUNCTION: void mcp2515MessageRead(dataFrame *data)
- * Description: Read data from the receiving registers (buffer 0 and buffer 1) of the MCP2515 module 
- * and store it in a variable of type structure (dataFrame data)
- *******************************************************************************/
-void mcp2515MessageRead(uint8_t id, dataFrame *data)
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515Start(void)
+ * Description: Configures the MCP2515 module with the defaults of mcp2515InitTable (mcp2515StartWith()).
+ **********************************************************************************************************************************************/
+uint8_t mcp2515Start(void)
 {
-    CS = 0;
+    return mcp2515StartWith(0);
+    
+} // end uint8_t mcp2515Start(void); function
+
+
+/***********************************************************************************************************************************************
+ * Bit timing for each CAN_BITRATE_xxx, in register order CNF3, CNF2, CNF1 (8 MHz oscillator).
+ * 125 Kbps: BRP = 1, 16 TQ, sampling at 62.5% (see mcp2515Start()).
+ * 250 Kbps: BRP = 0, 16 TQ, same segments as 125 Kbps.
+ * 500 Kbps: BRP = 0, 8 TQ: PRSEG = 2 TQ, PS1 = 3 TQ, PS2 = 2 TQ, single sample, sampling at 75%.
+ **********************************************************************************************************************************************/
+static const uint8_t mcp2515BitTiming[CAN_BITRATES][3] =
+{
+    { 0xC5, 0xF1, 0x01 },   // 125 Kbps
+    { 0xC5, 0xF1, 0x00 },   // 250 Kbps
+    { 0xC1, 0x91, 0x00 },   // 500 Kbps
+};
+
+static uint8_t mcp2515SavedMode;       // Operation mode restored by mcp2515ConfigEnd()
+static uint16_t mcp2515OfflineStart;   // timerMicros() when configuration mode was requested
+static uint16_t mcp2515OfflineUs;      // Duration of the last reconfiguration
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515ConfigBegin(void)
+ * Description: Saves the current operation mode and puts the MCP2515 in configuration mode without
+ * a reset, so the transmit and receive buffers and every register not rewritten are kept.
+ * Use the mcp2515SetXxx() functions and then mcp2515ConfigEnd().
+ * Returns MCP2515_OK or MCP2515_ERR_MODE.
+ **********************************************************************************************************************************************/
+uint8_t mcp2515ConfigBegin(void)
+{
+    mcp2515SavedMode = mcp2515OpMode;
+    mcp2515OfflineStart = timerMicros();
+    
+    return mcp2515SetMode(OPMODE_CONFIG);
+    
+} // end uint8_t mcp2515ConfigBegin(void) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t mcp2515ConfigEnd(void)
+ * Description: Returns to the operation mode saved by mcp2515ConfigBegin() and records how long the 
+ * node was off the bus (see mcp2515OfflineTime()).
+ * Returns MCP2515_OK or MCP2515_ERR_MODE.
+ **********************************************************************************************************************************************/
+uint8_t mcp2515ConfigEnd(void)
+{
+    uint8_t result;
+    
+    result = mcp2515SetMode(mcp2515SavedMode);
+    mcp2515OfflineUs = timerMicros() - mcp2515OfflineStart;
+    
+    return result;
+    
+} // end uint8_t mcp2515ConfigEnd(void) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint16_t mcp2515OfflineTime(void)
+ * Description: Returns the time, in microseconds, between the last mcp2515ConfigBegin() and 
+ * mcp2515ConfigEnd(). Reconfigurations longer than 65 ms wrap around.
+ **********************************************************************************************************************************************/
+uint16_t mcp2515OfflineTime(void)
+{
+    return mcp2515OfflineUs;
+    
+} // end uint16_t mcp2515OfflineTime(void) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515SetBitrate(uint8_t bitrate)
+ * Description: Writes CNF3, CNF2 and CNF1 for the bit rate (CAN_BITRATE_xxx) in one burst.
+ * Configuration mode only.
+ **********************************************************************************************************************************************/
+void mcp2515SetBitrate(uint8_t bitrate)
+{
+    if (bitrate < CAN_BITRATES)
+        mcp2515WriteBurst(CNF3, mcp2515BitTiming[bitrate], 3);
     
-    if ((mcp2515ReadRegister(RXB0SIDH)) == id)
+} // end void mcp2515SetBitrate(uint8_t bitrate) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515SetFilter(uint8_t filter, uint8_t id)
+ * Description: Sets the acceptance filter (filter, 0..5) to the standard identifier (id), the same 
+ * SIDH byte used by canSend() and canRead(). Configuration mode only.
+ **********************************************************************************************************************************************/
+void mcp2515SetFilter(uint8_t filter, uint8_t id)
+{
+    uint8_t value[2] = { id, 0x00 };   // RXFnSIDH, RXFnSIDL (EXIDE = 0)
+    
+    if (filter < 6)
+        mcp2515WriteBurst(RXFn_BASE(filter), value, 2);
+    
+} // end void mcp2515SetFilter(uint8_t filter, uint8_t id) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515SetMask(uint8_t mask, uint8_t id)
+ * Description: Sets the acceptance mask (mask, 0..1) bits compared in SIDH. The 3 low bits of the
+ * identifier (SIDL) are left as don't care. Configuration mode only.
+ **********************************************************************************************************************************************/
+void mcp2515SetMask(uint8_t mask, uint8_t id)
+{
+    uint8_t value[2] = { id, 0x00 };   // RXMnSIDH, RXMnSIDL
+    
+    if (mask < 2)
+        mcp2515WriteBurst(RXMn_BASE(mask), value, 2);
+    
+} // end void mcp2515SetMask(uint8_t mask, uint8_t id) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm)
+ * Description: Selects how the receive buffer (rxb, 0..1) uses the filters (RXM_xxx in REGS2515.h).
+ * RXM_RCV_ALL turns the mask/filters off.
+ **********************************************************************************************************************************************/
+void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm)
+{
+    if (rxb < 2)
+        mcp2515BitChange(RXBnCTRL(rxb), RXM, rxm);
+    
+} // end void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t canAutobaud(void)
+ * Description: Listens to the bus at each supported bit rate, in listen-only mode so the node never 
+ * disturbs the bus with error frames, and keeps the first bit rate that receives a valid message 
+ * without a message error (MERRF). Each bit rate is listened to for CAN_AUTOBAUD_WINDOW_MS.
+ * The receive buffers and the previous operation mode are preserved.
+ * Returns the detected CAN_BITRATE_xxx or CAN_BITRATE_NONE (bit timing left unchanged).
+ **********************************************************************************************************************************************/
+uint8_t canAutobaud(void)
+{
+    uint8_t previous[3];
+    uint8_t found = CAN_BITRATE_NONE;
+    
+    uint8_t interrupt = canIntEnabled;
+    
+    // canService() would empty the receive buffers before CANINTF is checked here.
+    canIntEnabled = 0;
+    INTCON3bits.INT2IE = 0;
+    
+    if (mcp2515ConfigBegin() != MCP2515_OK)
     {
-        data->idh = id;
-        data->dlc = mcp2515ReadRegister(RXB0DLC);
-        
-        for (uint8_t i = 0; i < (data->dlc); i++)
-        {
-            data->data[i] = mcp2515ReadRegister(RXB0D0);
-        }
+        canIntEnabled = interrupt;
+        INTCON3bits.INT2IE = interrupt;
+        return CAN_BITRATE_NONE;
     }
-    else if ((mcp2515ReadRegister(RXB1SIDH)) == id )
+    
+    mcp2515ReadBurst(CNF3, previous, 3);
+    
+    for (uint8_t bitrate = 0; (bitrate < CAN_BITRATES) && (found == CAN_BITRATE_NONE); bitrate++)
     {
-        data->idh = id;
-        data->dlc = mcp2515ReadRegister(RXB1DLC);
+        uint16_t last;
+        uint16_t elapsed = 0;
         
-        for (uint8_t i = 0; i < (data->dlc); i++)
-        {
-            data->data[i] = mcp2515ReadRegister(RXB1D0);
-        }        
+        if (mcp2515SetMode(OPMODE_CONFIG) != MCP2515_OK)
+            break;
+        mcp2515SetBitrate(bitrate);
+        mcp2515BitChange(CANINTF, (MERRF | RX1IF | RX0IF), 0x00);
+        if (mcp2515SetMode(OPMODE_LISTEN) != MCP2515_OK)
+            break;
         
+        last = timerMicros();
+        while (elapsed < CAN_AUTOBAUD_WINDOW_MS)
+        {
+            uint8_t flags = mcp2515ReadRegister(CANINTF);
+            
+            if (flags & MERRF)
+                break;                       // Wrong bit rate: keep trying the next one
+            if (flags & (RX1IF | RX0IF))
+            {
+                found = bitrate;
+                break;
+            }
+            
+            elapsed += timerMillisTick(&last);
+        }
     }
-    else 
-        data->idh = 0xFF;
+    
+    mcp2515SetMode(OPMODE_CONFIG);
+    if (found == CAN_BITRATE_NONE)
+        mcp2515WriteBurst(CNF3, previous, 3);
+    mcp2515BitChange(CANINTF, MERRF, 0x00);
+    mcp2515ConfigEnd();
+    
+    canIntEnabled = interrupt;
+    INTCON3bits.INT2IE = interrupt;
+    
+    return found;
+    
+} // end uint8_t canAutobaud(void) function
+
 
-    CS = 1;    
+/*******************************************************************************
+ * FUNCTION: void mcp2515MessageRead(dataFrame *data)
+ * Description: Takes the oldest received message with identifier (id) from the receive queue
+ * and store it in a variable of type structure (dataFrame data). data->idh is 0xFF when there
+ * is no such message. A remote frame is reported with CAN_RTR set in data->dlc and no data (all 0).
+ *******************************************************************************/
+void mcp2515MessageRead(uint8_t id, dataFrame *data)
+{
+    if (!canRxTake(id, data))
+        data->idh = 0xFF;
     
 } // end void mcp2515MessageRead(dataFrame *data) function
 
 /*******************************************************************************
  * FUNCTION: mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew)
  * Description: Change the state of one or more bits of a register (addressReg) as selected in the 
- * mask (maskBit) to a new state (valueNew).
+ * mask (maskBit) to a new state (valueNew). Nothing is sent when the shadow copy shows the bits
+ * already in that state.
  *******************************************************************************/
 void  mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew)
 {
-    	CS = 0;
-	
-	SPI_send(CAN_BIT_MODIFY);
-	SPI_send(addressReg);
-	SPI_send(maskBit);
-	SPI_send(valueNew);
-	
-	CS = 1;
+    uint8_t index = mcp2515ShadowIndex(addressReg);
+    
+    if (index < MCP2515_SHADOW_SIZE)
+    {
+        uint8_t bits = mcp2515ShadowBits[index];
+        
+        if (!(maskBit & ~bits) && !((mcp2515Shadow[index] ^ valueNew) & maskBit))
+            return;
+        mcp2515Shadow[index] = (mcp2515Shadow[index] & ~maskBit) | (valueNew & maskBit);
+    }
+    
+    MCP2515_SELECT();
+    SPI_send(CAN_BIT_MODIFY);
+    SPI_send(addressReg);
+    SPI_send(maskBit);
+    SPI_send(valueNew);
+    MCP2515_DESELECT();
 }
 
 /***********************************************************************************************************************************************
@@ -245,83 +938,479 @@ void  mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew)
  *******************************************************************************/
 void canSend(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data)
 {
-    CS = 0;
-    SPI_send(CAN_WRITE);
+    if (txb > 2)
+        txb = 0;
     
-    switch (txb)
-    {
-        case 1:
-            SPI_send(TXB1SIDH);
-            SPI_send(id);
-            SPI_send(TXB1DLC);
-            SPI_send(lenght);
-            for (uint8_t i = 0; i < (lenght); i++)
-            {
-                SPI_send(data[i]);
-            }
-            SPI_send(CAN_RTS);
-            mcp2515BitChange(TXB1CTRL, 0b00001000, 0b00001000);            
-            break;
-        case 2:
-            SPI_send(TXB2SIDH);
-            SPI_send(id);
-            SPI_send(TXB2DLC);
-            SPI_send(lenght);
-            for (uint8_t i = 0; i < (lenght); i++)
-            {
-                SPI_send(data[i]);
-            }
-            SPI_send(CAN_RTS);
-            mcp2515BitChange(TXB2CTRL, 0b00001000, 0b00001000);            
-            break;
-        default:
-            SPI_send(TXB0SIDH);
-            SPI_send(id);
-            SPI_send(TXB0DLC);
-            SPI_send(lenght);
-            for (uint8_t i = 0; i < (lenght); i++)
-            {
-                SPI_send(data[i]);
-            }
-            SPI_send(CAN_RTS);
-            mcp2515BitChange(TXB0CTRL, 0b00001000, 0b00001000);
-            break;   
-    }    
-    CS = 1;
+    mcp2515TxLoad(txb, id, lenght, data);
     
 } // end void canSend(uint8_t id, uint8_t lenght, uint8_t *data) function
 
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght)
+ * Description: Requests the message with identifier (id) and size (lenght) from the CAN network
+ * with a remote frame sent through the register (txb). The answer arrives as a normal message.
+ *******************************************************************************/
+void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght)
+{
+    if (txb > 2)
+        txb = 0;
+    
+    mcp2515TxLoad(txb, id, (CAN_RTR | lenght), 0);
+    
+} // end void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght) function
+
  /***********************************************************************************************************************************************
  * FUNCTION: void canRead(uint8_t id, uint8_t lenght, uint8_t *data)
-  * Description: Searches the MCP2515 module receipt records by the specific identifier (id) and copies 
-  * the message to the specific variable (data).
+  * Description: Searches the receive queue by the specific identifier (id) and copies 
+  * the message to the specific variable (data). Remote frames with that identifier, which
+  * carry no data, are taken and skipped; (data) keeps its values when no data frame is left.
   * The data variable is a predefined array.
  *******************************************************************************/
 void canRead(uint8_t id, uint8_t *data)
  {
-    uint8_t lenght = 0;
-    if ((mcp2515ReadRegister(RXB0SIDH)) == id)
+    dataFrame frame;
+    
+    while (canRxTake(id, &frame))
     {
-        lenght = mcp2515ReadRegister(RXB0DLC);
-        
-        for (uint8_t i = 0; i < (lenght); i++)
+        if (frame.dlc & CAN_RTR)
+            continue;
+        for (uint8_t i = 0; i < (frame.dlc & CAN_DLC_MASK); i++)
         {
-            data[i] = mcp2515ReadRegister(RXB0D0);
+            data[i] = frame.data[i];
         }
+        break;
     }
-    else if ((mcp2515ReadRegister(RXB1SIDH)) == id )
+    
+ } // end void canRead(uint8_t id, uint8_t lenght, uint8_t *data) function
+
+
+/***********************************************************************************************************************************************
+ * Receive path: canService() (INT2 interrupt) fills the receive queue and answers the registered remote
+ * frames (canQueue.c); the read functions are the only consumer.
+ **********************************************************************************************************************************************/
+volatile uint8_t canIntEnabled;                // INT2 interrupt in use (see MCP2515_DESELECT())
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void canInterruptEnable(void)
+ * Description: Enables the MCP2515 receive interrupts (INT pin) and the PIC INT2 interrupt on its 
+ * falling edge. From now on messages are received by canService().
+ **********************************************************************************************************************************************/
+void canInterruptEnable(void)
+{
+    // INT2IF is cleared before CANINTE is written: a message already waiting (canAutobaud()
+    // leaves the one it found) pulls INT low at once, and that edge must not be lost.
+    INTCON2bits.INTEDG2 = 0;   // MCP2515 INT is active low
+    INTCON3bits.INT2IF = 0;
+    mcp2515WriteRegister(CANINTE, (RX1IE | RX0IE));
+    
+    canIntEnabled = 1;
+    INTCON3bits.INT2IE = 1;
+    
+} // end void canInterruptEnable(void) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static uint8_t canRtrAnswer(const dataFrame *frame)
+ * Description: Loads the registered answer for the remote frame (frame) in CAN_RTR_TXB, with its 
+ * whole 11 bit identifier. Returns 1 when the remote frame was answered.
+ **********************************************************************************************************************************************/
+static uint8_t canRtrAnswer(const dataFrame *frame)
+{
+    const canRtrEntry *answer = canRtrFind(frame);
+    
+    if (!answer)
+        return 0;
+    if (mcp2515ReadStatus() & STAT_TXnREQ(CAN_RTR_TXB))
     {
-        data = id;
-        lenght = mcp2515ReadRegister(RXB1DLC);
-        
-        for (uint8_t i = 0; i < (lenght); i++)
+        canRtrMissed++;
+        return 0;
+    }
+    
+    mcp2515TxLoadId(CAN_RTR_TXB, frame->idh, frame->idl, answer->dlc, answer->data);
+    canRtrAnswered++;
+    
+    return 1;
+    
+} // end static uint8_t canRtrAnswer(const dataFrame *frame) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void canService(void)
+ * Description: Empties the MCP2515 receive buffers into the receive queue, answering the registered
+ * remote frames directly. Called by the INT2 interrupt, or by the read functions when the interrupt
+ * is not enabled. It loops until both buffers are empty so the INT pin goes back high and the next 
+ * message produces a new edge.
+ **********************************************************************************************************************************************/
+void canService(void)
+{
+    uint8_t pending;
+    
+    while ((pending = mcp2515RxPending()) != 0)
+    {
+        for (uint8_t rxb = 0; rxb < 2; rxb++)
         {
-            data[i] = mcp2515ReadRegister(RXB1D0);
-        }        
+            if (pending & STAT_RXnIF(rxb))
+            {
+                dataFrame received;
+                dataFrame *frame = &received;
+                
+                mcp2515RxUnload(rxb, frame);
+#if CAN_WATCH
+                canWatchReceive(frame);
+#endif
+#if TIME_SYNC
+                if ((frame->idh == TIME_SYNC_IDH) && !frame->idl)
+                    timeSyncStamp(frame);
+#endif
+#if CANOPEN
+                if (canOpenReceive(frame))
+                    continue;
+#endif
+                
+                if ((frame->dlc & CAN_RTR) && canRtrCount && canRtrAnswer(frame))
+                    continue;
+                
+                canRxStore(frame);
+            }
+        }
+    }
+    
+} // end void canService(void) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t canReceive(dataFrame *frame)
+ * Description: Takes the oldest message of the receive queue. Returns 0 when the queue is empty.
+ **********************************************************************************************************************************************/
+uint8_t canReceive(dataFrame *frame)
+{
+    if (!canIntEnabled)
+        canService();
+    
+    return canRxFetch(frame) != CAN_RX_NONE;
+    
+} // end uint8_t canReceive(dataFrame *frame) function
+
+
+/***********************************************************************************************************************************************
+ * Asynchronous SPI path (CAN_SPI_ASYNC). Each MCP2515 buffer owns a transfer descriptor and its raw
+ * register image: [instruction][SIDH][SIDL][EID8][EID0][DLC][D0..D7]. The SSP interrupt runs the
+ * transfers back to back while the main program runs; the flags below mark the descriptors in use.
+ **********************************************************************************************************************************************/
+#define CAN_RAW_SIZE            14
+#define CAN_BUSY_STATUS         0x80                    // canAsyncBusy: READ STATUS queued
+#define CAN_BUSY_RXB(n)         (0x01 << (n))           // canAsyncBusy: RXBn being read
+#define CAN_BUSY_TXB(n)         (0x04 << (n))           // canAsyncBusy: TXBn being loaded
+
+static uint8_t canStatusRaw[2];
+static uint8_t canRxRaw[2][CAN_RAW_SIZE];
+static uint8_t canTxRaw[3][CAN_RAW_SIZE];
+static uint8_t canRtsRaw[3][1];
+static spiTransfer canStatusTransfer;
+static spiTransfer canRxTransfer[2];
+static spiTransfer canTxTransfer[3];
+static spiTransfer canRtsTransfer[3];
+static volatile uint8_t canAsyncBusy;
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void canTxDone(spiTransfer *transfer)
+ * Description: Completion of the last transfer of a transmit buffer: with MCP2515_PIN_ASSIST the load
+ * itself, which is followed by the TXnRTS pulse; otherwise the RTS instruction.
+ **********************************************************************************************************************************************/
+static void canTxDone(spiTransfer *transfer)
+{
+#if MCP2515_PIN_ASSIST
+    uint8_t txb = (uint8_t)(transfer - canTxTransfer);
+    
+    mcp2515RequestToSend(txb);
+#else
+    uint8_t txb = (uint8_t)(transfer - canRtsTransfer);
+#endif
+    
+    canAsyncBusy &= ~CAN_BUSY_TXB(txb);
+    
+} // end static void canTxDone(spiTransfer *transfer) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static uint8_t canTxQueue(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+ * Description: Copies the message to the transfer image of (txb) and queues its load and request to
+ * the SPI engine. (txb) stays in canTxPending until a READ STATUS shows it sent (canTxSeen()).
+ * Returns MCP2515_OK or MCP2515_ERR_BUSY while the previous load of (txb) is queued or not seen sent.
+ **********************************************************************************************************************************************/
+static uint8_t canTxQueue(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+{
+    uint8_t *raw;
+    uint8_t count;
+    uint8_t gie = INTCONbits.GIE;
+    
+    // The SSP interrupt clears the other busy flags meanwhile.
+    INTCONbits.GIE = 0;
+    if ((canAsyncBusy | canTxPending) & CAN_BUSY_TXB(txb))
+    {
+        INTCONbits.GIE = gie;
+        return MCP2515_ERR_BUSY;
+    }
+    canAsyncBusy |= CAN_BUSY_TXB(txb);
+    canTxPending |= CAN_BUSY_TXB(txb);
+    INTCONbits.GIE = gie;
+    
+    count = lenght & CAN_DLC_MASK;
+    if (count > DLC_8)
+        count = DLC_8;
+    lenght = (lenght & CAN_RTR) | count;
+    if (lenght & CAN_RTR)
+        count = 0;
+    
+    raw = canTxRaw[txb];
+    raw[0] = CAN_LOAD_TXB_SIDH(txb);
+    raw[BUF_SIDH] = idh;
+    raw[BUF_SIDL] = idl & 0xE0;
+    raw[BUF_EID8] = 0x00;
+    raw[BUF_EID0] = 0x00;
+    raw[BUF_DLC] = lenght;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        raw[BUF_D0 + i] = data[i];
+    }
+    
+    canTxTransfer[txb].buffer = raw;
+    canTxTransfer[txb].length = BUF_D0 + count;
+    canTxTransfer[txb].cs = SPI_CS_MCP2515;
+#if MCP2515_PIN_ASSIST
+    canTxTransfer[txb].done = canTxDone;
+    SPI_submit(&canTxTransfer[txb]);
+#else
+    canTxTransfer[txb].done = 0;
+    canRtsRaw[txb][0] = CAN_RTS_TXB(txb);
+    canRtsTransfer[txb].buffer = canRtsRaw[txb];
+    canRtsTransfer[txb].length = 1;
+    canRtsTransfer[txb].cs = SPI_CS_MCP2515;
+    canRtsTransfer[txb].done = canTxDone;
+    SPI_submit(&canTxTransfer[txb]);
+    SPI_submit(&canRtsTransfer[txb]);
+#endif
+    
+    return MCP2515_OK;
+    
+} // end static uint8_t canTxQueue(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+ * Description: Same as canSend(), but the message is copied and queued to the SPI engine and the 
+ * function returns at once; loads of different buffers follow each other without the CPU waiting.
+ * The identifier is the whole 11 bits, (idh) << 3 | (idl) >> 5, as in mcp2515TxLoadId().
+ * CAN_RTR in (lenght) sends a remote frame.
+ * A buffer whose last load has not been seen sent (TXREQ clear) since is checked with a READ STATUS
+ * first, so a frame waiting for arbitration is never overwritten. Main program only: the receive
+ * path uses canAnswerAsync().
+ * Returns MCP2515_OK or MCP2515_ERR_BUSY while the previous message of (txb) is queued or not sent.
+ **********************************************************************************************************************************************/
+uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+{
+    if (txb > 2)
+        txb = 0;
+    if (canTxPending & CAN_BUSY_TXB(txb))
+        mcp2515ReadStatus();
+    
+    return canTxQueue(txb, idh, idl, lenght, data);
+    
+} // end uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data)
+ * Description: canSendAsyncId() for the identifiers of the idh API (SIDL = 0).
+ **********************************************************************************************************************************************/
+uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data)
+{
+    return canSendAsyncId(txb, id, 0x00, lenght, data);
+    
+} // end uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+ * Description: canSendAsyncId() for the receive path (canRxDone() and its hooks): the message is not 
+ * loaded while (txb) still holds the previous one, until a READ STATUS of the receive path or of the
+ * main program sees it sent. Nothing waits: one READ STATUS precedes every batch of receive buffer reads.
+ * Returns MCP2515_OK or MCP2515_ERR_BUSY.
+ **********************************************************************************************************************************************/
+uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+{
+    if (txb > 2)
+        txb = 0;
+    
+    return canTxQueue(txb, idh, idl, lenght, data);
+    
+} // end uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void canRxDone(spiTransfer *transfer)
+ * Description: Completion of a READ RX BUFFER: moves the message to the receive queue or answers it
+ * when it is a registered remote frame. Once no read is left and the INT pin is still low (a message
+ * arrived meanwhile), INT2IF is set by software because that message produced no new edge.
+ **********************************************************************************************************************************************/
+static void canRxDone(spiTransfer *transfer)
+{
+    uint8_t rxb = (uint8_t)(transfer - canRxTransfer);
+    uint8_t *raw = canRxRaw[rxb];
+    dataFrame received;
+    dataFrame *frame = &received;
+    uint8_t queued = 1;
+    
+    frame->idh = raw[BUF_SIDH];
+    frame->idl = raw[BUF_SIDL] & 0xE0;
+    frame->dlc = mcp2515RxDlc(raw[BUF_SIDL], raw[BUF_DLC]);
+    for (uint8_t i = 0; i < (frame->dlc & CAN_DLC_MASK); i++)
+    {
+        frame->data[i] = raw[BUF_D0 + i];
+    }
+    
+#if BUS_LOAD
+    busLoadFrame(&raw[BUF_SIDH], &raw[BUF_D0]);
+#endif
+#if CAN_WATCH
+    canWatchReceive(frame);
+#endif
+#if TIME_SYNC
+    if ((frame->idh == TIME_SYNC_IDH) && !frame->idl)
+        timeSyncStamp(frame);
+#endif
+#if CANOPEN
+    if (canOpenReceive(frame))
+        queued = 0;
+#endif
+    
+    if ((frame->dlc & CAN_RTR) && canRtrCount)
+    {
+        const canRtrEntry *answer = canRtrFind(frame);
         
+        if (answer)
+        {
+            if (canAnswerAsync(CAN_RTR_TXB, frame->idh, frame->idl, answer->dlc, answer->data) != MCP2515_OK)
+            {
+                canRtrMissed++;
+            }
+            else
+            {
+                canRtrAnswered++;
+                queued = 0;
+            }
+        }
     }
-    else 
-        data = 0xFF;
     
- } // end void canRead(uint8_t id, uint8_t lenght, uint8_t *data) function
+    if (queued)
+        canRxStore(frame);
+    
+    canAsyncBusy &= ~CAN_BUSY_RXB(rxb);
+    if (!(canAsyncBusy & (CAN_BUSY_RXB(0) | CAN_BUSY_RXB(1) | CAN_BUSY_STATUS)) && !MCP_INT)
+        INTCON3bits.INT2IF = 1;
+    
+} // end static void canRxDone(spiTransfer *transfer) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void canRxSubmit(uint8_t pending)
+ * Description: Queues a READ RX BUFFER of the full receive buffers (pending, STAT_RXnIF bits) that 
+ * are not being read already. The whole buffer is read, 13 bytes, since the DLC is not known yet.
+ **********************************************************************************************************************************************/
+static void canRxSubmit(uint8_t pending)
+{
+    for (uint8_t rxb = 0; rxb < 2; rxb++)
+    {
+        if ((pending & STAT_RXnIF(rxb)) && !(canAsyncBusy & CAN_BUSY_RXB(rxb)))
+        {
+            canAsyncBusy |= CAN_BUSY_RXB(rxb);
+            canRxRaw[rxb][0] = CAN_RD_RXB_SIDH(rxb);
+            canRxTransfer[rxb].buffer = canRxRaw[rxb];
+            canRxTransfer[rxb].length = CAN_RAW_SIZE;
+            canRxTransfer[rxb].cs = SPI_CS_MCP2515;
+            canRxTransfer[rxb].done = canRxDone;
+            SPI_submit(&canRxTransfer[rxb]);
+        }
+    }
+    
+} // end static void canRxSubmit(uint8_t pending) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void canTxSeen(uint8_t loaded, uint8_t status)
+ * Description: Clears the loads of canTxPending taken before a READ STATUS (loaded) that it shows sent
+ * (status): TXREQ clear and the load no longer queued. A load queued by an interrupt during the read
+ * is not in (loaded), so it is never cleared by a status taken before its request.
+ **********************************************************************************************************************************************/
+static void canTxSeen(uint8_t loaded, uint8_t status)
+{
+    uint8_t sent = 0;
+    uint8_t gie = INTCONbits.GIE;
+    
+    if (!loaded)
+        return;
+    for (uint8_t txb = 0; txb < 3; txb++)
+    {
+        if ((loaded & CAN_BUSY_TXB(txb)) && !(status & STAT_TXnREQ(txb)) && !(canAsyncBusy & CAN_BUSY_TXB(txb)))
+            sent |= CAN_BUSY_TXB(txb);
+    }
+    if (!sent)
+        return;
+    
+    INTCONbits.GIE = 0;
+    canTxPending &= ~sent;
+    INTCONbits.GIE = gie;
+    
+} // end static void canTxSeen(uint8_t loaded, uint8_t status) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: static void canStatusDone(spiTransfer *transfer)
+ * Description: Completion of the READ STATUS queued by canServiceAsync(). As the queue runs in order,
+ * a transmit request seen clear here was issued before this read, so a pending answer is done.
+ **********************************************************************************************************************************************/
+static void canStatusDone(spiTransfer *transfer)
+{
+    uint8_t status = canStatusRaw[1];
+    
+    (void)transfer;
+    canAsyncBusy &= ~CAN_BUSY_STATUS;
+    canTxSeen(canTxPending, status);
+    
+    canRxSubmit(status);
+    if (!(canAsyncBusy & (CAN_BUSY_RXB(0) | CAN_BUSY_RXB(1))) && !MCP_INT)
+        INTCON3bits.INT2IF = 1;
+    
+} // end static void canStatusDone(spiTransfer *transfer) function
+
+
+/***********************************************************************************************************************************************
+ * FUNCTION: void canServiceAsync(void)
+ * Description: INT2 interrupt with CAN_SPI_ASYNC: queues the transfers that empty the receive buffers
+ * and returns; the SSP interrupt completes them. With MCP2515_PIN_ASSIST the full buffers are known
+ * from the RXnBF pins, otherwise a READ STATUS is queued first.
+ **********************************************************************************************************************************************/
+void canServiceAsync(void)
+{
+#if MCP2515_PIN_ASSIST
+    canRxSubmit(mcp2515RxPending());
+    if (canTxPending)
+        mcp2515ReadStatus();
+#else
+    if (!(canAsyncBusy & CAN_BUSY_STATUS))
+    {
+        canAsyncBusy |= CAN_BUSY_STATUS;
+        canStatusRaw[0] = CAN_RD_STATUS;
+        canStatusTransfer.buffer = canStatusRaw;
+        canStatusTransfer.length = 2;
+        canStatusTransfer.cs = SPI_CS_MCP2515;
+        canStatusTransfer.done = canStatusDone;
+        SPI_submit(&canStatusTransfer);
+    }
+#endif
+    
+} // end void canServiceAsync(void) function
 
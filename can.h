@@ -21,9 +21,91 @@
 #include "spi.h"
 #include "REGS2515.h"
 #include "delayMy.h"
+#include "timer.h"
 
 // Defines and Macros
-#define getMode()        ((mcp2515ReadRegister(CANSTAT))>> 5) // Checks the operation mode of the MCP2515
+#define getMode()        (mcp2515OpMode >> 5) // Operation mode of the MCP2515 (last confirmed by CANSTAT)
+
+// Debug: compare the shadow registers with the chip periodically (see mcp2515ShadowVerify()).
+#ifndef MCP2515_SHADOW_VERIFY
+    #define MCP2515_SHADOW_VERIFY   0
+#endif
+
+// Wait for a mode change before it is given up, and the polls of CANSTAT it takes. A poll (READ,
+// 24 SPI clocks of 4 << (2 * SPI_CLOCK) oscillator periods) lasts 192 us at FOSC/64, 48 us at
+// FOSC/16 and 12 us at FOSC/4; the code around it only makes the wait longer.
+#ifndef MCP2515_MODE_TIMEOUT_US
+    #define MCP2515_MODE_TIMEOUT_US 10000
+#endif
+#define MCP2515_POLL_US         ((24UL * (4UL << (2 * SPI_CLOCK)) * 1000000UL) / _XTAL_FREQ)
+#ifndef MCP2515_MODE_TIMEOUT
+    #define MCP2515_MODE_TIMEOUT    (MCP2515_MODE_TIMEOUT_US / MCP2515_POLL_US)
+#endif
+
+// Bit rates supported by mcp2515SetBitrate() and canAutobaud() (8 MHz MCP2515 oscillator)
+#define CAN_BITRATE_125K        0
+#define CAN_BITRATE_250K        1
+#define CAN_BITRATE_500K        2
+#define CAN_BITRATES            3
+#define CAN_BITRATE_NONE        0xFF
+
+// Time each bit rate is listened to by canAutobaud(), in milliseconds.
+#ifndef CAN_AUTOBAUD_WINDOW_MS
+    #define CAN_AUTOBAUD_WINDOW_MS  250
+#endif
+
+// Results of the configuration functions
+#define MCP2515_OK              0x00
+#define MCP2515_ERR_MODE        0x01    // Mode change not confirmed by CANSTAT
+#define MCP2515_ERR_VERIFY      0x02    // Register read back differs from the written value
+#define MCP2515_ERR_FULL        0x03    // No free entry in a driver table
+#define MCP2515_ERR_BUSY        0x04    // Previous asynchronous transfer still in progress, or its frame not sent yet
+
+// dataFrame.dlc: data length in the low nibble, remote frame flag at the TXBnDLC.RTR position.
+#define CAN_DLC_MASK            0x0F
+#define CAN_RTR                 0x40
+
+// Messages buffered by the receive interrupt (power of 2).
+#ifndef CAN_RX_QUEUE_SIZE
+    #define CAN_RX_QUEUE_SIZE       8
+#endif
+
+// Data bytes kept per queued message (canPackedFrame): 8, or the longest DLC the application
+// receives. Longer messages are queued with their DLC cut to it (canRxClipped).
+#ifndef CAN_FRAME_PAYLOAD
+    #define CAN_FRAME_PAYLOAD       8
+#endif
+
+// RAM placement of the interrupt queues (receive queue, busLoad.c). CAN_QUEUE_INDEX_RAM qualifies
+// the head/tail indexes, touched by every interrupt: __near puts them in access RAM, reached
+// without a bank switch; empty leaves them to the linker (banked RAM). CAN_QUEUE_RAM qualifies
+// the entries (e.g. __near for a small queue, at the cost of the 96 byte access bank).
+#ifndef CAN_QUEUE_INDEX_RAM
+    #define CAN_QUEUE_INDEX_RAM     __near
+#endif
+#ifndef CAN_QUEUE_RAM
+    #define CAN_QUEUE_RAM
+#endif
+
+// Remote frame answers (canRtrRegister()) and the transmit buffer reserved to send them.
+#ifndef CAN_RTR_SLOTS
+    #define CAN_RTR_SLOTS           4
+#endif
+#ifndef CAN_RTR_TXB
+    #define CAN_RTR_TXB             2
+#endif
+
+// Every MCP2515 SPI transaction is framed by these macros. Outside the interrupt the INT2 interrupt
+// is held off while CS is low, so canService() never splits a transaction of the main program.
+// SPI_begin() also lets the asynchronous SPI transfers finish first.
+#define MCP2515_SELECT()        do { INTCON3bits.INT2IE = 0; SPI_begin(SPI_CS_MCP2515); } while (0)
+#define MCP2515_DESELECT()      do { SPI_end(SPI_CS_MCP2515); INTCON3bits.INT2IE = canIntEnabled; } while (0)
+
+// With CAN_SPI_ASYNC the INT2 interrupt only queues SPI transfers (canServiceAsync()); the
+// receive buffers are emptied by the SSP interrupt while the main program runs.
+#ifndef CAN_SPI_ASYNC
+    #define CAN_SPI_ASYNC           1
+#endif
 
 
 // PUBLIC VARIABLES
@@ -31,17 +113,83 @@
 typedef struct 
 {
     uint8_t idh;
+    uint8_t idl;            // Identifier bits 2..0 at SIDL position (bits 7..5), 0 for the idh API
     uint8_t dlc;
     uint8_t data[8];
 }dataFrame;
 
-dataFrame canMessageSend;
-dataFrame canMessageReceived;
+// dataFrame as queued: CAN_FRAME_PAYLOAD + 2 bytes (10 for 8 data bytes, 11 as dataFrame).
+// info: identifier bits 2..0 at bits 7..5 (as dataFrame.idl), remote frame flag, DLC in bits 3..0.
+typedef struct
+{
+    uint8_t idh;
+    uint8_t info;
+    uint8_t data[CAN_FRAME_PAYLOAD];
+}canPackedFrame;
+
+#define CAN_INFO_ID_MASK        0xE0
+#define CAN_INFO_RTR            0x10
+
+typedef struct
+{
+    uint8_t idh;        // Identifier, as in dataFrame: bits 10..3
+    uint8_t idl;        // bits 2..0 at 7..5
+    uint8_t dlc;
+    uint8_t *data;      // Latest data of the message, kept up to date by the application
+}canRtrEntry;
+
+// Controller settings a node works out once and keeps (eeConfig.h): register values in register
+// order, so each group goes in one WRITE burst (mcp2515StartWith()).
+typedef struct
+{
+    uint8_t filter[24];     // RXF0SIDH..RXF2EID0, RXF3SIDH..RXF5EID0
+    uint8_t mask[8];        // RXM0SIDH..RXM1EID0
+    uint8_t cnf[3];         // CNF3, CNF2, CNF1
+    uint8_t rxbCtrl[2];     // RXB0CTRL, RXB1CTRL
+}mcp2515Setup;
+
+extern uint8_t mcp2515OpMode;
+extern volatile uint8_t canIntEnabled;
+extern volatile uint8_t canRtrCount;
+extern volatile uint8_t canRxOverflow;
+extern volatile uint8_t canRxClipped;
+extern volatile uint8_t canRtrAnswered;
+extern volatile uint8_t canRtrMissed;
 
 /***********************************************************************************************************************************************
  * FUNCTION PROTOTYPES 
  **********************************************************************************************************************************************/
-void mcp2515Start(void);
+uint8_t mcp2515Start(void);
+
+uint8_t mcp2515StartWith(const mcp2515Setup *setup);
+
+void mcp2515SetupRead(mcp2515Setup *setup);
+
+void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count);
+
+void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count);
+
+uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count);
+
+uint8_t mcp2515WaitMode(uint8_t opmode);
+
+uint8_t mcp2515SetMode(uint8_t opmode);
+
+uint8_t mcp2515ConfigBegin(void);
+
+uint8_t mcp2515ConfigEnd(void);
+
+uint16_t mcp2515OfflineTime(void);
+
+void mcp2515SetBitrate(uint8_t bitrate);
+
+void mcp2515SetFilter(uint8_t filter, uint8_t id);
+
+void mcp2515SetMask(uint8_t mask, uint8_t id);
+
+void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm);
+
+uint8_t canAutobaud(void);
 
 void mcp2515DataReset(uint8_t data);
 
@@ -51,12 +199,43 @@ void mcp2515MessageRead(uint8_t id, dataFrame *data);
 
 void mcp2515WriteRegister(uint8_t address, uint8_t value);
 
+void mcp2515ShadowSync(void);
+
+uint8_t mcp2515ShadowVerify(void);
+
 uint8_t mcp2515ReadRegister(uint8_t address);
 
 void  mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew);
 
+uint8_t mcp2515ReadStatus(void);
+
+void mcp2515RequestToSend(uint8_t txb);
+
+uint8_t mcp2515RxPending(void);
+
+void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data);
+void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data);
+
+void mcp2515RxUnload(uint8_t rxb, dataFrame *frame);
+
 void canSend(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data);
+void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght);
 void canRead(uint8_t id, uint8_t *data);
 
+void canInterruptEnable(void);
+void canService(void);
+void canServiceAsync(void);
+uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data);
+uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data);
+uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data);
+uint8_t canReceive(dataFrame *frame);
+uint8_t canRxTake(uint8_t id, dataFrame *frame);
+void canFramePack(canPackedFrame *packed, const dataFrame *frame);
+void canFrameUnpack(dataFrame *frame, const canPackedFrame *packed);
+uint8_t canRtrRegister(uint8_t id, uint8_t dlc, uint8_t *data);
+uint8_t canRtrRegisterId(uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data);
+void canRtrRemove(uint8_t id);
+void canRtrRemoveId(uint8_t idh, uint8_t idl);
+
 #endif	/* CAN_H */
 
@@ -0,0 +1,175 @@
+/* File:  canBench.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Loopback self-test and throughput benchmark of the CAN driver.
+ * The MCP2515 is put in loopback mode and frames of every DLC go through the whole transmit
+ * (mcp2515MessageSend()) and receive (interrupt, receive queue, canReceive()) paths. The same
+ * code runs on the host against the simulated MCP2515 (host/benchHost.c).
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canBench.h"
+
+volatile uint32_t canBenchIsrMicros;           // Time spent in isr() (hardware.c) with CAN_BENCH
+
+
+/*******************************************************************************
+ * FUNCTION: static void canBenchCheck(uint16_t *received, uint16_t *corrupted)
+ * Description: Takes the benchmark frames back from the receive queue and checks their data,
+ * data[i] = data[0] + i.
+ *******************************************************************************/
+static void canBenchCheck(uint16_t *received, uint16_t *corrupted)
+{
+    dataFrame frame;
+    
+    while (canReceive(&frame))
+    {
+        uint8_t intact = (frame.idh == CAN_BENCH_IDH);
+        
+        for (uint8_t i = 1; i < (frame.dlc & CAN_DLC_MASK); i++)
+        {
+            if (frame.data[i] != (uint8_t)(frame.data[0] + i))
+                intact = 0;
+        }
+        
+        if (intact)
+            (*received)++;
+        else
+            (*corrupted)++;
+    }
+    
+} // end static void canBenchCheck(uint16_t *received, uint16_t *corrupted) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canBenchRun(uint16_t durationMs, canBenchResult *result)
+ * Description: Sends frames in loopback mode for (durationMs) milliseconds, keeping at most
+ * CAN_BENCH_WINDOW of them in flight, and fills (result). Frames not back after 10 ms are
+ * written off as lost so the test goes on. The receive queue is emptied first, RXB0 rolls over into
+ * RXB1 during the test, and the previous operation mode is restored at the end (mcp2515ConfigBegin(),
+ * mcp2515ConfigEnd()).
+ * Returns MCP2515_OK or MCP2515_ERR_MODE.
+ *******************************************************************************/
+uint8_t canBenchRun(uint16_t durationMs, canBenchResult *result)
+{
+    dataFrame frame;
+    uint16_t last;
+    uint16_t elapsed = 0;
+    uint16_t stalled = 0;
+    uint16_t written = 0;                      // Frames given up as lost
+    uint16_t back;
+    uint8_t seq = 0;
+    uint32_t spiStart;
+    uint8_t rollover;
+    
+    result->sent = 0;
+    result->received = 0;
+    result->corrupted = 0;
+    
+    if (mcp2515ConfigBegin() != MCP2515_OK)
+        return MCP2515_ERR_MODE;
+    if (mcp2515SetMode(OPMODE_LOOPBACK) != MCP2515_OK)
+    {
+        mcp2515ConfigEnd();
+        return MCP2515_ERR_MODE;
+    }
+    
+    rollover = mcp2515ReadRegister(RXB0CTRL) & BUKT;
+    mcp2515BitChange(RXB0CTRL, BUKT, BUKT);
+    while (canReceive(&frame));
+    
+    frame.idh = CAN_BENCH_IDH;
+    frame.idl = 0;
+    frame.dlc = 0;
+    spiStart = spiBytes;
+    canBenchIsrMicros = 0;
+    last = timerMicros();
+    
+    while (elapsed < durationMs)
+    {
+        back = result->received + result->corrupted;
+        canBenchCheck(&result->received, &result->corrupted);
+        
+        if ((uint16_t)(result->sent - result->received - result->corrupted - written) < CAN_BENCH_WINDOW)
+        {
+            for (uint8_t i = 0; i < frame.dlc; i++)
+            {
+                frame.data[i] = seq + i;
+            }
+            mcp2515MessageSend(&frame);
+            result->sent++;
+            seq++;
+            frame.dlc = (frame.dlc == DLC_8) ? DLC_0 : (frame.dlc + 1);
+            stalled = 0;
+        }
+        else if (back != (result->received + result->corrupted))
+            stalled = 0;
+        
+        // A pass can take more than a millisecond (SPI at FOSC/64): catch up.
+        while (timerMillisTick(&last))
+        {
+            elapsed++;
+            stalled++;
+        }
+        if (stalled >= 10)
+        {
+            written = result->sent - result->received - result->corrupted;
+            stalled = 0;
+        }
+    }
+    
+    // The last frames are still on their way: 10 ms is more than 3 frames at 125 Kbps.
+    for (elapsed = 0; elapsed < 10; )
+    {
+        canBenchCheck(&result->received, &result->corrupted);
+        while (timerMillisTick(&last))
+        {
+            elapsed++;
+        }
+    }
+    
+    result->lost = result->sent - result->received - result->corrupted;
+    result->framesPerSecond = (uint16_t)(((uint32_t)result->received * 1000) / durationMs);
+    result->spiBytesPerFrame = result->sent ? (uint16_t)((spiBytes - spiStart) / result->sent) : 0;
+    result->isrMicrosPerFrame = result->received ? (uint16_t)(canBenchIsrMicros / result->received) : 0;
+    
+    mcp2515BitChange(RXB0CTRL, BUKT, rollover);
+    
+    return mcp2515ConfigEnd();
+    
+} // end uint8_t canBenchRun(uint16_t durationMs, canBenchResult *result) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canBenchReport(canBenchResult *result)
+ * Description: Sends the result on the bus as CAN_BENCH_REPORT_IDH:
+ * frames/s (2 bytes), SPI bytes/frame, ISR us/frame (2 bytes), lost (2 bytes), corrupted,
+ * all big endian, and shows it on the LEDs: LED 7 on = no frame lost or corrupted.
+ *******************************************************************************/
+void canBenchReport(canBenchResult *result)
+{
+    uint8_t data[8];
+    
+    data[0] = (uint8_t)(result->framesPerSecond >> 8);
+    data[1] = (uint8_t)result->framesPerSecond;
+    data[2] = (result->spiBytesPerFrame > 0xFF) ? 0xFF : (uint8_t)result->spiBytesPerFrame;
+    data[3] = (uint8_t)(result->isrMicrosPerFrame >> 8);
+    data[4] = (uint8_t)result->isrMicrosPerFrame;
+    data[5] = (uint8_t)(result->lost >> 8);
+    data[6] = (uint8_t)result->lost;
+    data[7] = (result->corrupted > 0xFF) ? 0xFF : (uint8_t)result->corrupted;
+    
+    canSend(0, CAN_BENCH_REPORT_IDH, 8, data);
+    
+    LATBbits.LATB7 = ((result->lost == 0) && (result->corrupted == 0)) ? 0 : 1;
+    
+} // end void canBenchReport(canBenchResult *result) function
+
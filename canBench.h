@@ -0,0 +1,59 @@
+/* File:  canBench.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Loopback self-test and throughput benchmark of the CAN driver.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_BENCH_H
+#define	CAN_BENCH_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CAN_BENCH = 1 runs the benchmark at start-up (main.c) and times the interrupt routine.
+#ifndef CAN_BENCH
+    #define CAN_BENCH               0
+#endif
+#ifndef CAN_BENCH_TIME_MS
+    #define CAN_BENCH_TIME_MS       1000
+#endif
+
+ // Frames in flight: the two receive buffers of the MCP2515 (RXB0 rolls over into RXB1 during the
+// test). More overruns them, as a frame takes about as long to send through SPI as to read back.
+#ifndef CAN_BENCH_WINDOW
+    #define CAN_BENCH_WINDOW        2
+#endif
+
+#define CAN_BENCH_IDH           0x7E    // Frames sent in loopback (identifier 0x3F0)
+#define CAN_BENCH_REPORT_IDH    0x7F    // Result frame sent on the bus (identifier 0x3F8)
+
+typedef struct
+{
+    uint16_t sent;                  // Frames sent, every DLC from 0 to 8 in turn
+    uint16_t received;              // Frames received back intact
+    uint16_t lost;                  // Frames never received
+    uint16_t corrupted;             // Frames received with wrong data
+    uint16_t framesPerSecond;
+    uint16_t spiBytesPerFrame;
+    uint16_t isrMicrosPerFrame;
+}canBenchResult;
+
+extern volatile uint32_t canBenchIsrMicros;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+uint8_t canBenchRun(uint16_t durationMs, canBenchResult *result);
+void canBenchReport(canBenchResult *result);
+
+#endif	/* CAN_BENCH_H */
+
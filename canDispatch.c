@@ -0,0 +1,269 @@
+/* File:  canDispatch.c  (generated by tools/dispatchgen.py, do not edit)
+ * ******************************************************************************
+ * Description: CAN receive dispatch tables, one per combination of the conditions.
+ *******************************************************************************/
+
+#include <xc.h>
+#include "canDispatch.h"
+
+typedef struct
+{
+    uint16_t id;                        // 0xFFFF: free slot
+    canHandler handler;
+}canDispatchEntry;
+
+#if !(BOOT_COMMAND) && !(TIME_SYNC) && !(CANOPEN)
+
+static const uint8_t canDispatchDisplace[1] =
+{
+    0,
+};
+
+static const canDispatchEntry canDispatchTable[1] =
+{
+    { 0x100, nodeCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * y = lo * 21 + hi * 133 (8 bit), slot = y + displace[0]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[0]) & 0x00];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    return 0;
+}
+
+#elif (BOOT_COMMAND) && !(TIME_SYNC) && !(CANOPEN)
+
+static const uint8_t canDispatchDisplace[2] =
+{
+    0, 0,
+};
+
+static const canDispatchEntry canDispatchTable[4] =
+{
+    { 0xFFFF, 0 },
+    { 0x100, nodeCommandHandler },
+    { 0xFFFF, 0 },
+    { 0x7C0, bootCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * x = lo * 119 + hi * 33, y = lo * 155 + hi * 69 (8 bit), slot = y + displace[x >> 7]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t x = (uint8_t)(lo * 119) + (uint8_t)(hi * 33);
+    uint8_t y = (uint8_t)(lo * 155) + (uint8_t)(hi * 69);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[x >> 7]) & 0x03];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    return 0;
+}
+
+#elif !(BOOT_COMMAND) && (TIME_SYNC) && !(CANOPEN)
+
+static const uint8_t canDispatchDisplace[1] =
+{
+    0,
+};
+
+static const canDispatchEntry canDispatchTable[2] =
+{
+    { 0x040, timeSyncHandler },
+    { 0x100, nodeCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * y = lo * 21 + hi * 133 (8 bit), slot = y + displace[0]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[0]) & 0x01];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    return 0;
+}
+
+#elif (BOOT_COMMAND) && (TIME_SYNC) && !(CANOPEN)
+
+static const uint8_t canDispatchDisplace[2] =
+{
+    0, 0,
+};
+
+static const canDispatchEntry canDispatchTable[4] =
+{
+    { 0x040, timeSyncHandler },
+    { 0x100, nodeCommandHandler },
+    { 0xFFFF, 0 },
+    { 0x7C0, bootCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * x = lo * 197 + hi * 215, y = lo * 21 + hi * 133 (8 bit), slot = y + displace[x >> 7]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t x = (uint8_t)(lo * 197) + (uint8_t)(hi * 215);
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[x >> 7]) & 0x03];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    return 0;
+}
+
+#elif !(BOOT_COMMAND) && !(TIME_SYNC) && (CANOPEN)
+
+static const uint8_t canDispatchDisplace[1] =
+{
+    0,
+};
+
+static const canDispatchEntry canDispatchTable[1] =
+{
+    { 0x100, nodeCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * y = lo * 21 + hi * 133 (8 bit), slot = y + displace[0]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[0]) & 0x00];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    canOpenHandler(frame);
+    return 0;
+}
+
+#elif (BOOT_COMMAND) && !(TIME_SYNC) && (CANOPEN)
+
+static const uint8_t canDispatchDisplace[2] =
+{
+    0, 0,
+};
+
+static const canDispatchEntry canDispatchTable[4] =
+{
+    { 0xFFFF, 0 },
+    { 0x100, nodeCommandHandler },
+    { 0xFFFF, 0 },
+    { 0x7C0, bootCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * x = lo * 119 + hi * 33, y = lo * 155 + hi * 69 (8 bit), slot = y + displace[x >> 7]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t x = (uint8_t)(lo * 119) + (uint8_t)(hi * 33);
+    uint8_t y = (uint8_t)(lo * 155) + (uint8_t)(hi * 69);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[x >> 7]) & 0x03];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    canOpenHandler(frame);
+    return 0;
+}
+
+#elif !(BOOT_COMMAND) && (TIME_SYNC) && (CANOPEN)
+
+static const uint8_t canDispatchDisplace[1] =
+{
+    0,
+};
+
+static const canDispatchEntry canDispatchTable[2] =
+{
+    { 0x040, timeSyncHandler },
+    { 0x100, nodeCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * y = lo * 21 + hi * 133 (8 bit), slot = y + displace[0]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[0]) & 0x01];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    canOpenHandler(frame);
+    return 0;
+}
+
+#elif (BOOT_COMMAND) && (TIME_SYNC) && (CANOPEN)
+
+static const uint8_t canDispatchDisplace[2] =
+{
+    0, 0,
+};
+
+static const canDispatchEntry canDispatchTable[4] =
+{
+    { 0x040, timeSyncHandler },
+    { 0x100, nodeCommandHandler },
+    { 0xFFFF, 0 },
+    { 0x7C0, bootCommandHandler },
+};
+
+/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.
+ * x = lo * 197 + hi * 215, y = lo * 21 + hi * 133 (8 bit), slot = y + displace[x >> 7]. */
+uint8_t canDispatch(const dataFrame *frame)
+{
+    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);
+    uint8_t hi = frame->idh >> 5;
+    uint8_t x = (uint8_t)(lo * 197) + (uint8_t)(hi * 215);
+    uint8_t y = (uint8_t)(lo * 21) + (uint8_t)(hi * 133);
+    const canDispatchEntry *entry = &canDispatchTable[(uint8_t)(y + canDispatchDisplace[x >> 7]) & 0x03];
+
+    if (entry->id == (((uint16_t)hi << 8) | lo))
+    {
+        entry->handler(frame);
+        return 1;
+    }
+    canOpenHandler(frame);
+    return 0;
+}
+
+#endif
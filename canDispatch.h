@@ -0,0 +1,51 @@
+/* File:  canDispatch.h  (generated by tools/dispatchgen.py, do not edit)
+ * ******************************************************************************
+ * Description: CAN receive dispatch table.
+ *******************************************************************************/
+
+#ifndef CANDISPATCH_H
+#define	CANDISPATCH_H
+
+#include <xc.h>
+#include "can.h"
+#include "boot.h"
+#include "timeSync.h"
+#include "canOpen.h"
+
+#if !(BOOT_COMMAND) && !(TIME_SYNC) && !(CANOPEN)
+#define CAN_DISPATCH_IDS        1
+#define CAN_DISPATCH_SLOTS      1
+#elif (BOOT_COMMAND) && !(TIME_SYNC) && !(CANOPEN)
+#define CAN_DISPATCH_IDS        2
+#define CAN_DISPATCH_SLOTS      4
+#elif !(BOOT_COMMAND) && (TIME_SYNC) && !(CANOPEN)
+#define CAN_DISPATCH_IDS        2
+#define CAN_DISPATCH_SLOTS      2
+#elif (BOOT_COMMAND) && (TIME_SYNC) && !(CANOPEN)
+#define CAN_DISPATCH_IDS        3
+#define CAN_DISPATCH_SLOTS      4
+#elif !(BOOT_COMMAND) && !(TIME_SYNC) && (CANOPEN)
+#define CAN_DISPATCH_IDS        1
+#define CAN_DISPATCH_SLOTS      1
+#elif (BOOT_COMMAND) && !(TIME_SYNC) && (CANOPEN)
+#define CAN_DISPATCH_IDS        2
+#define CAN_DISPATCH_SLOTS      4
+#elif !(BOOT_COMMAND) && (TIME_SYNC) && (CANOPEN)
+#define CAN_DISPATCH_IDS        2
+#define CAN_DISPATCH_SLOTS      2
+#elif (BOOT_COMMAND) && (TIME_SYNC) && (CANOPEN)
+#define CAN_DISPATCH_IDS        3
+#define CAN_DISPATCH_SLOTS      4
+#endif
+
+typedef void (*canHandler)(const dataFrame *frame);
+
+// Handlers, defined by the application
+void bootCommandHandler(const dataFrame *frame);
+void canOpenHandler(const dataFrame *frame);
+void nodeCommandHandler(const dataFrame *frame);
+void timeSyncHandler(const dataFrame *frame);
+
+uint8_t canDispatch(const dataFrame *frame);
+
+#endif	/* CANDISPATCH_H */
@@ -0,0 +1,394 @@
+/* File:  canGen.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Traffic generator (see canGen.h). canGenService() keeps a credit of bits, fed every
+ * millisecond at the target load: a frame goes out when a transmit buffer is free and the credit
+ * covers it, or, in burst mode, the credit first fills up to a whole burst and is then spent back
+ * to back. A frame costs its length on the bus, stuff bits included (busLoadFrameBits()), so the
+ * load is the one a bus analyser measures. The next frame is drawn in advance (xorshift generator,
+ * weighted choice by one 8x8 product) while the SPI engine loads the previous one. A frame of an identifier already waiting in
+ * another buffer waits too: the MCP2515 sends its buffers by priority, not in load order, and two
+ * frames of one identifier would swap.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canGen.h"
+#include "busLoad.h"
+#include "timer.h"
+
+#define CAN_GEN_FRAME_BITS_MAX  135                     // Standard frame of 8 bytes, most stuff bits
+#define CAN_GEN_NONE            0xFF                    // canGenInFlight: buffer free
+#define CAN_GEN_REPORT          0xFE                    // canGenInFlight: the report frame
+
+canGenStats canGenCount;
+
+static const canGenMix *canGenConfig;
+static uint8_t canGenIdTotal;           // Sum of the identifier weights
+static uint8_t canGenDlcTotal;
+static uint16_t canGenRandom;           // xorshift state, never 0
+static uint8_t canGenTx[CAN_GEN_IDS];   // Sequence counter of each identifier, sending side
+static uint8_t canGenRx[CAN_GEN_IDS];   // Next counter expected, receiving side
+static uint8_t canGenSynced[CAN_GEN_IDS];
+static uint8_t canGenInFlight[3];       // Identifier waiting in each transmit buffer
+static uint8_t canGenInFlightBits[3];
+
+static uint8_t canGenNext;              // Identifier of the next frame
+static uint8_t canGenNextDlc;
+static uint8_t canGenNextData[8];
+static uint8_t canGenNextBits;          // On the bus, SOF to intermission, stuff bits included
+static int32_t canGenCredit;            // Bits
+static int32_t canGenCreditBurst;      // Credit that starts a burst
+static uint16_t canGenBitsPerMs;        // 0: no limit
+static uint8_t canGenBursting;
+
+static uint16_t canGenLast;             // timerMillisTick()
+static uint32_t canGenMs;               // Since the last canGenGet()
+static uint16_t canGenReportMs;
+static uint8_t canGenReportDue;
+static uint8_t canGenReportData[8];
+static uint32_t canGenLastSent;         // canGenCount at the last canGenGet()
+static uint32_t canGenLastBits;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canGenRoll(uint8_t total)
+ * Description: Random number from 0 to (total) - 1.
+ *******************************************************************************/
+static uint8_t canGenRoll(uint8_t total)
+{
+    canGenRandom ^= canGenRandom << 7;
+    canGenRandom ^= canGenRandom >> 9;
+    canGenRandom ^= canGenRandom << 8;
+    
+    return (uint8_t)(((uint16_t)(uint8_t)canGenRandom * total) >> 8);
+    
+} // end static uint8_t canGenRoll(uint8_t total) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canGenDraw(void)
+ * Description: Draws the identifier and the data length of the next frame, and builds its payload
+ * and its length on the bus.
+ *******************************************************************************/
+static void canGenDraw(void)
+{
+    uint8_t r = canGenRoll(canGenIdTotal);
+    uint8_t i = 0;
+    uint16_t id;
+    uint8_t header[5];                          // As RXBnSIDH..RXBnDLC, for busLoadFrameBits()
+    uint8_t counter;
+    
+    while ((i < canGenConfig->idCount - 1) && (r >= canGenConfig->ids[i].weight))
+    {
+        r -= canGenConfig->ids[i].weight;
+        i++;
+    }
+    canGenNext = i;
+    
+    r = canGenRoll(canGenDlcTotal);
+    i = 0;
+    while ((i < 8) && (r >= canGenConfig->dlcWeight[i]))
+    {
+        r -= canGenConfig->dlcWeight[i];
+        i++;
+    }
+    canGenNextDlc = i;
+    
+    counter = canGenTx[canGenNext];
+    for (i = 0; i < canGenNextDlc; i++)
+    {
+        canGenNextData[i] = counter;
+        counter += CAN_GEN_PATTERN;
+    }
+    id = canGenConfig->ids[canGenNext].id;
+    header[0] = (uint8_t)(id >> 3);
+    header[1] = (uint8_t)(id << 5);
+    header[2] = 0;
+    header[3] = 0;
+    header[4] = canGenNextDlc;
+    canGenNextBits = busLoadFrameBits(header, canGenNextData);
+    
+} // end static void canGenDraw(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canGenStart(const canGenMix *mix)
+ * Description: Starts the generator, and the checks, with (mix), which stays in use. The target
+ * load is reached over the bit rate set in the MCP2515 (busLoadKbps()).
+ * Returns CAN_GEN_OK or CAN_GEN_ERR_MIX.
+ *******************************************************************************/
+uint8_t canGenStart(const canGenMix *mix)
+{
+    uint16_t idTotal = 0;
+    uint16_t dlcTotal = 0;
+    uint8_t burst = mix->burst ? mix->burst : 1;
+    
+    canGenConfig = 0;
+    if (!mix->idCount || (mix->idCount > CAN_GEN_IDS))
+        return CAN_GEN_ERR_MIX;
+    for (uint8_t i = 0; i < mix->idCount; i++)
+    {
+        idTotal += mix->ids[i].weight;
+        canGenTx[i] = 0;
+        canGenSynced[i] = 0;
+    }
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        dlcTotal += mix->dlcWeight[i];
+    }
+    if (!idTotal || (idTotal > 255) || !dlcTotal || (dlcTotal > 255))
+        return CAN_GEN_ERR_MIX;
+    
+    canGenIdTotal = (uint8_t)idTotal;
+    canGenDlcTotal = (uint8_t)dlcTotal;
+    canGenRandom = mix->seed ? mix->seed : 0xACE1;
+    canGenBitsPerMs = (mix->loadPermille >= 1000) ? 0 : (uint16_t)(((uint32_t)busLoadKbps() * mix->loadPermille) / 1000);
+    canGenCreditBurst = (int32_t)burst * CAN_GEN_FRAME_BITS_MAX;
+    canGenCredit = 0;
+    canGenBursting = 0;
+    for (uint8_t txb = 0; txb < 3; txb++)
+    {
+        canGenInFlight[txb] = CAN_GEN_NONE;
+    }
+    canGenCount.sent = 0;
+    canGenCount.bits = 0;
+    canGenCount.received = 0;
+    canGenCount.lost = 0;
+    canGenCount.reordered = 0;
+    canGenCount.corrupted = 0;
+    canGenLastSent = 0;
+    canGenLastBits = 0;
+    canGenMs = 0;
+    canGenReportMs = 0;
+    canGenReportDue = 0;
+    canGenLast = timerMicros();
+    canGenConfig = mix;
+    canGenDraw();
+    
+    return CAN_GEN_OK;
+    
+} // end uint8_t canGenStart(const canGenMix *mix) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canGenLoad(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+ * Description: Loads and requests a transmit buffer: queued to the SPI engine with CAN_SPI_ASYNC.
+ * Returns MCP2515_OK or MCP2515_ERR_BUSY.
+ *******************************************************************************/
+static uint8_t canGenLoad(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+{
+#if CAN_SPI_ASYNC
+    return canSendAsyncId(txb, idh, idl, dlc, data);
+#else
+    mcp2515TxLoadId(txb, idh, idl, dlc, data);
+    return MCP2515_OK;
+#endif
+    
+} // end static uint8_t canGenLoad(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canGenSend(uint8_t txb)
+ * Description: Sends the frame drawn in transmit buffer (txb), when its identifier is not waiting
+ * in another one, and draws the next. Returns 1 when it was loaded.
+ *******************************************************************************/
+static uint8_t canGenSend(uint8_t txb)
+{
+    uint8_t next = canGenNext;
+    uint8_t dlc = canGenNextDlc;
+    uint16_t id = canGenConfig->ids[next].id;
+    
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (canGenInFlight[i] == next)
+            return 0;
+    }
+    
+    // With CAN_SPI_ASYNC the payload is copied to the transfer image: canGenDraw() may overwrite it.
+    if (canGenLoad(txb, (uint8_t)(id >> 3), (uint8_t)(id << 5), dlc, canGenNextData) != MCP2515_OK)
+        return 0;
+    
+    if (dlc)
+        canGenTx[next]++;
+    canGenInFlight[txb] = next;
+    canGenInFlightBits[txb] = canGenNextBits;
+    canGenCredit -= canGenNextBits;
+    canGenDraw();
+    
+    return 1;
+    
+} // end static uint8_t canGenSend(uint8_t txb) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canGenService(void)
+ * Description: Main loop side: credit and report timing, frames of the buffers seen sent counted,
+ * then every free buffer loaded while the credit allows. Call it as often as possible: at full
+ * load a buffer is freed every 100 to 230 us (500 Kbps).
+ *******************************************************************************/
+void canGenService(void)
+{
+    uint8_t status;
+    
+    if (!canGenConfig)
+        return;
+    
+    while (timerMillisTick(&canGenLast))
+    {
+        canGenMs++;
+        if (canGenBitsPerMs)
+        {
+            // Capped one millisecond over a burst: an idle bus is not made up for later.
+            canGenCredit += canGenBitsPerMs;
+            if (canGenCredit > canGenCreditBurst + canGenBitsPerMs)
+                canGenCredit = canGenCreditBurst + canGenBitsPerMs;
+            if (canGenCredit >= canGenCreditBurst)
+                canGenBursting = 1;
+        }
+        if (CAN_GEN_REPORT_IDH && (++canGenReportMs >= CAN_GEN_REPORT_MS))
+        {
+            canGenReportMs = 0;
+            canGenReportDue = 1;
+        }
+    }
+    
+    status = mcp2515ReadStatus();
+    for (uint8_t txb = 0; txb < 3; txb++)
+    {
+        if (status & STAT_TXnREQ(txb))
+            continue;
+    
+        if (canGenInFlight[txb] < CAN_GEN_IDS)
+        {
+            canGenCount.sent++;
+            canGenCount.bits += canGenInFlightBits[txb];
+        }
+        canGenInFlight[txb] = CAN_GEN_NONE;
+    
+        if (canGenReportDue)
+        {
+            canGenReport report;
+    
+            canGenGet(&report);
+            canGenReportData[0] = (uint8_t)report.permille;
+            canGenReportData[1] = (uint8_t)(report.permille >> 8);
+            canGenReportData[2] = (uint8_t)report.framesPerSecond;
+            canGenReportData[3] = (uint8_t)(report.framesPerSecond >> 8);
+            canGenReportData[4] = (uint8_t)report.lost;
+            canGenReportData[5] = (uint8_t)(report.lost >> 8);
+            canGenReportData[6] = report.reordered;
+            canGenReportData[7] = report.corrupted;
+            if (canGenLoad(txb, CAN_GEN_REPORT_IDH, 0x00, 8, canGenReportData) == MCP2515_OK)
+            {
+                canGenReportDue = 0;
+                canGenInFlight[txb] = CAN_GEN_REPORT;
+            }
+            continue;
+        }
+    
+#if CAN_GEN_SEND
+        // Evenly spread: as soon as the credit covers the frame. Bursts: once the credit is full,
+        // until it is spent.
+        if (canGenBitsPerMs)
+        {
+            if (canGenConfig->burst > 1 && !canGenBursting)
+                continue;
+            if (canGenCredit < canGenNextBits)
+            {
+                canGenBursting = 0;
+                continue;
+            }
+        }
+        canGenSend(txb);
+#endif
+    }
+    
+} // end void canGenService(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canGenCheck(const dataFrame *frame)
+ * Description: Receiving side: checks (frame) when its identifier is one of the mix. The first
+ * counter of an identifier sets the sequence; then a step over one counts the frames skipped, a
+ * step back one reordered frame.
+ *******************************************************************************/
+void canGenCheck(const dataFrame *frame)
+{
+    uint16_t id = ((uint16_t)frame->idh << 3) | (frame->idl >> 5);
+    uint8_t dlc = frame->dlc & CAN_DLC_MASK;
+    uint8_t counter;
+    uint8_t i;
+    int8_t step;
+    
+    if (!canGenConfig || (frame->dlc & CAN_RTR))
+        return;
+    for (i = 0; i < canGenConfig->idCount; i++)
+    {
+        if (canGenConfig->ids[i].id == id)
+            break;
+    }
+    if (i == canGenConfig->idCount)
+        return;
+    
+    canGenCount.received++;
+    if (!dlc)
+        return;
+    
+    counter = frame->data[0];
+    for (uint8_t j = 1; j < dlc; j++)
+    {
+        counter += CAN_GEN_PATTERN;
+        if (frame->data[j] != counter)
+        {
+            canGenCount.corrupted++;
+            return;
+        }
+    }
+    
+    counter = frame->data[0];
+    step = (int8_t)(counter - canGenRx[i]);
+    if (!canGenSynced[i])
+    {
+        canGenSynced[i] = 1;
+        step = 0;
+    }
+    if (step < 0)
+    {
+        canGenCount.reordered++;
+        return;
+    }
+    canGenCount.lost += (uint8_t)step;
+    canGenRx[i] = counter + 1;
+    
+} // end void canGenCheck(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canGenGet(canGenReport *report)
+ * Description: Load and frame rate sent since the last call, and the receiving side totals.
+ *******************************************************************************/
+void canGenGet(canGenReport *report)
+{
+    uint32_t capacity = ((uint32_t)busLoadKbps() * canGenMs) / 100;     // Bits, divided by 100
+    uint32_t bits = canGenCount.bits - canGenLastBits;
+    uint32_t sent = canGenCount.sent - canGenLastSent;
+    
+    report->permille = capacity ? (uint16_t)((bits * 10) / capacity) : 0;
+    report->framesPerSecond = canGenMs ? (uint16_t)((sent * 1000) / canGenMs) : 0;
+    report->lost = canGenCount.lost > 0xFFFF ? 0xFFFF : (uint16_t)canGenCount.lost;
+    report->reordered = canGenCount.reordered > 0xFF ? 0xFF : (uint8_t)canGenCount.reordered;
+    report->corrupted = canGenCount.corrupted > 0xFF ? 0xFF : (uint8_t)canGenCount.corrupted;
+    
+    canGenLastBits = canGenCount.bits;
+    canGenLastSent = canGenCount.sent;
+    canGenMs = 0;
+    
+} // end void canGenGet(canGenReport *report) function
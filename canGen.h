@@ -0,0 +1,106 @@
+/* File:  canGen.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Traffic generator for bus stress tests. The node sends a configured mix of frames
+ * (identifiers and data lengths drawn with given weights) at a target bus load, evenly spread or
+ * in bursts, keeping the three transmit buffers loaded back to back, and reports the load it
+ * achieved. Each frame of an identifier carries its own sequence counter and a payload derived
+ * from it: the receiving side, a node running the same mix, counts the frames lost, reordered
+ * and corrupted by the bus or the device under test (a gateway) in between.
+ *
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ *
+ * Author: Antonio Aparecido Ariza Castilho;
+ *
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_GEN_H
+#define	CAN_GEN_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CAN_GEN = 1: main.c runs the generator with the mix of canGenMix (main.c) in a loop around
+// canGenService() and canGenCheck(). Use SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h): at FOSC/64 a frame
+// takes longer to load than to send at 500 Kbps, and the bus cannot be filled.
+#ifndef CAN_GEN
+    #define CAN_GEN                 0
+#endif
+#ifndef CAN_GEN_SEND
+    #define CAN_GEN_SEND            1       // 0: check only, no frame sent
+#endif
+#ifndef CAN_GEN_LOAD_PERMILLE
+    #define CAN_GEN_LOAD_PERMILLE   500     // Target, stuff bits included; 1000: as fast as possible
+#endif
+#ifndef CAN_GEN_BURST
+    #define CAN_GEN_BURST           0       // Frames per burst, 0 or 1: evenly spread
+#endif
+#ifndef CAN_GEN_REPORT_IDH
+    #define CAN_GEN_REPORT_IDH      0x7D    // 0x3E8: canGenReport frame, 0: none
+#endif
+#ifndef CAN_GEN_REPORT_MS
+    #define CAN_GEN_REPORT_MS       1000
+#endif
+#ifndef CAN_GEN_IDS
+    #define CAN_GEN_IDS             16      // Identifiers of a mix, at most
+#endif
+
+#define CAN_GEN_OK              0
+#define CAN_GEN_ERR_MIX         1       // canGenStart(): no identifier, too many, or weights over 255
+
+/* Payload of a mix frame, data length n >= 1: [0] sequence counter of the identifier, [i] counter
+ * + i * CAN_GEN_PATTERN. Frames of data length 0 carry no counter and are only counted. */
+#define CAN_GEN_PATTERN         0x3B
+
+typedef struct
+{
+    uint16_t id;                        // 11 bit identifier
+    uint8_t weight;                     // Share of the frames
+}canGenId;
+
+typedef struct
+{
+    const canGenId *ids;
+    uint8_t idCount;                    // 1..CAN_GEN_IDS
+    uint8_t dlcWeight[9];               // Share of each data length, 0..8
+    uint16_t loadPermille;
+    uint8_t burst;
+    uint16_t seed;                      // Not 0: same seed, same frame sequence
+}canGenMix;                             // Weights of each list add up to 255 at most
+
+typedef struct
+{
+    // Sending side
+    uint32_t sent;                      // Frames on the bus
+    uint32_t bits;                      // Their bits, stuff bits included
+    // Receiving side
+    uint32_t received;                  // Frames of the mix
+    uint32_t lost;                      // Sequence counter steps skipped
+    uint32_t reordered;                 // Counter behind the last one: late or repeated frame
+    uint32_t corrupted;                 // Payload not the one of its counter
+}canGenStats;
+
+typedef struct
+{
+    uint16_t permille;                  // Load sent since the last report, stuff bits included
+    uint16_t framesPerSecond;           // Sent
+    uint16_t lost;                      // Totals, saturated
+    uint8_t reordered;
+    uint8_t corrupted;
+}canGenReport;
+
+extern canGenStats canGenCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint8_t canGenStart(const canGenMix *mix);
+void canGenService(void);
+void canGenCheck(const dataFrame *frame);
+void canGenGet(canGenReport *report);
+
+#endif	/* CAN_GEN_H */
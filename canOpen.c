@@ -0,0 +1,675 @@
+/* File:  canOpen.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Minimal CANopen slave (see canOpen.h). Two sides:
+ *   receive path (interrupt): canOpenReceive() takes the SYNC and the RPDO out of the receive
+ *       queue; at a SYNC the TPDO is packed from the process image and queued to the SPI engine
+ *       (canAnswerAsync()), and a synchronous RPDO is unpacked;
+ *   main loop: canOpenHandler() (NMT, SDO requests) and canOpenService() (boot-up, heartbeat,
+ *       SDO responses and timeout) on CANOPEN_TXB.
+ * The SDO server walks the dictionary table, the PDOs never do: their pack and unpack code is
+ * expanded from the mapping lists.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canOpen.h"
+#include "eeConfig.h"
+#include "timer.h"
+
+#define CANOPEN_IDH(cob)        ((uint8_t)((cob) >> 3))
+#define CANOPEN_IDL(cob)        ((uint8_t)((cob) << 5))
+
+// Dictionary entry access. CANOPEN_ARRAY: (sub) of the entry is the number of elements, (size)
+// the size of one; sub-index 0 reads that number, 1..n the elements.
+#define CANOPEN_RO              0x01
+#define CANOPEN_WO              0x02
+#define CANOPEN_RW              0x03
+#define CANOPEN_ARRAY           0x04
+
+#define CANOPEN_SDO_BUFFER      32      // Largest object, the transfers go through a copy
+#define CANOPEN_SDO_IDLE        0
+#define CANOPEN_SDO_DOWNLOAD    1
+#define CANOPEN_SDO_UPLOAD      2
+#define CANOPEN_STORE_SAVE      0x65766173UL    // "save", 0x1010:01
+
+// Pack and unpack, little endian, one byte move each.
+#define CANOPEN_PUT_8(p, v)     do { *(p)++ = (uint8_t)(v); } while (0)
+#define CANOPEN_PUT_16(p, v)    do { uint16_t v16 = (uint16_t)(v); *(p)++ = (uint8_t)v16; *(p)++ = (uint8_t)(v16 >> 8); } while (0)
+#define CANOPEN_PUT_32(p, v)    do { uint32_t v32 = (uint32_t)(v); *(p)++ = (uint8_t)v32; *(p)++ = (uint8_t)(v32 >> 8); \
+                                     *(p)++ = (uint8_t)(v32 >> 16); *(p)++ = (uint8_t)(v32 >> 24); } while (0)
+#define CANOPEN_GET_8(p, v)     do { (v) = *(p)++; } while (0)
+#define CANOPEN_GET_16(p, v)    do { (v) = (p)[0] | ((uint16_t)(p)[1] << 8); (p) += 2; } while (0)
+#define CANOPEN_GET_32(p, v)    do { (v) = (p)[0] | ((uint16_t)(p)[1] << 8) | ((uint32_t)(p)[2] << 16) \
+                                     | ((uint32_t)(p)[3] << 24); (p) += 4; } while (0)
+
+#define CANOPEN_PACK(index, sub, bits, var)         CANOPEN_PUT_##bits(p, var);
+#define CANOPEN_UNPACK(index, sub, bits, var)       CANOPEN_GET_##bits(p, var);
+#define CANOPEN_MAP_ENTRY(index, sub, bits, var)    ((uint32_t)(index) << 16) | ((uint32_t)(sub) << 8) | (bits),
+#define CANOPEN_OD_TPDO(index, sub, bits, var)      { index, sub, CANOPEN_RO, (bits) / 8, (const void *)&(var), 0 },
+#define CANOPEN_OD_RPDO(index, sub, bits, var)      { index, sub, CANOPEN_RW, (bits) / 8, (const void *)&(var), 0 },
+
+typedef struct
+{
+    uint16_t index;
+    uint8_t sub;
+    uint8_t access;
+    uint8_t size;                       // Bytes
+    const void *data;                   // Little endian, as in the PIC RAM
+    uint32_t (*write)(const uint8_t *value);    // 0: plain copy, else stores (value), returns an abort code or 0
+}canOpenEntry;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint8_t size;
+    uint8_t access;
+    uint32_t (*write)(const uint8_t *value);
+}canOpenObject;
+
+volatile canOpenProcessImage canOpenIo;
+canOpenStats canOpenCount;
+volatile uint8_t canOpenState;
+
+static uint8_t canOpenNode;
+static uint16_t canOpenHeartbeatMs;     // 0x1017
+static volatile uint8_t canOpenTpdoType;        // 0x1800:02
+static uint32_t canOpenTpdoCob;         // 0x1800:01
+static uint32_t canOpenRpdoCob;         // 0x1400:01
+static uint8_t canOpenTpdoIdh;
+static uint8_t canOpenTpdoIdl;
+static uint8_t canOpenRpdoIdh;
+static uint8_t canOpenRpdoIdl;
+static uint8_t canOpenSyncs;            // SYNC since the last TPDO
+static uint8_t canOpenTpdoData[8];
+static uint8_t canOpenRpdoData[8];
+static volatile uint8_t canOpenRpdoNew; // RPDO waiting for the SYNC
+
+static uint16_t canOpenLast;            // timerMillisTick()
+static uint16_t canOpenHeartbeatCount;
+static uint8_t canOpenBootDue;
+static uint8_t canOpenHeartbeatDue;
+
+static uint8_t canOpenSdoState;
+static canOpenObject canOpenSdoObject;
+static uint16_t canOpenSdoIndex;
+static uint8_t canOpenSdoSub;
+static uint8_t canOpenSdoSize;
+static uint8_t canOpenSdoOffset;
+static uint8_t canOpenSdoToggle;        // 0x00 or 0x10, the toggle bit expected next
+static uint16_t canOpenSdoMs;           // Since the last request
+static uint8_t canOpenSdoBuffer[CANOPEN_SDO_BUFFER];
+static uint8_t canOpenSdoReply[8];
+static uint8_t canOpenSdoReplyDue;
+
+static const uint32_t canOpenDeviceType = 0x00030191UL;        // CiA 401, digital in and out
+static const uint8_t canOpenErrorRegister = 0x00;
+static const uint32_t canOpenSyncCob = CANOPEN_COB_SYNC;
+static const char canOpenDeviceName[] = "CAN_ONE PIC18F4550";
+static const uint32_t canOpenVendorId = 0x00000000UL;
+static const uint8_t canOpenOne = 1;
+static const uint8_t canOpenTwo = 2;
+static const uint8_t canOpenRpdoType = CANOPEN_RPDO_SYNC ? 1 : 0xFF;
+static const uint32_t canOpenTpdo1Map[] = { CANOPEN_TPDO1_MAP(CANOPEN_MAP_ENTRY) };
+static const uint32_t canOpenRpdo1Map[] = { CANOPEN_RPDO1_MAP(CANOPEN_MAP_ENTRY) };
+#if EE_CONFIG
+static const uint32_t canOpenStoreFlags = 0x00000001UL;         // Saves on command
+#endif
+
+static uint32_t canOpenTpdoTypeWrite(const uint8_t *value);
+#if EE_CONFIG
+static uint32_t canOpenStore(const uint8_t *value);
+#endif
+
+static const canOpenEntry canOpenDictionary[] =
+{
+    { 0x1000, 0x00, CANOPEN_RO, 4, &canOpenDeviceType, 0 },
+    { 0x1001, 0x00, CANOPEN_RO, 1, &canOpenErrorRegister, 0 },
+    { 0x1005, 0x00, CANOPEN_RO, 4, &canOpenSyncCob, 0 },
+    { 0x1008, 0x00, CANOPEN_RO, sizeof(canOpenDeviceName) - 1, canOpenDeviceName, 0 },
+#if EE_CONFIG
+    { 0x1010, 0x00, CANOPEN_RO, 1, &canOpenOne, 0 },
+    { 0x1010, 0x01, CANOPEN_RW, 4, &canOpenStoreFlags, canOpenStore },
+#endif
+    { 0x1017, 0x00, CANOPEN_RW, 2, &canOpenHeartbeatMs, 0 },
+    { 0x1018, 0x00, CANOPEN_RO, 1, &canOpenOne, 0 },
+    { 0x1018, 0x01, CANOPEN_RO, 4, &canOpenVendorId, 0 },
+    { 0x1400, 0x00, CANOPEN_RO, 1, &canOpenTwo, 0 },
+    { 0x1400, 0x01, CANOPEN_RO, 4, &canOpenRpdoCob, 0 },
+    { 0x1400, 0x02, CANOPEN_RO, 1, &canOpenRpdoType, 0 },
+    { 0x1600, 0 CANOPEN_RPDO1_MAP(CANOPEN_MAP_COUNT), CANOPEN_RO | CANOPEN_ARRAY, 4, canOpenRpdo1Map, 0 },
+    { 0x1800, 0x00, CANOPEN_RO, 1, &canOpenTwo, 0 },
+    { 0x1800, 0x01, CANOPEN_RO, 4, &canOpenTpdoCob, 0 },
+    { 0x1800, 0x02, CANOPEN_RW, 1, (const void *)&canOpenTpdoType, canOpenTpdoTypeWrite },
+    { 0x1A00, 0 CANOPEN_TPDO1_MAP(CANOPEN_MAP_COUNT), CANOPEN_RO | CANOPEN_ARRAY, 4, canOpenTpdo1Map, 0 },
+    { 0x2001, 0x00, CANOPEN_RW, EE_CONFIG_PARAMS, eeConfig.param, 0 },  // Application parameters
+    CANOPEN_TPDO1_MAP(CANOPEN_OD_TPDO)
+    CANOPEN_RPDO1_MAP(CANOPEN_OD_RPDO)
+};
+
+
+/*******************************************************************************
+ * FUNCTION: static void canOpenReset(void)
+ * Description: Reset communication: the communication objects back to their defaults, the
+ * boot-up message queued and PRE-OPERATIONAL.
+ *******************************************************************************/
+static void canOpenReset(void)
+{
+    canOpenState = CANOPEN_INITIALISATION;
+    canOpenHeartbeatMs = CANOPEN_HEARTBEAT_MS;
+    canOpenTpdoType = CANOPEN_TPDO_TYPE;
+    canOpenTpdoCob = CANOPEN_COB_TPDO1 + canOpenNode;
+    canOpenRpdoCob = CANOPEN_COB_RPDO1 + canOpenNode;
+    canOpenTpdoIdh = CANOPEN_IDH(canOpenTpdoCob);
+    canOpenTpdoIdl = CANOPEN_IDL(canOpenTpdoCob);
+    canOpenRpdoIdh = CANOPEN_IDH(canOpenRpdoCob);
+    canOpenRpdoIdl = CANOPEN_IDL(canOpenRpdoCob);
+    canOpenSyncs = 0;
+    canOpenRpdoNew = 0;
+    canOpenSdoState = CANOPEN_SDO_IDLE;
+    canOpenSdoReplyDue = 0;
+    canOpenHeartbeatDue = 0;
+    canOpenHeartbeatCount = 0;
+    canOpenBootDue = 1;
+    canOpenState = CANOPEN_PRE_OPERATIONAL;
+    
+} // end static void canOpenReset(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canOpenIni(uint8_t node)
+ * Description: Starts the slave as node (node, 1..127): boot-up, then PRE-OPERATIONAL until the
+ * NMT master starts it.
+ *******************************************************************************/
+void canOpenIni(uint8_t node)
+{
+    canOpenNode = node & 0x7F;
+    canOpenLast = timerMicros();
+    canOpenReset();
+    
+} // end void canOpenIni(uint8_t node) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canOpenTpdoSend(void)
+ * Description: Queues the TPDO in CANOPEN_TPDO_TXB, from the receive path. Returns MCP2515_OK or
+ * MCP2515_ERR_BUSY when the previous TPDO is still waiting for the bus.
+ *******************************************************************************/
+static uint8_t canOpenTpdoSend(void)
+{
+#if CAN_SPI_ASYNC
+    return canAnswerAsync(CANOPEN_TPDO_TXB, canOpenTpdoIdh, canOpenTpdoIdl, CANOPEN_TPDO1_DLC, canOpenTpdoData);
+#else
+    if (mcp2515ReadStatus() & STAT_TXnREQ(CANOPEN_TPDO_TXB))
+        return MCP2515_ERR_BUSY;
+    mcp2515TxLoadId(CANOPEN_TPDO_TXB, canOpenTpdoIdh, canOpenTpdoIdl, CANOPEN_TPDO1_DLC, canOpenTpdoData);
+    return MCP2515_OK;
+#endif
+    
+} // end static uint8_t canOpenTpdoSend(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canOpenRpdoApply(void)
+ * Description: Unpacks the RPDO into the process image.
+ *******************************************************************************/
+static void canOpenRpdoApply(void)
+{
+    const uint8_t *p = canOpenRpdoData;
+    
+    CANOPEN_RPDO1_MAP(CANOPEN_UNPACK)
+    canOpenCount.rpdos++;
+    
+} // end static void canOpenRpdoApply(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canOpenReceive(const dataFrame *frame)
+ * Description: Receive path hook (can.c, interrupt): SYNC and RPDO. A SYNC in OPERATIONAL sends
+ * the TPDO every canOpenTpdoType SYNC, packed now, and applies the RPDO received before it.
+ * Returns 1 when the frame was taken, so it is not queued.
+ *******************************************************************************/
+uint8_t canOpenReceive(const dataFrame *frame)
+{
+    if ((frame->idh == CANOPEN_IDH(CANOPEN_COB_SYNC)) && (frame->idl == CANOPEN_IDL(CANOPEN_COB_SYNC)))
+    {
+        if (canOpenState != CANOPEN_OPERATIONAL)
+            return 1;
+        canOpenCount.syncs++;
+    
+        if (++canOpenSyncs >= canOpenTpdoType)
+        {
+            uint8_t *p = canOpenTpdoData;
+    
+            canOpenSyncs = 0;
+            CANOPEN_TPDO1_MAP(CANOPEN_PACK)
+            if (canOpenTpdoSend() == MCP2515_OK)
+                canOpenCount.tpdos++;
+            else
+                canOpenCount.tpdoMissed++;
+        }
+    
+        if (canOpenRpdoNew)
+        {
+            canOpenRpdoNew = 0;
+            canOpenRpdoApply();
+        }
+        return 1;
+    }
+    
+    if ((frame->idh == canOpenRpdoIdh) && (frame->idl == canOpenRpdoIdl) && !(frame->dlc & CAN_RTR))
+    {
+        if (canOpenState != CANOPEN_OPERATIONAL)
+            return 1;
+        if ((frame->dlc & CAN_DLC_MASK) < CANOPEN_RPDO1_DLC)
+        {
+            canOpenCount.rpdoErrors++;
+            return 1;
+        }
+        for (uint8_t i = 0; i < CANOPEN_RPDO1_DLC; i++)
+        {
+            canOpenRpdoData[i] = frame->data[i];
+        }
+#if CANOPEN_RPDO_SYNC
+        canOpenRpdoNew = 1;
+#else
+        canOpenRpdoApply();
+#endif
+        return 1;
+    }
+    
+    return 0;
+    
+} // end uint8_t canOpenReceive(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t canOpenFind(uint16_t index, uint8_t sub, canOpenObject *object)
+ * Description: Dictionary lookup. Returns 0 or the abort code.
+ *******************************************************************************/
+static uint32_t canOpenFind(uint16_t index, uint8_t sub, canOpenObject *object)
+{
+    uint32_t abort = CANOPEN_ABORT_OBJECT;
+    const canOpenEntry *entry = canOpenDictionary;
+    
+    for (uint8_t i = 0; i < sizeof(canOpenDictionary) / sizeof(canOpenDictionary[0]); i++, entry++)
+    {
+        if (entry->index != index)
+            continue;
+        abort = CANOPEN_ABORT_SUB;
+        if (entry->access & CANOPEN_ARRAY)
+        {
+            if (sub > entry->sub)
+                continue;
+            object->access = CANOPEN_RO;
+            object->write = 0;
+            object->size = sub ? entry->size : 1;
+            object->data = sub ? (const uint8_t *)entry->data + (uint8_t)((sub - 1) * entry->size) : &entry->sub;
+            return 0;
+        }
+        if (entry->sub == sub)
+        {
+            object->access = entry->access;
+            object->write = entry->write;
+            object->size = entry->size;
+            object->data = entry->data;
+            return 0;
+        }
+    }
+    
+    return abort;
+    
+} // end static uint32_t canOpenFind(uint16_t index, uint8_t sub, canOpenObject *object) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t canOpenWrite(const canOpenObject *object, const uint8_t *value)
+ * Description: Stores (value) in the object, with GIE off: the receive path reads and writes the
+ * process image. Returns 0 or the abort code.
+ *******************************************************************************/
+static uint32_t canOpenWrite(const canOpenObject *object, const uint8_t *value)
+{
+    uint8_t *data = (uint8_t *)object->data;
+    uint8_t gie = INTCONbits.GIE;
+    
+    if (object->write)
+        return object->write(value);
+    
+    INTCONbits.GIE = 0;
+    for (uint8_t i = 0; i < object->size; i++)
+    {
+        data[i] = value[i];
+    }
+    INTCONbits.GIE = gie;
+    
+    return 0;
+    
+} // end static uint32_t canOpenWrite(const canOpenObject *object, const uint8_t *value) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canOpenRead(const canOpenObject *object, uint8_t *value)
+ * Description: Copies the object to (value), with GIE off.
+ *******************************************************************************/
+static void canOpenRead(const canOpenObject *object, uint8_t *value)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    INTCONbits.GIE = 0;
+    for (uint8_t i = 0; i < object->size; i++)
+    {
+        value[i] = object->data[i];
+    }
+    INTCONbits.GIE = gie;
+    
+} // end static void canOpenRead(const canOpenObject *object, uint8_t *value) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t canOpenTpdoTypeWrite(const uint8_t *value)
+ * Description: 0x1800:02, synchronous transmission types only (every 1..240 SYNC).
+ *******************************************************************************/
+static uint32_t canOpenTpdoTypeWrite(const uint8_t *value)
+{
+    if ((value[0] == 0) || (value[0] > 240))
+        return CANOPEN_ABORT_RANGE;
+    
+    canOpenTpdoType = value[0];
+    
+    return 0;
+    
+} // end static uint32_t canOpenTpdoTypeWrite(const uint8_t *value) function
+
+
+#if EE_CONFIG
+/*******************************************************************************
+ * FUNCTION: static uint32_t canOpenStore(const uint8_t *value)
+ * Description: 0x1010:01, "save": eeConfigSave() (CAN setup, node address, parameters 0x2001).
+ *******************************************************************************/
+static uint32_t canOpenStore(const uint8_t *value)
+{
+    uint32_t signature = value[0] | ((uint16_t)value[1] << 8) | ((uint32_t)value[2] << 16) | ((uint32_t)value[3] << 24);
+    
+    if ((signature != CANOPEN_STORE_SAVE) || (eeConfigSave() != EE_CONFIG_OK))
+        return CANOPEN_ABORT_STORE;
+    
+    return 0;
+    
+} // end static uint32_t canOpenStore(const uint8_t *value) function
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: static void canOpenSdoAbort(uint16_t index, uint8_t sub, uint32_t code)
+ * Description: Abort transfer response; the transfer in progress ends.
+ *******************************************************************************/
+static void canOpenSdoAbort(uint16_t index, uint8_t sub, uint32_t code)
+{
+    canOpenSdoReply[0] = 0x80;
+    canOpenSdoReply[1] = (uint8_t)index;
+    canOpenSdoReply[2] = (uint8_t)(index >> 8);
+    canOpenSdoReply[3] = sub;
+    canOpenSdoReply[4] = (uint8_t)code;
+    canOpenSdoReply[5] = (uint8_t)(code >> 8);
+    canOpenSdoReply[6] = (uint8_t)(code >> 16);
+    canOpenSdoReply[7] = (uint8_t)(code >> 24);
+    canOpenSdoReplyDue = 1;
+    canOpenSdoState = CANOPEN_SDO_IDLE;
+    canOpenCount.sdoAborts++;
+    
+} // end static void canOpenSdoAbort(uint16_t index, uint8_t sub, uint32_t code) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canOpenSdoRequest(const uint8_t *request)
+ * Description: SDO server, one request (CiA 301 7.2.4.3): initiate download and upload, expedited
+ * or segmented, the segments, and the abort from the client. The answer is sent by
+ * canOpenService().
+ *******************************************************************************/
+static void canOpenSdoRequest(const uint8_t *request)
+{
+    uint8_t command = request[0];
+    uint16_t index = request[1] | ((uint16_t)request[2] << 8);
+    uint8_t sub = request[3];
+    uint32_t abort = 0;
+    uint8_t count;
+    
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        canOpenSdoReply[i] = 0;
+    }
+    canOpenSdoMs = 0;
+    
+    switch (command >> 5)
+    {
+        case 1:     // Initiate download
+            canOpenSdoState = CANOPEN_SDO_IDLE;
+            abort = canOpenFind(index, sub, &canOpenSdoObject);
+            if (!abort && !(canOpenSdoObject.access & CANOPEN_WO))
+                abort = CANOPEN_ABORT_WRITE;
+            if (!abort && (command & 0x02))
+            {
+                // Expedited: 4 data bytes at most, size indicated or not.
+                count = (command & 0x01) ? 4 - ((command >> 2) & 0x03) : canOpenSdoObject.size;
+                abort = ((count != canOpenSdoObject.size) || (count > 4)) ? CANOPEN_ABORT_LENGTH
+                        : canOpenWrite(&canOpenSdoObject, &request[4]);
+            }
+            else if (!abort)
+            {
+                if (!(command & 0x01) || (request[4] != canOpenSdoObject.size) || request[5] || request[6] || request[7])
+                    abort = CANOPEN_ABORT_LENGTH;
+                canOpenSdoState = CANOPEN_SDO_DOWNLOAD;
+                canOpenSdoSize = canOpenSdoObject.size;
+            }
+            canOpenSdoReply[0] = 0x60;
+            break;
+    
+        case 0:     // Download segment
+            index = canOpenSdoIndex;
+            sub = canOpenSdoSub;
+            count = 7 - ((command >> 1) & 0x07);
+            if (canOpenSdoState != CANOPEN_SDO_DOWNLOAD)
+                abort = CANOPEN_ABORT_COMMAND;
+            else if ((command & 0x10) != canOpenSdoToggle)
+                abort = CANOPEN_ABORT_TOGGLE;
+            else if (canOpenSdoOffset + count > canOpenSdoSize)
+                abort = CANOPEN_ABORT_LENGTH;
+            else
+            {
+                for (uint8_t i = 0; i < count; i++)
+                {
+                    canOpenSdoBuffer[canOpenSdoOffset++] = request[1 + i];
+                }
+                canOpenSdoReply[0] = 0x20 | canOpenSdoToggle;
+                canOpenSdoToggle ^= 0x10;
+                if (command & 0x01)
+                {
+                    canOpenSdoState = CANOPEN_SDO_IDLE;
+                    abort = (canOpenSdoOffset != canOpenSdoSize) ? CANOPEN_ABORT_LENGTH
+                            : canOpenWrite(&canOpenSdoObject, canOpenSdoBuffer);
+                }
+            }
+            break;
+    
+        case 2:     // Initiate upload
+            canOpenSdoState = CANOPEN_SDO_IDLE;
+            abort = canOpenFind(index, sub, &canOpenSdoObject);
+            if (!abort && !(canOpenSdoObject.access & CANOPEN_RO))
+                abort = CANOPEN_ABORT_READ;
+            if (abort)
+                break;
+            canOpenSdoSize = canOpenSdoObject.size;
+            canOpenRead(&canOpenSdoObject, canOpenSdoBuffer);
+            if (canOpenSdoSize <= 4)
+            {
+                canOpenSdoReply[0] = 0x43 | (uint8_t)((4 - canOpenSdoSize) << 2);
+                for (uint8_t i = 0; i < canOpenSdoSize; i++)
+                {
+                    canOpenSdoReply[4 + i] = canOpenSdoBuffer[i];
+                }
+            }
+            else
+            {
+                canOpenSdoReply[0] = 0x41;
+                canOpenSdoReply[4] = canOpenSdoSize;
+                canOpenSdoState = CANOPEN_SDO_UPLOAD;
+            }
+            break;
+    
+        case 3:     // Upload segment
+            index = canOpenSdoIndex;
+            sub = canOpenSdoSub;
+            if (canOpenSdoState != CANOPEN_SDO_UPLOAD)
+                abort = CANOPEN_ABORT_COMMAND;
+            else if ((command & 0x10) != canOpenSdoToggle)
+                abort = CANOPEN_ABORT_TOGGLE;
+            else
+            {
+                count = canOpenSdoSize - canOpenSdoOffset;
+                if (count > 7)
+                    count = 7;
+                canOpenSdoReply[0] = canOpenSdoToggle | (uint8_t)((7 - count) << 1);
+                for (uint8_t i = 0; i < count; i++)
+                {
+                    canOpenSdoReply[1 + i] = canOpenSdoBuffer[canOpenSdoOffset++];
+                }
+                if (canOpenSdoOffset == canOpenSdoSize)
+                {
+                    canOpenSdoReply[0] |= 0x01;
+                    canOpenSdoState = CANOPEN_SDO_IDLE;
+                }
+                canOpenSdoToggle ^= 0x10;
+            }
+            canOpenSdoReplyDue = !abort;
+            break;
+    
+        case 4:     // Abort from the client: no answer
+            canOpenSdoState = CANOPEN_SDO_IDLE;
+            return;
+    
+        default:
+            abort = CANOPEN_ABORT_COMMAND;
+            break;
+    }
+    
+    if (abort)
+    {
+        canOpenSdoAbort(index, sub, abort);
+        return;
+    }
+    
+    // Initiate and segment answers: the segments carry no index, the initiate ones do.
+    if ((command >> 5) == 1 || (command >> 5) == 2)
+    {
+        canOpenSdoReply[1] = (uint8_t)index;
+        canOpenSdoReply[2] = (uint8_t)(index >> 8);
+        canOpenSdoReply[3] = sub;
+        canOpenSdoIndex = index;
+        canOpenSdoSub = sub;
+        canOpenSdoOffset = 0;
+        canOpenSdoToggle = 0;
+    }
+    canOpenSdoReplyDue = 1;
+    
+} // end static void canOpenSdoRequest(const uint8_t *request) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canOpenHandler(const dataFrame *frame)
+ * Description: Default handler of canDispatch.def: NMT commands to this node or to all, and the
+ * SDO requests (not in STOPPED). Other identifiers are ignored, as is everything before
+ * canOpenIni().
+ *******************************************************************************/
+void canOpenHandler(const dataFrame *frame)
+{
+    uint16_t id = ((uint16_t)frame->idh << 3) | (frame->idl >> 5);
+    
+    if (!canOpenNode)       // canOpenIni() not run (CANOPEN = 0)
+        return;
+    if ((id == CANOPEN_COB_NMT) && ((frame->dlc & (CAN_RTR | CAN_DLC_MASK)) == 2)
+        && (!frame->data[1] || (frame->data[1] == canOpenNode)))
+    {
+        switch (frame->data[0])
+        {
+            case CANOPEN_NMT_START:
+                canOpenState = CANOPEN_OPERATIONAL;
+                break;
+            case CANOPEN_NMT_STOP:
+                canOpenState = CANOPEN_STOPPED;
+                canOpenSdoState = CANOPEN_SDO_IDLE;
+                break;
+            case CANOPEN_NMT_PRE_OP:
+                canOpenState = CANOPEN_PRE_OPERATIONAL;
+                break;
+            case CANOPEN_NMT_RESET_NODE:
+                RESET();
+                canOpenReset();     // Host build: RESET() returns
+                break;
+            case CANOPEN_NMT_RESET_COMM:
+                canOpenReset();
+                break;
+            default:
+                break;
+        }
+    }
+    else if ((id == CANOPEN_COB_SDO_RX + canOpenNode) && ((frame->dlc & (CAN_RTR | CAN_DLC_MASK)) == 8)
+             && (canOpenState != CANOPEN_STOPPED))
+    {
+        canOpenSdoRequest(frame->data);
+    }
+    
+} // end void canOpenHandler(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canOpenService(void)
+ * Description: Main loop side: heartbeat period and SDO timeout, then one frame on CANOPEN_TXB
+ * when its previous one is out: the boot-up, an SDO answer, or the heartbeat, in that order.
+ * Call it at least every 65 ms.
+ *******************************************************************************/
+void canOpenService(void)
+{
+    uint16_t cob = CANOPEN_COB_HEARTBEAT + canOpenNode;
+    uint8_t state = canOpenState;
+    
+    while (timerMillisTick(&canOpenLast))
+    {
+        if (canOpenHeartbeatMs && (++canOpenHeartbeatCount >= canOpenHeartbeatMs))
+        {
+            canOpenHeartbeatCount = 0;
+            canOpenHeartbeatDue = 1;
+        }
+        if ((canOpenSdoState != CANOPEN_SDO_IDLE) && (++canOpenSdoMs >= CANOPEN_SDO_TIMEOUT_MS))
+            canOpenSdoAbort(canOpenSdoIndex, canOpenSdoSub, CANOPEN_ABORT_TIMEOUT);
+    }
+    
+    if (!canOpenBootDue && !canOpenSdoReplyDue && !canOpenHeartbeatDue)
+        return;
+    if (mcp2515ReadStatus() & STAT_TXnREQ(CANOPEN_TXB))
+        return;
+    
+    if (canOpenBootDue)
+    {
+        state = CANOPEN_INITIALISATION;
+        canOpenBootDue = 0;
+    }
+    else if (canOpenSdoReplyDue)
+    {
+        cob = CANOPEN_COB_SDO_TX + canOpenNode;
+        mcp2515TxLoadId(CANOPEN_TXB, CANOPEN_IDH(cob), CANOPEN_IDL(cob), 8, canOpenSdoReply);
+        canOpenSdoReplyDue = 0;
+        return;
+    }
+    else
+        canOpenHeartbeatDue = 0;
+    mcp2515TxLoadId(CANOPEN_TXB, CANOPEN_IDH(cob), CANOPEN_IDL(cob), 1, &state);
+    
+} // end void canOpenService(void) function
+
@@ -0,0 +1,141 @@
+/* File:  canOpen.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Minimal CANopen slave (CiA 301) on the driver: NMT state machine with boot-up and
+ * heartbeat, one synchronous TPDO and one RPDO with their mapping fixed at compile time, and an
+ * SDO server (expedited and segmented transfers) on a small object dictionary. The SYNC is taken
+ * in the receive path (can.c), in the interrupt: the TPDO is packed and queued there, so its
+ * latency is the SPI traffic only, whatever the main loop is doing. No dynamic allocation.
+ *
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ *
+ * Author: Antonio Aparecido Ariza Castilho;
+ *
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CANOPEN_H
+#define	CANOPEN_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CANOPEN = 1: main.c runs canOpenIni() and a loop around canOpenService() and canDispatch(); the
+// SYNC and the RPDO are taken by the receive path and the other frames reach canOpenHandler(), the
+// default handler of canDispatch.def. The INT2 interrupt has to be enabled (canInterruptEnable()).
+// Use SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h): the SYNC to TPDO latency is about 30 SPI bytes.
+// The SYNC identifier, 0x080, is the one of the NODE_STATUS demo message: not on the same bus.
+#ifndef CANOPEN
+    #define CANOPEN                 0
+#endif
+#ifndef CANOPEN_NODE_ID
+    #define CANOPEN_NODE_ID         0x05    // 1..127; eeConfig.node with EE_CONFIG
+#endif
+#ifndef CANOPEN_HEARTBEAT_MS
+    #define CANOPEN_HEARTBEAT_MS    1000    // 0x1017 after a reset, 0: no heartbeat
+#endif
+#ifndef CANOPEN_TPDO_TYPE
+    #define CANOPEN_TPDO_TYPE       1       // 0x1800:02 after a reset: sent every n SYNC (1..240)
+#endif
+#ifndef CANOPEN_RPDO_SYNC
+    #define CANOPEN_RPDO_SYNC       1       // 1: the RPDO takes effect at the next SYNC, 0: at once
+#endif
+#ifndef CANOPEN_SDO_TIMEOUT_MS
+    #define CANOPEN_SDO_TIMEOUT_MS  1000    // Segmented transfer aborted without a segment this long
+#endif
+#ifndef CANOPEN_TPDO_TXB
+    #define CANOPEN_TPDO_TXB        1       // Taken by the TPDO (receive path)
+#endif
+#ifndef CANOPEN_TXB
+    #define CANOPEN_TXB             0       // Boot-up, heartbeat and SDO responses (main loop)
+#endif
+
+// NMT states, as in the heartbeat, and commands (CiA 301 7.2.8)
+#define CANOPEN_INITIALISATION  0x00
+#define CANOPEN_STOPPED         0x04
+#define CANOPEN_OPERATIONAL     0x05
+#define CANOPEN_PRE_OPERATIONAL 0x7F
+
+#define CANOPEN_NMT_START       0x01
+#define CANOPEN_NMT_STOP        0x02
+#define CANOPEN_NMT_PRE_OP      0x80
+#define CANOPEN_NMT_RESET_NODE  0x81
+#define CANOPEN_NMT_RESET_COMM  0x82
+
+// Function codes of the predefined connection set, identifier = code + node id
+#define CANOPEN_COB_NMT         0x000
+#define CANOPEN_COB_SYNC        0x080
+#define CANOPEN_COB_TPDO1       0x180
+#define CANOPEN_COB_RPDO1       0x200
+#define CANOPEN_COB_SDO_TX      0x580
+#define CANOPEN_COB_SDO_RX      0x600
+#define CANOPEN_COB_HEARTBEAT   0x700
+
+// SDO abort codes (CiA 301 7.2.4.3.17)
+#define CANOPEN_ABORT_TOGGLE    0x05030000UL    // Toggle bit not alternated
+#define CANOPEN_ABORT_TIMEOUT   0x05040000UL
+#define CANOPEN_ABORT_COMMAND   0x05040001UL    // Command specifier not valid
+#define CANOPEN_ABORT_READ      0x06010001UL    // Read of a write only object
+#define CANOPEN_ABORT_WRITE     0x06010002UL    // Write of a read only object
+#define CANOPEN_ABORT_OBJECT    0x06020000UL    // Object does not exist
+#define CANOPEN_ABORT_LENGTH    0x06070010UL    // Length does not match
+#define CANOPEN_ABORT_SUB       0x06090011UL    // Sub-index does not exist
+#define CANOPEN_ABORT_RANGE     0x06090030UL    // Value out of range
+#define CANOPEN_ABORT_STORE     0x08000020UL    // Cannot be stored
+#define CANOPEN_ABORT_STATE     0x08000022UL    // Not in the present device state
+
+/* Process image and PDO mapping. Each X(index, subindex, bits, variable) entry is one mapped
+ * object, 8, 16 or 32 bits, in frame order: the pack and unpack code is expanded from the lists
+ * into plain byte moves (canOpen.c), and the same lists give the mapping objects 0x1A00/0x1600
+ * and the dictionary entries of the variables. The TPDO is packed in the interrupt and the RPDO
+ * unpacked there: the main loop writes the TPDO variables and reads the RPDO ones wider than a
+ * byte with GIE off. */
+typedef struct
+{
+    uint8_t inputs;                     // 0x6000:01 digital inputs
+    uint16_t analog[2];                 // 0x6401:01..02 analog inputs
+    uint8_t outputs;                    // 0x6200:01 digital outputs
+    int16_t setpoint;                   // 0x6411:01 analog output
+}canOpenProcessImage;
+
+extern volatile canOpenProcessImage canOpenIo;
+
+#define CANOPEN_TPDO1_MAP(X) \
+    X(0x6000, 0x01, 8, canOpenIo.inputs) \
+    X(0x6401, 0x01, 16, canOpenIo.analog[0]) \
+    X(0x6401, 0x02, 16, canOpenIo.analog[1])
+
+#define CANOPEN_RPDO1_MAP(X) \
+    X(0x6200, 0x01, 8, canOpenIo.outputs) \
+    X(0x6411, 0x01, 16, canOpenIo.setpoint)
+
+#define CANOPEN_MAP_BYTES(index, sub, bits, var)    + (bits) / 8
+#define CANOPEN_MAP_COUNT(index, sub, bits, var)    + 1
+#define CANOPEN_TPDO1_DLC       (0 CANOPEN_TPDO1_MAP(CANOPEN_MAP_BYTES))
+#define CANOPEN_RPDO1_DLC       (0 CANOPEN_RPDO1_MAP(CANOPEN_MAP_BYTES))
+
+typedef struct
+{
+    uint16_t syncs;                     // SYNC frames taken in OPERATIONAL
+    uint16_t tpdos;                     // TPDO queued
+    uint16_t tpdoMissed;                // TPDO due while the previous one was still in its buffer
+    uint16_t rpdos;                     // RPDO applied
+    uint16_t rpdoErrors;                // RPDO shorter than its mapping
+    uint16_t sdoAborts;                 // SDO transfers aborted by this server
+}canOpenStats;
+
+extern canOpenStats canOpenCount;
+extern volatile uint8_t canOpenState;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void canOpenIni(uint8_t node);
+uint8_t canOpenReceive(const dataFrame *frame);
+void canOpenHandler(const dataFrame *frame);
+void canOpenService(void);
+
+#endif	/* CANOPEN_H */
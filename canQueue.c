@@ -0,0 +1,293 @@
+/* File:  canQueue.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Receive queue and remote frame answers of the CAN driver (see canQueue.h). The
+ * receive path of the driver (canService() or canRxDone() in the INT2 interrupt, canService() of
+ * the SocketCAN backend) is the only producer; the read functions are the only consumer.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canQueue.h"
+
+static CAN_QUEUE_RAM canPackedFrame canRxQueue[CAN_RX_QUEUE_SIZE];
+static volatile CAN_QUEUE_INDEX_RAM uint8_t canRxHead;     // Oldest message
+static volatile CAN_QUEUE_INDEX_RAM uint8_t canRxTail;     // Next free position
+static canRtrEntry canRtrTable[CAN_RTR_SLOTS];
+
+#if CAN_RX_STAMP
+uint64_t canRxStamp[CAN_RX_QUEUE_SIZE];
+#endif
+
+volatile uint8_t canRtrCount;                  // Registered remote answers
+volatile uint8_t canRxOverflow;                // Messages lost because the receive queue was full
+volatile uint8_t canRxClipped;                 // Messages queued without the data past CAN_FRAME_PAYLOAD
+volatile uint8_t canRtrAnswered;               // Remote frames answered by the receive path
+volatile uint8_t canRtrMissed;                 // Remote frames passed on because CAN_RTR_TXB was busy
+
+
+/*******************************************************************************
+ * FUNCTION: void canFramePack(canPackedFrame *packed, const dataFrame *frame)
+ * Description: Stores (frame) as a receive queue entry. A DLC over CAN_FRAME_PAYLOAD is cut to it.
+ * A remote frame keeps the DLC it requests but no data: mcp2515RxUnload() does not write any.
+ *******************************************************************************/
+void canFramePack(canPackedFrame *packed, const dataFrame *frame)
+{
+    uint8_t lenght = frame->dlc & CAN_DLC_MASK;
+    uint8_t rtr = (frame->dlc & CAN_RTR) != 0;
+    
+    if (!rtr && (lenght > CAN_FRAME_PAYLOAD))
+    {
+        if (CAN_FRAME_PAYLOAD < 8)
+            canRxClipped++;
+        lenght = CAN_FRAME_PAYLOAD;
+    }
+    
+    packed->idh = frame->idh;
+    packed->info = (frame->idl & CAN_INFO_ID_MASK) | (rtr ? CAN_INFO_RTR : 0) | lenght;
+    for (uint8_t i = 0; i < (rtr ? 0 : lenght); i++)
+    {
+        packed->data[i] = frame->data[i];
+    }
+    
+} // end void canFramePack(canPackedFrame *packed, const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canFrameUnpack(dataFrame *frame, const canPackedFrame *packed)
+ * Description: Gives back the message of a receive queue entry. The data bytes past its DLC, and
+ * all of them for a remote frame, are 0, not those of the message (frame) held before.
+ *******************************************************************************/
+void canFrameUnpack(dataFrame *frame, const canPackedFrame *packed)
+{
+    uint8_t lenght = packed->info & CAN_DLC_MASK;
+    uint8_t stored = (packed->info & CAN_INFO_RTR) ? 0 : lenght;
+    
+    frame->idh = packed->idh;
+    frame->idl = packed->info & CAN_INFO_ID_MASK;
+    frame->dlc = ((packed->info & CAN_INFO_RTR) ? CAN_RTR : 0) | lenght;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        frame->data[i] = (i < stored) ? packed->data[i] : 0;
+    }
+    
+} // end void canFrameUnpack(dataFrame *frame, const canPackedFrame *packed) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRxStore(const dataFrame *frame)
+ * Description: Producer: queues (frame). Returns the index of its entry, or CAN_RX_NONE when the
+ * queue is full (counted in canRxOverflow).
+ *******************************************************************************/
+uint8_t canRxStore(const dataFrame *frame)
+{
+    uint8_t tail = canRxTail;
+    uint8_t next = (tail + 1) & (CAN_RX_QUEUE_SIZE - 1);
+    
+    if (next == canRxHead)
+    {
+        canRxOverflow++;
+        return CAN_RX_NONE;
+    }
+    
+    canFramePack(&canRxQueue[tail], frame);
+    canRxTail = next;
+    
+    return tail;
+    
+} // end uint8_t canRxStore(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRxFetch(dataFrame *frame)
+ * Description: Consumer: takes the oldest message into (frame). Returns the index of its entry,
+ * or CAN_RX_NONE when the queue is empty.
+ *******************************************************************************/
+uint8_t canRxFetch(dataFrame *frame)
+{
+    uint8_t head = canRxHead;
+    
+    if (head == canRxTail)
+        return CAN_RX_NONE;
+    
+    canFrameUnpack(frame, &canRxQueue[head]);
+    canRxHead = (head + 1) & (CAN_RX_QUEUE_SIZE - 1);
+    
+    return head;
+    
+} // end uint8_t canRxFetch(dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRxWaiting(void)
+ * Description: Messages in the receive queue (at most CAN_RX_QUEUE_SIZE - 1).
+ *******************************************************************************/
+uint8_t canRxWaiting(void)
+{
+    return (uint8_t)(canRxTail - canRxHead) & (CAN_RX_QUEUE_SIZE - 1);
+    
+} // end uint8_t canRxWaiting(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canRxClear(void)
+ * Description: Consumer: drops the messages of the receive queue.
+ *******************************************************************************/
+void canRxClear(void)
+{
+    canRxHead = canRxTail;
+    
+} // end void canRxClear(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRxTake(uint8_t id, dataFrame *frame)
+ * Description: Takes the oldest message with identifier (id) from the receive queue. The older
+ * messages with other identifiers are moved up one position and stay queued.
+ * Returns 0 when there is no such message.
+ *******************************************************************************/
+uint8_t canRxTake(uint8_t id, dataFrame *frame)
+{
+    uint8_t found;
+    
+    if (!canIntEnabled)
+        canService();
+    
+    for (found = canRxHead; found != canRxTail; found = (found + 1) & (CAN_RX_QUEUE_SIZE - 1))
+    {
+        if (canRxQueue[found].idh == id)
+            break;
+    }
+    if (found == canRxTail)
+        return 0;
+    
+    canFrameUnpack(frame, &canRxQueue[found]);
+    
+    // Only the consumer moves canRxHead and the entries behind canRxTail, so the producer can keep
+    // filling the queue meanwhile.
+    while (found != canRxHead)
+    {
+        uint8_t previous = (found - 1) & (CAN_RX_QUEUE_SIZE - 1);
+        canRxQueue[found] = canRxQueue[previous];
+#if CAN_RX_STAMP
+        canRxStamp[found] = canRxStamp[previous];
+#endif
+        found = previous;
+    }
+    canRxHead = (canRxHead + 1) & (CAN_RX_QUEUE_SIZE - 1);
+    
+    return 1;
+    
+} // end uint8_t canRxTake(uint8_t id, dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: const canRtrEntry *canRtrFind(const dataFrame *frame)
+ * Description: Registered answer to the remote frame (frame), same 11 bit identifier, or 0.
+ *******************************************************************************/
+const canRtrEntry *canRtrFind(const dataFrame *frame)
+{
+    for (uint8_t i = 0; i < CAN_RTR_SLOTS; i++)
+    {
+        if ((canRtrTable[i].data != 0) && (canRtrTable[i].idh == frame->idh) && (canRtrTable[i].idl == frame->idl))
+            return &canRtrTable[i];
+    }
+    
+    return 0;
+    
+} // end const canRtrEntry *canRtrFind(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRtrRegister(uint8_t id, uint8_t dlc, uint8_t *data)
+ * Description: Registers the answer to remote frames with identifier (id) << 3 (see canRtrRegisterId()).
+ *******************************************************************************/
+uint8_t canRtrRegister(uint8_t id, uint8_t dlc, uint8_t *data)
+{
+    return canRtrRegisterId(id, 0x00, dlc, data);
+    
+} // end uint8_t canRtrRegister(uint8_t id, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canRtrRegisterId(uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+ * Description: Registers the answer to remote frames with identifier (idh) << 3 | (idl) >> 5: (dlc)
+ * bytes taken from (data) at the moment the request arrives, so (data) must always hold the latest
+ * values. Registering an identifier again replaces its answer.
+ * Returns MCP2515_OK or MCP2515_ERR_FULL when the CAN_RTR_SLOTS entries are in use.
+ *******************************************************************************/
+uint8_t canRtrRegisterId(uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+{
+    uint8_t slot = CAN_RTR_SLOTS;
+    uint8_t gie = INTCONbits.GIE;
+    
+    idl &= CAN_INFO_ID_MASK;
+    for (uint8_t i = 0; i < CAN_RTR_SLOTS; i++)
+    {
+        if ((canRtrTable[i].data != 0) && (canRtrTable[i].idh == idh) && (canRtrTable[i].idl == idl))
+        {
+            slot = i;
+            break;
+        }
+        if ((canRtrTable[i].data == 0) && (slot == CAN_RTR_SLOTS))
+            slot = i;
+    }
+    if (slot == CAN_RTR_SLOTS)
+        return MCP2515_ERR_FULL;
+    
+    // The reader is the INT2 interrupt, or the SSP one (canRxDone()) with CAN_SPI_ASYNC: both off
+    // while the entry is half written.
+    INTCONbits.GIE = 0;
+    if (canRtrTable[slot].data == 0)
+        canRtrCount++;
+    canRtrTable[slot].idh = idh;
+    canRtrTable[slot].idl = idl;
+    canRtrTable[slot].dlc = dlc & CAN_DLC_MASK;
+    canRtrTable[slot].data = data;
+    INTCONbits.GIE = gie;
+    
+    return MCP2515_OK;
+    
+} // end uint8_t canRtrRegisterId(uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canRtrRemove(uint8_t id)
+ * Description: Stops answering remote frames with identifier (id) << 3 (see canRtrRemoveId()).
+ *******************************************************************************/
+void canRtrRemove(uint8_t id)
+{
+    canRtrRemoveId(id, 0x00);
+    
+} // end void canRtrRemove(uint8_t id) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canRtrRemoveId(uint8_t idh, uint8_t idl)
+ * Description: Stops answering remote frames with identifier (idh) << 3 | (idl) >> 5; they reach the
+ * receive queue again.
+ *******************************************************************************/
+void canRtrRemoveId(uint8_t idh, uint8_t idl)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    idl &= CAN_INFO_ID_MASK;
+    INTCONbits.GIE = 0;
+    for (uint8_t i = 0; i < CAN_RTR_SLOTS; i++)
+    {
+        if ((canRtrTable[i].data != 0) && (canRtrTable[i].idh == idh) && (canRtrTable[i].idl == idl))
+        {
+            canRtrTable[i].data = 0;
+            canRtrCount--;
+        }
+    }
+    INTCONbits.GIE = gie;
+    
+} // end void canRtrRemoveId(uint8_t idh, uint8_t idl) function
@@ -0,0 +1,45 @@
+/* File:  canQueue.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Receive queue and remote frame answers of the CAN driver, shared by the MCP2515
+ * driver (can.c) and the SocketCAN backend (host/canSocket.c). The application reads the queue
+ * with canReceive() and canRxTake() (can.h); these functions are the driver's side of it.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_QUEUE_H
+#define	CAN_QUEUE_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CAN_RX_STAMP = 1 keeps a 64 bit receive time with each queued frame, in canRxStamp[] at the
+// index canRxStore() and canRxFetch() return (host/canSocket.c: kernel time, ns). Host builds only.
+#ifndef CAN_RX_STAMP
+    #define CAN_RX_STAMP            0
+#endif
+
+#define CAN_RX_NONE             0xFF    // canRxStore(): queue full, canRxFetch(): queue empty
+
+#if CAN_RX_STAMP
+extern uint64_t canRxStamp[CAN_RX_QUEUE_SIZE];
+#endif
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint8_t canRxStore(const dataFrame *frame);
+uint8_t canRxFetch(dataFrame *frame);
+uint8_t canRxWaiting(void);
+void canRxClear(void);
+const canRtrEntry *canRtrFind(const dataFrame *frame);
+
+#endif	/* CAN_QUEUE_H */
@@ -0,0 +1,156 @@
+/* File:  canSignals.c  (generated by tools/dbcgen.py, do not edit)
+ * ******************************************************************************
+ * Description: CAN signal pack/unpack functions.
+ *******************************************************************************/
+
+#include <xc.h>
+#include "canSignals.h"
+
+// NODE_STATUS_Counter: 0|8@1+
+uint8_t NODE_STATUS_CounterGet(const uint8_t *data)
+{
+    uint8_t value = ((uint8_t)data[0]);
+    return (uint8_t)value;
+}
+
+void NODE_STATUS_CounterSet(uint8_t *data, uint8_t value)
+{
+    uint8_t raw = (uint8_t)value;
+    data[0] = (uint8_t)raw;
+}
+
+// NODE_STATUS_SupplyVoltage: 8|12@1+
+uint16_t NODE_STATUS_SupplyVoltageGet(const uint8_t *data)
+{
+    uint16_t value = ((uint16_t)data[1])
+        | ((uint16_t)(data[2] & 0x0F) << 8);
+    return (uint16_t)value;
+}
+
+void NODE_STATUS_SupplyVoltageSet(uint8_t *data, uint16_t value)
+{
+    uint16_t raw = (uint16_t)value;
+    data[1] = (uint8_t)raw;
+    data[2] = (data[2] & 0xF0) | ((uint8_t)(raw >> 8) & 0x0F);
+}
+
+// NODE_STATUS_Temperature: 20|8@1-
+int8_t NODE_STATUS_TemperatureGet(const uint8_t *data)
+{
+    uint8_t value = ((uint8_t)(data[2] >> 4))
+        | ((uint8_t)(data[3] & 0x0F) << 4);
+    return (int8_t)value;
+}
+
+void NODE_STATUS_TemperatureSet(uint8_t *data, int8_t value)
+{
+    uint8_t raw = (uint8_t)value;
+    data[2] = (data[2] & 0x0F) | ((uint8_t)((uint8_t)raw << 4) & 0xF0);
+    data[3] = (data[3] & 0xF0) | ((uint8_t)(raw >> 4) & 0x0F);
+}
+
+// NODE_STATUS_Analog0: 39|10@0+
+uint16_t NODE_STATUS_Analog0Get(const uint8_t *data)
+{
+    uint16_t value = ((uint16_t)(data[5] >> 6))
+        | ((uint16_t)data[4] << 2);
+    return (uint16_t)value;
+}
+
+void NODE_STATUS_Analog0Set(uint8_t *data, uint16_t value)
+{
+    uint16_t raw = (uint16_t)value;
+    data[5] = (data[5] & 0x3F) | ((uint8_t)((uint8_t)raw << 6) & 0xC0);
+    data[4] = (uint8_t)(raw >> 2);
+}
+
+// NODE_STATUS_Analog1: 45|10@0+
+uint16_t NODE_STATUS_Analog1Get(const uint8_t *data)
+{
+    uint16_t value = ((uint16_t)(data[6] >> 4))
+        | ((uint16_t)(data[5] & 0x3F) << 4);
+    return (uint16_t)value;
+}
+
+void NODE_STATUS_Analog1Set(uint8_t *data, uint16_t value)
+{
+    uint16_t raw = (uint16_t)value;
+    data[6] = (data[6] & 0x0F) | ((uint8_t)((uint8_t)raw << 4) & 0xF0);
+    data[5] = (data[5] & 0xC0) | ((uint8_t)(raw >> 4) & 0x3F);
+}
+
+// NODE_STATUS_Flags: 59|4@0+
+uint8_t NODE_STATUS_FlagsGet(const uint8_t *data)
+{
+    uint8_t value = ((uint8_t)(data[7] & 0x0F));
+    return (uint8_t)value;
+}
+
+void NODE_STATUS_FlagsSet(uint8_t *data, uint8_t value)
+{
+    uint8_t raw = (uint8_t)value;
+    data[7] = (data[7] & 0xF0) | ((uint8_t)raw & 0x0F);
+}
+
+// NODE_STATUS: change detector for canTxPoll()
+uint8_t NODE_STATUS_Changed(const uint8_t *sent, const uint8_t *data)
+{
+    int32_t SupplyVoltage = (int32_t)NODE_STATUS_SupplyVoltageGet(data) - NODE_STATUS_SupplyVoltageGet(sent);
+    int32_t Analog0 = (int32_t)NODE_STATUS_Analog0Get(data) - NODE_STATUS_Analog0Get(sent);
+    int32_t Analog1 = (int32_t)NODE_STATUS_Analog1Get(data) - NODE_STATUS_Analog1Get(sent);
+    if (SupplyVoltage > 5 || SupplyVoltage < -5)   // Deadband
+        return 1;
+    if (Analog0 > 4 || Analog0 < -4)   // Deadband
+        return 1;
+    if (Analog1 > 4 || Analog1 < -4)   // Deadband
+        return 1;
+    if (sent[0] != data[0])
+        return 1;
+    if ((sent[2] ^ data[2]) & 0xF0)
+        return 1;
+    if ((sent[3] ^ data[3]) & 0x0F)
+        return 1;
+    if ((sent[7] ^ data[7]) & 0x0F)
+        return 1;
+    return 0;
+}
+
+// NODE_COMMAND_LedMask: 0|3@1+
+uint8_t NODE_COMMAND_LedMaskGet(const uint8_t *data)
+{
+    uint8_t value = ((uint8_t)(data[0] & 0x07));
+    return (uint8_t)value;
+}
+
+void NODE_COMMAND_LedMaskSet(uint8_t *data, uint8_t value)
+{
+    uint8_t raw = (uint8_t)value;
+    data[0] = (data[0] & 0xF8) | ((uint8_t)raw & 0x07);
+}
+
+// NODE_COMMAND_Setpoint: 15|16@0-
+int16_t NODE_COMMAND_SetpointGet(const uint8_t *data)
+{
+    uint16_t value = ((uint16_t)data[2])
+        | ((uint16_t)data[1] << 8);
+    return (int16_t)value;
+}
+
+void NODE_COMMAND_SetpointSet(uint8_t *data, int16_t value)
+{
+    uint16_t raw = (uint16_t)value;
+    data[2] = (uint8_t)raw;
+    data[1] = (uint8_t)(raw >> 8);
+}
+
+// NODE_COMMAND: change detector for canTxPoll()
+uint8_t NODE_COMMAND_Changed(const uint8_t *sent, const uint8_t *data)
+{
+    if ((sent[0] ^ data[0]) & 0x07)
+        return 1;
+    if (sent[1] != data[1])
+        return 1;
+    if (sent[2] != data[2])
+        return 1;
+    return 0;
+}
@@ -0,0 +1,75 @@
+/* File:  canSignals.h  (generated by tools/dbcgen.py, do not edit)
+ * ******************************************************************************
+ * Description: CAN signal pack/unpack functions.
+ *******************************************************************************/
+
+#ifndef CANSIGNALS_H
+#define	CANSIGNALS_H
+
+#include <xc.h>
+
+// NODE_STATUS: identifier 0x080, 8 bytes
+#define NODE_STATUS_ID            0x080
+#define NODE_STATUS_IDH           0x10    // SIDH byte used by canSend()/canRead()
+#define NODE_STATUS_DLC           8
+#define NODE_STATUS_CYCLE_MS      1000     // Heartbeat, 0 = on change only
+#define NODE_STATUS_DELAY_MS      50     // Minimum interval between transmissions
+uint8_t NODE_STATUS_Changed(const uint8_t *sent, const uint8_t *data);
+#define NODE_STATUS_Counter_SCALE         1
+#define NODE_STATUS_Counter_OFFSET        0
+#define NODE_STATUS_Counter_TO_PHYS(raw)  ((raw) * 1 + 0)
+#define NODE_STATUS_Counter_FROM_PHYS(phys) ((uint8_t)(((phys) - 0) / 1))
+uint8_t NODE_STATUS_CounterGet(const uint8_t *data);
+void NODE_STATUS_CounterSet(uint8_t *data, uint8_t value);
+#define NODE_STATUS_SupplyVoltage_SCALE         0.01
+#define NODE_STATUS_SupplyVoltage_OFFSET        0
+#define NODE_STATUS_SupplyVoltage_TO_PHYS(raw)  ((raw) * 0.01 + 0)   // V
+#define NODE_STATUS_SupplyVoltage_FROM_PHYS(phys) ((uint16_t)(((phys) - 0) / 0.01 + (((phys) < 0) ? -0.5 : 0.5)))
+uint16_t NODE_STATUS_SupplyVoltageGet(const uint8_t *data);
+void NODE_STATUS_SupplyVoltageSet(uint8_t *data, uint16_t value);
+#define NODE_STATUS_Temperature_SCALE         1
+#define NODE_STATUS_Temperature_OFFSET        0
+#define NODE_STATUS_Temperature_TO_PHYS(raw)  ((raw) * 1 + 0)   // degC
+#define NODE_STATUS_Temperature_FROM_PHYS(phys) ((int8_t)(((phys) - 0) / 1))
+int8_t NODE_STATUS_TemperatureGet(const uint8_t *data);
+void NODE_STATUS_TemperatureSet(uint8_t *data, int8_t value);
+#define NODE_STATUS_Analog0_SCALE         1
+#define NODE_STATUS_Analog0_OFFSET        0
+#define NODE_STATUS_Analog0_TO_PHYS(raw)  ((raw) * 1 + 0)
+#define NODE_STATUS_Analog0_FROM_PHYS(phys) ((uint16_t)(((phys) - 0) / 1))
+uint16_t NODE_STATUS_Analog0Get(const uint8_t *data);
+void NODE_STATUS_Analog0Set(uint8_t *data, uint16_t value);
+#define NODE_STATUS_Analog1_SCALE         1
+#define NODE_STATUS_Analog1_OFFSET        0
+#define NODE_STATUS_Analog1_TO_PHYS(raw)  ((raw) * 1 + 0)
+#define NODE_STATUS_Analog1_FROM_PHYS(phys) ((uint16_t)(((phys) - 0) / 1))
+uint16_t NODE_STATUS_Analog1Get(const uint8_t *data);
+void NODE_STATUS_Analog1Set(uint8_t *data, uint16_t value);
+#define NODE_STATUS_Flags_SCALE         1
+#define NODE_STATUS_Flags_OFFSET        0
+#define NODE_STATUS_Flags_TO_PHYS(raw)  ((raw) * 1 + 0)
+#define NODE_STATUS_Flags_FROM_PHYS(phys) ((uint8_t)(((phys) - 0) / 1))
+uint8_t NODE_STATUS_FlagsGet(const uint8_t *data);
+void NODE_STATUS_FlagsSet(uint8_t *data, uint8_t value);
+
+// NODE_COMMAND: identifier 0x100, 8 bytes
+#define NODE_COMMAND_ID            0x100
+#define NODE_COMMAND_IDH           0x20    // SIDH byte used by canSend()/canRead()
+#define NODE_COMMAND_DLC           8
+#define NODE_COMMAND_CYCLE_MS      0     // Heartbeat, 0 = on change only
+#define NODE_COMMAND_DELAY_MS      0     // Minimum interval between transmissions
+uint8_t NODE_COMMAND_Changed(const uint8_t *sent, const uint8_t *data);
+#define NODE_COMMAND_LedMask_SCALE         1
+#define NODE_COMMAND_LedMask_OFFSET        0
+#define NODE_COMMAND_LedMask_TO_PHYS(raw)  ((raw) * 1 + 0)
+#define NODE_COMMAND_LedMask_FROM_PHYS(phys) ((uint8_t)(((phys) - 0) / 1))
+uint8_t NODE_COMMAND_LedMaskGet(const uint8_t *data);
+void NODE_COMMAND_LedMaskSet(uint8_t *data, uint8_t value);
+#define NODE_COMMAND_Setpoint_SCALE         0.1
+#define NODE_COMMAND_Setpoint_OFFSET        -100
+#define NODE_COMMAND_Setpoint_TO_PHYS(raw)  ((raw) * 0.1 + -100)
+#define NODE_COMMAND_Setpoint_FROM_PHYS(phys) ((int16_t)(((phys) - -100) / 0.1 + (((phys) < -100) ? -0.5 : 0.5)))
+int16_t NODE_COMMAND_SetpointGet(const uint8_t *data);
+void NODE_COMMAND_SetpointSet(uint8_t *data, int16_t value);
+
+#endif	/* CANSIGNALS_H */
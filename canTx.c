@@ -0,0 +1,90 @@
+/* File:  canTx.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Transmit-on-change (see canTx.h). canTxPoll() runs from the main loop and decides
+ * for each message of the table, with the millisecond count of timer.c, whether it is due.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canTx.h"
+#include "can.h"
+#include "timer.h"
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canTxDiffers(const uint8_t *sent, const uint8_t *data, uint8_t dlc)
+ * Description: Default change detector: bytewise compare of the data bytes.
+ *******************************************************************************/
+static uint8_t canTxDiffers(const uint8_t *sent, const uint8_t *data, uint8_t dlc)
+{
+    uint8_t i;
+    
+    for (i = 0; i < dlc; i++)
+    {
+        if (sent[i] != data[i])
+            return 1;
+    }
+    
+    return 0;
+    
+} // end static uint8_t canTxDiffers() function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canTxPoll(canTxMessage *messages, uint8_t count)
+ * Description: Sends the messages that are due: never sent yet, heartbeat (maxMs) elapsed, or
+ * data changed and minMs elapsed. A message whose transmit buffer is still pending (TXREQ, bus
+ * busy or no acknowledge) is not loaded over it; it is tried again in the next poll. Call it at
+ * least every 524 ms (timerMillis()).
+ * Returns the number of messages sent.
+ *******************************************************************************/
+uint8_t canTxPoll(canTxMessage *messages, uint8_t count)
+{
+    uint16_t now = timerMillis();
+    uint16_t elapsed;
+    uint8_t status;
+    uint8_t sent = 0;
+    uint8_t dlc;
+    uint8_t due;
+    uint8_t i;
+    
+    status = mcp2515ReadStatus();
+    for (; count; count--, messages++)
+    {
+        dlc = messages->dlc > DLC_8 ? DLC_8 : messages->dlc;
+        elapsed = now - messages->lastMs;
+        
+        if (!(messages->flags & CAN_TX_SENT))
+            due = 1;
+        else if (messages->maxMs && elapsed >= messages->maxMs)
+            due = 1;
+        else if (elapsed < messages->minMs)
+            due = 0;
+        else if (messages->changed)
+            due = messages->changed(messages->sent, messages->data);
+        else
+            due = canTxDiffers(messages->sent, messages->data, dlc);
+        
+        if (!due || (status & STAT_TXnREQ(messages->txb)))
+            continue;
+        
+        canSend(messages->txb, messages->id, dlc, messages->data);
+        status |= STAT_TXnREQ(messages->txb);
+        for (i = 0; i < dlc; i++)
+            messages->sent[i] = messages->data[i];
+        messages->lastMs = now;
+        messages->flags |= CAN_TX_SENT;
+        sent++;
+    }
+    
+    return sent;
+    
+} // end uint8_t canTxPoll(canTxMessage *messages, uint8_t count) function
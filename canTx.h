@@ -0,0 +1,51 @@
+/* File:  canTx.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Transmit-on-change. Each periodic message is sent when its data changed, but not
+ * more often than its minimum interval, and at least once every heartbeat period, so a slow
+ * signal costs the bus one frame per heartbeat instead of one frame per loop.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_TX_H
+#define	CAN_TX_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+#define CAN_TX_SENT             0x01    // canTxMessage.flags: sent at least once
+
+// Returns non zero when (data) differs enough from (sent), the last data sent. The detectors
+// generated from the DBC file (<MSG>_Changed, canSignals.h) apply the signal deadbands.
+typedef uint8_t (*canTxDetector)(const uint8_t *sent, const uint8_t *data);
+
+typedef struct
+{
+    // Set by the application
+    uint8_t txb;                        // Transmit buffer, one per message
+    uint8_t id;                         // SIDH byte, as in canSend()
+    uint8_t dlc;
+    uint16_t minMs;                     // Minimum interval between transmissions
+    uint16_t maxMs;                     // Heartbeat period, 0: sent on change only
+    canTxDetector changed;              // NULL: any byte that differs
+    uint8_t *data;                      // Current data, updated by the application
+    // State kept by canTxPoll()
+    uint8_t sent[8];
+    uint16_t lastMs;
+    uint8_t flags;
+}canTxMessage;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+uint8_t canTxPoll(canTxMessage *messages, uint8_t count);
+
+#endif	/* CAN_TX_H */
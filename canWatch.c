@@ -0,0 +1,261 @@
+/* File:  canWatch.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Receive deadline supervision (see canWatch.h).
+ *   receive path: canWatchReceive() finds the message in an open addressing hash table (two 8x8
+ *       products and usually one probe) and copies the millisecond count to its lastMs;
+ *   main loop: canWatchService() counts the milliseconds and, each one, empties one slot of the
+ *       timing wheel: the messages whose deadline is this millisecond are looked at, the others
+ *       (a period longer than the wheel) go back for another turn.
+ * The stamps are whole milliseconds: a deadline is one millisecond past the window, so a timeout
+ * is never early and at most 1 ms late. The receive path never touches the wheel. A message is put on the wheel at (lastMs + periodMs +
+ * toleranceMs); when that deadline comes and lastMs has moved, it only goes back on the wheel at
+ * the new deadline, so the wheel sees a message once per period whatever its traffic.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "canWatch.h"
+#include "timer.h"
+
+#define CAN_WATCH_END           0xFF    // End of a wheel slot list
+
+canWatchStats canWatchCount;
+
+static canWatchMessage *canWatchMessages;
+static canWatchCallback canWatchEvent;
+static volatile uint8_t canWatchMessageCount;   // 0: not started, the receive path returns at once
+static uint8_t canWatchSlot[CAN_WATCH_SLOTS];   // Message index + 1, 0: free
+static uint8_t canWatchWheel[CAN_WATCH_WHEEL];  // First message of each millisecond slot
+static volatile uint16_t canWatchMs;            // Milliseconds since canWatchIni()
+static uint16_t canWatchLast;                   // timerMillisTick()
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t canWatchHash(uint16_t id)
+ * Description: First hash table slot of (id).
+ *******************************************************************************/
+static uint8_t canWatchHash(uint16_t id)
+{
+    return ((uint8_t)((uint8_t)id * 167) + (uint8_t)((uint8_t)(id >> 8) * 59)) & (CAN_WATCH_SLOTS - 1);
+    
+} // end static uint8_t canWatchHash(uint16_t id) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canWatchSchedule(uint8_t index, uint16_t deadline)
+ * Description: Puts message (index) on the wheel at (deadline).
+ *******************************************************************************/
+static void canWatchSchedule(uint8_t index, uint16_t deadline)
+{
+    uint8_t slot = (uint8_t)deadline & (CAN_WATCH_WHEEL - 1);
+    
+    canWatchMessages[index].deadlineMs = deadline;
+    canWatchMessages[index].next = canWatchWheel[slot];
+    canWatchWheel[slot] = index;
+    
+} // end static void canWatchSchedule(uint8_t index, uint16_t deadline) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canWatchIni(canWatchMessage *messages, uint8_t count, canWatchCallback callback)
+ * Description: Starts the supervision of (count) messages; (callback), which can be 0, gets the
+ * timeouts and the returns. Every message is first due (periodMs + toleranceMs) from now, so one
+ * never received times out too. The table stays in use: it must not be moved or freed.
+ * Returns CAN_WATCH_OK or a CAN_WATCH_ERR_ code, the supervision then stopped.
+ *******************************************************************************/
+uint8_t canWatchIni(canWatchMessage *messages, uint8_t count, canWatchCallback callback)
+{
+    uint16_t now;
+    
+    canWatchMessageCount = 0;
+    if (!count || (count > CAN_WATCH_SLOTS / 2))
+        return CAN_WATCH_ERR_SIZE;
+    
+    canWatchMessages = messages;
+    canWatchEvent = callback;
+    for (uint8_t i = 0; i < CAN_WATCH_SLOTS; i++)
+    {
+        canWatchSlot[i] = 0;
+    }
+    for (uint8_t i = 0; i < CAN_WATCH_WHEEL; i++)
+    {
+        canWatchWheel[i] = CAN_WATCH_END;
+    }
+    
+    now = canWatchNow();
+    for (uint8_t i = 0; i < count; i++)
+    {
+        canWatchMessage *message = &messages[i];
+        uint16_t window = message->periodMs + message->toleranceMs + 1;
+        uint8_t slot = canWatchHash(message->id);
+    
+        if (!message->periodMs || (window > 0x7FFF) || (message->periodMs >= window))
+            return CAN_WATCH_ERR_PERIOD;
+        if (message->id > 0x7FF)
+            return CAN_WATCH_ERR_ID;
+        while (canWatchSlot[slot])
+        {
+            if (messages[canWatchSlot[slot] - 1].id == message->id)
+                return CAN_WATCH_ERR_ID;
+            slot = (slot + 1) & (CAN_WATCH_SLOTS - 1);
+        }
+        canWatchSlot[slot] = i + 1;
+    
+        message->lastMs = now;
+        message->lostMs = now;
+        message->timeouts = 0;
+        message->flags = 0;
+        canWatchSchedule(i, now + window);
+    }
+    
+    canWatchLast = timerMicros();
+    canWatchMessageCount = count;
+    
+    return CAN_WATCH_OK;
+    
+} // end uint8_t canWatchIni(canWatchMessage *messages, uint8_t count, canWatchCallback callback) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canWatchReceive(const dataFrame *frame)
+ * Description: Receive path hook (can.c, interrupt): stamps (frame) when its identifier is
+ * supervised. Remote frames are stamped too.
+ *******************************************************************************/
+void canWatchReceive(const dataFrame *frame)
+{
+    uint16_t id = ((uint16_t)frame->idh << 3) | (frame->idl >> 5);
+    uint8_t slot = canWatchHash(id);
+    uint8_t index;
+    
+    if (!canWatchMessageCount)
+        return;
+    
+    while ((index = canWatchSlot[slot]) != 0)
+    {
+        if (canWatchMessages[index - 1].id == id)
+        {
+            canWatchMessages[index - 1].lastMs = canWatchMs;
+            return;
+        }
+        slot = (slot + 1) & (CAN_WATCH_SLOTS - 1);
+    }
+    
+} // end void canWatchReceive(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canWatchCheck(uint8_t index, uint16_t now)
+ * Description: Message (index) at its deadline: received in time, it goes back on the wheel at the
+ * next deadline; otherwise it is reported once, then looked at every period until it comes back.
+ *******************************************************************************/
+static void canWatchCheck(uint8_t index, uint16_t now)
+{
+    canWatchMessage *message = &canWatchMessages[index];
+    uint16_t window = message->periodMs + message->toleranceMs + 1;
+    uint8_t gie = INTCONbits.GIE;
+    uint16_t last;
+    
+    INTCONbits.GIE = 0;
+    last = message->lastMs;
+    INTCONbits.GIE = gie;
+    
+    if (message->flags & CAN_WATCH_LOST)
+    {
+        if (last == message->lostMs)
+        {
+            canWatchSchedule(index, now + message->periodMs);
+            return;
+        }
+        message->flags &= ~CAN_WATCH_LOST;
+        canWatchCount.recovered++;
+        if (canWatchEvent)
+            canWatchEvent(message, CAN_WATCH_BACK);
+        // Back during the last period: due one window after that arrival, or at once.
+        if ((int16_t)(last + window - now) <= 0)
+            last = now - window + 1;
+    }
+    else if ((int16_t)(last + window - now) <= 0)
+    {
+        message->flags |= CAN_WATCH_LOST;
+        message->lostMs = last;
+        message->timeouts++;
+        canWatchCount.timeouts++;
+        if (canWatchEvent)
+            canWatchEvent(message, CAN_WATCH_TIMEOUT);
+        canWatchSchedule(index, now + message->periodMs);
+        return;
+    }
+    
+    canWatchSchedule(index, last + window);
+    
+} // end static void canWatchCheck(uint8_t index, uint16_t now) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canWatchService(void)
+ * Description: Main loop side: one wheel slot per millisecond passed. Call it at least every 65 ms;
+ * a late call catches up, the timeouts then reported late by as much.
+ *******************************************************************************/
+void canWatchService(void)
+{
+    while (canWatchMessageCount && timerMillisTick(&canWatchLast))
+    {
+        uint8_t gie = INTCONbits.GIE;
+        uint16_t now;
+        uint8_t index;
+        uint8_t visits = 0;
+        uint8_t *slot;
+    
+        INTCONbits.GIE = 0;
+        now = ++canWatchMs;
+        INTCONbits.GIE = gie;
+    
+        // The list is taken off the slot first: a message rescheduled here may come back to it.
+        slot = &canWatchWheel[(uint8_t)now & (CAN_WATCH_WHEEL - 1)];
+        index = *slot;
+        *slot = CAN_WATCH_END;
+        while (index != CAN_WATCH_END)
+        {
+            uint8_t next = canWatchMessages[index].next;
+    
+            if (canWatchMessages[index].deadlineMs == now)
+                canWatchCheck(index, now);
+            else
+                canWatchSchedule(index, canWatchMessages[index].deadlineMs);    // Later turn
+            visits++;
+            index = next;
+        }
+    
+        canWatchCount.visits += visits;
+        if (visits > canWatchCount.visitsMax)
+            canWatchCount.visitsMax = visits;
+    }
+    
+} // end void canWatchService(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint16_t canWatchNow(void)
+ * Description: Milliseconds counted by canWatchService(), the time base of canWatchMessage.lastMs:
+ * (canWatchNow() - lastMs) is the age of the last reception.
+ *******************************************************************************/
+uint16_t canWatchNow(void)
+{
+    uint8_t gie = INTCONbits.GIE;
+    uint16_t now;
+    
+    INTCONbits.GIE = 0;
+    now = canWatchMs;
+    INTCONbits.GIE = gie;
+    
+    return now;
+    
+} // end uint16_t canWatchNow(void) function
@@ -0,0 +1,90 @@
+/* File:  canWatch.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Receive deadline supervision. Each supervised identifier has an expected period and
+ * a tolerance; the receive path (can.c, interrupt) stamps its arrival in a few instructions, through
+ * a small hash table, and a timing wheel in the main loop looks at a message only when its deadline
+ * comes: a message that stops arriving (dead sensor, cut wire) is reported once, by callback and
+ * counters, (periodMs + toleranceMs) after its last arrival, and again when it comes back. The work
+ * per millisecond does not grow with the number of messages supervised.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_WATCH_H
+#define	CAN_WATCH_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CAN_WATCH = 1 stamps the supervised messages in the receive path (can.c); canWatchService() must
+// then run in the main loop at least every 65 ms. The INT2 interrupt should be enabled
+// (canInterruptEnable()): without it the stamps are only as recent as the last canReceive().
+#ifndef CAN_WATCH
+    #define CAN_WATCH               0
+#endif
+#ifndef CAN_WATCH_SLOTS
+    #define CAN_WATCH_SLOTS         64      // Hash table, at least twice the messages (power of 2, <= 128)
+#endif
+#ifndef CAN_WATCH_WHEEL
+    #define CAN_WATCH_WHEEL         32      // Timing wheel, 1 ms per slot (power of 2)
+#endif
+
+#define CAN_WATCH_OK            0
+#define CAN_WATCH_ERR_SIZE      1       // canWatchIni(): more than CAN_WATCH_SLOTS / 2 messages, or none
+#define CAN_WATCH_ERR_PERIOD    2       // canWatchIni(): periodMs 0, or periodMs + toleranceMs over 32766 ms
+#define CAN_WATCH_ERR_ID        3       // canWatchIni(): identifier listed twice or over 0x7FF
+
+// canWatchCallback events
+#define CAN_WATCH_TIMEOUT       0x01    // Not received for periodMs + toleranceMs
+#define CAN_WATCH_BACK          0x02    // Received again after a timeout
+
+// canWatchMessage.flags
+#define CAN_WATCH_LOST          0x01    // Timed out, not received since
+
+typedef struct canWatchMessage canWatchMessage;
+
+// Called from canWatchService(), in the main loop.
+typedef void (*canWatchCallback)(canWatchMessage *message, uint8_t event);
+
+struct canWatchMessage
+{
+    // Set by the application
+    uint16_t id;                        // 11 bit identifier
+    uint16_t periodMs;                  // Expected period
+    uint16_t toleranceMs;               // Lateness accepted (jitter, bus load)
+    // State kept by canWatch.c
+    volatile uint16_t lastMs;           // canWatchNow() at the last reception, written by the receive path
+    uint16_t deadlineMs;                // Next look, on the wheel
+    uint16_t lostMs;                    // lastMs when the timeout was reported
+    uint16_t timeouts;
+    uint8_t flags;
+    uint8_t next;                       // Wheel slot list, 0xFF: last
+};
+
+typedef struct
+{
+    uint16_t timeouts;
+    uint16_t recovered;
+    uint32_t visits;                    // Messages looked at by the wheel
+    uint8_t visitsMax;                  // In one millisecond
+}canWatchStats;
+
+extern canWatchStats canWatchCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint8_t canWatchIni(canWatchMessage *messages, uint8_t count, canWatchCallback callback);
+void canWatchReceive(const dataFrame *frame);
+void canWatchService(void);
+uint16_t canWatchNow(void);
+
+#endif	/* CAN_WATCH_H */
@@ -0,0 +1,182 @@
+/* File:  e2e.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: End-to-end protection (see e2e.h). The CRC covers the 11 bit identifier, low byte
+ * first, and the data bytes except the CRC byte itself; the alive counter is written before the
+ * CRC is computed, so it is covered too. A host benchmark is in host/e2eBench.c.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "e2e.h"
+#include "can.h"
+
+#if E2E_CRC_NIBBLE
+// CRC of the high nibble of the index, with a zero low nibble.
+static const uint8_t e2eCrcTable[16] =
+{
+    0x00, 0x1D, 0x3A, 0x27, 0x74, 0x69, 0x4E, 0x53, 0xE8, 0xF5, 0xD2, 0xCF, 0x9C, 0x81, 0xA6, 0xBB,
+};
+#else
+static const uint8_t e2eCrcTable[256] =
+{
+    0x00, 0x1D, 0x3A, 0x27, 0x74, 0x69, 0x4E, 0x53, 0xE8, 0xF5, 0xD2, 0xCF, 0x9C, 0x81, 0xA6, 0xBB,
+    0xCD, 0xD0, 0xF7, 0xEA, 0xB9, 0xA4, 0x83, 0x9E, 0x25, 0x38, 0x1F, 0x02, 0x51, 0x4C, 0x6B, 0x76,
+    0x87, 0x9A, 0xBD, 0xA0, 0xF3, 0xEE, 0xC9, 0xD4, 0x6F, 0x72, 0x55, 0x48, 0x1B, 0x06, 0x21, 0x3C,
+    0x4A, 0x57, 0x70, 0x6D, 0x3E, 0x23, 0x04, 0x19, 0xA2, 0xBF, 0x98, 0x85, 0xD6, 0xCB, 0xEC, 0xF1,
+    0x13, 0x0E, 0x29, 0x34, 0x67, 0x7A, 0x5D, 0x40, 0xFB, 0xE6, 0xC1, 0xDC, 0x8F, 0x92, 0xB5, 0xA8,
+    0xDE, 0xC3, 0xE4, 0xF9, 0xAA, 0xB7, 0x90, 0x8D, 0x36, 0x2B, 0x0C, 0x11, 0x42, 0x5F, 0x78, 0x65,
+    0x94, 0x89, 0xAE, 0xB3, 0xE0, 0xFD, 0xDA, 0xC7, 0x7C, 0x61, 0x46, 0x5B, 0x08, 0x15, 0x32, 0x2F,
+    0x59, 0x44, 0x63, 0x7E, 0x2D, 0x30, 0x17, 0x0A, 0xB1, 0xAC, 0x8B, 0x96, 0xC5, 0xD8, 0xFF, 0xE2,
+    0x26, 0x3B, 0x1C, 0x01, 0x52, 0x4F, 0x68, 0x75, 0xCE, 0xD3, 0xF4, 0xE9, 0xBA, 0xA7, 0x80, 0x9D,
+    0xEB, 0xF6, 0xD1, 0xCC, 0x9F, 0x82, 0xA5, 0xB8, 0x03, 0x1E, 0x39, 0x24, 0x77, 0x6A, 0x4D, 0x50,
+    0xA1, 0xBC, 0x9B, 0x86, 0xD5, 0xC8, 0xEF, 0xF2, 0x49, 0x54, 0x73, 0x6E, 0x3D, 0x20, 0x07, 0x1A,
+    0x6C, 0x71, 0x56, 0x4B, 0x18, 0x05, 0x22, 0x3F, 0x84, 0x99, 0xBE, 0xA3, 0xF0, 0xED, 0xCA, 0xD7,
+    0x35, 0x28, 0x0F, 0x12, 0x41, 0x5C, 0x7B, 0x66, 0xDD, 0xC0, 0xE7, 0xFA, 0xA9, 0xB4, 0x93, 0x8E,
+    0xF8, 0xE5, 0xC2, 0xDF, 0x8C, 0x91, 0xB6, 0xAB, 0x10, 0x0D, 0x2A, 0x37, 0x64, 0x79, 0x5E, 0x43,
+    0xB2, 0xAF, 0x88, 0x95, 0xC6, 0xDB, 0xFC, 0xE1, 0x5A, 0x47, 0x60, 0x7D, 0x2E, 0x33, 0x14, 0x09,
+    0x7F, 0x62, 0x45, 0x58, 0x0B, 0x16, 0x31, 0x2C, 0x97, 0x8A, 0xAD, 0xB0, 0xE3, 0xFE, 0xD9, 0xC4,
+};
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t e2eCrc(uint8_t crc, const uint8_t *data, uint8_t count)
+ * Description: Runs (count) bytes of (data) through the CRC-8, from the value (crc). The start
+ * value and the final XOR are applied by the caller.
+ *******************************************************************************/
+uint8_t e2eCrc(uint8_t crc, const uint8_t *data, uint8_t count)
+{
+    for (; count; count--, data++)
+    {
+#if E2E_CRC_NIBBLE
+        crc = (uint8_t)(crc << 4) ^ e2eCrcTable[(crc ^ *data) >> 4];
+        crc = (uint8_t)(crc << 4) ^ e2eCrcTable[(crc >> 4) ^ (*data & 0x0F)];
+#else
+        crc = e2eCrcTable[crc ^ *data];
+#endif
+    }
+    
+    return crc;
+    
+} // end uint8_t e2eCrc(uint8_t crc, const uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t e2eFrameCrc(const e2eChannel *channel, const uint8_t *data)
+ * Description: CRC of a frame of (channel): identifier, then the data around the CRC byte.
+ *******************************************************************************/
+static uint8_t e2eFrameCrc(const e2eChannel *channel, const uint8_t *data)
+{
+    uint8_t id[2];
+    uint8_t crc;
+    
+    id[0] = (uint8_t)(channel->id << 3);
+    id[1] = channel->id >> 5;
+    crc = e2eCrc(E2E_CRC_START, id, 2);
+    crc = e2eCrc(crc, data, channel->crcByte);
+    crc = e2eCrc(crc, &data[channel->crcByte + 1], channel->dlc - channel->crcByte - 1);
+    
+    return crc ^ E2E_CRC_XOR;
+    
+} // end static uint8_t e2eFrameCrc(const e2eChannel *channel, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void e2eProtect(e2eChannel *channel, uint8_t *data)
+ * Description: Advances the alive counter of (channel) and writes it and the CRC into (data), the
+ * (dlc) bytes about to be sent.
+ *******************************************************************************/
+void e2eProtect(e2eChannel *channel, uint8_t *data)
+{
+    channel->counter = (channel->counter + 1) & E2E_COUNTER_MASK;
+    data[channel->counterByte] = (data[channel->counterByte] & ~E2E_COUNTER_MASK) | channel->counter;
+    data[channel->crcByte] = e2eFrameCrc(channel, data);
+    
+} // end void e2eProtect(e2eChannel *channel, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t e2eCheck(e2eChannel *channel, const uint8_t *data, uint8_t lenght)
+ * Description: Checks a received frame of (channel), (lenght) data bytes, and counts the result.
+ * The first valid frame synchronizes the counter; after a sequence error the frame's counter is
+ * taken, so one jump costs one frame. Returns E2E_OK or E2E_OK_LOST when the data can be used.
+ *******************************************************************************/
+uint8_t e2eCheck(e2eChannel *channel, const uint8_t *data, uint8_t lenght)
+{
+    uint8_t counter;
+    uint8_t delta;
+    
+    if (lenght < channel->dlc || data[channel->crcByte] != e2eFrameCrc(channel, data))
+    {
+        channel->crcErrors++;
+        return E2E_ERR_CRC;
+    }
+    
+    counter = data[channel->counterByte] & E2E_COUNTER_MASK;
+    delta = (counter - channel->counter) & E2E_COUNTER_MASK;
+    if (!(channel->flags & E2E_SYNCED))
+    {
+        channel->flags |= E2E_SYNCED;
+        delta = 1;
+    }
+    else if (delta == 0)
+    {
+        channel->repeats++;
+        return E2E_ERR_REPEATED;
+    }
+    
+    channel->counter = counter;
+    if (delta > 1)
+        channel->gaps++;
+    if (delta > channel->maxDelta)
+        return E2E_ERR_SEQUENCE;
+    
+    channel->received++;
+    
+    return (delta > 1) ? E2E_OK_LOST : E2E_OK;
+    
+} // end uint8_t e2eCheck(e2eChannel *channel, const uint8_t *data, uint8_t lenght) function
+
+
+/*******************************************************************************
+ * FUNCTION: void e2eSend(e2eChannel *channel, uint8_t txb, uint8_t *data)
+ * Description: Protects (data) and sends it through the transmit buffer (txb), as canSend().
+ *******************************************************************************/
+void e2eSend(e2eChannel *channel, uint8_t txb, uint8_t *data)
+{
+    e2eProtect(channel, data);
+    canSend(txb, channel->id, channel->dlc, data);
+    
+} // end void e2eSend(e2eChannel *channel, uint8_t txb, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t e2eRead(e2eChannel *channel, uint8_t *data)
+ * Description: Takes the oldest queued frame of (channel) (canRxTake()), copies its data bytes
+ * to (data) and checks it. Returns E2E_NO_DATA when none is queued.
+ *******************************************************************************/
+uint8_t e2eRead(e2eChannel *channel, uint8_t *data)
+{
+    dataFrame frame;
+    uint8_t lenght;
+    
+    if (!canRxTake(channel->id, &frame))
+        return E2E_NO_DATA;
+    
+    lenght = (frame.dlc & DLC_RTR) ? 0 : (frame.dlc & CAN_DLC_MASK);
+    if (lenght > DLC_8)
+        lenght = DLC_8;
+    for (uint8_t i = 0; i < lenght; i++)
+        data[i] = frame.data[i];
+    
+    return e2eCheck(channel, data, lenght);
+    
+} // end uint8_t e2eRead(e2eChannel *channel, uint8_t *data) function
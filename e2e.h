@@ -0,0 +1,71 @@
+/* File:  e2e.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: End-to-end protection of safety relevant messages, in the style of AUTOSAR E2E
+ * profiles 1 and 2: every frame carries a CRC-8 over its identifier and data and a 4 bit alive
+ * counter, so the receiver detects corrupted, repeated, lost and stale frames that the CAN CRC
+ * does not (faults in a gateway, in RAM or in the sender software).
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef E2E_H
+#define	E2E_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// CRC-8 SAE J1850 (polynomial 0x1D, start and final XOR 0xFF). E2E_CRC_NIBBLE = 0 uses a 256 byte
+// table in program memory, one lookup per byte; 1 a 16 byte table, two lookups per byte.
+#ifndef E2E_CRC_NIBBLE
+    #define E2E_CRC_NIBBLE          0
+#endif
+
+#define E2E_CRC_START           0xFF
+#define E2E_CRC_XOR             0xFF
+#define E2E_COUNTER_MASK        0x0F    // Alive counter: low nibble of data[counterByte], 0..15
+
+// e2eCheck()/e2eRead() results.
+#define E2E_OK                  0x00
+#define E2E_OK_LOST             0x01    // Valid, frames were lost before it (up to maxDelta - 1)
+#define E2E_ERR_CRC             0x02    // Corrupted, or shorter than dlc: discard
+#define E2E_ERR_REPEATED        0x03    // Same counter as the last valid frame: discard
+#define E2E_ERR_SEQUENCE        0x04    // Counter jump over maxDelta: discard, counter resynchronized
+#define E2E_NO_DATA             0x05    // e2eRead(): no frame with this identifier queued
+
+#define E2E_SYNCED              0x01    // e2eChannel.flags: a valid counter was received
+
+typedef struct
+{
+    // Set by the application
+    uint8_t id;                         // SIDH byte, as in canSend()/canRead()
+    uint8_t dlc;
+    uint8_t crcByte;                    // Data byte of the CRC
+    uint8_t counterByte;                // Data byte of the alive counter, low nibble
+    uint8_t maxDelta;                   // Largest counter step accepted, 1: no frame may be lost
+    // State kept by the E2E functions
+    uint8_t counter;                    // Last sent, or last valid received
+    uint8_t flags;
+    uint16_t received;                  // Valid frames
+    uint16_t crcErrors;
+    uint16_t repeats;
+    uint16_t gaps;                      // Counter steps over 1, accepted or not
+}e2eChannel;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+uint8_t e2eCrc(uint8_t crc, const uint8_t *data, uint8_t count);
+void e2eProtect(e2eChannel *channel, uint8_t *data);
+uint8_t e2eCheck(e2eChannel *channel, const uint8_t *data, uint8_t lenght);
+void e2eSend(e2eChannel *channel, uint8_t txb, uint8_t *data);
+uint8_t e2eRead(e2eChannel *channel, uint8_t *data);
+
+#endif	/* E2E_H */
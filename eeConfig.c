@@ -0,0 +1,131 @@
+/* File:  eeConfig.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Configuration store in the data EEPROM (see eeConfig.h).
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "eeConfig.h"
+#include "boot.h"
+
+eeConfigData eeConfig;
+uint8_t eeConfigStatus = EE_CONFIG_ERR_BLANK;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint16_t eeConfigCrc(void)
+ * Description: CRC of eeConfig, every byte before the CRC field.
+ *******************************************************************************/
+static uint16_t eeConfigCrc(void)
+{
+    return bootCrc(0xFFFF, (const uint8_t *)&eeConfig, sizeof(eeConfig) - sizeof(eeConfig.crc));
+    
+} // end static uint16_t eeConfigCrc(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eeConfigLoad(void)
+ * Description: Reads the store into eeConfig and checks it. When it is not valid, the node address
+ * and the parameters are set to their defaults; eeConfig.can is then left to the caller.
+ * Returns EE_CONFIG_OK or EE_CONFIG_ERR_BLANK, EE_CONFIG_ERR_VERSION, EE_CONFIG_ERR_CRC.
+ *******************************************************************************/
+uint8_t eeConfigLoad(void)
+{
+    uint8_t result = EE_CONFIG_OK;
+    uint16_t crc;
+    
+    eepromReadBlock(EE_CONFIG_ADDRESS, (uint8_t *)&eeConfig, sizeof(eeConfig));
+    crc = ((uint16_t)eeConfig.crc[0] << 8) | eeConfig.crc[1];
+    
+    if (eeConfig.magic != EE_CONFIG_MAGIC)
+        result = EE_CONFIG_ERR_BLANK;
+    else if ((eeConfig.version != EE_CONFIG_VERSION) || (eeConfig.size != sizeof(eeConfig)))
+        result = EE_CONFIG_ERR_VERSION;
+    else if (crc != eeConfigCrc())
+        result = EE_CONFIG_ERR_CRC;
+    
+    if (result != EE_CONFIG_OK)
+    {
+        eeConfig.node = EE_CONFIG_NODE;
+        for (uint8_t i = 0; i < EE_CONFIG_PARAMS; i++)
+            eeConfig.param[i] = 0;
+    }
+    
+    return result;
+    
+} // end uint8_t eeConfigLoad(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eeConfigSave(void)
+ * Description: Stores the MCP2515 setup in use (mcp2515SetupRead()) with eeConfig.node and
+ * eeConfig.param. Only the bytes that changed are written, about 4 ms each (and each byte stands
+ * about 100K writes): the first save takes a quarter of a second, later ones a few writes.
+ * Returns EE_CONFIG_OK or EE_CONFIG_ERR_VERIFY.
+ *******************************************************************************/
+uint8_t eeConfigSave(void)
+{
+    const uint8_t *data = (const uint8_t *)&eeConfig;
+    uint16_t crc;
+    
+    mcp2515SetupRead(&eeConfig.can);
+    eeConfig.magic = EE_CONFIG_MAGIC;
+    eeConfig.version = EE_CONFIG_VERSION;
+    eeConfig.size = sizeof(eeConfig);
+    crc = eeConfigCrc();
+    eeConfig.crc[0] = (uint8_t)(crc >> 8);
+    eeConfig.crc[1] = (uint8_t)crc;
+    
+    for (uint8_t i = 0; i < sizeof(eeConfig); i++)
+    {
+        if (eepromRead(EE_CONFIG_ADDRESS + i) != data[i])
+            eepromWrite(EE_CONFIG_ADDRESS + i, data[i]);
+    }
+    
+    for (uint8_t i = 0; i < sizeof(eeConfig); i++)
+    {
+        if (eepromRead(EE_CONFIG_ADDRESS + i) != data[i])
+            return EE_CONFIG_ERR_VERIFY;
+    }
+    
+    return EE_CONFIG_OK;
+    
+} // end uint8_t eeConfigSave(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eeConfigStart(void)
+ * Description: Starts the MCP2515 (replaces mcp2515Start() in hardware_ini()). With a valid store
+ * its setup goes in with the initialization bursts and the node is on the bus at once. Otherwise
+ * the defaults are used and, with EE_CONFIG_AUTOBAUD, the bit rate found on the bus is saved for
+ * the next start. eeConfigStatus tells which way it went.
+ * Returns the mcp2515StartWith() result.
+ *******************************************************************************/
+uint8_t eeConfigStart(void)
+{
+    uint8_t result;
+    
+    eeConfigStatus = eeConfigLoad();
+    if (eeConfigStatus == EE_CONFIG_OK)
+        return mcp2515StartWith(&eeConfig.can);
+    
+    result = mcp2515Start();
+    mcp2515SetupRead(&eeConfig.can);
+    
+#if EE_CONFIG_AUTOBAUD
+    if ((result == MCP2515_OK) && (canAutobaud() != CAN_BITRATE_NONE))
+        eeConfigSave();
+#endif
+    
+    return result;
+    
+} // end uint8_t eeConfigStart(void) function
+
@@ -0,0 +1,83 @@
+/* File:  eeConfig.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Configuration store in the data EEPROM. It keeps what a node works out at run time
+ * (bit timing, from canAutobaud() or set by a tool, the filters and masks, the receive modes), its
+ * node address and application parameters, so the next power-up starts the MCP2515 straight with
+ * them (mcp2515StartWith()) instead of the defaults followed by the autobaud and a second pass.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef EE_CONFIG_H
+#define	EE_CONFIG_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+#include "eeprom.h"
+
+// Defines and Macros
+// EE_CONFIG = 1: hardware_ini() starts the MCP2515 with eeConfigStart() instead of mcp2515Start().
+#ifndef EE_CONFIG
+    #define EE_CONFIG               0
+#endif
+// Without a valid store, the bit rate is detected (canAutobaud()) and the result saved. The autobaud
+// listens up to CAN_BITRATES * CAN_AUTOBAUD_WINDOW_MS on a silent bus, and nothing is saved then.
+#ifndef EE_CONFIG_AUTOBAUD
+    #define EE_CONFIG_AUTOBAUD      1
+#endif
+#ifndef EE_CONFIG_ADDRESS
+    #define EE_CONFIG_ADDRESS       0x00    // Data EEPROM address of the store
+#endif
+#ifndef EE_CONFIG_NODE
+    #define EE_CONFIG_NODE          0x01    // Node address until one is saved
+#endif
+#ifndef EE_CONFIG_PARAMS
+    #define EE_CONFIG_PARAMS        16      // Application parameters (routing table, ...), bytes
+#endif
+
+/* Layout, at EE_CONFIG_ADDRESS: the eeConfigData structure as it is in RAM.
+ * magic EE_CONFIG_MAGIC (an erased EEPROM reads 0xFF), version EE_CONFIG_VERSION, size of the
+ * structure, then the data, then the CRC-16/CCITT-FALSE (bootCrc()) of every byte before it, high
+ * byte first. Change EE_CONFIG_VERSION whenever the structure changes: an older store is then
+ * ignored rather than misread. A save interrupted by a reset fails the CRC and the defaults are
+ * used. */
+#define EE_CONFIG_MAGIC         0xC5
+#define EE_CONFIG_VERSION       1
+
+// Results of eeConfigLoad() and eeConfigSave()
+#define EE_CONFIG_OK            0x00
+#define EE_CONFIG_ERR_BLANK     0x01    // Nothing stored
+#define EE_CONFIG_ERR_VERSION   0x02    // Other layout (EE_CONFIG_VERSION or size)
+#define EE_CONFIG_ERR_CRC       0x03    // Corrupted or partly written
+#define EE_CONFIG_ERR_VERIFY    0x04    // Save: read back differs
+
+typedef struct
+{
+    uint8_t magic;
+    uint8_t version;
+    uint8_t size;                       // sizeof(eeConfigData)
+    mcp2515Setup can;
+    uint8_t node;
+    uint8_t param[EE_CONFIG_PARAMS];
+    uint8_t crc[2];
+}eeConfigData;
+
+extern eeConfigData eeConfig;           // Configuration in use
+extern uint8_t eeConfigStatus;          // eeConfigLoad() result at start-up
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint8_t eeConfigLoad(void);
+uint8_t eeConfigSave(void);
+uint8_t eeConfigStart(void);
+
+#endif	/* EE_CONFIG_H */
+
@@ -0,0 +1,88 @@
+/* File:  eeprom.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Data EEPROM access (see eeprom.h). Datasheet section 7: a write is started by the
+ * EECON2 0x55/0xAA sequence with GIE off, as in flash.c, and ends on its own (WR cleared, EEIF
+ * set). The host build replaces this file with host/eepromSim.c.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "eeprom.h"
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eepromBusy(void)
+ * Description: Returns 1 while a write is in progress.
+ *******************************************************************************/
+uint8_t eepromBusy(void)
+{
+    return EECON1bits.WR;
+    
+} // end uint8_t eepromBusy(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eepromRead(uint8_t address)
+ * Description: Returns the byte at (address). A write in progress is waited for first.
+ *******************************************************************************/
+uint8_t eepromRead(uint8_t address)
+{
+    while (EECON1bits.WR);
+    
+    EEADR = address;
+    EECON1bits.EEPGD = 0;
+    EECON1bits.CFGS = 0;
+    EECON1bits.RD = 1;
+    
+    return EEDATA;
+    
+} // end uint8_t eepromRead(uint8_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count)
+ * Description: Copies (count) bytes of data EEPROM from (address) to (data).
+ *******************************************************************************/
+void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count)
+{
+    for (; count; count--)
+        *data++ = eepromRead(address++);
+    
+} // end void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: void eepromWrite(uint8_t address, uint8_t value)
+ * Description: Starts writing (value) at (address), after the write in progress, and returns
+ * while the byte is programmed.
+ *******************************************************************************/
+void eepromWrite(uint8_t address, uint8_t value)
+{
+    uint8_t gie;
+    
+    while (EECON1bits.WR);
+    
+    EEADR = address;
+    EEDATA = value;
+    EECON1bits.EEPGD = 0;
+    EECON1bits.CFGS = 0;
+    EECON1bits.WREN = 1;
+    
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    INTCONbits.GIE = gie;
+    EECON1bits.WREN = 0;
+    
+} // end void eepromWrite(uint8_t address, uint8_t value) function
+
@@ -0,0 +1,35 @@
+/* File:  eeprom.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: PIC18F4550 data EEPROM: 256 bytes, read in one instruction cycle, written one byte
+ * at a time. A write takes about 4 ms (TDEW in the datasheet) and, unlike a program memory write,
+ * does not stall the CPU: eepromWrite() only waits for the write before it.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef EEPROM_H
+#define	EEPROM_H
+
+// Includes
+#include <xc.h>
+
+// Defines and Macros
+#define EEPROM_SIZE             256     // Addresses fit in EEADR
+#define EEPROM_ERASED           0xFF
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+uint8_t eepromRead(uint8_t address);
+void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count);
+void eepromWrite(uint8_t address, uint8_t value);
+uint8_t eepromBusy(void);
+
+#endif	/* EEPROM_H */
+
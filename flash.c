@@ -0,0 +1,102 @@
+/* File:  flash.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Program memory self-programming (see flash.h). Datasheet section 6: erases and
+ * writes are started by the EECON2 0x55/0xAA sequence with GIE off, and the CPU stalls until the
+ * operation ends. The host build replaces this file with host/flashSim.c.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "flash.h"
+
+
+/*******************************************************************************
+ * FUNCTION: static void flashStart(void)
+ * Description: Required sequence that starts the erase or write selected in EECON1. The CPU
+ * stalls on WR = 1 and goes on with the next instruction when the operation ends.
+ *******************************************************************************/
+static void flashStart(void)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    INTCONbits.GIE = 0;
+    EECON2 = 0x55;
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    NOP();
+    INTCONbits.GIE = gie;
+    EECON1bits.WREN = 0;
+    
+} // end static void flashStart(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashRead(uint16_t address, uint8_t *data, uint8_t count)
+ * Description: Copies (count) bytes of program memory from (address) to (data).
+ *******************************************************************************/
+void flashRead(uint16_t address, uint8_t *data, uint8_t count)
+{
+    TBLPTRU = 0;
+    TBLPTRH = (uint8_t)(address >> 8);
+    TBLPTRL = (uint8_t)address;
+    for (; count; count--)
+    {
+        asm("TBLRD*+");
+        *data++ = TABLAT;
+    }
+    
+} // end void flashRead(uint16_t address, uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashErase(uint16_t address)
+ * Description: Erases (FLASH_ERASED) the 64 byte block holding (address).
+ *******************************************************************************/
+void flashErase(uint16_t address)
+{
+    TBLPTRU = 0;
+    TBLPTRH = (uint8_t)(address >> 8);
+    TBLPTRL = (uint8_t)address & ~(FLASH_ERASE_SIZE - 1);
+    EECON1bits.EEPGD = 1;
+    EECON1bits.CFGS = 0;
+    EECON1bits.WREN = 1;
+    EECON1bits.FREE = 1;
+    flashStart();
+    
+} // end void flashErase(uint16_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashWrite(uint16_t address, const uint8_t *data)
+ * Description: Writes the 32 bytes of (data) to the write block at (address), which must be
+ * erased. The bytes are loaded in the holding registers with TBLWT; TBLPTR is moved back into
+ * the block before the write starts.
+ *******************************************************************************/
+void flashWrite(uint16_t address, const uint8_t *data)
+{
+    TBLPTRU = 0;
+    TBLPTRH = (uint8_t)(address >> 8);
+    TBLPTRL = (uint8_t)address & ~(FLASH_WRITE_SIZE - 1);
+    for (uint8_t i = 0; i < FLASH_WRITE_SIZE; i++)
+    {
+        TABLAT = *data++;
+        asm("TBLWT*+");
+    }
+    asm("TBLRD*-");
+    
+    EECON1bits.EEPGD = 1;
+    EECON1bits.CFGS = 0;
+    EECON1bits.WREN = 1;
+    EECON1bits.FREE = 0;
+    flashStart();
+    
+} // end void flashWrite(uint16_t address, const uint8_t *data) function
+
@@ -0,0 +1,36 @@
+/* File:  flash.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: PIC18F4550 program memory self-programming: table reads, 64 byte block erases and
+ * 32 byte block writes. The CPU stalls while a block is erased or written (about 2 ms, TIW in the
+ * datasheet), interrupts included, so the caller decides when it can afford it.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef FLASH_H
+#define	FLASH_H
+
+// Includes
+#include <xc.h>
+
+// Defines and Macros
+#define FLASH_SIZE              0x8000  // 32 Kbytes, addresses fit in 16 bits (TBLPTRU = 0)
+#define FLASH_ERASE_SIZE        64      // Erase block, aligned
+#define FLASH_WRITE_SIZE        32      // Holding registers, one write block, aligned
+#define FLASH_ERASED            0xFF
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void flashRead(uint16_t address, uint8_t *data, uint8_t count);
+void flashErase(uint16_t address);
+void flashWrite(uint16_t address, const uint8_t *data);
+
+#endif	/* FLASH_H */
+
@@ -17,10 +17,19 @@
 #include <xc.h>
 #include "config_bits.h"
 #include "hardware.h"
+#include "busLoad.h"
+#include "boot.h"
+#include "timeSync.h"
+#include "eeConfig.h"
+#include "adcStream.h"
+
+volatile uint8_t isrDeferred;           // ISR_DEFER_xxx bits waiting for isrLow()
+uint8_t hardwareCanStatus;              // Result of the last MCP2515 start (see hardware_ini())
 
 /****************************************************************************************
  * Function void hardware_ini();
- * Initialize hardware peripherals and pins.
+ * Initialize hardware peripherals and pins. An MCP2515 that does not reach normal mode (a mode
+ * change timed out, or its setup did not read back) is started again, up to MCP2515_START_TRIES.
  ****************************************************************************************/
 void hardware_ini()
 {
@@ -29,7 +38,7 @@ void hardware_ini()
     // I/O definitions
     TRISB = 0X00;
     LATB = 0XFF;
-
+    
     // I/O pins definition for SPI 
     TRISBbits.TRISB1 = 0;  // Pin 34-Serial Clock (SCK) - RB1/AN10/INT1/SCK/SCL
     TRISCbits.TRISC7 = 0;  // Pin 26-Serial Data Out (SDO) - RC7/RX/DT/SDO
@@ -37,25 +46,154 @@ void hardware_ini()
     TRISBbits.TRISB0 = 1;  // Pin 33-Serial Data In (SDI) - RB0/AN12/INT0/FLT0/SDI/SDA
     TRISBbits.TRISB2 = 1;   // MCP_INT: INT2
     
-    // Interrupt
-   /* INTCON   = 0b11000000;
-    INTCON2 = 0b00000100; // PORTB pull-ups are enabled by individual port latch values. TMR0 High priority. Pg. 102
-    INTCON3 = 0b00001000;
-    PIR1        = 0b00000000; // SPI transmit flag.
-    PIR2        = 0b00000000;
-    PIE1        = 0b00001000; // SPI interupt enable.
-    PIE2        = 0b00000000;
-    IPR1        = 0b00000000;
-    IPR2        = 0b00000000;*/
+#if MCP2515_PIN_ASSIST
+    // MCP2515 buffer pins. RTS outputs idle high, the MCP2515 acts on the falling edge.
+    MCP_TX0RTS = 1;
+    MCP_TX1RTS = 1;
+    MCP_TX2RTS = 1;
+    MCP_TX0RTS_TRIS = 0;
+    MCP_TX1RTS_TRIS = 0;
+    MCP_TX2RTS_TRIS = 0;
+    MCP_RX0BF_TRIS = 1;
+    MCP_RX1BF_TRIS = 1;
+#endif
+    
+#if ISR_PROBE
+    ISR_PROBE_PIN = 0;
+    ISR_PROBE_TRIS = 0;
+#endif
     
-    // PIE1bits.SPPIE = 1;         // SPI interupt enable.
-    // PIR1bits.SPPIF = 0;         // SPI transmit flag.
+    // Interrupt priorities (see hardware.h). Pg. 97
+    RCONbits.IPEN = 1;
+    IPR1 = 0b00001000;             // SSP high; timers, UART, ADC low.
+    IPR2 = 0b00000000;             // USB, Timer3 (isrDefer()) and the others low.
+    INTCON2bits.TMR0IP = 0;
+    INTCON3bits.INT2IP = 1;
+    PIR2bits.TMR3IF = 0;
+    PIE2bits.TMR3IE = 1;
     
+    timerIni();
     SPI_ini();
-    delayMS(100);
-    mcp2515Start();
-    delayMS(100);
+    for (uint8_t i = 0; i < MCP2515_START_TRIES; i++)
+    {
+#if EE_CONFIG
+        hardwareCanStatus = eeConfigStart();
+#else
+        hardwareCanStatus = mcp2515Start();
+#endif
+        if (hardwareCanStatus == MCP2515_OK)
+            break;
+    }
+    
+    if (hardwareCanStatus == MCP2515_OK)
+        canInterruptEnable();
+    else
+        LATBbits.LATB5 = 0;         // LED_5: the MCP2515 does not run
+#if TIME_SYNC
+    timeSyncIni();
+#endif
+    INTCONbits.GIEL = 1;
+    INTCONbits.GIEH = 1;
     
 } // end function hardware_ini().
 
 
+// The bootloader runs polled; its interrupt vectors jump to the application's (main.c).
+#if !BOOTLOADER
+/****************************************************************************************
+ * Function void isr(void);
+ * High priority interrupt service routine. INT2 (MCP_INT) signals a message in the MCP2515;
+ * the flag is cleared first so a message arriving during canService() raises it again.
+ * SSP clocks the asynchronous SPI transfers. CCP1 and Timer1 timestamp the start of frames
+ * (TIME_SYNC), ahead of INT2 so the capture of a frame is stored before the frame is unloaded.
+ ****************************************************************************************/
+void __interrupt(high_priority) isr(void)
+{
+#if CAN_BENCH
+    uint16_t start = timerMicros();
+#endif
+    
+#if TIME_SYNC
+    if ((PIE1bits.CCP1IE && PIR1bits.CCP1IF) || (PIE1bits.TMR1IE && PIR1bits.TMR1IF))
+    {
+        timeSyncInterrupt();
+    }
+#endif
+    
+    if (PIE1bits.SSPIE && PIR1bits.SSPIF)
+    {
+        SPI_interrupt();
+    }
+    
+    if (INTCON3bits.INT2IE && INTCON3bits.INT2IF)
+    {
+#if ISR_PROBE
+        ISR_PROBE_PIN = 1;
+#endif
+        INTCON3bits.INT2IF = 0;
+#if TIME_SYNC
+        timeSyncRxMark();
+#endif
+#if CAN_SPI_ASYNC
+        canServiceAsync();
+#else
+        canService();
+#endif
+#if ISR_PROBE
+        ISR_PROBE_PIN = 0;
+#endif
+    }
+    
+#if CAN_BENCH
+    canBenchIsrMicros += (uint16_t)(timerMicros() - start);
+#endif
+    
+} // end function isr().
+
+
+/****************************************************************************************
+ * Function void isrLow(void);
+ * Low priority interrupt service routine: runs the work deferred by isr(). The bits are
+ * taken with GIEH off, the work itself runs with isr() enabled.
+ ****************************************************************************************/
+void __interrupt(low_priority) isrLow(void)
+{
+    uint8_t work;
+    
+    if (PIE2bits.TMR3IE && PIR2bits.TMR3IF)
+    {
+        PIR2bits.TMR3IF = 0;
+        INTCONbits.GIEH = 0;
+        work = isrDeferred;
+        isrDeferred = 0;
+        INTCONbits.GIEH = 1;
+        (void)work;                 // Unused when no deferred work is compiled in
+    
+#if BUS_LOAD
+        if (work & ISR_DEFER_BUS_LOAD)
+            busLoadService();
+#endif
+    }
+    
+#if ADC_STREAM
+    if (PIE1bits.ADIE && PIR1bits.ADIF)
+        adcStreamInterrupt();
+#endif
+    
+} // end function isrLow().
+#endif
+
+
+/****************************************************************************************
+ * Function void isrDefer(uint8_t work);
+ * Hands (work, ISR_DEFER_xxx bits) off to isrLow(), which runs as soon as isr() returns
+ * and the main program has GIEL set. Called from isr().
+ ****************************************************************************************/
+void isrDefer(uint8_t work)
+{
+    isrDeferred |= work;
+    PIR2bits.TMR3IF = 1;
+    
+} // end function isrDefer().
+
+
@@ -22,6 +22,8 @@
 #include "spi.h"
 #include "can.h"
 #include "delayMy.h"
+#include "timer.h"
+#include "canBench.h"
 
 #define _XTAL_FREQ     8000000
 
@@ -41,10 +43,69 @@
  #define SDI                PORTBbits.RB0  // Serial Data In (SDI) ? RB0/AN12/INT0/FLT0/SDI/SDA
  #define MCP_INT        PORTBbits.RB2
 
+// MCP2515 buffer pins. With MCP2515_PIN_ASSIST = 1 the RX0BF/RX1BF outputs and the TX0RTS-TX2RTS
+// inputs of the MCP2515 are wired to the PIC: a full receive buffer is read as a port bit and a
+// transmission is started with a pin pulse, each saving one SPI transaction per message.
+// Any of the pins below can be redefined before this file is included.
+#ifndef MCP2515_PIN_ASSIST
+    #define MCP2515_PIN_ASSIST      0
+#endif
+#ifndef MCP_RX0BF
+    #define MCP_RX0BF               PORTDbits.RD0   // MCP2515 pin 11, active low
+    #define MCP_RX0BF_TRIS          TRISDbits.TRISD0
+#endif
+#ifndef MCP_RX1BF
+    #define MCP_RX1BF               PORTDbits.RD1   // MCP2515 pin 10, active low
+    #define MCP_RX1BF_TRIS          TRISDbits.TRISD1
+#endif
+#ifndef MCP_TX0RTS
+    #define MCP_TX0RTS              LATDbits.LATD2  // MCP2515 pin 4, falling edge
+    #define MCP_TX0RTS_TRIS         TRISDbits.TRISD2
+#endif
+#ifndef MCP_TX1RTS
+    #define MCP_TX1RTS              LATDbits.LATD3  // MCP2515 pin 5, falling edge
+    #define MCP_TX1RTS_TRIS         TRISDbits.TRISD3
+#endif
+#ifndef MCP_TX2RTS
+    #define MCP_TX2RTS              LATDbits.LATD4  // MCP2515 pin 6, falling edge
+    #define MCP_TX2RTS_TRIS         TRISDbits.TRISD4
+#endif
+
+/* Interrupts, two priority levels (RCON.IPEN = 1):
+ * high, isr():     INT2 (MCP2515) and SSP (SPI engine), CCP1 and Timer1 with TIME_SYNC. Only the
+ *                  work that cannot wait: moving frames between the MCP2515 and RAM before a
+ *                  receive buffer overflows, and the start of frame captures.
+ * low, isrLow():   timers, UART, USB, A/D, and the work isr() hands off with isrDefer(). It is
+ *                  preempted by isr(); GIEL = 0 keeps it out of a main program section.
+ * isrDefer() sets the Timer3 flag as a low priority software interrupt: Timer3 stays off, or,
+ * with ADC_STREAM, is reset by CCP2 before it overflows.
+ * GIE is GIEH: GIE = 0 still keeps both routines out. */
+#define ISR_DEFER_BUS_LOAD      0x01    // busLoadService(): bus load of the frames received
+
+// ISR_PROBE = 1 drives ISR_PROBE_PIN high while isr() services INT2. On a scope, from the falling
+// edge of MCP2515 INT (pin 12) to the rising edge of the probe is the interrupt latency, and the
+// probe width the service time.
+#ifndef ISR_PROBE
+    #define ISR_PROBE               0
+#endif
+#ifndef ISR_PROBE_PIN
+    #define ISR_PROBE_PIN           LATDbits.LATD5
+    #define ISR_PROBE_TRIS          TRISDbits.TRISD5
+#endif
+
+// Starts of the MCP2515 hardware_ini() tries before it gives up: LED_5 lights and the CAN interrupt
+// stays off. hardwareCanStatus keeps the last result (MCP2515_OK: the node is on the bus).
+#ifndef MCP2515_START_TRIES
+    #define MCP2515_START_TRIES     3
+#endif
+
+extern uint8_t hardwareCanStatus;
+
 /****************************************************************************************
  * Function prototypes
  ****************************************************************************************/
 void hardware_ini();
+void isrDefer(uint8_t work);
 
 
 
@@ -0,0 +1,314 @@
+/* File:  adcStreamHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Runs the ADC to CAN stream (adcStream.c) on the host: the unmodified module and
+ * driver against the MCP2515 model and the A/D model of picSim.c, triggered by Timer3/CCP2 as on
+ * the target. Each input is a sine of its own frequency; every conversion is logged, and every
+ * sample frame that reaches the bus is decoded and checked against the log: channel order,
+ * decimation and averaging, and the frame count of the frames that did not make it (samples
+ * dropped by the module). The other nodes can load the bus (-l, percent of the bit time; the
+ * model hands the bus to the node after every one of their frames).
+ * Reports the sample sets per second, sets missed, samples dropped, frames, the bus load of the
+ * stream and the latency from the last sample of a frame to the end of the frame on the bus.
+ * The exit code is 1 when a frame is wrong or the counts do not add up.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DADC_STREAM=1 -DSPI_CLOCK=0 -o adcStreamHost host/adcStreamHost.c \
+ *       host/picSim.c host/spiSim.c host/mcp2515Sim.c adcStream.c canQueue.c can.c hardware.c timer.c -lm \
+ *       && ./adcStreamHost
+ * (-DADC_STREAM_RATE_HZ, -DADC_STREAM_CHANNELS, -DADC_STREAM_DECIMATE, ... as for the firmware.)
+ * Use:
+ *   ./adcStreamHost [-b 125|250|500] [-l loadPercent] [-t seconds]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../hardware.h"
+#include "../adcStream.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define HOST_OTHER_ID           0x100   // Frames of the other nodes
+#define HOST_DRAIN_NS           50000000
+
+#define HOST_CONVERSIONS        8       // Last conversions kept (power of 2)
+
+typedef struct
+{
+    uint16_t value[ADC_STREAM_CHANNELS];
+    uint64_t sampleNs;                  // Last channel of the set
+}hostSet;
+
+typedef struct
+{
+    uint8_t channel;
+    uint16_t value;
+    uint64_t sampleNs;
+}hostConversion;
+
+static hostConversion hostConversions[HOST_CONVERSIONS];
+static uint32_t hostConversionCount;
+
+static hostSet *hostLog;                // Every set the module took, in order
+static uint32_t hostLogSize;
+static uint32_t hostLogCount;
+
+static uint32_t hostFrameNext;          // Frame number expected next
+static uint32_t hostFrames;
+static uint32_t hostGaps;               // Frames missing in the count
+static uint32_t hostErrors;
+static uint64_t hostLatencySum;
+static uint64_t hostLatencyMax;
+static uint64_t hostBusNs;              // Bus time of the stream's frames
+static uint8_t hostReport[8];
+static uint32_t hostReports;
+
+static uint64_t hostOtherPeriodNs;
+static uint64_t hostOtherNs;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint16_t hostAdc(uint8_t channel, uint64_t ns)
+ * Description: picSimAdcHook: channel n is a sine of 10 * (n + 1) Hz around mid scale.
+ *******************************************************************************/
+static uint16_t hostAdc(uint8_t channel, uint64_t ns)
+{
+    hostConversion *conversion = &hostConversions[hostConversionCount++ % HOST_CONVERSIONS];
+    
+    conversion->channel = channel;
+    conversion->value = (uint16_t)(512 + 400 * sin(2 * M_PI * 10 * (channel + 1) * (ns / 1e9)));
+    conversion->sampleNs = ns;
+    
+    return conversion->value;
+    
+} // end static uint16_t hostAdc(uint8_t channel, uint64_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostLogSets(void)
+ * Description: A set the module counted (adcStreamCount.sets) is made of the last conversions,
+ * AN0 first: no conversion ends between the interrupt and the next clock step. Sets the module
+ * dropped (trigger in the middle) are not counted and not logged.
+ *******************************************************************************/
+static void hostLogSets(void)
+{
+    if (adcStreamCount.sets == hostLogCount)
+        return;
+    if (adcStreamCount.sets != hostLogCount + 1 || hostConversionCount < ADC_STREAM_CHANNELS)
+    {
+        printf("set %u not seen\n", (unsigned)hostLogCount);
+        hostErrors++;
+        hostLogCount = adcStreamCount.sets;
+        return;
+    }
+    if (hostLogCount == hostLogSize)
+    {
+        hostLogSize = hostLogSize ? hostLogSize * 2 : 4096;
+        hostLog = realloc(hostLog, hostLogSize * sizeof(hostSet));
+    }
+    for (uint8_t i = 0; i < ADC_STREAM_CHANNELS; i++)
+    {
+        hostConversion *conversion = &hostConversions[(hostConversionCount - ADC_STREAM_CHANNELS + i) % HOST_CONVERSIONS];
+    
+        if (conversion->channel != i && hostErrors++ < 10)
+            printf("set %u: AN%u converted as AN%u\n", (unsigned)hostLogCount, conversion->channel, i);
+        hostLog[hostLogCount].value[i] = conversion->value;
+        hostLog[hostLogCount].sampleNs = conversion->sampleNs;
+    }
+    hostLogCount++;
+    
+} // end static void hostLogSets(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint16_t hostExpected(uint32_t sample, uint8_t channel)
+ * Description: Published sample (sample) of (channel), from the log. 0xFFFF: not converted.
+ *******************************************************************************/
+static uint16_t hostExpected(uint32_t sample, uint8_t channel)
+{
+    uint32_t first = sample * ADC_STREAM_DECIMATE;
+    uint32_t sum = 0;
+    
+    if (first + ADC_STREAM_DECIMATE > hostLogCount)
+        return 0xFFFF;
+#if ADC_STREAM_AVERAGE
+    for (uint32_t i = 0; i < ADC_STREAM_DECIMATE; i++)
+        sum += hostLog[first + i].value[channel];
+    return (uint16_t)(sum / ADC_STREAM_DECIMATE);
+#else
+    (void)sum;
+    return hostLog[first + ADC_STREAM_DECIMATE - 1].value[channel];
+#endif
+    
+} // end static uint16_t hostExpected(uint32_t sample, uint8_t channel) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostBusTx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook: a frame of the node ended on the bus.
+ *******************************************************************************/
+static void hostBusTx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    uint32_t number;
+    uint32_t last;
+    
+    hostBusNs += (uint64_t)(47 + 8 * frame->dlc) * mcp2515SimBitNs();
+    if (frame->id == ((uint32_t)ADC_STREAM_REPORT_IDH << 3))
+    {
+        memcpy(hostReport, frame->data, 8);
+        hostReports++;
+        return;
+    }
+    if (frame->id != ((uint32_t)ADC_STREAM_IDH << 3) || frame->dlc != 8)
+    {
+        printf("unexpected frame 0x%03X\n", (unsigned)frame->id);
+        hostErrors++;
+        return;
+    }
+    
+    // The 4 bit count of the frame, past the frames dropped.
+    number = hostFrameNext + (((frame->data[1] >> (ADC_STREAM_SEQUENCE_SHIFT - 8)) - hostFrameNext) & 0x0F);
+    hostGaps += number - hostFrameNext;
+    hostFrameNext = number + 1;
+    hostFrames++;
+    
+    for (uint8_t w = 0; w < 4; w++)
+    {
+        uint32_t sample = number * ADC_STREAM_SETS_PER_FRAME + w / ADC_STREAM_CHANNELS;
+        uint16_t value = (frame->data[2 * w] | (frame->data[2 * w + 1] << 8)) & 0x3FF;
+        uint16_t expected = hostExpected(sample, w % ADC_STREAM_CHANNELS);
+    
+        if (value != expected)
+        {
+            if (hostErrors++ < 10)
+                printf("frame %u, AN%u sample %u: %u, %u expected\n", (unsigned)number,
+                       w % ADC_STREAM_CHANNELS, (unsigned)sample, value, expected);
+        }
+    }
+    
+    last = (number + 1) * ADC_STREAM_SETS_PER_FRAME * ADC_STREAM_DECIMATE - 1;
+    if (last < hostLogCount)
+    {
+        hostLatencySum += endNs - hostLog[last].sampleNs;
+        if (endNs - hostLog[last].sampleNs > hostLatencyMax)
+            hostLatencyMax = endNs - hostLog[last].sampleNs;
+    }
+    
+} // end static void hostBusTx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the sets taken, and the other nodes, one 8 byte frame every
+ * hostOtherPeriodNs.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    mcp2515SimFrame frame = { HOST_OTHER_ID, 0, 8, { 0 } };
+    
+    hostLogSets();
+    if (hostOtherPeriodNs && nowNs >= hostOtherNs)
+    {
+        mcp2515SimInject(&frame);
+        hostOtherNs += hostOtherPeriodNs;
+    }
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_250K;
+    uint32_t load = 0;
+    uint32_t seconds = 10;
+    uint64_t start;
+    uint64_t end;
+    dataFrame frame;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-b"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-l"))
+            load = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-t"))
+            seconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || bitrate >= CAN_BITRATES || load > 100 || !seconds)
+    {
+        fprintf(stderr, "use: %s [-b 125|250|500] [-l loadPercent] [-t seconds]\n", argv[0]);
+        return 2;
+    }
+    
+    hardware_ini();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(bitrate);
+    mcp2515ConfigEnd();
+    picSimAdcHook = hostAdc;
+    mcp2515SimTxHook = hostBusTx;
+    if (load)
+        hostOtherPeriodNs = 111ull * mcp2515SimBitNs() * 100 / load;
+    hostOtherNs = picSimNs();
+    picSimHook = hostStep;
+    
+    printf("ADC stream, %u channel(s) at %u sets/s, decimation %u (%s), bus %u Kbps, other nodes %u %%\n",
+           ADC_STREAM_CHANNELS, ADC_STREAM_RATE_HZ, ADC_STREAM_DECIMATE, ADC_STREAM_AVERAGE ? "mean" : "last",
+           rates[bitrate], (unsigned)load);
+    
+    start = picSimNs();
+    end = start + (uint64_t)seconds * 1000000000;
+    adcStreamStart();
+    while (picSimNs() < end)
+    {
+        adcStreamService();
+        while (canReceive(&frame));
+    }
+    
+    // Frames already full still go out.
+    adcStreamStop();
+    end = picSimNs() + HOST_DRAIN_NS;
+    while (picSimNs() < end)
+    {
+        adcStreamService();
+        while (canReceive(&frame));
+    }
+    
+    printf("  sets:           %u (%.1f per second)\n", (unsigned)adcStreamCount.sets,
+           adcStreamCount.sets * 1e9 / (picSimNs() - HOST_DRAIN_NS - start));
+    printf("  last report:    %u sets/s, %u missed/s, %u dropped, %u frames (%u reports)\n",
+           hostReport[0] | (hostReport[1] << 8), hostReport[2] | (hostReport[3] << 8),
+           hostReport[4] | (hostReport[5] << 8), hostReport[6] | (hostReport[7] << 8), (unsigned)hostReports);
+    printf("  samples dropped %u, frames %u sent, %u on the bus, %u missing in the count\n",
+           (unsigned)adcStreamCount.dropped, (unsigned)adcStreamCount.frames, (unsigned)hostFrames, (unsigned)hostGaps);
+    printf("  bus load of the stream %.1f %%\n", hostBusNs * 100.0 / (picSimNs() - start));
+    if (hostFrames)
+        printf("  sample to bus:  mean %.1f us, worst %.1f us\n", hostLatencySum / 1e3 / hostFrames, hostLatencyMax / 1e3);
+    
+    // Dropped samples go in whole frames; the last dropped frame may have no frame after it.
+    if (hostFrames != adcStreamCount.frames || adcStreamCount.dropped < hostGaps * 4
+        || adcStreamCount.dropped > (hostGaps + 1) * 4 || !hostReports)
+        hostErrors++;
+    if (hostErrors)
+    {
+        printf("FAIL (%u errors)\n", (unsigned)hostErrors);
+        return 1;
+    }
+    printf("OK\n");
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
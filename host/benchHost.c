@@ -0,0 +1,64 @@
+/* File:  benchHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Runs canBenchRun() (canBench.c) on the host: the unmodified driver (can.c,
+ * hardware.c, timer.c) against the MCP2515 model, at each bit rate, and prints the results.
+ * Throughput and SPI traffic follow the SPI clock and the bus; PIC instruction time is not
+ * simulated, so the target numbers are lower.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -o benchHost host/benchHost.c host/picSim.c host/spiSim.c host/mcp2515Sim.c \
+ *       canQueue.c can.c canBench.c hardware.c timer.c -DCAN_BENCH=1 && ./benchHost
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include "../hardware.h"
+#include "../canBench.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+int main(void)
+{
+    static const char *names[CAN_BITRATES] = {"125 Kbps", "250 Kbps", "500 Kbps"};
+    canBenchResult result;
+    uint8_t failed = 0;
+    uint32_t isrWorst;
+    uint32_t isrMean;
+    
+    hardware_ini();
+    
+    for (uint8_t bitrate = CAN_BITRATE_125K; bitrate < CAN_BITRATES; bitrate++)
+    {
+        mcp2515SetBitrate(bitrate);
+        if (canBenchRun(CAN_BENCH_TIME_MS, &result) != MCP2515_OK)
+        {
+            printf("%s: mode change failed\n", names[bitrate]);
+            failed = 1;
+            continue;
+        }
+        
+        printf("%s: sent %u received %u lost %u corrupted %u, %u frames/s, "
+               "%u SPI bytes/frame, %u us ISR/frame, overflow %u\n",
+               names[bitrate], result.sent, result.received, result.lost, result.corrupted,
+               result.framesPerSecond, result.spiBytesPerFrame, result.isrMicrosPerFrame,
+               canRxOverflow);
+        
+        if (result.lost || result.corrupted)
+            failed = 1;
+    }
+    
+    picSimLatency(&isrWorst, &isrMean);
+    printf("INT2 latency: worst %.1f us, mean %.1f us\n", isrWorst / 1000.0, isrMean / 1000.0);
+    
+    return failed;
+    
+} // end int main(void) function
+
@@ -0,0 +1,436 @@
+/* File:  bootHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: End-to-end firmware update through the CAN bootloader (boot.c). The node runs the
+ * unmodified bootRun() on the driver, the MCP2515 model and the program memory model (flashSim.c:
+ * 2 ms CPU stall per erase or write, boot area write protected). The update tool is the other
+ * node of the bus: it answers each reply (HELLO, CREDIT, DONE) after the turnaround time, like
+ * a USB-CAN adapter, and sends the data frames the credit allows.
+ * 
+ * The image is random data from BOOT_APP_START with a hole of erased blocks, so it goes out as
+ * two segments; with -u a share of its blocks is already in the flash, as after a small change.
+ * Reported: update time against the bus limit (data frames back to back) and the flash limit
+ * (erases and writes back to back), frames dropped by the MCP2515, and the check of the flash
+ * content, the marker and the boot area. -l drops every Nth data frame at the tool, so the
+ * rewind path runs. The exit code is 1 when a check fails.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DSPI_CLOCK=0 -o bootHost host/bootHost.c host/picSim.c host/spiSim.c \
+ *       host/mcp2515Sim.c host/flashSim.c boot.c canQueue.c can.c hardware.c timer.c && ./bootHost
+ * Use:
+ *   ./bootHost [-t turnaroundUs] [-s imageBytes] [-u unchangedPercent] [-l dropEvery]
+ * The bit rate is the bootloader's, set at build time: add -DBOOT_BITRATE=CAN_BITRATE_500K.
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../boot.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+#include "flashSim.h"
+
+#define HOST_REPLIES            16
+#define HOST_SEGMENTS           8
+#define HOST_TIMEOUT_NS         100000000   // No reply: STATUS
+#define HOST_LIMIT_NS           600000000000ull
+
+// Tool states.
+#define HOST_HELLO              0
+#define HOST_SEGMENT            1
+#define HOST_DATA               2
+#define HOST_COMMIT             3
+#define HOST_END                4
+
+typedef struct
+{
+    uint16_t address;
+    uint16_t lenght;
+}hostSegment;
+
+static uint8_t hostImage[FLASH_SIZE];
+static hostSegment hostSegments[HOST_SEGMENTS];
+static uint8_t hostSegmentCount;
+static uint8_t hostSegmentNow;
+static uint8_t hostState;
+static uint16_t hostNext;               // Next data frame of the segment to send
+static uint16_t hostCredit;
+static uint16_t hostCrc = 0xFFFF;
+static uint32_t hostDropEvery;
+static uint32_t hostSent;
+static uint32_t hostDropped;
+static uint32_t hostRewinds;
+static uint32_t hostTimeouts;
+static uint8_t hostAsked;               // STATUS sent: the frames not received are lost
+static uint8_t hostResult = 0xFF;       // DONE status of COMMIT
+static uint64_t hostTurnaroundNs = 250000;
+static uint64_t hostWaitNs;             // A reply is awaited since
+static uint64_t hostStartNs;
+static uint64_t hostEndNs;
+
+// Replies seen on the bus, handled after the turnaround.
+static mcp2515SimFrame hostReplies[HOST_REPLIES];
+static uint64_t hostReplyDue[HOST_REPLIES];
+static uint8_t hostReplyHead;
+static uint8_t hostReplyCount;
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostCommand(uint8_t command, uint16_t first, uint16_t second)
+ * Description: Sends a command to BOOT_NODE.
+ *******************************************************************************/
+static void hostCommand(uint8_t command, uint16_t first, uint16_t second)
+{
+    mcp2515SimFrame frame = { 0x7C0, 0, 8, { command, BOOT_NODE, (uint8_t)first, (uint8_t)(first >> 8),
+                                           (uint8_t)second, (uint8_t)(second >> 8), 0, 0 } };
+    
+    if (!mcp2515SimInject(&frame))
+    {
+        fprintf(stderr, "tool queue full\n");
+        exit(1);
+    }
+    hostWaitNs = picSimNs();
+    
+} // end static void hostCommand(uint8_t command, uint16_t first, uint16_t second) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostSendData(void)
+ * Description: Queues the data frames of the segment the credit allows. With -l every Nth frame
+ * is counted as sent but not put on the bus.
+ *******************************************************************************/
+static void hostSendData(void)
+{
+    const hostSegment *segment = &hostSegments[hostSegmentNow];
+    mcp2515SimFrame frame = { 0, 0, 8, { 0 } };
+    
+    while (hostNext < hostCredit)
+    {
+        frame.id = 0x7D0 + (hostNext & 0x0F);
+        memcpy(frame.data, &hostImage[segment->address + hostNext * 8], 8);
+        hostSent++;
+        if (hostDropEvery && (hostSent % hostDropEvery) == 0)
+            hostDropped++;
+        else if (!mcp2515SimInject(&frame))
+            break;
+        hostNext++;
+    }
+    
+} // end static void hostSendData(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStartSegment(void)
+ * Description: SEGMENT command of the next segment, or COMMIT after the last one.
+ *******************************************************************************/
+static void hostStartSegment(void)
+{
+    if (hostSegmentNow < hostSegmentCount)
+    {
+        const hostSegment *segment = &hostSegments[hostSegmentNow];
+    
+        hostState = HOST_SEGMENT;
+        hostNext = 0;
+        hostCredit = 0;
+        for (uint16_t i = 0; i < segment->lenght; i += 8)
+            hostCrc = bootCrc(hostCrc, &hostImage[segment->address + i], 8);
+        hostCommand(BOOT_CMD_SEGMENT, segment->address, segment->lenght);
+    }
+    else
+    {
+        hostState = HOST_COMMIT;
+        hostCommand(BOOT_CMD_COMMIT, hostCrc, 0);
+    }
+    
+} // end static void hostStartSegment(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostReply(const mcp2515SimFrame *frame)
+ * Description: Tool side of a reply from the node.
+ *******************************************************************************/
+static void hostReply(const mcp2515SimFrame *frame)
+{
+    uint16_t first = frame->data[2] | (frame->data[3] << 8);
+    uint16_t second = frame->data[4] | (frame->data[5] << 8);
+    uint8_t asked = hostAsked;
+    
+    hostWaitNs = 0;
+    hostAsked = 0;
+    switch (frame->data[0])
+    {
+        case BOOT_REPLY_HELLO:
+            if (hostState == HOST_HELLO)
+            {
+                hostStartNs = picSimNs();
+                hostStartSegment();
+            }
+            break;
+    
+        case BOOT_REPLY_CREDIT:
+            if (hostState == HOST_SEGMENT)
+                hostState = HOST_DATA;
+            if (hostState != HOST_DATA)
+                break;
+            if ((frame->data[6] & BOOT_CREDIT_REWIND) || asked)
+            {
+                hostRewinds++;
+                hostNext = first;
+            }
+            if (second > hostCredit)
+                hostCredit = second;
+            hostSendData();
+            if (hostNext < hostSegments[hostSegmentNow].lenght / 8)
+                hostWaitNs = picSimNs();
+            break;
+    
+        case BOOT_REPLY_DONE:
+            if (frame->data[2] != BOOT_OK)
+            {
+                fprintf(stderr, "DONE status %u of command %u\n", frame->data[2], frame->data[3]);
+                hostResult = frame->data[2];
+                hostState = HOST_END;
+            }
+            else if (frame->data[3] == BOOT_CMD_SEGMENT)
+            {
+                hostSegmentNow++;
+                hostStartSegment();
+            }
+            else
+            {
+                hostResult = BOOT_OK;
+                hostEndNs = picSimNs();
+                hostState = HOST_END;
+            }
+            break;
+    
+        default:
+            break;
+    }
+    
+} // end static void hostReply(const mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: Frame of the node on the bus: queued for the tool, due after the turnaround.
+ *******************************************************************************/
+static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    uint8_t slot = (hostReplyHead + hostReplyCount) % HOST_REPLIES;
+    
+    if (frame->id != 0x7C8 || hostReplyCount == HOST_REPLIES)
+        return;
+    hostReplies[slot] = *frame;
+    hostReplyDue[slot] = endNs + hostTurnaroundNs;
+    hostReplyCount++;
+    
+} // end static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: handles the replies that are due, the pending data frames and the
+ * reply timeout.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    while (hostReplyCount && hostReplyDue[hostReplyHead] <= nowNs)
+    {
+        hostReply(&hostReplies[hostReplyHead]);
+        hostReplyHead = (hostReplyHead + 1) % HOST_REPLIES;
+        hostReplyCount--;
+    }
+    
+    if (hostState == HOST_DATA)
+        hostSendData();
+    
+    if (hostWaitNs && nowNs - hostWaitNs > HOST_TIMEOUT_NS && hostState != HOST_END)
+    {
+        hostTimeouts++;
+        if (hostState == HOST_HELLO)
+            hostCommand(BOOT_CMD_ENTER, 0, 0);
+        else
+        {
+            hostCommand(BOOT_CMD_STATUS, 0, 0);
+            hostAsked = 1;
+        }
+    }
+    
+    if (nowNs > HOST_LIMIT_NS)
+    {
+        fprintf(stderr, "update stuck: state %u, segment %u, frame %u, credit %u\n", hostState, hostSegmentNow, hostNext, hostCredit);
+        exit(1);
+    }
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t hostBlank(uint32_t address)
+ * Description: Returns 1 when the image block at (address) is erased: the tool skips it.
+ *******************************************************************************/
+static uint8_t hostBlank(uint32_t address)
+{
+    for (uint8_t i = 0; i < FLASH_ERASE_SIZE; i++)
+    {
+        if (hostImage[address + i] != FLASH_ERASED)
+            return 0;
+    }
+    
+    return 1;
+    
+} // end static uint8_t hostBlank(uint32_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostMakeImage(uint32_t size, uint32_t unchanged)
+ * Description: Random image of (size) bytes from BOOT_APP_START with a hole of 4 erased blocks in
+ * the middle, split in segments; (unchanged) percent of the blocks are put in the flash first.
+ *******************************************************************************/
+static void hostMakeImage(uint32_t size, uint32_t unchanged)
+{
+    uint32_t hole = BOOT_APP_START + (size / 2 & ~(FLASH_ERASE_SIZE - 1));
+    uint32_t end = BOOT_APP_START + size;
+    
+    memset(hostImage, FLASH_ERASED, sizeof(hostImage));
+    for (uint32_t address = BOOT_APP_START; address < end; address++)
+    {
+        if (address < hole || address >= hole + 4 * FLASH_ERASE_SIZE)
+            hostImage[address] = (uint8_t)rand();
+    }
+    
+    for (uint32_t address = BOOT_APP_START; address < end; )
+    {
+        uint32_t segment;
+    
+        while (address < end && hostBlank(address))
+            address += FLASH_ERASE_SIZE;
+        for (segment = address; address < end && !hostBlank(address); address += FLASH_ERASE_SIZE);
+        if (address > segment && hostSegmentCount < HOST_SEGMENTS)
+        {
+            hostSegments[hostSegmentCount].address = (uint16_t)segment;
+            hostSegments[hostSegmentCount].lenght = (uint16_t)(address - segment);
+            hostSegmentCount++;
+        }
+    }
+    
+    for (uint32_t address = BOOT_APP_START; address < end; address += FLASH_ERASE_SIZE)
+    {
+        if ((uint32_t)(rand() % 100) < unchanged)
+            memcpy(&flashSimMemory[address], &hostImage[address], FLASH_ERASE_SIZE);
+        else if (rand() & 1)
+            memset(&flashSimMemory[address], 0x3C, FLASH_ERASE_SIZE);  // Old code, to be erased
+    }
+    
+} // end static void hostMakeImage(uint32_t size, uint32_t unchanged) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    static uint8_t bootArea[BOOT_APP_START];
+    uint32_t size = 0x5000;
+    uint32_t unchanged = 0;
+    uint32_t frames = 0;
+    uint64_t busNs;
+    uint64_t flashNs;
+    uint64_t updateNs;
+    uint32_t errors = 0;
+    int differ = 0;
+    uint8_t result;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-t"))
+            hostTurnaroundNs = (uint64_t)(atof(argv[opt + 1]) * 1000);
+        else if (!strcmp(argv[opt], "-s"))
+            size = (uint32_t)strtoul(argv[opt + 1], 0, 0) & ~(FLASH_ERASE_SIZE - 1);
+        else if (!strcmp(argv[opt], "-u"))
+            unchanged = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-l"))
+            hostDropEvery = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || size < 8 * FLASH_ERASE_SIZE || size > BOOT_APP_END - BOOT_APP_START)
+    {
+        fprintf(stderr, "use: %s [-t turnaroundUs] [-s imageBytes] [-u unchangedPercent] [-l dropEvery]\n", argv[0]);
+        return 2;
+    }
+    
+    flashSimIni();
+    for (uint32_t i = 0; i < BOOT_APP_START; i++)
+        bootArea[i] = flashSimMemory[i] = (uint8_t)(i * 7);
+    flashSimProtect = BOOT_APP_START;
+    srand(1);
+    hostMakeImage(size, unchanged);
+    for (uint8_t i = 0; i < hostSegmentCount; i++)
+        frames += hostSegments[i].lenght / 8;
+    
+    mcp2515SimTxHook = hostBusEnd;
+    picSimHook = hostStep;
+    result = bootRun();
+    while (hostState != HOST_END)
+        picSimAdvance(PIC_SIM_TIMER_READ_NS);     // The last reply reaches the tool
+    
+    // Bus limit: the data frames back to back; flash limit: the erases and writes back to back.
+    busNs = (uint64_t)frames * (47 + 64) * mcp2515SimBitNs();
+    flashNs = flashSimCount.stallNs;
+    updateNs = hostEndNs - hostStartNs;
+    printf("bootloader update, %u Kbps, turnaround %.0f us, image %u bytes in %u segments, %u%% unchanged\n",
+           rates[BOOT_BITRATE], hostTurnaroundNs / 1e3, size, hostSegmentCount, unchanged);
+    printf("  update time       %8.1f ms  (%.1f Kbytes/s)\n", updateNs / 1e6, size / (updateNs / 1e9) / 1024);
+    printf("  bus limit         %8.1f ms  (%u data frames, %.0f%% of it)\n", busNs / 1e6, frames, 100.0 * busNs / updateNs);
+    printf("  stop and wait     %8.1f ms  (one reply per data frame, then the flash)\n",
+           (frames * ((47 + 64) * 2 * mcp2515SimBitNs() + hostTurnaroundNs) + flashNs) / 1e6);
+    printf("  flash limit       %8.1f ms  (%u erases, %u writes)\n", flashNs / 1e6, flashSimCount.erases, flashSimCount.writes);
+    printf("  frames sent       %8u     (dropped by the tool %u, rewinds %u, timeouts %u)\n", hostSent, hostDropped, hostRewinds, hostTimeouts);
+    printf("  MCP2515 overflows %8u\n", mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1]);
+    
+    if (result != 1 || hostResult != BOOT_OK)
+    {
+        printf("  FAIL: update not committed\n");
+        errors++;
+    }
+    for (uint8_t i = 0; i < hostSegmentCount; i++)
+        differ |= memcmp(&flashSimMemory[hostSegments[i].address], &hostImage[hostSegments[i].address], hostSegments[i].lenght);
+    if (differ)
+    {
+        printf("  FAIL: flash differs from the segments sent\n");
+        errors++;
+    }
+    if (memcmp(flashSimMemory, bootArea, BOOT_APP_START) || flashSimCount.protectedWrites)
+    {
+        printf("  FAIL: boot area written\n");
+        errors++;
+    }
+    if (!bootAppValid())
+    {
+        printf("  FAIL: marker not written\n");
+        errors++;
+    }
+    
+    // Next reset: a valid application, nobody asks for the bootloader.
+    picSimHook = 0;
+    if (bootRun() != 0)
+    {
+        printf("  FAIL: the bootloader did not start the application\n");
+        errors++;
+    }
+    printf("%s\n", errors ? "FAIL" : "OK: image programmed, verified and committed");
+    
+    return errors ? 1 : 0;
+    
+} // end int main(int argc, char **argv) function
+
@@ -0,0 +1,216 @@
+/* File:  canDispatchHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Test and benchmark of canDispatch() as generated by tools/dispatchgen.py, on a
+ * large bindings file: host/canDispatchBench.def, 128 random identifiers (136 with
+ * HOST_DISPATCH_EXTRA = 1, a conditional block). The file is read again here: every bound
+ * identifier must reach its handler, every other one of the 2048 the default handler. Then the
+ * cost per frame is timed for the first and the last bindings of the file, against the linear
+ * search of the same list (an if/else chain or a table loop), which grows with the position.
+ * The exit code is 1 when a frame reaches the wrong handler.
+ * 
+ * Build and run, from the project folder:
+ *   python3 tools/dispatchgen.py host/canDispatchBench.def host/canDispatchBench && \
+ *   gcc -O2 -Ihost -I. -o canDispatchHost host/canDispatchHost.c host/canDispatchBench.c && \
+ *   ./canDispatchHost host/canDispatchBench.def
+ * (add -DHOST_DISPATCH_EXTRA=1 to gcc for the conditional block)
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "canDispatchBench.h"
+
+#ifndef HOST_DISPATCH_EXTRA
+    #define HOST_DISPATCH_EXTRA     0
+#endif
+
+#define HOST_IDS                2048
+#define HOST_NO_HANDLER         0xFF
+#define HOST_DEFAULT            4
+#define HOST_TIMED              8           // Bindings timed at each end of the file
+#define HOST_REPEAT             2000000
+
+static uint8_t hostBound[HOST_IDS];         // Handler expected for each identifier
+static uint16_t hostList[HOST_IDS];         // Bound identifiers, in file order
+static uint16_t hostListed;
+static uint8_t hostCalled;
+static uint16_t hostCalledId;
+static volatile uint32_t hostSink;
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostRecord(uint8_t handler, const dataFrame *frame);
+ *           void hostHandler0(const dataFrame *frame) ... void hostDefaultHandler(const dataFrame *frame)
+ * Description: Handlers of the bindings file: record which one ran, for which identifier.
+ *******************************************************************************/
+static void hostRecord(uint8_t handler, const dataFrame *frame)
+{
+    hostCalled = handler;
+    hostCalledId = ((uint16_t)frame->idh << 3) | (frame->idl >> 5);
+    
+} // end static void hostRecord(uint8_t handler, const dataFrame *frame) function
+
+void hostHandler0(const dataFrame *frame) { hostRecord(0, frame); }
+void hostHandler1(const dataFrame *frame) { hostRecord(1, frame); }
+void hostHandler2(const dataFrame *frame) { hostRecord(2, frame); }
+void hostHandler3(const dataFrame *frame) { hostRecord(3, frame); }
+void hostDefaultHandler(const dataFrame *frame) { hostRecord(HOST_DEFAULT, frame); }
+
+
+/*******************************************************************************
+ * FUNCTION: static int hostRead(const char *path)
+ * Description: Expected bindings from the bindings file, "if HOST_DISPATCH_EXTRA" block included
+ * when the build has it. Returns 0 when the file cannot be read.
+ *******************************************************************************/
+static int hostRead(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char line[160];
+    uint8_t skip = 0;
+    
+    if (!file)
+        return 0;
+    memset(hostBound, HOST_DEFAULT, sizeof(hostBound));
+    while (fgets(line, sizeof(line), file))
+    {
+        unsigned id;
+        unsigned handler;
+    
+        if (!strncmp(line, "if ", 3))
+            skip = !HOST_DISPATCH_EXTRA;
+        else if (!strncmp(line, "endif", 5))
+            skip = 0;
+        else if (!skip && (sscanf(line, "%x hostHandler%u", &id, &handler) == 2) && (id < HOST_IDS))
+        {
+            hostBound[id] = (uint8_t)handler;
+            hostList[hostListed++] = (uint16_t)id;
+        }
+    }
+    fclose(file);
+    
+    return 1;
+    
+} // end static int hostRead(const char *path) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostFrame(dataFrame *frame, uint16_t id)
+ * Description: Standard data frame with identifier (id), as canReceive() gives it.
+ *******************************************************************************/
+static void hostFrame(dataFrame *frame, uint16_t id)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->idh = (uint8_t)(id >> 3);
+    frame->idl = (uint8_t)(id << 5);
+    frame->dlc = 8;
+    
+} // end static void hostFrame(dataFrame *frame, uint16_t id) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t hostLinear(const dataFrame *frame)
+ * Description: The dispatch it replaces: the bound identifiers compared in file order.
+ *******************************************************************************/
+static uint8_t hostLinear(const dataFrame *frame)
+{
+    uint16_t id = ((uint16_t)frame->idh << 3) | (frame->idl >> 5);
+    
+    for (uint16_t i = 0; i < hostListed; i++)
+    {
+        if (hostList[i] == id)
+        {
+            hostRecord(hostBound[id], frame);
+            return 1;
+        }
+    }
+    hostDefaultHandler(frame);
+    
+    return 0;
+    
+} // end static uint8_t hostLinear(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static double hostTime(uint8_t (*dispatch)(const dataFrame *), uint16_t first)
+ * Description: ns per frame of (dispatch) over the HOST_TIMED bindings from position (first).
+ *******************************************************************************/
+static double hostTime(uint8_t (*dispatch)(const dataFrame *), uint16_t first)
+{
+    dataFrame frames[HOST_TIMED];
+    struct timespec start;
+    struct timespec end;
+    uint32_t sum = 0;
+    
+    for (uint8_t i = 0; i < HOST_TIMED; i++)
+    {
+        hostFrame(&frames[i], hostList[first + i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t n = 0; n < HOST_REPEAT; n++)
+    {
+        sum += dispatch(&frames[n & (HOST_TIMED - 1)]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    hostSink = sum;
+    
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / HOST_REPEAT;
+    
+} // end static double hostTime(uint8_t (*dispatch)(const dataFrame *), uint16_t first) function
+
+
+int main(int argc, char **argv)
+{
+    uint32_t wrong = 0;
+    uint32_t bound = 0;
+    
+    if ((argc != 2) || !hostRead(argv[1]))
+    {
+        fprintf(stderr, "use: %s <bindings file>, the one canDispatchBench.c was generated from\n", argv[0]);
+        return 2;
+    }
+    if (hostListed != CAN_DISPATCH_IDS)
+    {
+        printf("FAIL: %u bindings in the file, %u in the table\n", hostListed, CAN_DISPATCH_IDS);
+        return 1;
+    }
+    
+    // Every identifier, bound or not.
+    for (uint16_t id = 0; id < HOST_IDS; id++)
+    {
+        dataFrame frame;
+        uint8_t found;
+    
+        hostFrame(&frame, id);
+        hostCalled = HOST_NO_HANDLER;
+        found = canDispatch(&frame);
+        if ((hostCalled != hostBound[id]) || (hostCalledId != id) || (found != (hostBound[id] != HOST_DEFAULT)))
+        {
+            if (wrong++ < 10)
+                printf("  FAIL 0x%03X: handler %u, expected %u\n", id, hostCalled, hostBound[id]);
+        }
+        bound += found;
+    }
+    printf("%u bindings in %u slots: %u identifiers dispatched, %u bound, %u wrong\n", CAN_DISPATCH_IDS,
+           CAN_DISPATCH_SLOTS, HOST_IDS, bound, wrong);
+    
+    printf("ns per frame        first %u bindings   last %u bindings\n", HOST_TIMED, HOST_TIMED);
+    printf("  canDispatch()     %10.2f        %10.2f\n", hostTime(canDispatch, 0),
+           hostTime(canDispatch, hostListed - HOST_TIMED));
+    printf("  linear search     %10.2f        %10.2f\n", hostTime(hostLinear, 0),
+           hostTime(hostLinear, hostListed - HOST_TIMED));
+    
+    printf(wrong ? "FAIL\n" : "OK: every identifier reached its handler\n");
+    
+    return wrong ? 1 : 0;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,371 @@
+/* File:  canGenHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Traffic generator (canGen.c) on the MCP2515 model. The node runs the generator with
+ * the mix of main.c at the load of -l (permille, 1000: as fast as it goes), evenly spread or in
+ * bursts of -b frames. The tool, on the bus:
+ *   sending side: checks every frame of the node (sequence counter of its identifier, payload) and
+ *       measures the load it puts on the bus, stuff bits counted bit by bit, and the identifier and data
+ *       length shares against the weights of the mix;
+ *   receiving side: plays a faulty gateway, sending identifier 0x0A0 of the mix every -i us and
+ *       dropping, swapping and corrupting frames at known places; the node's counters must match.
+ * The node's report frame (0x3E8) is decoded. The exit code is 1 when a check fails, the load is
+ * more than 2 % from the target, or the node reports more than 1 % off the load measured here.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DCAN_GEN=1 -DSPI_CLOCK=0 -o canGenHost host/canGenHost.c host/picSim.c \
+ *       host/spiSim.c host/mcp2515Sim.c canGen.c busLoad.c canQueue.c can.c hardware.c timer.c \
+ *       && ./canGenHost
+ * Use:
+ *   ./canGenHost [-l loadPermille] [-b burstFrames] [-i gatewayPeriodUs] [-r 125|250|500] [-s seconds]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../canGen.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define HOST_STEP_NS            1000
+#define HOST_WARMUP_NS          100000000   // Load measured after it
+#define HOST_FAULT_EVERY        40          // Gateway frames: one drop, one swap, one corruption in each 40
+
+// The mix of main.c.
+static const canGenId hostIds[] =
+{
+    { 0x0A0, 60 }, { 0x0C8, 50 }, { 0x1F0, 40 }, { 0x2A0, 30 }, { 0x3A0, 20 }, { 0x4B0, 20 }, { 0x5C0, 20 }, { 0x6D0, 15 },
+};
+#define HOST_IDS                (sizeof(hostIds) / sizeof(hostIds[0]))
+static canGenMix hostMix =
+{
+    hostIds, HOST_IDS,
+    { 5, 5, 10, 5, 20, 5, 10, 5, 190 },
+    500, 0, 0x1234,
+};
+
+static uint64_t hostStartNs;
+static uint64_t hostEndNs;
+static uint64_t hostGatewayNs;
+static uint64_t hostGatewayPeriodNs = 2000000;
+
+// Sending side, seen on the bus.
+static uint32_t hostFrames;
+static uint64_t hostBits;               // Stuff bits included
+static uint32_t hostIdCount[HOST_IDS];
+static uint32_t hostDlcCount[9];
+static uint8_t hostNext[HOST_IDS];
+static uint8_t hostSeen[HOST_IDS];
+static uint32_t hostSeqErrors;
+static uint32_t hostPayloadErrors;
+static canGenReport hostReport;
+static uint32_t hostReports;
+
+// Receiving side, the faults of the gateway.
+static uint32_t hostGatewayIndex;
+static uint8_t hostGatewayCounter;
+static uint8_t hostHeld;                // Swap: frame held back (1), sent once a newer one is (2)
+static uint8_t hostHeldCounter;
+static uint32_t hostDropped;
+static uint32_t hostSwapped;
+static uint32_t hostCorrupted;
+static uint32_t hostDelivered;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t hostGatewaySend(uint8_t counter, uint8_t corrupt)
+ * Description: One frame of identifier 0x0A0 with (counter), its payload broken with (corrupt).
+ * Returns 0 when the model's queue is full.
+ *******************************************************************************/
+static uint8_t hostGatewaySend(uint8_t counter, uint8_t corrupt)
+{
+    mcp2515SimFrame frame = { hostIds[0].id, 0, 8, { 0 } };
+    
+    for (uint8_t i = 0; i < 8; i++)
+        frame.data[i] = (uint8_t)(counter + i * CAN_GEN_PATTERN);
+    if (corrupt)
+        frame.data[5] ^= 0x10;
+    
+    return mcp2515SimInject(&frame);
+    
+} // end static uint8_t hostGatewaySend(uint8_t counter, uint8_t corrupt) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the faulty gateway. In every HOST_FAULT_EVERY frames, frame 10 is
+ * dropped, frame 20 held back and sent once frame 21 is, frame 30 corrupted. A frame the model
+ * cannot queue (the node holding the bus) is tried again at the next step.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    uint8_t k;
+    
+    if (hostHeld == 2 && hostGatewaySend(hostHeldCounter, 0))
+    {
+        hostHeld = 0;
+        hostSwapped++;
+        hostDelivered++;
+    }
+    if (!hostGatewayPeriodNs || nowNs < hostGatewayNs || nowNs >= hostEndNs)
+        return;
+    hostGatewayNs += hostGatewayPeriodNs;
+    
+    k = (uint8_t)(hostGatewayIndex % HOST_FAULT_EVERY);
+    if (k == 10 && hostGatewayIndex)
+        hostDropped++;
+    else if (k == 20)
+    {
+        hostHeld = 1;
+        hostHeldCounter = hostGatewayCounter;
+    }
+    else
+    {
+        if (!hostGatewaySend(hostGatewayCounter, k == 30))
+            return;         // Queue full (the node holds the bus): same frame next time
+        hostDelivered++;
+        hostCorrupted += k == 30;
+        if (hostHeld)
+            hostHeld = 2;
+    }
+    hostGatewayCounter++;
+    hostGatewayIndex++;
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t hostFrameBits(const mcp2515SimFrame *frame)
+ * Description: Length on the bus of a standard data frame, as an analyser counts it: the bits from
+ * SOF to the CRC, stuffed one by one, then CRC delimiter, ACK, EOF and intermission (13 bits).
+ *******************************************************************************/
+static uint32_t hostFrameBits(const mcp2515SimFrame *frame)
+{
+    uint8_t bits[128];
+    uint32_t count = 0;
+    uint32_t stuffed = 0;
+    uint16_t crc = 0;
+    uint8_t dlc = frame->dlc & 0x0F;
+    uint8_t level = 0;                                      // SOF, after the recessive idle bus
+    uint8_t run = 1;
+    
+    bits[count++] = 0;                                      // SOF
+    for (int i = 10; i >= 0; i--)
+        bits[count++] = (frame->id >> i) & 1;
+    bits[count++] = 0;                                      // RTR
+    bits[count++] = 0;                                      // IDE
+    bits[count++] = 0;                                      // r0
+    for (int i = 3; i >= 0; i--)
+        bits[count++] = (dlc >> i) & 1;
+    for (uint8_t j = 0; j < dlc; j++)
+        for (int i = 7; i >= 0; i--)
+            bits[count++] = (frame->data[j] >> i) & 1;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint8_t next = bits[i] ^ ((crc >> 14) & 1);
+    
+        crc = (crc << 1) & 0x7FFF;
+        if (next)
+            crc ^= 0x4599;
+    }
+    for (int i = 14; i >= 0; i--)
+        bits[count++] = (crc >> i) & 1;
+    
+    for (uint32_t i = 1; i < count; i++)
+    {
+        run = (bits[i] == level) ? run + 1 : 1;
+        level = bits[i];
+        if (run == 5)
+        {
+            // Five equal bits: the stuff bit, of the other level, starts the next run.
+            stuffed++;
+            level ^= 1;
+            run = 1;
+        }
+    }
+    
+    return count + stuffed + 13;
+    
+} // end static uint32_t hostFrameBits(const mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook: every frame of the node.
+ *******************************************************************************/
+static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    uint8_t dlc = frame->dlc & 0x0F;
+    uint8_t i;
+    
+    if (frame->id == (uint32_t)CAN_GEN_REPORT_IDH << 3)
+    {
+        hostReport.permille = frame->data[0] | (frame->data[1] << 8);
+        hostReport.framesPerSecond = frame->data[2] | (frame->data[3] << 8);
+        hostReport.lost = frame->data[4] | (frame->data[5] << 8);
+        hostReport.reordered = frame->data[6];
+        hostReport.corrupted = frame->data[7];
+        hostReports++;
+        return;
+    }
+    for (i = 0; i < HOST_IDS && hostIds[i].id != frame->id; i++);
+    if (i == HOST_IDS)
+        return;
+    
+    if (endNs >= hostStartNs + HOST_WARMUP_NS)
+    {
+        hostFrames++;
+        hostBits += hostFrameBits(frame);
+        hostIdCount[i]++;
+        hostDlcCount[dlc]++;
+    }
+    if (!dlc)
+        return;
+    for (uint8_t j = 1; j < dlc; j++)
+    {
+        if (frame->data[j] != (uint8_t)(frame->data[0] + j * CAN_GEN_PATTERN))
+        {
+            hostPayloadErrors++;
+            break;
+        }
+    }
+    if (hostSeen[i] && frame->data[0] != hostNext[i])
+        hostSeqErrors++;
+    hostSeen[i] = 1;
+    hostNext[i] = frame->data[0] + 1;
+    
+} // end static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_500K;
+    uint32_t seconds = 5;
+    uint32_t lostExpected;
+    double permille;
+    double shareWorst = 0;
+    uint32_t idWeights = 0;
+    uint32_t dlcWeights = 0;
+    uint8_t fail;
+    dataFrame frame;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-l"))
+            hostMix.loadPermille = (uint16_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-b"))
+            hostMix.burst = (uint8_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-i"))
+            hostGatewayPeriodNs = (uint64_t)atoi(argv[opt + 1]) * 1000;
+        else if (!strcmp(argv[opt], "-r"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-s"))
+            seconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || !hostMix.loadPermille || hostMix.loadPermille > 1000 || bitrate >= CAN_BITRATES || seconds < 2)
+    {
+        fprintf(stderr, "use: %s [-l loadPermille] [-b burstFrames] [-i gatewayPeriodUs] [-r 125|250|500] [-s seconds]\n",
+                argv[0]);
+        return 2;
+    }
+    
+    hardware_ini();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(bitrate);
+    mcp2515ConfigEnd();
+    if (canGenStart(&hostMix) != CAN_GEN_OK)
+    {
+        printf("FAIL: canGenStart()\n");
+        return 1;
+    }
+    
+    mcp2515SimTxHook = hostTx;
+    picSimHook = hostStep;
+    hostStartNs = picSimNs();
+    hostGatewayNs = hostStartNs + 1000000;
+    hostEndNs = hostStartNs + (uint64_t)seconds * 1000000000;
+    
+    // Main loop of the node, as in main.c; the generator stops at the end, the gateway's frames
+    // still queued then go out.
+    while (picSimNs() < hostEndNs + 100000000)
+    {
+        if (picSimNs() < hostEndNs)
+            canGenService();
+        while (canReceive(&frame))
+        {
+            canGenCheck(&frame);
+        }
+        picSimAdvance(HOST_STEP_NS);
+    }
+    
+    permille = hostBits * 1000.0 / ((hostEndNs - hostStartNs - HOST_WARMUP_NS) / 1000.0 * rates[bitrate] / 1000.0);
+    for (uint8_t i = 0; i < HOST_IDS; i++)
+        idWeights += hostIds[i].weight;
+    for (uint8_t i = 0; i < 9; i++)
+        dlcWeights += hostMix.dlcWeight[i];
+    
+    printf("traffic generator, %u Kbps, target %u permille, %s, %u s\n", rates[bitrate], hostMix.loadPermille,
+           hostMix.burst > 1 ? "bursts" : "evenly spread", seconds);
+    printf("  sent              %8u frames, %.1f permille of the bus (stuff bits included)\n", hostFrames, permille);
+    printf("  node's report     %8u permille, %u frames/s  (%u reports)\n", hostReport.permille,
+           hostReport.framesPerSecond, hostReports);
+    printf("  sequence, payload %8u, %u errors on the bus\n", hostSeqErrors, hostPayloadErrors);
+    printf("  identifier share ");
+    for (uint8_t i = 0; i < HOST_IDS; i++)
+    {
+        double share = hostFrames ? hostIdCount[i] * 100.0 / hostFrames : 0;
+        double expected = hostIds[i].weight * 100.0 / idWeights;
+    
+        printf(" %.1f/%.1f", share, expected);
+        if (share - expected > shareWorst || expected - share > shareWorst)
+            shareWorst = share > expected ? share - expected : expected - share;
+    }
+    printf(" %%\n  length share     ");
+    for (uint8_t i = 0; i < 9; i++)
+    {
+        double share = hostFrames ? hostDlcCount[i] * 100.0 / hostFrames : 0;
+        double expected = hostMix.dlcWeight[i] * 100.0 / dlcWeights;
+    
+        printf(" %.1f/%.1f", share, expected);
+        if (share - expected > shareWorst || expected - share > shareWorst)
+            shareWorst = share > expected ? share - expected : expected - share;
+    }
+    printf(" %%\n");
+    
+    // A swap is one step over and one back; a corrupted frame leaves a step over too.
+    lostExpected = hostDropped + hostSwapped + hostCorrupted;
+    printf("  gateway           %8u frames delivered: %u dropped, %u swapped, %u corrupted\n", hostDelivered, hostDropped,
+           hostSwapped, hostCorrupted);
+    printf("  node checked      %8u frames: %u lost, %u reordered, %u corrupted  (expected %u, %u, %u)\n",
+           canGenCount.received, canGenCount.lost, canGenCount.reordered, canGenCount.corrupted, lostExpected,
+           hostSwapped, hostCorrupted);
+    
+    fail = hostSeqErrors || hostPayloadErrors || shareWorst > 3.0 || canGenCount.received != hostDelivered
+           || canGenCount.lost != lostExpected || canGenCount.reordered != hostSwapped
+           || canGenCount.corrupted != hostCorrupted || !hostReports
+           || hostReport.permille < permille - 10 || hostReport.permille > permille + 10;
+    if (hostMix.loadPermille < 1000 && (permille < hostMix.loadPermille - 20 || permille > hostMix.loadPermille + 20))
+        fail = 1;
+    if (fail)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: %.1f permille for %u, every fault of the gateway counted\n", permille, hostMix.loadPermille);
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,410 @@
+/* File:  canOpenHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: CANopen slave (canOpen.c) against a master. The node runs the driver and canOpen.c on
+ * the MCP2515 model, its main loop as in main.c; other nodes load the bus with random frames (-b
+ * percent, identifiers 0x280-0x4FF). The tool is the NMT master, the SYNC producer (-p us), the
+ * RPDO producer and an SDO client:
+ *   NMT:   boot-up after the start, START, then STOP and RESET COMMUNICATION at the end (no TPDO
+ *          while stopped, a second boot-up);
+ *   PDO:   before each SYNC the tool writes the process image as the application would, and each
+ *          TPDO must carry the image of its SYNC; an RPDO sent between two SYNC must be in the
+ *          image after the second (synchronous RPDO);
+ *   SDO:   a script of expedited and segmented uploads and downloads, then the aborts (unknown
+ *          object and sub-index, read only object, value out of range, toggle bit, timeout);
+ *          heartbeat time changed to 100 ms by SDO and the heartbeat period checked.
+ * The SYNC to TPDO latency is measured from the end of the SYNC frame to the start of frame of the
+ * TPDO and to its end. The exit code is 1 when a check fails or the TPDO start of frame comes
+ * later than -l us after the SYNC.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DCANOPEN=1 -DSPI_CLOCK=0 -o canOpenHost host/canOpenHost.c \
+ *       host/picSim.c host/spiSim.c host/mcp2515Sim.c host/eepromSim.c host/flashSim.c canOpen.c \
+ *       eeConfig.c boot.c canQueue.c can.c hardware.c timer.c && ./canOpenHost
+ * Use:
+ *   ./canOpenHost [-b busLoadPercent] [-r 125|250|500] [-p syncPeriodUs] [-l latencyBudgetUs] [-s seconds]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../canOpen.h"
+#include "../eeConfig.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define HOST_STEP_NS            1000
+#define HOST_NODE               CANOPEN_NODE_ID
+#define HOST_START_NS           5000000     // NMT START
+#define HOST_SDO_NS             20000000    // First SDO request
+#define HOST_SDO_GAP_NS         1000000     // Between an answer and the next request
+#define HOST_HEARTBEAT_MS       100         // Written to 0x1017 by the script
+#define HOST_END_NS             300000000   // STOP, then RESET COMMUNICATION, before the end
+#define HOST_NO_ANSWER          0xFF        // Script step: no request, wait for the answer
+
+// SDO script: request (HOST_NO_ANSWER: none) and the answer expected, all 8 bytes.
+typedef struct
+{
+    uint8_t request[8];
+    uint8_t answer[8];
+    const char *name;
+}hostSdoStep;
+
+static const hostSdoStep hostScript[] =
+{
+    { {0x40, 0x00, 0x10, 0x00}, {0x43, 0x00, 0x10, 0x00, 0x91, 0x01, 0x03, 0x00}, "upload 0x1000 device type" },
+    { {0x40, 0x08, 0x10, 0x00}, {0x41, 0x08, 0x10, 0x00, 0x12}, "upload 0x1008 name, initiate" },
+    { {0x60}, {0x00, 'C', 'A', 'N', '_', 'O', 'N', 'E'}, "segment 1" },
+    { {0x70}, {0x10, ' ', 'P', 'I', 'C', '1', '8', 'F'}, "segment 2" },
+    { {0x60}, {0x07, '4', '5', '5', '0'}, "segment 3, last" },
+    { {0x40, 0x00, 0x1A, 0x00}, {0x4F, 0x00, 0x1A, 0x00, 0x03}, "upload 0x1A00:00 TPDO entries" },
+    { {0x40, 0x00, 0x1A, 0x02}, {0x43, 0x00, 0x1A, 0x02, 0x10, 0x01, 0x01, 0x64}, "upload 0x1A00:02 mapping" },
+    { {0x40, 0x00, 0x16, 0x02}, {0x43, 0x00, 0x16, 0x02, 0x10, 0x01, 0x11, 0x64}, "upload 0x1600:02 mapping" },
+    { {0x2B, 0x17, 0x10, 0x00, HOST_HEARTBEAT_MS}, {0x60, 0x17, 0x10, 0x00}, "download 0x1017 heartbeat" },
+    { {0x40, 0x17, 0x10, 0x00}, {0x4B, 0x17, 0x10, 0x00, HOST_HEARTBEAT_MS}, "upload 0x1017" },
+    { {0x21, 0x01, 0x20, 0x00, EE_CONFIG_PARAMS}, {0x60, 0x01, 0x20, 0x00}, "download 0x2001 parameters, initiate" },
+    { {0x00, 1, 2, 3, 4, 5, 6, 7}, {0x20}, "segment 1" },
+    { {0x10, 8, 9, 10, 11, 12, 13, 14}, {0x30}, "segment 2" },
+    { {0x0B, 15, 16}, {0x20}, "segment 3, last" },
+    { {0x2F, 0x00, 0x18, 0x02, 0x02}, {0x60, 0x00, 0x18, 0x02}, "download 0x1800:02 TPDO every 2 SYNC" },
+    { {0x2F, 0x00, 0x18, 0x02, 0x01}, {0x60, 0x00, 0x18, 0x02}, "download 0x1800:02 TPDO every SYNC" },
+    { {0x40, 0x00, 0x30, 0x00}, {0x80, 0x00, 0x30, 0x00, 0x00, 0x00, 0x02, 0x06}, "abort: object 0x3000" },
+    { {0x40, 0x00, 0x60, 0x02}, {0x80, 0x00, 0x60, 0x02, 0x11, 0x00, 0x09, 0x06}, "abort: sub-index 0x6000:02" },
+    { {0x23, 0x00, 0x10, 0x00, 1, 2, 3, 4}, {0x80, 0x00, 0x10, 0x00, 0x02, 0x00, 0x01, 0x06}, "abort: write 0x1000" },
+    { {0x2F, 0x00, 0x18, 0x02, 0x00}, {0x80, 0x00, 0x18, 0x02, 0x30, 0x00, 0x09, 0x06}, "abort: 0x1800:02 range" },
+    { {0x2B, 0x00, 0x62, 0x01, 1, 2}, {0x80, 0x00, 0x62, 0x01, 0x10, 0x00, 0x07, 0x06}, "abort: 0x6200:01 length" },
+    { {0x22, 0x01, 0x20, 0x00, 1, 2, 3, 4}, {0x80, 0x01, 0x20, 0x00, 0x10, 0x00, 0x07, 0x06}, "abort: 0x2001 expedited, no size" },
+    { {0x21, 0x01, 0x20, 0x00, EE_CONFIG_PARAMS}, {0x60, 0x01, 0x20, 0x00}, "download 0x2001, initiate" },
+    { {0x10, 1, 2, 3, 4, 5, 6, 7}, {0x80, 0x01, 0x20, 0x00, 0x00, 0x00, 0x03, 0x05}, "abort: toggle bit" },
+    { {0x40, 0x08, 0x10, 0x00}, {0x41, 0x08, 0x10, 0x00, 0x12}, "upload 0x1008, initiate" },
+    { {HOST_NO_ANSWER}, {0x80, 0x08, 0x10, 0x00, 0x00, 0x00, 0x04, 0x05}, "abort: timeout" },
+};
+
+#define HOST_SCRIPT_STEPS       (sizeof(hostScript) / sizeof(hostScript[0]))
+
+static uint32_t hostLoad = 30;
+static uint64_t hostPeriodNs = 10000000;
+static uint64_t hostEndNs;
+static uint64_t hostTrafficNs;          // Next frame of the other nodes
+static uint64_t hostSyncNs;             // Next SYNC
+static uint64_t hostRpdoNs;             // Next RPDO, halfway between two SYNC
+static uint8_t hostSeq;                 // Process image written before the last SYNC
+static uint8_t hostRpdoSent;            // Last RPDO sent, applied at the next SYNC
+static uint8_t hostRpdoDue;             // RPDO the image must hold once its SYNC is in
+static uint8_t hostNmt;                 // NMT commands sent
+static uint64_t hostStopNs;             // NMT STOP sent
+
+static uint64_t hostSyncEndNs;          // End of the last SYNC
+static uint32_t hostSyncs;
+static uint32_t hostTpdos;
+static uint32_t hostTpdoErrors;         // Content not the image of its SYNC
+static uint32_t hostRpdoErrors;         // Image without the RPDO after its SYNC
+static uint32_t hostStoppedTpdos;       // TPDO while STOPPED
+static double hostSofSum;
+static uint32_t hostSofWorst;
+static double hostEndSum;
+static uint32_t hostEndWorst;
+
+static uint32_t hostBootups;
+static uint32_t hostHeartbeats;
+static uint64_t hostHeartbeatNs;
+static uint32_t hostHeartbeatWorst;     // Period error once the script set it, us
+static uint8_t hostHeartbeatArmed;      // Last heartbeat in OPERATIONAL after the script changed 0x1017
+
+static uint32_t hostScriptStep;         // SDO script step
+static uint64_t hostSdoNs;              // Next request, 0: waiting for the answer
+static uint32_t hostSdoErrors;
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostImage(uint8_t seq)
+ * Description: The application: process image of SYNC (seq). The hook runs between two
+ * instructions, as the GIE off copy canOpen.h asks for.
+ *******************************************************************************/
+static void hostImage(uint8_t seq)
+{
+    canOpenIo.inputs = seq;
+    canOpenIo.analog[0] = (uint16_t)(seq * 0x0101u);
+    canOpenIo.analog[1] = (uint16_t)~(seq * 3u);
+    
+} // end static void hostImage(uint8_t seq) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostInject(uint32_t id, uint8_t dlc, const uint8_t *data)
+ * Description: A frame of the master.
+ *******************************************************************************/
+static void hostInject(uint32_t id, uint8_t dlc, const uint8_t *data)
+{
+    mcp2515SimFrame frame = { id, 0, dlc, { 0 } };
+    
+    memcpy(frame.data, data, dlc);
+    mcp2515SimInject(&frame);
+    
+} // end static void hostInject(uint32_t id, uint8_t dlc, const uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimRxHook: end of each SYNC taken by the node.
+ *******************************************************************************/
+static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    if (frame->id == CANOPEN_COB_SYNC)
+    {
+        hostSyncEndNs = endNs;
+        hostSyncs++;
+    }
+    
+} // end static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs)
+ * Description: mcp2515SimStartHook: start of frame of each TPDO.
+ *******************************************************************************/
+static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs)
+{
+    uint32_t latency = (uint32_t)((startNs - hostSyncEndNs) / 1000);
+    
+    if (frame->id != CANOPEN_COB_TPDO1 + HOST_NODE)
+        return;
+    hostSofSum += latency;
+    if (latency > hostSofWorst)
+        hostSofWorst = latency;
+    
+} // end static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook: the frames of the node. TPDO content and latency, RPDO applied,
+ * boot-up and heartbeat, SDO answers against the script.
+ *******************************************************************************/
+static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    if (frame->id == CANOPEN_COB_TPDO1 + HOST_NODE)
+    {
+        uint8_t seq = hostSeq;
+        uint16_t analog0 = (uint16_t)(seq * 0x0101u);
+        uint16_t analog1 = (uint16_t)~(seq * 3u);
+        uint32_t latency = (uint32_t)((endNs - hostSyncEndNs) / 1000);
+    
+        hostTpdos++;
+        if (hostNmt >= 2 && hostSyncEndNs > hostStopNs)
+            hostStoppedTpdos++;
+        if (frame->dlc != CANOPEN_TPDO1_DLC || frame->data[0] != seq || frame->data[1] != (uint8_t)analog0
+            || frame->data[2] != (uint8_t)(analog0 >> 8) || frame->data[3] != (uint8_t)analog1
+            || frame->data[4] != (uint8_t)(analog1 >> 8))
+            hostTpdoErrors++;
+        if (hostNmt == 1 && (canOpenIo.outputs != hostRpdoDue || canOpenIo.setpoint != (int16_t)(hostRpdoDue * -100)))
+            hostRpdoErrors++;
+        hostEndSum += latency;
+        if (latency > hostEndWorst)
+            hostEndWorst = latency;
+    }
+    else if (frame->id == CANOPEN_COB_HEARTBEAT + HOST_NODE && frame->dlc == 1)
+    {
+        if (frame->data[0] == CANOPEN_INITIALISATION)
+            hostBootups++;
+        else
+        {
+            // Period checked between two heartbeats in OPERATIONAL once the script has changed it.
+            if (frame->data[0] == CANOPEN_OPERATIONAL && hostScriptStep >= 10)
+            {
+                int32_t error = (int32_t)((endNs - hostHeartbeatNs) / 1000) - HOST_HEARTBEAT_MS * 1000;
+    
+                if (error < 0)
+                    error = -error;
+                if (hostHeartbeatArmed && (uint32_t)error > hostHeartbeatWorst)
+                    hostHeartbeatWorst = (uint32_t)error;
+                hostHeartbeatArmed = 1;
+            }
+            else
+                hostHeartbeatArmed = 0;
+            hostHeartbeats++;
+        }
+        hostHeartbeatNs = endNs;
+    }
+    else if (frame->id == CANOPEN_COB_SDO_TX + HOST_NODE)
+    {
+        if (hostScriptStep >= HOST_SCRIPT_STEPS || hostSdoNs || frame->dlc != 8
+            || memcmp(frame->data, hostScript[hostScriptStep].answer, 8))
+        {
+            printf("  SDO answer unexpected at step %u (%s)\n", hostScriptStep,
+                   hostScriptStep < HOST_SCRIPT_STEPS ? hostScript[hostScriptStep].name : "end");
+            hostSdoErrors++;
+        }
+        hostScriptStep++;
+        hostSdoNs = endNs + HOST_SDO_GAP_NS;
+    }
+    
+} // end static void hostTx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the master and the other nodes.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    if (hostLoad && nowNs >= hostTrafficNs)
+    {
+        mcp2515SimFrame frame = { 0x280 + (uint32_t)(rand() % 0x280), 0, (uint8_t)(rand() % 9), { 0 } };
+        uint64_t frameNs = (uint64_t)(47 + 8 * frame.dlc) * mcp2515SimBitNs();
+    
+        for (uint8_t i = 0; i < frame.dlc; i++)
+            frame.data[i] = (uint8_t)rand();
+        mcp2515SimInject(&frame);
+        hostTrafficNs = nowNs + frameNs * 100 / hostLoad * (50 + rand() % 101) / 100;
+    }
+    
+    if (!hostNmt && nowNs >= HOST_START_NS)
+    {
+        const uint8_t start[2] = { CANOPEN_NMT_START, HOST_NODE };
+    
+        hostInject(CANOPEN_COB_NMT, 2, start);
+        hostNmt = 1;
+    }
+    else if (hostNmt == 1 && nowNs >= hostEndNs - HOST_END_NS)
+    {
+        const uint8_t stop[2] = { CANOPEN_NMT_STOP, 0 };        // To all nodes
+    
+        hostInject(CANOPEN_COB_NMT, 2, stop);
+        hostNmt = 2;
+        hostStopNs = nowNs;
+    }
+    else if (hostNmt == 2 && nowNs >= hostEndNs - HOST_END_NS / 2)
+    {
+        const uint8_t reset[2] = { CANOPEN_NMT_RESET_COMM, HOST_NODE };
+    
+        hostInject(CANOPEN_COB_NMT, 2, reset);
+        hostNmt = 3;
+    }
+    
+    if (hostNmt && nowNs >= hostSyncNs)
+    {
+        hostImage(++hostSeq);
+        hostRpdoDue = hostRpdoSent;
+        hostInject(CANOPEN_COB_SYNC, 0, &hostSeq);
+        hostSyncNs += hostPeriodNs;
+        hostRpdoNs = nowNs + hostPeriodNs / 2;
+    }
+    
+    if (hostRpdoNs && nowNs >= hostRpdoNs)
+    {
+        int16_t setpoint = (int16_t)(++hostRpdoSent * -100);
+        const uint8_t rpdo[CANOPEN_RPDO1_DLC] = { hostRpdoSent, (uint8_t)setpoint, (uint8_t)((uint16_t)setpoint >> 8) };
+    
+        hostInject(CANOPEN_COB_RPDO1 + HOST_NODE, CANOPEN_RPDO1_DLC, rpdo);
+        hostRpdoNs = 0;
+    }
+    
+    if (hostSdoNs && nowNs >= hostSdoNs && hostScriptStep < HOST_SCRIPT_STEPS)
+    {
+        if (hostScript[hostScriptStep].request[0] != HOST_NO_ANSWER)
+            hostInject(CANOPEN_COB_SDO_RX + HOST_NODE, 8, hostScript[hostScriptStep].request);
+        hostSdoNs = 0;
+    }
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    static const uint8_t parameters[EE_CONFIG_PARAMS] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    uint8_t bitrate = CAN_BITRATE_500K;
+    uint32_t seconds = 5;
+    uint32_t budget = 500;
+    uint8_t fail;
+    dataFrame frame;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-b"))
+            hostLoad = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-r"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-p"))
+            hostPeriodNs = (uint64_t)atoi(argv[opt + 1]) * 1000;
+        else if (!strcmp(argv[opt], "-l"))
+            budget = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-s"))
+            seconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || hostLoad > 90 || bitrate >= CAN_BITRATES || hostPeriodNs < 1000000 || seconds < 3)
+    {
+        fprintf(stderr, "use: %s [-b busLoadPercent] [-r 125|250|500] [-p syncPeriodUs] [-l latencyBudgetUs] [-s seconds]\n",
+                argv[0]);
+        return 2;
+    }
+    
+    srand(1);
+    hardware_ini();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(bitrate);
+    mcp2515ConfigEnd();
+    canOpenIni(HOST_NODE);
+    
+    mcp2515SimRxHook = hostRx;
+    mcp2515SimStartHook = hostStart;
+    mcp2515SimTxHook = hostTx;
+    picSimHook = hostStep;
+    hostEndNs = picSimNs() + (uint64_t)seconds * 1000000000;
+    hostSyncNs = picSimNs() + 2 * HOST_START_NS;
+    hostSdoNs = picSimNs() + HOST_SDO_NS;
+    
+    // Main loop of the node, as in main.c (canOpenHandler() is the default of canDispatch()).
+    while (picSimNs() < hostEndNs)
+    {
+        canOpenService();
+        while (canReceive(&frame))
+        {
+            canOpenHandler(&frame);
+        }
+        picSimAdvance(HOST_STEP_NS);
+    }
+    
+    printf("CANopen slave, node %u, %u Kbps, SYNC every %u us, bus load %u%%, %u s\n", HOST_NODE, rates[bitrate],
+           (unsigned)(hostPeriodNs / 1000), hostLoad, seconds);
+    printf("  SYNC taken        %8u     (node: %u, TPDO queued %u, missed %u)\n", hostSyncs, canOpenCount.syncs,
+           canOpenCount.tpdos, canOpenCount.tpdoMissed);
+    printf("  TPDO on the bus   %8u     (content wrong in %u, while stopped %u)\n", hostTpdos, hostTpdoErrors,
+           hostStoppedTpdos);
+    printf("  RPDO applied      %8u     (not in the image at its SYNC %u)\n", canOpenCount.rpdos, hostRpdoErrors);
+    printf("  SYNC to TPDO SOF  %8u us worst, %.1f us mean  (budget %u us)\n", hostSofWorst,
+           hostTpdos ? hostSofSum / hostTpdos : 0, budget);
+    printf("  SYNC to TPDO end  %8u us worst, %.1f us mean\n", hostEndWorst, hostTpdos ? hostEndSum / hostTpdos : 0);
+    printf("  SDO script        %8u/%u steps (%u wrong, %u aborts sent)\n", hostScriptStep, (unsigned)HOST_SCRIPT_STEPS,
+           hostSdoErrors, canOpenCount.sdoAborts);
+    printf("  boot-up, heartbeat %7u, %u  (period error %u us worst, state at the end 0x%02X)\n", hostBootups,
+           hostHeartbeats, hostHeartbeatWorst, canOpenState);
+    printf("  MCP2515 overflows %8u\n", mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1]);
+    
+    fail = hostTpdoErrors || hostRpdoErrors || hostStoppedTpdos || hostSdoErrors || hostScriptStep != HOST_SCRIPT_STEPS
+           || hostBootups != 2 || hostHeartbeatWorst > 2000 || canOpenState != CANOPEN_PRE_OPERATIONAL
+           || memcmp(eeConfig.param, parameters, EE_CONFIG_PARAMS) || hostTpdos + 2 * HOST_END_NS / hostPeriodNs < hostSyncs
+           || hostSofWorst > budget;
+    if (fail)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: every TPDO on the bus %u us after its SYNC at most\n", hostSofWorst);
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,366 @@
+/* File:  canSignalsHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Test and benchmark of the signal code generated from canSignals.dbc by
+ * tools/dbcgen.py. Every signal is written and read back, with random values over random
+ * bytes, and checked against a generic table decoder (bit by bit, DBC numbering, both byte
+ * orders): the value, its sign, the bits of the other signals left alone. The scale/offset
+ * macros go both ways over the raw range, and the <MSG>_Changed() detectors are checked at
+ * their deadbands. Then one decode + encode of both messages is timed, generated code against
+ * the table loop. The exit code is 1 when a check fails.
+ * 
+ * Build and run, from the project folder (after 'python3 tools/dbcgen.py canSignals.dbc canSignals'):
+ *   gcc -O2 -Ihost -o canSignalsHost host/canSignalsHost.c canSignals.c -lm && ./canSignalsHost
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../canSignals.h"
+
+#define HOST_ROUNDS             20000
+#define HOST_BENCH_FRAMES       2000000
+
+// The signals of canSignals.dbc, as the table decoder sees them:
+// message, signal, start bit, length, Motorola (@0), signed, C type, scale, offset, deadband (raw).
+#define HOST_SIGNALS(X) \
+    X(NODE_STATUS,  Counter,        0,  8, 0, 0, uint8_t,  1,    0,    0) \
+    X(NODE_STATUS,  SupplyVoltage,  8, 12, 0, 0, uint16_t, 0.01, 0,    5) \
+    X(NODE_STATUS,  Temperature,   20,  8, 0, 1, int8_t,   1,    0,    0) \
+    X(NODE_STATUS,  Analog0,       39, 10, 1, 0, uint16_t, 1,    0,    4) \
+    X(NODE_STATUS,  Analog1,       45, 10, 1, 0, uint16_t, 1,    0,    4) \
+    X(NODE_STATUS,  Flags,         59,  4, 1, 0, uint8_t,  1,    0,    0) \
+    X(NODE_COMMAND, LedMask,        0,  3, 0, 0, uint8_t,  1,    0,    0) \
+    X(NODE_COMMAND, Setpoint,      15, 16, 1, 1, int16_t,  0.1,  -100, 0)
+
+typedef struct
+{
+    const char *name;
+    uint8_t message;                    // 0: NODE_STATUS, 1: NODE_COMMAND
+    uint8_t start;
+    uint8_t length;
+    uint8_t motorola;
+    uint8_t isSigned;
+    double scale;
+    double offset;
+    int32_t deadband;
+    int32_t (*get)(const uint8_t *data);
+    void (*set)(uint8_t *data, int32_t value);
+    double (*toPhys)(int32_t raw);
+    int32_t (*fromPhys)(double phys);
+}hostSignal;
+
+#define HOST_MESSAGE_NODE_STATUS    0
+#define HOST_MESSAGE_NODE_COMMAND   1
+
+// Generated functions and macros behind one signature per signal.
+#define HOST_ADAPTERS(msg, sig, start, length, motorola, sign, type, scale, offset, deadband) \
+    static int32_t msg##_##sig##HostGet(const uint8_t *data) { return msg##_##sig##Get(data); } \
+    static void msg##_##sig##HostSet(uint8_t *data, int32_t value) { msg##_##sig##Set(data, (type)value); } \
+    static double msg##_##sig##HostToPhys(int32_t raw) { return msg##_##sig##_TO_PHYS(raw); } \
+    static int32_t msg##_##sig##HostFromPhys(double phys) { return msg##_##sig##_FROM_PHYS(phys); }
+HOST_SIGNALS(HOST_ADAPTERS)
+
+#define HOST_ENTRY(msg, sig, start, length, motorola, sign, type, scale, offset, deadband) \
+    { #msg "_" #sig, HOST_MESSAGE_##msg, start, length, motorola, sign, scale, offset, deadband, \
+      msg##_##sig##HostGet, msg##_##sig##HostSet, msg##_##sig##HostToPhys, msg##_##sig##HostFromPhys },
+static const hostSignal hostSignals[] = { HOST_SIGNALS(HOST_ENTRY) };
+
+#define HOST_SIGNAL_COUNT       (sizeof(hostSignals) / sizeof(hostSignals[0]))
+
+static uint32_t hostFailures;
+static volatile int32_t hostSink;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t hostNextBit(const hostSignal *signal, uint8_t bit)
+ * Description: DBC bit after (bit), LSB first for Intel, MSB first for Motorola (sawtooth).
+ *******************************************************************************/
+static uint8_t hostNextBit(const hostSignal *signal, uint8_t bit)
+{
+    if (!signal->motorola)
+        return bit + 1;
+    
+    return (bit & 7) ? bit - 1 : bit + 15;
+    
+} // end static uint8_t hostNextBit(const hostSignal *signal, uint8_t bit) function
+
+
+/*******************************************************************************
+ * FUNCTION: static int32_t hostTableGet(const hostSignal *signal, const uint8_t *data);
+ *           static void hostTableSet(const hostSignal *signal, uint8_t *data, int32_t value)
+ * Description: Generic table decoder and encoder, one bit per step.
+ *******************************************************************************/
+static int32_t hostTableGet(const hostSignal *signal, const uint8_t *data)
+{
+    uint32_t raw = 0;
+    uint8_t bit = signal->start;
+    
+    for (uint8_t i = 0; i < signal->length; i++)
+    {
+        uint32_t value = (data[bit >> 3] >> (bit & 7)) & 1;
+    
+        if (signal->motorola)
+            raw = (raw << 1) | value;
+        else
+            raw |= value << i;
+        bit = hostNextBit(signal, bit);
+    }
+    if (signal->isSigned && (raw & (1ul << (signal->length - 1))))
+        return (int32_t)raw - (int32_t)(1ul << signal->length);
+    
+    return (int32_t)raw;
+    
+} // end static int32_t hostTableGet(const hostSignal *signal, const uint8_t *data) function
+
+static void hostTableSet(const hostSignal *signal, uint8_t *data, int32_t value)
+{
+    uint8_t bit = signal->start;
+    
+    for (uint8_t i = 0; i < signal->length; i++)
+    {
+        uint8_t shift = signal->motorola ? signal->length - 1 - i : i;
+    
+        if (((uint32_t)value >> shift) & 1)
+            data[bit >> 3] |= (uint8_t)(1 << (bit & 7));
+        else
+            data[bit >> 3] &= (uint8_t)~(1 << (bit & 7));
+        bit = hostNextBit(signal, bit);
+    }
+    
+} // end static void hostTableSet(const hostSignal *signal, uint8_t *data, int32_t value) function
+
+
+/*******************************************************************************
+ * FUNCTION: static int32_t hostRandomRaw(const hostSignal *signal)
+ * Description: Random raw value in the range of (signal).
+ *******************************************************************************/
+static int32_t hostRandomRaw(const hostSignal *signal)
+{
+    int32_t raw = (int32_t)((uint32_t)rand() & ((1ul << signal->length) - 1));
+    
+    if (signal->isSigned && (raw & (1l << (signal->length - 1))))
+        raw -= 1l << signal->length;
+    
+    return raw;
+    
+} // end static int32_t hostRandomRaw(const hostSignal *signal) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostCheck(uint8_t ok, const char *what, const char *name, int32_t value)
+ * Description: Counts and prints a failed check (the first ones).
+ *******************************************************************************/
+static void hostCheck(uint8_t ok, const char *what, const char *name, int32_t value)
+{
+    if (ok)
+        return;
+    if (hostFailures++ < 20)
+        printf("  FAIL %s: %s, value %ld\n", name, what, (long)value);
+    
+} // end static void hostCheck(uint8_t ok, const char *what, const char *name, int32_t value) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostRoundTrip(void)
+ * Description: Each signal written by the generated code and by the table encoder over the same
+ * random bytes: the frames must match, both decoders must give the value back.
+ *******************************************************************************/
+static void hostRoundTrip(void)
+{
+    for (uint32_t round = 0; round < HOST_ROUNDS; round++)
+    {
+        for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+        {
+            const hostSignal *signal = &hostSignals[s];
+            int32_t value = hostRandomRaw(signal);
+            uint8_t generated[8];
+            uint8_t table[8];
+    
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                generated[i] = (uint8_t)rand();
+            }
+            memcpy(table, generated, 8);
+            signal->set(generated, value);
+            hostTableSet(signal, table, value);
+    
+            hostCheck(!memcmp(generated, table, 8), "set differs from the table (other bits touched?)", signal->name, value);
+            hostCheck(signal->get(generated) == value, "get of set", signal->name, value);
+            hostCheck(hostTableGet(signal, generated) == value, "table get of set", signal->name, value);
+        }
+    }
+    
+} // end static void hostRoundTrip(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostPhysical(void)
+ * Description: _TO_PHYS is raw * scale + offset; _FROM_PHYS gives the raw value back from it.
+ *******************************************************************************/
+static void hostPhysical(void)
+{
+    for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+    {
+        const hostSignal *signal = &hostSignals[s];
+        int32_t low = signal->isSigned ? -(1l << (signal->length - 1)) : 0;
+        int32_t high = signal->isSigned ? (1l << (signal->length - 1)) - 1 : (1l << signal->length) - 1;
+    
+        for (int32_t raw = low; raw <= high; raw++)
+        {
+            double phys = signal->toPhys(raw);
+    
+            hostCheck(fabs(phys - (raw * signal->scale + signal->offset)) < signal->scale / 1000, "TO_PHYS",
+                      signal->name, raw);
+            hostCheck(signal->fromPhys(phys) == raw, "FROM_PHYS of TO_PHYS", signal->name, raw);
+        }
+    }
+    
+} // end static void hostPhysical(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostDeadband(void)
+ * Description: <MSG>_Changed(): a signal with a deadband is reported once it moves more than the
+ * deadband, the others on any change; bits outside the signals are never reported.
+ *******************************************************************************/
+static void hostDeadband(void)
+{
+    static uint8_t (* const changed[2])(const uint8_t *sent, const uint8_t *data) =
+    {
+        NODE_STATUS_Changed, NODE_COMMAND_Changed,
+    };
+    
+    for (uint32_t round = 0; round < HOST_ROUNDS / 10; round++)
+    {
+        for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+        {
+            const hostSignal *signal = &hostSignals[s];
+            uint8_t (*detector)(const uint8_t *, const uint8_t *) = changed[signal->message];
+            int32_t step = signal->deadband ? signal->deadband : 1;
+            int32_t value = hostRandomRaw(signal);
+            int32_t high = signal->isSigned ? (1l << (signal->length - 1)) - 1 : (1l << signal->length) - 1;
+            uint8_t sent[8];
+            uint8_t data[8];
+    
+            if (value > high - step - 1)
+                value = high - step - 1;
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                sent[i] = (uint8_t)rand();
+            }
+            signal->set(sent, value);
+            memcpy(data, sent, 8);
+            hostCheck(!detector(sent, data), "change reported without a change", signal->name, value);
+    
+            signal->set(data, value + step);
+            hostCheck(detector(sent, data) == !signal->deadband, "change at the deadband", signal->name, value);
+            signal->set(data, value + step + 1);
+            hostCheck(detector(sent, data), "change over the deadband missed", signal->name, value);
+        }
+    
+        // Bits outside every signal of the message.
+        for (uint8_t message = 0; message < 2; message++)
+        {
+            uint8_t sent[8];
+            uint8_t data[8];
+    
+            for (uint8_t i = 0; i < 8; i++)
+            {
+                sent[i] = (uint8_t)rand();
+                data[i] = (uint8_t)rand();
+            }
+            for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+            {
+                if (hostSignals[s].message == message)
+                    hostSignals[s].set(data, hostSignals[s].get(sent));
+            }
+            hostCheck(!changed[message](sent, data), "change reported for unused bits", message ? "NODE_COMMAND"
+                      : "NODE_STATUS", 0);
+        }
+    }
+    
+} // end static void hostDeadband(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static double hostBench(uint8_t generated)
+ * Description: ns for one decode and one encode of every signal of both messages.
+ *******************************************************************************/
+static double hostBench(uint8_t generated)
+{
+    static uint8_t frames[2][8] = { {1, 2, 3, 4, 5, 6, 7, 8}, {9, 10, 11, 12, 13, 14, 15, 16} };
+    struct timespec start;
+    struct timespec end;
+    int32_t sum = 0;
+    
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t frame = 0; frame < HOST_BENCH_FRAMES; frame++)
+    {
+        if (generated)
+        {
+            sum += NODE_STATUS_CounterGet(frames[0]) + NODE_STATUS_SupplyVoltageGet(frames[0])
+                   + NODE_STATUS_TemperatureGet(frames[0]) + NODE_STATUS_Analog0Get(frames[0])
+                   + NODE_STATUS_Analog1Get(frames[0]) + NODE_STATUS_FlagsGet(frames[0])
+                   + NODE_COMMAND_LedMaskGet(frames[1]) + NODE_COMMAND_SetpointGet(frames[1]);
+            NODE_STATUS_CounterSet(frames[0], (uint8_t)frame);
+            NODE_STATUS_SupplyVoltageSet(frames[0], (uint16_t)frame);
+            NODE_STATUS_TemperatureSet(frames[0], (int8_t)frame);
+            NODE_STATUS_Analog0Set(frames[0], (uint16_t)frame);
+            NODE_STATUS_Analog1Set(frames[0], (uint16_t)frame);
+            NODE_STATUS_FlagsSet(frames[0], (uint8_t)frame);
+            NODE_COMMAND_LedMaskSet(frames[1], (uint8_t)frame);
+            NODE_COMMAND_SetpointSet(frames[1], (int16_t)frame);
+        }
+        else
+        {
+            for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+            {
+                sum += hostTableGet(&hostSignals[s], frames[hostSignals[s].message]);
+            }
+            for (uint8_t s = 0; s < HOST_SIGNAL_COUNT; s++)
+            {
+                hostTableSet(&hostSignals[s], frames[hostSignals[s].message], (int32_t)frame);
+            }
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    hostSink = sum;
+    
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / HOST_BENCH_FRAMES;
+    
+} // end static double hostBench(uint8_t generated) function
+
+
+int main(void)
+{
+    double generatedNs;
+    double tableNs;
+    
+    srand(1);
+    hostRoundTrip();
+    hostPhysical();
+    hostDeadband();
+    printf("%u signals: round trip, scale/offset and deadband checks, %u failed\n", (unsigned)HOST_SIGNAL_COUNT,
+           hostFailures);
+    
+    generatedNs = hostBench(1);
+    tableNs = hostBench(0);
+    printf("decode + encode of both messages: generated %.1f ns, table loop %.1f ns (%.1fx)\n", generatedNs,
+           tableNs, tableNs / generatedNs);
+    
+    printf(hostFailures ? "FAIL\n" : "OK: generated code matches the table decoder\n");
+    
+    return hostFailures ? 1 : 0;
+    
+} // end int main(void) function
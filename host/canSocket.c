@@ -0,0 +1,1015 @@
+/* File:  canSocket.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: SocketCAN backend of the driver API (see canSocket.h). The MCP2515 becomes a raw
+ * CAN socket:
+ *   registers: a RAM image, written and read by the register functions, so the configuration
+ *       code runs as is. A mode change completes at once. Leaving configuration mode turns the
+ *       masks and filters of RXB0/RXB1 into kernel filters (CAN_RAW_FILTER): the node only wakes
+ *       up for its frames;
+ *   transmit buffers: a frame requested (RTS) in normal mode joins the transmit batch and its
+ *       buffer is free again, as if it had gone out on the bus. The batch goes out in one
+ *       sendmmsg() when it holds canSocketBatch frames, when its oldest frame waited
+ *       CAN_SOCKET_LINGER_US, or at canSocketFlush(); a same identifier keeps its order. In
+ *       listen-only, configuration and sleep mode the request waits in its buffer (TXREQ set), in
+ *       loopback mode the frame comes back to the node's own receive queue;
+ *   receive buffers: canService() empties the socket into the receive queue of the firmware
+ *       (canQueue.c) with recvmmsg(), as many frames as the queue has room for, without
+ *       blocking. Each frame carries the kernel receive time (SO_TIMESTAMPNS), returned by
+ *       canSocketReceive(). Frames the socket buffer dropped meanwhile are counted (SO_RXQ_OVFL).
+ *       The receive path hooks of can.c (BUS_LOAD, CAN_WATCH, CANOPEN) and the remote frame
+ *       answers (canQueue.c) run as in the firmware.
+ * There is no interrupt: the receive functions call canService() whenever the queue runs empty.
+ * TIME_SYNC is not supported (it stamps the SOF pin) and canAutobaud() returns the bit rate set:
+ * a virtual bus has none. Extended frames are received with the 11 high bits of the identifier,
+ * like the MCP2515 gives them to this driver.
+ * 
+ * Environment: gcc (host, Linux), see host/canSocketHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#define _GNU_SOURCE
+#include <xc.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include "canSocket.h"
+#include "../canQueue.h"
+#include "../busLoad.h"
+#include "../canOpen.h"
+#include "../canWatch.h"
+
+#ifndef CAN_SOCKET_LINGER_US
+    #define CAN_SOCKET_LINGER_US    100     // Longest wait of a frame in the transmit batch
+#endif
+
+#if !CAN_RX_STAMP
+    #error "build canQueue.c and canSocket.c with -DCAN_RX_STAMP=1 (receive times, see canQueue.h)"
+#endif
+
+#define CAN_SOCKET_REGS         0x80
+#define CAN_SOCKET_CONTROL      CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))
+
+canSocketStats canSocketCount;
+uint8_t canSocketBatch = CAN_SOCKET_BATCH;
+
+uint8_t mcp2515OpMode = OPMODE_CONFIG;
+volatile uint8_t canIntEnabled;                 // Stays 0: the receive functions read the socket
+
+static int canSocketFd = -1;
+static uint8_t canSocketReg[CAN_SOCKET_REGS];
+
+static struct can_frame canTxBuffer[3];         // TXB0-TXB2
+static uint8_t canTxRequest;                    // STAT_TXnREQ bits: waiting for normal mode
+static struct can_frame canTxBatch[CAN_SOCKET_BATCH];
+static uint8_t canTxBatchCount;
+static struct timespec canTxBatchSince;         // Oldest frame of the batch
+
+static uint8_t mcp2515SavedMode;
+static uint16_t mcp2515OfflineStart;
+static uint16_t mcp2515OfflineUs;
+
+// Registers written by mcp2515StartWith(), as mcp2515InitTable of can.c: filters and masks
+// cleared, 125 Kbps, every receive buffer taking any frame.
+static const uint8_t mcp2515BitTiming[CAN_BITRATES][3] =
+{
+    { 0xC5, 0xF1, 0x01 },   // 125 Kbps
+    { 0xC5, 0xF1, 0x00 },   // 250 Kbps
+    { 0xC1, 0x91, 0x00 },   // 500 Kbps
+};
+
+// Registers held by an mcp2515Setup, in the order of the structure: address, number of registers.
+static const uint8_t mcp2515SetupMap[][2] =
+{
+    { RXF0SIDH, 12 },
+    { RXF3SIDH, 12 },
+    { RXM0SIDH, 8 },
+    { CNF3, 3 },
+    { RXB0CTRL, 1 },
+    { RXB1CTRL, 1 },
+};
+
+
+/*******************************************************************************
+ * FUNCTION: static uint64_t canSocketNs(clockid_t clock)
+ * Description: Time of (clock) in nanoseconds.
+ *******************************************************************************/
+static uint64_t canSocketNs(clockid_t clock)
+{
+    struct timespec now;
+    
+    clock_gettime(clock, &now);
+    
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    
+} // end static uint64_t canSocketNs(clockid_t clock) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canSocketFilter(void)
+ * Description: Kernel filters from the receive buffer registers: masks and filters of RXB0 (RXF0,
+ * RXF1, RXM0) and RXB1 (RXF2-RXF5, RXM1); none when a buffer takes any frame (RXM_RCV_ALL). A
+ * filter matches standard or extended frames after its EXIDE bit, data and remote frames alike.
+ * When the RXM modes skip every filter, the socket receives nothing, as the buffers would.
+ *******************************************************************************/
+static void canSocketFilter(void)
+{
+    struct can_filter filters[6];
+    uint8_t count = 0;
+    uint8_t any = 0;
+    
+    if (canSocketFd < 0)
+        return;
+    
+    for (uint8_t filter = 0; filter < 6; filter++)
+    {
+        uint8_t rxb = (filter < 2) ? 0 : 1;
+        uint8_t rxm = canSocketReg[RXBnCTRL(rxb)] & RXM;
+        const uint8_t *f = &canSocketReg[RXFn_BASE(filter)];
+        const uint8_t *m = &canSocketReg[RXMn_BASE(rxb)];
+        uint8_t extended = (f[1] & EXIDE_SET) != 0;
+    
+        if (rxm == RXM_RCV_ALL)
+        {
+            any = 1;
+            break;
+        }
+        if ((rxm == RXM_VALID_STD && extended) || (rxm == RXM_VALID_EXT && !extended))
+            continue;
+    
+        if (extended)
+        {
+            filters[count].can_id = CAN_EFF_FLAG | ((uint32_t)f[0] << 21) | ((uint32_t)(f[1] & 0xE0) << 13)
+                                    | ((uint32_t)(f[1] & 0x03) << 16) | ((uint32_t)f[2] << 8) | f[3];
+            filters[count].can_mask = CAN_EFF_FLAG | ((uint32_t)m[0] << 21) | ((uint32_t)(m[1] & 0xE0) << 13)
+                                      | ((uint32_t)(m[1] & 0x03) << 16) | ((uint32_t)m[2] << 8) | m[3];
+        }
+        else
+        {
+            filters[count].can_id = ((uint32_t)f[0] << 3) | (f[1] >> 5);
+            filters[count].can_mask = CAN_EFF_FLAG | ((uint32_t)m[0] << 3) | (m[1] >> 5);
+        }
+        count++;
+    }
+    
+    if (any)
+    {
+        struct can_filter all = { 0, 0 };
+    
+        setsockopt(canSocketFd, SOL_CAN_RAW, CAN_RAW_FILTER, &all, sizeof(all));
+    }
+    else
+        setsockopt(canSocketFd, SOL_CAN_RAW, CAN_RAW_FILTER, count ? filters : 0, count * sizeof(filters[0]));
+    
+} // end static void canSocketFilter(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canSocketStore(const struct can_frame *frame, uint64_t stampNs)
+ * Description: Receive path of one frame: the hooks of can.c, the remote frame answers, then the
+ * receive queue (canQueue.c) with the kernel receive time (stampNs).
+ *******************************************************************************/
+static void canSocketStore(const struct can_frame *frame, uint64_t stampNs)
+{
+    dataFrame received;
+    dataFrame *message = &received;
+    const canRtrEntry *answer;
+    uint8_t index;
+    uint8_t lenght = (frame->can_dlc > 8) ? 8 : frame->can_dlc;
+    uint8_t rtr = (frame->can_id & CAN_RTR_FLAG) != 0;
+    uint8_t header[5];                          // RXBnSIDH, SIDL, EID8, EID0, DLC
+    
+    if (frame->can_id & CAN_ERR_FLAG)
+        return;
+    
+    if (frame->can_id & CAN_EFF_FLAG)
+    {
+        uint32_t id = frame->can_id & CAN_EFF_MASK;
+    
+        header[0] = (uint8_t)(id >> 21);
+        header[1] = (uint8_t)(((id >> 13) & 0xE0) | EXIDE_SET | ((id >> 16) & 0x03));
+        header[2] = (uint8_t)(id >> 8);
+        header[3] = (uint8_t)id;
+        header[4] = lenght | (rtr ? DLC_RTR : 0);
+    }
+    else
+    {
+        uint16_t id = frame->can_id & CAN_SFF_MASK;
+    
+        header[0] = (uint8_t)(id >> 3);
+        header[1] = (uint8_t)((id << 5) | (rtr ? SIDL_SRR : 0));
+        header[2] = 0;
+        header[3] = 0;
+        header[4] = lenght;
+    }
+    
+    message->idh = header[0];
+    message->idl = header[1] & 0xE0;
+    message->dlc = lenght | (rtr ? CAN_RTR : 0);
+    for (uint8_t i = 0; i < lenght; i++)
+    {
+        message->data[i] = frame->data[i];
+    }
+    
+#if BUS_LOAD
+    busLoadFrame(header, frame->data);
+#endif
+#if CAN_WATCH
+    canWatchReceive(message);
+#endif
+#if CANOPEN
+    if (canOpenReceive(message))
+        return;
+#endif
+    
+    if (rtr && canRtrCount && ((answer = canRtrFind(message)) != 0))
+    {
+        if (!(canTxRequest & STAT_TXnREQ(CAN_RTR_TXB)))
+        {
+            mcp2515TxLoadId(CAN_RTR_TXB, message->idh, message->idl, answer->dlc, answer->data);
+            canRtrAnswered++;
+            return;
+        }
+        canRtrMissed++;
+    }
+    
+    index = canRxStore(message);
+    if (index != CAN_RX_NONE)
+        canRxStamp[index] = stampNs;
+    
+} // end static void canSocketStore(const struct can_frame *frame, uint64_t stampNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canSocketFlush(void)
+ * Description: Sends the transmit batch with sendmmsg(). A full interface queue (ENOBUFS) is
+ * waited for and the rest sent again; any other error drops the batch.
+ *******************************************************************************/
+void canSocketFlush(void)
+{
+    struct mmsghdr messages[CAN_SOCKET_BATCH];
+    struct iovec vectors[CAN_SOCKET_BATCH];
+    uint8_t sent = 0;
+    
+    if (!canTxBatchCount || (canSocketFd < 0))
+    {
+        canTxBatchCount = 0;
+        return;
+    }
+    
+    memset(messages, 0, sizeof(messages));
+    for (uint8_t i = 0; i < canTxBatchCount; i++)
+    {
+        vectors[i].iov_base = &canTxBatch[i];
+        vectors[i].iov_len = sizeof(struct can_frame);
+        messages[i].msg_hdr.msg_iov = &vectors[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+    
+    while (sent < canTxBatchCount)
+    {
+        int result = sendmmsg(canSocketFd, &messages[sent], canTxBatchCount - sent, 0);
+    
+        if (result > 0)
+        {
+            canSocketCount.txCalls++;
+            canSocketCount.txFrames += result;
+            sent += result;
+        }
+        else if ((errno == ENOBUFS) || (errno == EAGAIN) || (errno == EINTR))
+        {
+            struct pollfd wait = { canSocketFd, POLLOUT, 0 };
+    
+            canSocketCount.txRetries++;
+            poll(&wait, 1, 1);
+        }
+        else
+        {
+            perror("canSocketFlush: sendmmsg");
+            break;
+        }
+    }
+    canTxBatchCount = 0;
+    
+} // end void canSocketFlush(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canSocketLinger(void)
+ * Description: Sends the transmit batch once its oldest frame waited CAN_SOCKET_LINGER_US.
+ *******************************************************************************/
+static void canSocketLinger(void)
+{
+    struct timespec now;
+    
+    if (!canTxBatchCount)
+        return;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec - canTxBatchSince.tv_sec) * 1000000000L + (now.tv_nsec - canTxBatchSince.tv_nsec)
+        >= CAN_SOCKET_LINGER_US * 1000L)
+        canSocketFlush();
+    
+} // end static void canSocketLinger(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canSocketTransmit(uint8_t txb)
+ * Description: Transmit request of buffer (txb): the frame goes to the batch (normal mode), back
+ * to the receive queue (loopback mode) or waits in the buffer (the other modes).
+ *******************************************************************************/
+static void canSocketTransmit(uint8_t txb)
+{
+    if (mcp2515OpMode == OPMODE_LOOPBACK)
+    {
+        canTxRequest &= ~STAT_TXnREQ(txb);
+        canSocketStore(&canTxBuffer[txb], canSocketNs(CLOCK_REALTIME));
+        return;
+    }
+    if (mcp2515OpMode != OPMODE_NORMAL)
+    {
+        canTxRequest |= STAT_TXnREQ(txb);
+        return;
+    }
+    
+    canTxRequest &= ~STAT_TXnREQ(txb);
+    if (!canTxBatchCount)
+        clock_gettime(CLOCK_MONOTONIC, &canTxBatchSince);
+    canTxBatch[canTxBatchCount++] = canTxBuffer[txb];
+    if (canTxBatchCount >= canSocketBatch)
+        canSocketFlush();
+    
+} // end static void canSocketTransmit(uint8_t txb) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void canSocketMode(uint8_t opmode)
+ * Description: Operation mode (opmode, OPMODE_xxx) requested through CANCTRL: CANSTAT follows at
+ * once. The kernel filters are set when configuration mode is left, and the requests waiting in
+ * the transmit buffers go out in normal and loopback mode.
+ *******************************************************************************/
+static void canSocketMode(uint8_t opmode)
+{
+    uint8_t previous = canSocketReg[CANSTAT] & REQOP;
+    
+    canSocketReg[CANSTAT] = (canSocketReg[CANSTAT] & ~REQOP) | opmode;
+    mcp2515OpMode = opmode;
+    if (previous == OPMODE_CONFIG && opmode != OPMODE_CONFIG)
+        canSocketFilter();
+    if (opmode == OPMODE_NORMAL || opmode == OPMODE_LOOPBACK)
+    {
+        for (uint8_t txb = 0; txb < 3; txb++)
+        {
+            if (canTxRequest & STAT_TXnREQ(txb))
+                canSocketTransmit(txb);
+        }
+    }
+    
+} // end static void canSocketMode(uint8_t opmode) function
+
+
+/*******************************************************************************
+ * FUNCTION: int canSocketOpen(const char *interface)
+ * Description: Opens a raw CAN socket on (interface), vcan0 for instance, with kernel receive
+ * times and drop counts. The controller is left in configuration mode, as after a reset: call
+ * mcp2515Start() or mcp2515StartWith() next.
+ * Returns 0, or -1 with errno set.
+ *******************************************************************************/
+int canSocketOpen(const char *interface)
+{
+    struct sockaddr_can address;
+    int on = 1;
+    
+    canSocketClose();
+    canSocketFd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (canSocketFd < 0)
+        return -1;
+    
+    memset(&address, 0, sizeof(address));
+    address.can_family = AF_CAN;
+    address.can_ifindex = (int)if_nametoindex(interface);
+    if (!address.can_ifindex || (bind(canSocketFd, (struct sockaddr *)&address, sizeof(address)) < 0)
+        || (setsockopt(canSocketFd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+        || (setsockopt(canSocketFd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0))
+    {
+        int error = address.can_ifindex ? errno : ENODEV;
+    
+        canSocketClose();
+        errno = error;
+        return -1;
+    }
+    
+    memset(&canSocketCount, 0, sizeof(canSocketCount));
+    memset(canSocketReg, 0, sizeof(canSocketReg));
+    canSocketReg[CANSTAT] = OPMODE_CONFIG;
+    canSocketReg[CANCTRL] = REQOP_CONFIG;
+    mcp2515OpMode = OPMODE_CONFIG;
+    canTxRequest = 0;
+    canTxBatchCount = 0;
+    canRxClear();
+    if (!canSocketBatch || (canSocketBatch > CAN_SOCKET_BATCH))
+        canSocketBatch = CAN_SOCKET_BATCH;
+    
+    return 0;
+    
+} // end int canSocketOpen(const char *interface) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canSocketClose(void)
+ * Description: Sends the transmit batch and closes the socket.
+ *******************************************************************************/
+void canSocketClose(void)
+{
+    if (canSocketFd < 0)
+        return;
+    
+    canSocketFlush();
+    close(canSocketFd);
+    canSocketFd = -1;
+    
+} // end void canSocketClose(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canSocketReceive(dataFrame *frame, uint64_t *stampNs)
+ * Description: canReceive() with the kernel receive time of the frame (CLOCK_REALTIME, ns) in
+ * (stampNs), when not 0. Returns 0 when the queue is empty.
+ *******************************************************************************/
+uint8_t canSocketReceive(dataFrame *frame, uint64_t *stampNs)
+{
+    uint8_t index;
+    
+    if (!canRxWaiting())
+        canService();
+    index = canRxFetch(frame);
+    if (index == CAN_RX_NONE)
+        return 0;
+    
+    if (stampNs)
+        *stampNs = canRxStamp[index];
+    
+    return 1;
+    
+} // end uint8_t canSocketReceive(dataFrame *frame, uint64_t *stampNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515Start(void)
+ * Description: mcp2515StartWith() with the defaults.
+ *******************************************************************************/
+uint8_t mcp2515Start(void)
+{
+    return mcp2515StartWith(0);
+    
+} // end uint8_t mcp2515Start(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515StartWith(const mcp2515Setup *setup)
+ * Description: The registers of mcp2515InitTable (can.c), those of (setup) in their place when
+ * given, then normal mode.
+ *******************************************************************************/
+uint8_t mcp2515StartWith(const mcp2515Setup *setup)
+{
+    const uint8_t *source = (const uint8_t *)setup;
+    
+    canSocketMode(OPMODE_CONFIG);
+    memset(canSocketReg, 0, CANSTAT);
+    memset(&canSocketReg[RXF3SIDH], 0, 12);
+    memset(&canSocketReg[RXM0SIDH], 0, 8);
+    mcp2515WriteBurst(CNF3, mcp2515BitTiming[CAN_BITRATE_125K], 3);
+    canSocketReg[RXB0CTRL] = RXM_RCV_ALL;
+    canSocketReg[RXB1CTRL] = RXM_RCV_ALL;
+    
+    for (uint8_t i = 0; setup && (i < sizeof(mcp2515SetupMap) / sizeof(mcp2515SetupMap[0])); i++)
+    {
+        for (uint8_t j = 0; j < mcp2515SetupMap[i][1]; j++)
+            canSocketReg[mcp2515SetupMap[i][0] + j] = *source++;
+    }
+    
+    mcp2515WriteRegister(CANCTRL, (REQOP_NORMAL | CLKOUT_ENABLED));
+    
+    return mcp2515WaitMode(OPMODE_NORMAL);
+    
+} // end uint8_t mcp2515StartWith(const mcp2515Setup *setup) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515SetupRead(mcp2515Setup *setup)
+ * Description: Copies the bit timing, filters, masks and receive modes in use to (setup).
+ *******************************************************************************/
+void mcp2515SetupRead(mcp2515Setup *setup)
+{
+    uint8_t *target = (uint8_t *)setup;
+    
+    for (uint8_t i = 0; i < sizeof(mcp2515SetupMap) / sizeof(mcp2515SetupMap[0]); i++)
+    {
+        for (uint8_t j = 0; j < mcp2515SetupMap[i][1]; j++)
+            *target++ = canSocketReg[mcp2515SetupMap[i][0] + j];
+    }
+    
+} // end void mcp2515SetupRead(mcp2515Setup *setup) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515WriteRegister(uint8_t address, uint8_t value); uint8_t mcp2515ReadRegister(uint8_t address);
+ *           void mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew)
+ * Description: The register image; a write of CANCTRL requests the operation mode.
+ *******************************************************************************/
+void mcp2515WriteRegister(uint8_t address, uint8_t value)
+{
+    if (address >= CAN_SOCKET_REGS)
+        return;
+    
+    canSocketReg[address] = value;
+    if (address == CANCTRL)
+        canSocketMode(value & REQOP);
+    
+} // end void mcp2515WriteRegister(uint8_t address, uint8_t value) function
+
+
+uint8_t mcp2515ReadRegister(uint8_t address)
+{
+    return (address < CAN_SOCKET_REGS) ? canSocketReg[address] : 0;
+    
+} // end uint8_t mcp2515ReadRegister(uint8_t address) function
+
+
+void mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew)
+{
+    mcp2515WriteRegister(addressReg, (mcp2515ReadRegister(addressReg) & ~maskBit) | (valueNew & maskBit));
+    
+} // end void mcp2515BitChange(uint8_t addressReg, uint8_t maskBit, uint8_t valueNew) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515WriteBurst(...); void mcp2515ReadBurst(...); uint8_t mcp2515VerifyBurst(...);
+ *           void mcp2515ShadowSync(void); uint8_t mcp2515ShadowVerify(void)
+ * Description: Register by register on the image, which is its own shadow copy.
+ *******************************************************************************/
+void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        mcp2515WriteRegister(address + i, values[i]);
+    }
+    
+} // end void mcp2515WriteBurst(uint8_t address, const uint8_t *values, uint8_t count) function
+
+
+void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        values[i] = mcp2515ReadRegister(address + i);
+    }
+    
+} // end void mcp2515ReadBurst(uint8_t address, uint8_t *values, uint8_t count) function
+
+
+uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (mcp2515ReadRegister(address + i) != values[i])
+            return MCP2515_ERR_VERIFY;
+    }
+    
+    return MCP2515_OK;
+    
+} // end uint8_t mcp2515VerifyBurst(uint8_t address, const uint8_t *values, uint8_t count) function
+
+
+void mcp2515ShadowSync(void)
+{
+} // end void mcp2515ShadowSync(void) function
+
+
+uint8_t mcp2515ShadowVerify(void)
+{
+    return 0;
+    
+} // end uint8_t mcp2515ShadowVerify(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515WaitMode(uint8_t opmode); uint8_t mcp2515SetMode(uint8_t opmode); mcp2515ConfigBegin(),
+ *           mcp2515ConfigEnd(), mcp2515OfflineTime(), mcp2515SetBitrate(), mcp2515SetFilter(),
+ *           mcp2515SetMask(), mcp2515SetRxMode()
+ * Description: As in can.c; a mode change never times out.
+ *******************************************************************************/
+uint8_t mcp2515WaitMode(uint8_t opmode)
+{
+    if ((canSocketReg[CANSTAT] & REQOP) != opmode)
+        return MCP2515_ERR_MODE;
+    
+    mcp2515OpMode = opmode;
+    return MCP2515_OK;
+    
+} // end uint8_t mcp2515WaitMode(uint8_t opmode) function
+
+
+uint8_t mcp2515SetMode(uint8_t opmode)
+{
+    mcp2515BitChange(CANCTRL, REQOP, opmode);
+    
+    return mcp2515WaitMode(opmode);
+    
+} // end uint8_t mcp2515SetMode(uint8_t opmode) function
+
+
+uint8_t mcp2515ConfigBegin(void)
+{
+    mcp2515SavedMode = mcp2515OpMode;
+    mcp2515OfflineStart = timerMicros();
+    
+    return mcp2515SetMode(OPMODE_CONFIG);
+    
+} // end uint8_t mcp2515ConfigBegin(void) function
+
+
+uint8_t mcp2515ConfigEnd(void)
+{
+    uint8_t result = mcp2515SetMode(mcp2515SavedMode);
+    
+    mcp2515OfflineUs = timerMicros() - mcp2515OfflineStart;
+    
+    return result;
+    
+} // end uint8_t mcp2515ConfigEnd(void) function
+
+
+uint16_t mcp2515OfflineTime(void)
+{
+    return mcp2515OfflineUs;
+    
+} // end uint16_t mcp2515OfflineTime(void) function
+
+
+void mcp2515SetBitrate(uint8_t bitrate)
+{
+    if (bitrate < CAN_BITRATES)
+        mcp2515WriteBurst(CNF3, mcp2515BitTiming[bitrate], 3);
+    
+} // end void mcp2515SetBitrate(uint8_t bitrate) function
+
+
+void mcp2515SetFilter(uint8_t filter, uint8_t id)
+{
+    uint8_t value[2] = { id, 0x00 };
+    
+    if (filter < 6)
+        mcp2515WriteBurst(RXFn_BASE(filter), value, 2);
+    
+} // end void mcp2515SetFilter(uint8_t filter, uint8_t id) function
+
+
+void mcp2515SetMask(uint8_t mask, uint8_t id)
+{
+    uint8_t value[2] = { id, 0x00 };
+    
+    if (mask < 2)
+        mcp2515WriteBurst(RXMn_BASE(mask), value, 2);
+    
+} // end void mcp2515SetMask(uint8_t mask, uint8_t id) function
+
+
+void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm)
+{
+    if (rxb < 2)
+        mcp2515BitChange(RXBnCTRL(rxb), RXM, rxm);
+    
+} // end void mcp2515SetRxMode(uint8_t rxb, uint8_t rxm) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canAutobaud(void)
+ * Description: A virtual bus has no bit rate: returns the one set in CNF1-CNF3, or
+ * CAN_BITRATE_NONE when it is none of CAN_BITRATE_xxx.
+ *******************************************************************************/
+uint8_t canAutobaud(void)
+{
+    for (uint8_t bitrate = 0; bitrate < CAN_BITRATES; bitrate++)
+    {
+        if (mcp2515VerifyBurst(CNF3, mcp2515BitTiming[bitrate], 3) == MCP2515_OK)
+            return bitrate;
+    }
+    
+    return CAN_BITRATE_NONE;
+    
+} // end uint8_t canAutobaud(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515ReadStatus(void)
+ * Description: TXREQ of the buffers still holding a request and RX0IF while the receive queue holds a
+ * frame. Sends the transmit batch when due.
+ *******************************************************************************/
+uint8_t mcp2515ReadStatus(void)
+{
+    canSocketLinger();
+    
+    return canTxRequest | (canRxWaiting() ? STAT_RX0IF : 0);
+    
+} // end uint8_t mcp2515ReadStatus(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515RequestToSend(uint8_t txb)
+ * Description: Transmit request of buffer (txb, 0..2) (canSocketTransmit()).
+ *******************************************************************************/
+void mcp2515RequestToSend(uint8_t txb)
+{
+    if (txb < 3)
+        canSocketTransmit(txb);
+    
+} // end void mcp2515RequestToSend(uint8_t txb) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515RxPending(void)
+ * Description: STAT_RX0IF while a frame waits in the receive queue, the socket read first when empty.
+ *******************************************************************************/
+uint8_t mcp2515RxPending(void)
+{
+    if (!canRxWaiting())
+        canService();
+    
+    return canRxWaiting() ? STAT_RX0IF : 0;
+    
+} // end uint8_t mcp2515RxPending(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data);
+ *           void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+ * Description: Loads a standard frame in buffer (txb, 0..2) and requests its transmission, as in can.c.
+ *******************************************************************************/
+void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data)
+{
+    mcp2515TxLoadId(txb, id, 0x00, dlc, data);
+    
+} // end void mcp2515TxLoad(uint8_t txb, uint8_t id, uint8_t dlc, uint8_t *data) function
+
+
+void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data)
+{
+    struct can_frame *frame;
+    uint8_t lenght = dlc & CAN_DLC_MASK;
+    
+    if (txb > 2)
+        return;
+    if (lenght > DLC_8)
+        lenght = DLC_8;
+    
+    frame = &canTxBuffer[txb];
+    memset(frame, 0, sizeof(*frame));
+    frame->can_id = ((uint32_t)idh << 3) | (idl >> 5);
+    frame->can_dlc = lenght;
+    if (dlc & CAN_RTR)
+        frame->can_id |= CAN_RTR_FLAG;
+    else
+    {
+        for (uint8_t i = 0; i < lenght; i++)
+        {
+            frame->data[i] = data[i];
+        }
+    }
+    
+    mcp2515RequestToSend(txb);
+    
+} // end void mcp2515TxLoadId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t dlc, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515RxUnload(uint8_t rxb, dataFrame *frame)
+ * Description: The oldest frame of the receive queue: there are no receive buffers apart from it.
+ *******************************************************************************/
+void mcp2515RxUnload(uint8_t rxb, dataFrame *frame)
+{
+    (void)rxb;
+    canSocketReceive(frame, 0);
+    
+} // end void mcp2515RxUnload(uint8_t rxb, dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515MessageSend(dataFrame *data); void mcp2515MessageRead(uint8_t id, dataFrame *data);
+ *           canSend(), canSendRemote(), canRead()
+ * Description: As in can.c.
+ *******************************************************************************/
+void mcp2515MessageSend(dataFrame *data)
+{
+    uint8_t txb = 0xFF;
+    
+    while (txb == 0xFF)
+    {
+        uint8_t status = mcp2515ReadStatus();
+    
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if (!(status & STAT_TXnREQ(i)) && !((i == CAN_RTR_TXB) && canRtrCount))
+            {
+                txb = i;
+                break;
+            }
+        }
+    }
+    
+    mcp2515TxLoadId(txb, data->idh, data->idl, data->dlc, data->data);
+    
+} // end void mcp2515MessageSend(dataFrame *data) function
+
+
+void mcp2515MessageRead(uint8_t id, dataFrame *data)
+{
+    if (!canRxTake(id, data))
+        data->idh = 0xFF;
+    
+} // end void mcp2515MessageRead(uint8_t id, dataFrame *data) function
+
+
+void canSend(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data)
+{
+    if (txb > 2)
+        txb = 0;
+    
+    mcp2515TxLoad(txb, id, lenght, data);
+    
+} // end void canSend(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data) function
+
+
+void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght)
+{
+    if (txb > 2)
+        txb = 0;
+    
+    mcp2515TxLoad(txb, id, (CAN_RTR | lenght), 0);
+    
+} // end void canSendRemote(uint8_t txb, uint8_t id, uint8_t lenght) function
+
+
+void canRead(uint8_t id, uint8_t *data)
+{
+    dataFrame frame;
+    
+    while (canRxTake(id, &frame))
+    {
+        if (frame.dlc & CAN_RTR)
+            continue;
+        for (uint8_t i = 0; i < (frame.dlc & CAN_DLC_MASK); i++)
+        {
+            data[i] = frame.data[i];
+        }
+        break;
+    }
+    
+} // end void canRead(uint8_t id, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+ * Description: mcp2515TxLoadId(), which does not wait either. Returns MCP2515_ERR_BUSY while
+ * (txb) still holds a request (not in normal mode).
+ *******************************************************************************/
+uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+{
+    if (txb > 2)
+        txb = 0;
+    if (canTxRequest & STAT_TXnREQ(txb))
+        return MCP2515_ERR_BUSY;
+    
+    mcp2515TxLoadId(txb, idh, idl, lenght, data);
+    
+    return MCP2515_OK;
+    
+} // end uint8_t canSendAsyncId(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t canSendAsync(...); uint8_t canAnswerAsync(...)
+ * Description: canSendAsyncId(): a request is never queued behind another one here.
+ *******************************************************************************/
+uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data)
+{
+    return canSendAsyncId(txb, id, 0x00, lenght, data);
+    
+} // end uint8_t canSendAsync(uint8_t txb, uint8_t id, uint8_t lenght, uint8_t *data) function
+
+
+uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data)
+{
+    return canSendAsyncId(txb, idh, idl, lenght, data);
+    
+} // end uint8_t canAnswerAsync(uint8_t txb, uint8_t idh, uint8_t idl, uint8_t lenght, uint8_t *data) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canInterruptEnable(void)
+ * Description: Nothing to enable: canIntEnabled stays 0, so the receive functions (canRxTake() of
+ * canQueue.c included) read the socket themselves.
+ *******************************************************************************/
+void canInterruptEnable(void)
+{
+} // end void canInterruptEnable(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canService(void)
+ * Description: Sends the transmit batch when due, then empties the socket into the receive
+ * queue: recvmmsg() calls of up to canSocketBatch frames, as long as the queue has room and the
+ * socket frames. Configuration and sleep mode receive nothing; loopback mode drops the frames of
+ * the bus.
+ *******************************************************************************/
+void canService(void)
+{
+    struct mmsghdr messages[CAN_SOCKET_BATCH];
+    struct iovec vectors[CAN_SOCKET_BATCH];
+    struct can_frame frames[CAN_SOCKET_BATCH];
+    uint8_t control[CAN_SOCKET_BATCH][CAN_SOCKET_CONTROL];
+    uint8_t count;
+    int received;
+    
+    canSocketLinger();
+    if ((canSocketFd < 0) || (mcp2515OpMode == OPMODE_CONFIG) || (mcp2515OpMode == OPMODE_SLEEP))
+        return;
+    
+    do
+    {
+        uint8_t room = (CAN_RX_QUEUE_SIZE - 1) - canRxWaiting();
+    
+        count = (room < canSocketBatch) ? room : canSocketBatch;
+        if (!count)
+            return;
+    
+        memset(messages, 0, count * sizeof(messages[0]));
+        for (uint8_t i = 0; i < count; i++)
+        {
+            vectors[i].iov_base = &frames[i];
+            vectors[i].iov_len = sizeof(frames[i]);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = control[i];
+            messages[i].msg_hdr.msg_controllen = sizeof(control[i]);
+        }
+    
+        received = recvmmsg(canSocketFd, messages, count, MSG_DONTWAIT, 0);
+        if (received <= 0)
+            return;
+        canSocketCount.rxCalls++;
+        canSocketCount.rxFrames += received;
+    
+        for (int i = 0; i < received; i++)
+        {
+            uint64_t stampNs = 0;
+    
+            for (struct cmsghdr *c = CMSG_FIRSTHDR(&messages[i].msg_hdr); c; c = CMSG_NXTHDR(&messages[i].msg_hdr, c))
+            {
+                if (c->cmsg_level != SOL_SOCKET)
+                    continue;
+                if (c->cmsg_type == SCM_TIMESTAMPNS)
+                {
+                    struct timespec stamp;
+    
+                    memcpy(&stamp, CMSG_DATA(c), sizeof(stamp));
+                    stampNs = (uint64_t)stamp.tv_sec * 1000000000 + stamp.tv_nsec;
+                }
+                else if (c->cmsg_type == SO_RXQ_OVFL)
+                    memcpy(&canSocketCount.kernelDrops, CMSG_DATA(c), sizeof(uint32_t));
+            }
+            if ((messages[i].msg_len == sizeof(struct can_frame)) && (mcp2515OpMode != OPMODE_LOOPBACK))
+                canSocketStore(&frames[i], stampNs);
+        }
+    } while (received == count);
+    
+} // end void canService(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void canServiceAsync(void); uint8_t canReceive(dataFrame *frame)
+ * Description: canService(); canSocketReceive() without the receive time.
+ *******************************************************************************/
+void canServiceAsync(void)
+{
+    canService();
+    
+} // end void canServiceAsync(void) function
+
+
+uint8_t canReceive(dataFrame *frame)
+{
+    return canSocketReceive(frame, 0);
+    
+} // end uint8_t canReceive(dataFrame *frame) function
@@ -0,0 +1,49 @@
+/* File:  canSocket.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: SocketCAN backend of the driver API (can.h) for Linux: linked in place of can.c,
+ * spi.c and the host models, the application modules (canGen.c, canWatch.c, canOpen.c, ...) run
+ * unchanged on a raw CAN socket, a vcan interface for multi-node simulations on one box or a
+ * real interface on a Linux gateway. picLinux.c gives them the PIC registers and timers.
+ * 
+ * Environment: gcc (host, Linux), see host/canSocketHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef CAN_SOCKET_H
+#define	CAN_SOCKET_H
+
+#include <stdint.h>
+#include "../can.h"
+
+// Frames moved by one sendmmsg()/recvmmsg() call, at most.
+#ifndef CAN_SOCKET_BATCH
+    #define CAN_SOCKET_BATCH        32
+#endif
+
+typedef struct
+{
+    uint32_t rxCalls;                   // recvmmsg() calls that returned frames
+    uint32_t rxFrames;
+    uint32_t txCalls;                   // sendmmsg() calls
+    uint32_t txFrames;
+    uint32_t txRetries;                 // Interface queue full (ENOBUFS), sent again
+    uint32_t kernelDrops;               // Frames dropped by a full socket buffer (SO_RXQ_OVFL)
+}canSocketStats;
+
+extern canSocketStats canSocketCount;
+// Frames per system call, 1..CAN_SOCKET_BATCH (default): 1 measures the cost of unbatched I/O.
+extern uint8_t canSocketBatch;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+int canSocketOpen(const char *interface);
+void canSocketClose(void);
+void canSocketFlush(void);
+uint8_t canSocketReceive(dataFrame *frame, uint64_t *stampNs);
+
+#endif	/* CAN_SOCKET_H */
@@ -0,0 +1,222 @@
+/* File:  canSocketHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Multi-node run of the firmware on a vcan interface, in real time, through the
+ * SocketCAN backend (canSocket.c): one process per node, each with the application code as
+ * compiled for the PIC. Node 0 runs the traffic generator (canGen.c, the mix of main.c) at -l
+ * permille of the -r bit rate (1000: as fast as it goes); the -n - 1 other nodes check its frames
+ * with canGenCheck(). Each node prints what it moved, the frames per system call (-b frames per
+ * sendmmsg()/recvmmsg() at most, 1: unbatched), the CPU time per frame and, on the receiving
+ * nodes, how long the frames waited in the socket (kernel receive time to canReceive()). The
+ * exit code is 1 when a receiving node saw a frame reordered or corrupted, or lost one the
+ * kernel did not drop.
+ * 
+ * Set up the interface once (root):
+ *   modprobe vcan && ip link add dev vcan0 type vcan && ip link set up vcan0
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DCAN_RX_QUEUE_SIZE=64 -DCAN_RX_STAMP=1 -o canSocketHost host/canSocketHost.c \
+ *       host/canSocket.c canQueue.c host/picLinux.c canGen.c busLoad.c timer.c && ./canSocketHost
+ * Use:
+ *   ./canSocketHost [-i interface] [-n nodes] [-l loadPermille] [-r 125|250|500] [-b batch] [-s seconds]
+ * 
+ * Environment: gcc (host, Linux with the can and vcan modules).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "../canGen.h"
+#include "canSocket.h"
+
+#define HOST_NODES              8
+#define HOST_DRAIN_NS           200000000ull    // Receiving nodes go on after the generator stops
+
+// The mix of main.c.
+static const canGenId hostIds[] =
+{
+    { 0x0A0, 60 }, { 0x0C8, 50 }, { 0x1F0, 40 }, { 0x2A0, 30 }, { 0x3A0, 20 }, { 0x4B0, 20 }, { 0x5C0, 20 }, { 0x6D0, 15 },
+};
+static canGenMix hostMix =
+{
+    hostIds, sizeof(hostIds) / sizeof(hostIds[0]),
+    { 5, 5, 10, 5, 20, 5, 10, 5, 190 },
+    500, 0, 0x1234,
+};
+
+static const char *hostInterface = "vcan0";
+static uint8_t hostBitrate = CAN_BITRATE_500K;
+static uint32_t hostSeconds = 5;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint64_t hostNs(clockid_t clock)
+ * Description: Time of (clock) in nanoseconds.
+ *******************************************************************************/
+static uint64_t hostNs(clockid_t clock)
+{
+    struct timespec now;
+    
+    clock_gettime(clock, &now);
+    
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    
+} // end static uint64_t hostNs(clockid_t clock) function
+
+
+/*******************************************************************************
+ * FUNCTION: static int hostNode(uint8_t node)
+ * Description: One node, in its own process: starts the controller on the socket, then runs the
+ * main loop of main.c (CAN_GEN) for the run time. Returns the exit code of the process.
+ *******************************************************************************/
+static int hostNode(uint8_t node)
+{
+    uint64_t startNs;
+    uint64_t endNs;
+    uint64_t cpuNs;
+    uint64_t waitSum = 0;
+    uint64_t waitWorst = 0;
+    uint32_t frames = 0;
+    uint32_t moved;
+    uint32_t calls;
+    dataFrame frame;
+    
+    if (canSocketOpen(hostInterface) < 0)
+    {
+        fprintf(stderr, "node %u: %s: %s\n", node, hostInterface, strerror(errno));
+        return 2;
+    }
+    mcp2515Start();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(hostBitrate);
+    mcp2515ConfigEnd();
+    if (canGenStart(&hostMix) != CAN_GEN_OK)
+        return 2;
+    
+    startNs = hostNs(CLOCK_MONOTONIC);
+    endNs = startNs + (uint64_t)hostSeconds * 1000000000 + (node ? HOST_DRAIN_NS : 0);
+    cpuNs = hostNs(CLOCK_PROCESS_CPUTIME_ID);
+    while (hostNs(CLOCK_MONOTONIC) < endNs)
+    {
+        uint64_t stampNs;
+    
+        if (!node)
+            canGenService();
+        while (canSocketReceive(&frame, &stampNs))
+        {
+            uint64_t waitNs = hostNs(CLOCK_REALTIME) - stampNs;
+    
+            canGenCheck(&frame);
+            waitSum += waitNs;
+            if (waitNs > waitWorst)
+                waitWorst = waitNs;
+            frames++;
+        }
+    }
+    canSocketFlush();
+    cpuNs = hostNs(CLOCK_PROCESS_CPUTIME_ID) - cpuNs;
+    
+    moved = node ? canSocketCount.rxFrames : canSocketCount.txFrames;
+    calls = node ? canSocketCount.rxCalls : canSocketCount.txCalls;
+    if (!node)
+    {
+        printf("  node 0 sent      %8u frames, %7.0f frames/s, %5.2f per sendmmsg(), %5.2f us CPU per frame, %u retries\n",
+               canGenCount.sent, canGenCount.sent / (double)hostSeconds, calls ? (double)moved / calls : 0,
+               moved ? cpuNs / 1000.0 / moved : 0, canSocketCount.txRetries);
+        return 0;
+    }
+    
+    printf("  node %u received  %8u frames, %u lost, %u reordered, %u corrupted, %5.2f per recvmmsg(), "
+           "%5.2f us CPU per frame, waited %.1f us mean %.1f us worst, %u dropped by the kernel\n",
+           node, canGenCount.received, canGenCount.lost, canGenCount.reordered, canGenCount.corrupted,
+           calls ? (double)moved / calls : 0, moved ? cpuNs / 1000.0 / moved : 0,
+           frames ? waitSum / 1000.0 / frames : 0, waitWorst / 1000.0, canSocketCount.kernelDrops);
+    
+    return (canGenCount.reordered || canGenCount.corrupted || (canGenCount.lost && !canSocketCount.kernelDrops)
+            || canRxOverflow) ? 1 : 0;
+    
+} // end static int hostNode(uint8_t node) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t nodes = 3;
+    int batch = CAN_SOCKET_BATCH;
+    int result = 0;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-i"))
+            hostInterface = argv[opt + 1];
+        else if (!strcmp(argv[opt], "-n"))
+            nodes = (uint8_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-l"))
+            hostMix.loadPermille = (uint16_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-r"))
+            hostBitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-b"))
+            batch = atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-s"))
+            hostSeconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || nodes < 2 || nodes > HOST_NODES || !hostMix.loadPermille || hostMix.loadPermille > 1000
+        || hostBitrate >= CAN_BITRATES || batch < 1 || batch > CAN_SOCKET_BATCH || !hostSeconds)
+    {
+        fprintf(stderr, "use: %s [-i interface] [-n nodes, 2..%u] [-l loadPermille] [-r 125|250|500] [-b batch, 1..%u] "
+                "[-s seconds]\n", argv[0], HOST_NODES, CAN_SOCKET_BATCH);
+        return 2;
+    }
+    canSocketBatch = (uint8_t)batch;
+    
+    printf("%u nodes on %s, traffic generator at %u permille of %u Kbps, batches of %u frames, %u s\n", nodes,
+           hostInterface, hostMix.loadPermille, rates[hostBitrate], canSocketBatch, hostSeconds);
+    fflush(stdout);
+    
+    // The receiving nodes first, so they see the first frame.
+    for (uint8_t node = nodes; node-- > 0; )
+    {
+        pid_t pid = fork();
+    
+        if (pid < 0)
+        {
+            perror("fork");
+            return 2;
+        }
+        if (!pid)
+        {
+            int code = hostNode(node);
+    
+            fflush(stdout);
+            _exit(code);
+        }
+        if (node == 1)
+            usleep(100000);
+    }
+    for (uint8_t node = 0; node < nodes; node++)
+    {
+        int status;
+    
+        if (wait(&status) < 0 || !WIFEXITED(status))
+            result = 2;
+        else if (WEXITSTATUS(status) > result)
+            result = WEXITSTATUS(status);
+    }
+    
+    printf(result ? "FAIL\n" : "OK: every frame of the generator checked on every node\n");
+    
+    return result;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,250 @@
+/* File:  canWatchHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Receive deadline supervision (canWatch.c) on a busy bus. The node runs the driver
+ * and canWatch.c on the MCP2515 model and supervises -n periodic messages (identifiers 0x300 up,
+ * periods 10 ms to 1 s, tolerance half a period); the other nodes send them with a jitter of a
+ * quarter period. Every fourth message goes silent for a while, once, then comes back (dead
+ * sensor). Checks:
+ *   no timeout for a message still sent;
+ *   each silent message reported once, (periodMs + toleranceMs) after its last frame, not before
+ *   and at most 2 ms later;
+ *   its return reported within one period of its first frame back.
+ * The wheel's work per millisecond is printed against the messages a scan would look at. The exit
+ * code is 1 when a check fails.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DCAN_WATCH=1 -DSPI_CLOCK=0 -o canWatchHost host/canWatchHost.c \
+ *       host/picSim.c host/spiSim.c host/mcp2515Sim.c canWatch.c canQueue.c can.c hardware.c timer.c \
+ *       && ./canWatchHost
+ * Use:
+ *   ./canWatchHost [-n messages] [-r 125|250|500] [-s seconds]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../canWatch.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define HOST_STEP_NS            1000
+#define HOST_MESSAGES           (CAN_WATCH_SLOTS / 2)
+#define HOST_ID                 0x300
+#define HOST_SILENT_NS          1500000000ull   // Silent messages stop at 1.5 s ...
+#define HOST_SILENT_FOR_NS      3000000000ull   // ... until 4.5 s
+#define HOST_LATE_US            2000            // Timeout later than the window by at most
+
+typedef struct
+{
+    uint64_t nextNs;                    // Next frame of the other node
+    uint64_t lastEndNs;                 // End of the last frame received by the node
+    uint64_t backNs;                    // End of the first frame after the silence, 0: none yet
+    uint8_t silent;                     // Goes silent once
+    uint32_t timeouts;
+    uint32_t backs;
+    uint32_t errors;
+}hostMessage;
+
+static canWatchMessage hostWatch[HOST_MESSAGES];
+static hostMessage hostMessages[HOST_MESSAGES];
+static uint8_t hostCount = 24;
+static uint64_t hostStartNs;
+static int32_t hostLateWorst = -1000000;        // Timeout minus window, us
+static int32_t hostLateBest = 1000000;
+static uint32_t hostBackWorst;                  // Return reported after the first frame back, us
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimRxHook: end of each supervised frame stored by the node.
+ *******************************************************************************/
+static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    hostMessage *message;
+    
+    if (frame->id < HOST_ID || frame->id >= (uint32_t)(HOST_ID + hostCount))
+        return;
+    message = &hostMessages[frame->id - HOST_ID];
+    if (hostWatch[frame->id - HOST_ID].flags & CAN_WATCH_LOST && !message->backNs)
+        message->backNs = endNs;
+    message->lastEndNs = endNs;
+    
+} // end static void hostRx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostEvent(canWatchMessage *watch, uint8_t event)
+ * Description: canWatchCallback: timeouts and returns, timed against the bus.
+ *******************************************************************************/
+static void hostEvent(canWatchMessage *watch, uint8_t event)
+{
+    uint8_t i = (uint8_t)(watch - hostWatch);
+    hostMessage *message = &hostMessages[i];
+    uint64_t now = picSimNs();
+    
+    if (event == CAN_WATCH_TIMEOUT)
+    {
+        int32_t late = (int32_t)((int64_t)(now - message->lastEndNs) / 1000) - (watch->periodMs + watch->toleranceMs) * 1000;
+    
+        message->timeouts++;
+        message->backNs = 0;
+        if (!message->silent || message->timeouts > 1 || late > HOST_LATE_US || late < 0)
+        {
+            printf("  0x%03X: timeout %d us after its window\n", watch->id, late);
+            message->errors++;
+        }
+        if (late > hostLateWorst)
+            hostLateWorst = late;
+        if (late < hostLateBest)
+            hostLateBest = late;
+    }
+    else
+    {
+        uint32_t after = message->backNs ? (uint32_t)((now - message->backNs) / 1000) : 0xFFFFFFFF;
+    
+        message->backs++;
+        if (!message->silent || message->backs > 1 || after > watch->periodMs * 1000u + HOST_LATE_US)
+        {
+            printf("  0x%03X: return reported %u us after the first frame back\n", watch->id, after);
+            message->errors++;
+        }
+        else if (after > hostBackWorst)
+            hostBackWorst = after;
+    }
+    
+} // end static void hostEvent(canWatchMessage *watch, uint8_t event) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the other nodes, each supervised message at its period with jitter.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    for (uint8_t i = 0; i < hostCount; i++)
+    {
+        hostMessage *message = &hostMessages[i];
+        uint64_t periodNs = (uint64_t)hostWatch[i].periodMs * 1000000;
+        uint64_t at = nowNs - hostStartNs;
+    
+        if (nowNs < message->nextNs)
+            continue;
+        if (!message->silent || at < HOST_SILENT_NS + i * 10000000ull || at >= HOST_SILENT_NS + HOST_SILENT_FOR_NS)
+        {
+            mcp2515SimFrame frame = { HOST_ID + i, 0, 8, { 0 } };
+    
+            frame.data[0] = (uint8_t)rand();
+            mcp2515SimInject(&frame);
+        }
+        message->nextNs += periodNs - periodNs / 8 + (uint64_t)(rand() % 1000) * (periodNs / 4) / 1000;
+    }
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t periods[] = {10, 20, 50, 100, 200, 500, 1000};
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_500K;
+    uint32_t seconds = 6;
+    uint32_t errors = 0;
+    uint32_t silent = 0;
+    uint32_t scan = 0;
+    uint64_t ticks;
+    dataFrame frame;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-n"))
+            hostCount = (uint8_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-r"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-s"))
+            seconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || !hostCount || hostCount > HOST_MESSAGES || bitrate >= CAN_BITRATES || seconds < 4)
+    {
+        fprintf(stderr, "use: %s [-n messages, 1..%u] [-r 125|250|500] [-s seconds]\n", argv[0], HOST_MESSAGES);
+        return 2;
+    }
+    
+    srand(1);
+    hardware_ini();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(bitrate);
+    mcp2515ConfigEnd();
+    
+    for (uint8_t i = 0; i < hostCount; i++)
+    {
+        hostWatch[i].id = HOST_ID + i;
+        hostWatch[i].periodMs = periods[i % (sizeof(periods) / sizeof(periods[0]))];
+        hostWatch[i].toleranceMs = hostWatch[i].periodMs / 2;
+        hostMessages[i].silent = (i % 4) == 3;
+        hostMessages[i].nextNs = picSimNs() + (uint64_t)(rand() % hostWatch[i].periodMs) * 1000000;
+        silent += hostMessages[i].silent;
+    }
+    if (canWatchIni(hostWatch, hostCount, hostEvent) != CAN_WATCH_OK)
+    {
+        printf("FAIL: canWatchIni()\n");
+        return 1;
+    }
+    
+    mcp2515SimRxHook = hostRx;
+    picSimHook = hostStep;
+    hostStartNs = picSimNs();
+    
+    // Main loop of the node.
+    while (picSimNs() < hostStartNs + (uint64_t)seconds * 1000000000)
+    {
+        canWatchService();
+        while (canReceive(&frame));
+        picSimAdvance(HOST_STEP_NS);
+    }
+    
+    for (uint8_t i = 0; i < hostCount; i++)
+    {
+        hostMessage *message = &hostMessages[i];
+    
+        errors += message->errors;
+        if (message->silent && (message->timeouts != 1 || message->backs != 1))
+        {
+            printf("  0x%03X: %u timeouts, %u returns reported\n", hostWatch[i].id, message->timeouts, message->backs);
+            errors++;
+        }
+    }
+    ticks = (uint64_t)seconds * 1000;
+    scan = hostCount;
+    
+    printf("receive supervision, %u messages (%u go silent), %u Kbps, %u s, wheel %u ms, hash %u slots\n", hostCount,
+           silent, rates[bitrate], seconds, CAN_WATCH_WHEEL, CAN_WATCH_SLOTS);
+    printf("  timeouts          %8u     (%d to %d us after the window)\n", canWatchCount.timeouts, hostLateBest,
+           hostLateWorst);
+    printf("  returns           %8u     (%u us worst after the first frame back)\n", canWatchCount.recovered,
+           hostBackWorst);
+    printf("  wheel visits      %8.2f per ms, %u worst  (a scan: %u per ms)\n", (double)canWatchCount.visits / ticks,
+           canWatchCount.visitsMax, scan);
+    printf("  MCP2515 overflows %8u\n", mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1]);
+    if (errors || canWatchCount.timeouts != silent)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: every silent message reported once, within %d us of its window\n", hostLateWorst);
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
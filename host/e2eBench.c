@@ -0,0 +1,282 @@
+/* File:  e2eBench.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host benchmark and check of the end-to-end protection (e2e.c):
+ *   - CRC-8 SAE J1850 check value ("123456789" -> 0x4B) and agreement with a bit by bit CRC;
+ *   - cost of e2eProtect() + e2eCheck() per 8 byte frame, in host cycles, against the same
+ *     CRC computed bit by bit (the ratio is what carries over to the PIC);
+ *   - 1 and 2 bit errors in a frame all detected (Hamming distance 3 over 8 bytes), the share of
+ *     3 bit errors missed, repeats and gaps counted;
+ *   - e2eSend()/e2eRead() through the driver in loopback mode (MCP2515 model).
+ * The exit code is 1 when a check fails.
+ * 
+ * Build and run, from the project folder (add -DE2E_CRC_NIBBLE=1 for the 16 byte table):
+ *   gcc -O2 -fcommon -Ihost -o e2eBench host/e2eBench.c host/picSim.c host/spiSim.c host/mcp2515Sim.c \
+ *       e2e.c canQueue.c can.c hardware.c timer.c && ./e2eBench
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "../hardware.h"
+#include "../e2e.h"
+
+#define BENCH_FRAMES            1000000
+#define BENCH_ERRORS            100000
+#define BENCH_LOOPBACK          200
+
+static e2eChannel benchChannel =                            // CRC in data[0], counter in data[1]
+{
+    .id = 0x20, .dlc = 8, .crcByte = 0, .counterByte = 1, .maxDelta = 1
+};
+static volatile uint8_t benchSink;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint64_t benchCycles(void)
+ * Description: Time stamp counter, or nanoseconds where there is none.
+ *******************************************************************************/
+static uint64_t benchCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + now.tv_nsec;
+#endif
+    
+} // end static uint64_t benchCycles(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t benchBitwise(uint8_t crc, const uint8_t *data, uint8_t count)
+ * Description: Reference CRC-8 (polynomial 0x1D), one bit at a time.
+ *******************************************************************************/
+static uint8_t benchBitwise(uint8_t crc, const uint8_t *data, uint8_t count)
+{
+    for (; count; count--, data++)
+    {
+        crc ^= *data;
+        for (uint8_t bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x1D) : (uint8_t)(crc << 1);
+    }
+    
+    return crc;
+    
+} // end static uint8_t benchBitwise(uint8_t crc, const uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t benchCrc(void)
+ * Description: Check value and agreement with the bit by bit CRC. Returns 1 on a failure.
+ *******************************************************************************/
+static uint8_t benchCrc(void)
+{
+    static const uint8_t check[9] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    uint8_t data[8];
+    uint8_t value = e2eCrc(E2E_CRC_START, check, 9) ^ E2E_CRC_XOR;
+    uint32_t differ = 0;
+    
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        uint8_t count = rand() % 9;
+    
+        for (uint8_t j = 0; j < count; j++)
+            data[j] = (uint8_t)rand();
+        if (e2eCrc((uint8_t)i, data, count) != benchBitwise((uint8_t)i, data, count))
+            differ++;
+    }
+    
+    printf("CRC-8            check value 0x%02X (0x4B expected), %u of 100000 differ from bit by bit\n",
+           value, differ);
+    
+    return (value != 0x4B) || differ;
+    
+} // end static uint8_t benchCrc(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void benchSpeed(void)
+ * Description: Cycles per frame of e2eProtect() + e2eCheck(), and of the same two frame CRCs
+ * computed bit by bit.
+ *******************************************************************************/
+static void benchSpeed(void)
+{
+    static uint8_t frames[256][8];
+    e2eChannel tx = benchChannel;
+    e2eChannel rx = benchChannel;
+    uint64_t start;
+    uint64_t table;
+    uint64_t bitwise;
+    
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        for (uint8_t j = 0; j < 8; j++)
+            frames[i][j] = (uint8_t)rand();
+    }
+    
+    start = benchCycles();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        e2eProtect(&tx, frames[i & 0xFF]);
+        benchSink = e2eCheck(&rx, frames[i & 0xFF], 8);
+    }
+    table = benchCycles() - start;
+    
+    start = benchCycles();
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        uint8_t id[2] = { (uint8_t)(benchChannel.id << 3), benchChannel.id >> 5 };
+        uint8_t *data = frames[i & 0xFF];
+        uint8_t check;
+    
+        data[0] = benchBitwise(benchBitwise(E2E_CRC_START, id, 2), &data[1], 7) ^ E2E_CRC_XOR;
+        check = benchBitwise(benchBitwise(E2E_CRC_START, id, 2), &data[1], 7) ^ E2E_CRC_XOR;
+        benchSink = check == data[0];
+    }
+    bitwise = benchCycles() - start;
+    
+    printf("speed            %.1f %s per frame (%s table, protect + check), %.1f bit by bit: %.1f x\n",
+           (double)table / BENCH_FRAMES,
+#if defined(__x86_64__) || defined(__i386__)
+           "host cycles",
+#else
+           "ns",
+#endif
+           E2E_CRC_NIBBLE ? "16 byte" : "256 byte", (double)bitwise / BENCH_FRAMES,
+           (double)bitwise / table);
+    
+} // end static void benchSpeed(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t benchErrors(void)
+ * Description: Bit errors, repeated and lost frames. Returns 1 on a failure.
+ *******************************************************************************/
+static uint8_t benchErrors(void)
+{
+    e2eChannel tx = benchChannel;
+    e2eChannel rx = benchChannel;
+    uint8_t data[8];
+    uint8_t copy[8];
+    uint32_t missed[3] = { 0, 0, 0 };
+    uint8_t failed = 0;
+    
+    for (uint32_t i = 0; i < BENCH_ERRORS; i++)
+    {
+        uint8_t flips = 1 + i % 3;
+        uint64_t used = 0;
+    
+        for (uint8_t j = 0; j < 8; j++)
+            data[j] = (uint8_t)rand();
+        e2eProtect(&tx, data);
+        for (uint8_t j = 0; j < 8; j++)
+            copy[j] = data[j];
+    
+        // Distinct bits, anywhere in the frame, the CRC and the counter included.
+        while (flips)
+        {
+            uint8_t bit = rand() % 64;
+    
+            if (used & ((uint64_t)1 << bit))
+                continue;
+            copy[bit / 8] ^= 1 << (bit % 8);
+            used |= (uint64_t)1 << bit;
+            flips--;
+        }
+        if (e2eCheck(&rx, copy, 8) != E2E_ERR_CRC)
+        {
+            missed[i % 3]++;
+            rx.flags = 0;           // Its counter may be wrong: synchronize again
+        }
+        if (e2eCheck(&rx, data, 8) > E2E_OK_LOST)
+            failed = 1;
+    }
+    printf("bit errors       missed %u, %u and %u of %u frames with 1, 2 and 3 bit errors (%.2f %% of 3)\n",
+           missed[0], missed[1], missed[2], BENCH_ERRORS / 3, 300.0 * missed[2] / BENCH_ERRORS);
+    
+    // One repeat, then 2 and 4 frames lost (the second jump is over maxDelta = 3).
+    rx = benchChannel;
+    rx.maxDelta = 3;
+    e2eProtect(&tx, data);
+    benchSink = e2eCheck(&rx, data, 8);
+    if (e2eCheck(&rx, data, 8) != E2E_ERR_REPEATED)
+        failed = 1;
+    e2eProtect(&tx, data);
+    e2eProtect(&tx, data);
+    e2eProtect(&tx, data);
+    if (e2eCheck(&rx, data, 8) != E2E_OK_LOST)
+        failed = 1;
+    for (uint8_t j = 0; j < 5; j++)
+        e2eProtect(&tx, data);
+    if (e2eCheck(&rx, data, 8) != E2E_ERR_SEQUENCE)
+        failed = 1;
+    e2eProtect(&tx, data);
+    if (e2eCheck(&rx, data, 8) != E2E_OK)
+        failed = 1;
+    printf("sequence         %u repeats, %u gaps counted (1 and 2 expected)\n", rx.repeats, rx.gaps);
+    
+    return failed || missed[0] || missed[1] || (rx.repeats != 1) || (rx.gaps != 2);
+    
+} // end static uint8_t benchErrors(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t benchLoopback(void)
+ * Description: Protected frames sent and checked through the driver. Returns 1 on a failure.
+ *******************************************************************************/
+static uint8_t benchLoopback(void)
+{
+    e2eChannel tx = benchChannel;
+    e2eChannel rx = benchChannel;
+    uint8_t data[8];
+    uint8_t read[8];
+    uint16_t ok = 0;
+    
+    if (mcp2515SetMode(OPMODE_LOOPBACK) != MCP2515_OK)
+        return 1;
+    
+    for (uint16_t i = 0; i < BENCH_LOOPBACK; i++)
+    {
+        for (uint8_t j = 0; j < 8; j++)
+            data[j] = (uint8_t)rand();
+        e2eSend(&tx, 0, data);
+        delayMS(1);
+        if (e2eRead(&rx, read) == E2E_OK)
+            ok++;
+    }
+    printf("loopback         %u of %u frames valid\n", ok, BENCH_LOOPBACK);
+    
+    return ok != BENCH_LOOPBACK;
+    
+} // end static uint8_t benchLoopback(void) function
+
+
+int main(void)
+{
+    uint8_t failed = 0;
+    
+    srand(1);
+    hardware_ini();
+    
+    failed |= benchCrc();
+    benchSpeed();
+    failed |= benchErrors();
+    failed |= benchLoopback();
+    
+    return failed;
+    
+} // end int main(void) function
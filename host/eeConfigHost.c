@@ -0,0 +1,183 @@
+/* File:  eeConfigHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Start-up time with the configuration store (eeConfig.c). The node runs the
+ * unmodified hardware_ini() on the driver, the MCP2515 model and the data EEPROM model
+ * (eepromSim.c: 4 ms per byte written). The other nodes send a frame every -t ms at the bus bit
+ * rate (-r), which the node does not know at the first start.
+ * 
+ * Three starts are timed, from hardware_ini() until the MCP2515 is in normal mode at the bus bit
+ * rate, the node then receiving:
+ *   blank store:  defaults, canAutobaud() and the first save of the bit rate (a quarter of a
+ *                 second of EEPROM writes, once); the tool then sets filters and a node
+ *                 address and saves them, as an application would;
+ *   stored:       the saved setup goes in with the initialization bursts;
+ *   corrupted:    one byte of the store changed: CRC error, back to the blank store path.
+ * After each start the bit timing, filters and node address are checked. The exit code is 1
+ * when a check fails.
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DEE_CONFIG=1 -o eeConfigHost host/eeConfigHost.c host/picSim.c \
+ *       host/spiSim.c host/mcp2515Sim.c host/eepromSim.c host/flashSim.c eeConfig.c boot.c \
+ *       canQueue.c can.c hardware.c timer.c && ./eeConfigHost
+ * Use:
+ *   ./eeConfigHost [-r 125|250|500] [-t trafficPeriodMs]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../eeConfig.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+#include "eepromSim.h"
+
+#define HOST_NODE               0x23
+#define HOST_FILTER_IDH         0x40    // Demo filters: 0x200-0x207 in RXB0 ...
+#define HOST_FILTER2_IDH        0x10    // ... and 0x080-0x087 in RXB1
+#define HOST_LISTEN_NS          50000000
+
+static uint64_t hostPeriodNs = 100000000;
+static uint64_t hostTrafficNs;
+static uint32_t hostSent;
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the other nodes, identifiers 0x080-0x087 and 0x200-0x207 in turn.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    if (nowNs >= hostTrafficNs)
+    {
+        mcp2515SimFrame frame = { (hostSent & 1) ? 0x200 : 0x080, 0, 8, { 0 } };
+    
+        frame.id += hostSent & 0x07;
+        frame.data[0] = (uint8_t)hostSent;
+        mcp2515SimInject(&frame);
+        hostSent++;
+        hostTrafficNs = nowNs + hostPeriodNs;
+    }
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static double hostStart(const char *name, uint8_t status, uint8_t node)
+ * Description: One power-up: hardware_ini(), timed, then the checks. Returns the time in ms, or
+ * -1 when a check fails.
+ *******************************************************************************/
+static double hostStart(const char *name, uint8_t status, uint8_t node)
+{
+    uint64_t start;
+    uint64_t ready;
+    uint32_t received;
+    uint32_t writes = eepromSimCount.writes;
+    dataFrame frame;
+    
+    memset(&eeConfig, 0, sizeof(eeConfig));
+    while (canReceive(&frame));
+    
+    start = picSimNs();
+    hardware_ini();
+    ready = picSimNs();
+    
+    // Bus traffic is received at the right bit rate.
+    received = mcp2515SimCount.received;
+    while (picSimNs() < ready + HOST_LISTEN_NS + hostPeriodNs)
+    {
+        while (canReceive(&frame));
+        picSimAdvance(1000);
+    }
+    
+    printf("  %-13s %8.2f ms  (store: %s, %u EEPROM writes)\n", name, (ready - start) / 1e6,
+           eeConfigStatus == EE_CONFIG_OK ? "loaded" : eeConfigStatus == EE_CONFIG_ERR_BLANK ? "blank" :
+           eeConfigStatus == EE_CONFIG_ERR_CRC ? "CRC error" : "other version", eepromSimCount.writes - writes);
+    
+    if (eeConfigStatus != status || eeConfig.node != node || (mcp2515SimRegister(CANSTAT) & REQOP) != OPMODE_NORMAL
+        || mcp2515SimBitNs() != mcp2515SimBusBitNs || mcp2515SimCount.received == received)
+        return -1;
+    
+    return (ready - start) / 1e6;
+    
+} // end static double hostStart(const char *name, uint8_t status, uint8_t node) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_250K;
+    double blank, stored, corrupted;
+    uint64_t start;
+    uint32_t writes;
+    uint8_t result;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-r"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-t"))
+            hostPeriodNs = (uint64_t)atoi(argv[opt + 1]) * 1000000;
+        else
+            break;
+    }
+    if (opt != argc || bitrate >= CAN_BITRATES || !hostPeriodNs)
+    {
+        fprintf(stderr, "use: %s [-r 125|250|500] [-t trafficPeriodMs]\n", argv[0]);
+        return 2;
+    }
+    
+    eepromSimIni();
+    mcp2515SimBusBitNs = 8000 >> bitrate;
+    picSimHook = hostStep;
+    
+    printf("configuration store, bus %u Kbps, a frame every %u ms, store %u bytes\n", rates[bitrate],
+           (unsigned)(hostPeriodNs / 1000000), (unsigned)sizeof(eeConfigData));
+    
+    blank = hostStart("blank store", EE_CONFIG_ERR_BLANK, EE_CONFIG_NODE);
+    
+    // Settings worked out by the application, then saved.
+    mcp2515ConfigBegin();
+    mcp2515SetMask(0, 0xFF);
+    mcp2515SetFilter(0, HOST_FILTER_IDH);
+    mcp2515SetMask(1, 0xFF);
+    mcp2515SetFilter(2, HOST_FILTER2_IDH);
+    mcp2515SetRxMode(0, RXM_VALID_ALL);
+    mcp2515SetRxMode(1, RXM_VALID_ALL);
+    mcp2515ConfigEnd();
+    eeConfig.node = HOST_NODE;
+    eeConfig.param[0] = 0x5A;
+    start = picSimNs();
+    writes = eepromSimCount.writes;
+    result = eeConfigSave();
+    printf("  %-13s %8.2f ms  (filters and node address, %u EEPROM writes)\n", "save",
+           (picSimNs() - start) / 1e6, eepromSimCount.writes - writes);
+    
+    stored = hostStart("stored", EE_CONFIG_OK, HOST_NODE);
+    if (stored >= 0 && (mcp2515SimRegister(RXF0SIDH) != HOST_FILTER_IDH || mcp2515SimRegister(RXF2SIDH) != HOST_FILTER2_IDH
+        || mcp2515SimRegister(RXM1SIDH) != 0xFF || eeConfig.param[0] != 0x5A))
+        stored = -1;
+    
+    eepromSimMemory[EE_CONFIG_ADDRESS + 10] ^= 0x01;
+    corrupted = hostStart("corrupted", EE_CONFIG_ERR_CRC, EE_CONFIG_NODE);
+    
+    if (result != EE_CONFIG_OK || blank < 0 || stored < 0 || corrupted < 0)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: on the bus %.1f times sooner from the store\n", blank / stored);
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
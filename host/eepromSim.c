@@ -0,0 +1,109 @@
+/* File:  eepromSim.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host replacement of eeprom.c: 256 bytes of data EEPROM in an array. A write takes
+ * EEPROM_SIM_WRITE_NS while the virtual CPU goes on; an access during a write waits for it, the
+ * MCP2515 model and the interrupts running meanwhile.
+ * 
+ * Environment: gcc (host), see host/eeConfigHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <string.h>
+#include "picSim.h"
+#include "eepromSim.h"
+#include "../eeprom.h"
+
+#define EEPROM_SIM_STEP_NS      20000   // Clock step while a write is waited for
+
+uint8_t eepromSimMemory[EEPROM_SIZE];
+eepromSimStats eepromSimCount;
+
+static uint64_t eepromSimDoneNs;        // End of the write in progress
+
+
+/*******************************************************************************
+ * FUNCTION: static void eepromSimWait(void)
+ * Description: Lets the write in progress end.
+ *******************************************************************************/
+static void eepromSimWait(void)
+{
+    while (picSimNs() < eepromSimDoneNs)
+    {
+        picSimAdvance(EEPROM_SIM_STEP_NS);
+        eepromSimCount.waitNs += EEPROM_SIM_STEP_NS;
+    }
+    
+} // end static void eepromSimWait(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void eepromSimIni(void)
+ * Description: Erased memory, counters cleared.
+ *******************************************************************************/
+void eepromSimIni(void)
+{
+    memset(eepromSimMemory, EEPROM_ERASED, sizeof(eepromSimMemory));
+    memset(&eepromSimCount, 0, sizeof(eepromSimCount));
+    eepromSimDoneNs = 0;
+    
+} // end void eepromSimIni(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eepromBusy(void)
+ * Description: 1 while a write is in progress.
+ *******************************************************************************/
+uint8_t eepromBusy(void)
+{
+    return picSimNs() < eepromSimDoneNs;
+    
+} // end uint8_t eepromBusy(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t eepromRead(uint8_t address)
+ * Description: EEADR, EECON1 and EEDATA, 6 instruction cycles.
+ *******************************************************************************/
+uint8_t eepromRead(uint8_t address)
+{
+    eepromSimWait();
+    picSimAdvance(3000);
+    eepromSimCount.reads++;
+    
+    return eepromSimMemory[address];
+    
+} // end uint8_t eepromRead(uint8_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count)
+ * Description: eepromRead() loop.
+ *******************************************************************************/
+void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count)
+{
+    for (; count; count--)
+        *data++ = eepromRead(address++);
+    
+} // end void eepromReadBlock(uint8_t address, uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: void eepromWrite(uint8_t address, uint8_t value)
+ * Description: Starts a write, after the one in progress.
+ *******************************************************************************/
+void eepromWrite(uint8_t address, uint8_t value)
+{
+    eepromSimWait();
+    picSimAdvance(6000);
+    eepromSimMemory[address] = value;
+    eepromSimDoneNs = picSimNs() + EEPROM_SIM_WRITE_NS;
+    eepromSimCount.writes++;
+    
+} // end void eepromWrite(uint8_t address, uint8_t value) function
+
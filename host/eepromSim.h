@@ -0,0 +1,38 @@
+/* File:  eepromSim.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the PIC18F4550 data EEPROM (host/eepromSim.c), behind eeprom.h.
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef EEPROM_SIM_H
+#define	EEPROM_SIM_H
+
+#include <stdint.h>
+
+#ifndef EEPROM_SIM_WRITE_NS
+    #define EEPROM_SIM_WRITE_NS     4000000 // Write time, TDEW (datasheet: 4 ms typical)
+#endif
+
+typedef struct
+{
+    uint32_t reads;
+    uint32_t writes;
+    uint64_t waitNs;                    // CPU time spent waiting for a write in progress
+}eepromSimStats;
+
+extern uint8_t eepromSimMemory[];
+extern eepromSimStats eepromSimCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void eepromSimIni(void);
+
+#endif	/* EEPROM_SIM_H */
+
@@ -0,0 +1,108 @@
+/* File:  flashSim.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host replacement of flash.c: 32 Kbytes of program memory in an array. An erase
+ * or a write stalls the virtual CPU for FLASH_SIM_STALL_NS, with GIE off as on the PIC, while the
+ * MCP2515 model and picSimHook keep running. A write only clears bits, as on the part, and
+ * blocks below flashSimProtect are write protected (WRTB, WRT0).
+ * 
+ * Environment: gcc (host), see host/bootHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <string.h>
+#include "picSim.h"
+#include "flashSim.h"
+#include "../flash.h"
+
+#define FLASH_SIM_STEP_NS       20000   // Clock step while stalled
+
+uint8_t flashSimMemory[FLASH_SIZE];
+uint16_t flashSimProtect;
+flashSimStats flashSimCount;
+
+
+/*******************************************************************************
+ * FUNCTION: static void flashSimStall(void)
+ * Description: CPU stall of an erase or a write, GIE off.
+ *******************************************************************************/
+static void flashSimStall(void)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    INTCONbits.GIE = 0;
+    for (uint32_t ns = 0; ns < FLASH_SIM_STALL_NS; ns += FLASH_SIM_STEP_NS)
+        picSimAdvance(FLASH_SIM_STEP_NS);
+    INTCONbits.GIE = gie;
+    flashSimCount.stallNs += FLASH_SIM_STALL_NS;
+    
+} // end static void flashSimStall(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashSimIni(void)
+ * Description: Erased memory, no protection, counters cleared.
+ *******************************************************************************/
+void flashSimIni(void)
+{
+    memset(flashSimMemory, FLASH_ERASED, sizeof(flashSimMemory));
+    flashSimProtect = 0;
+    memset(&flashSimCount, 0, sizeof(flashSimCount));
+    
+} // end void flashSimIni(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashRead(uint16_t address, uint8_t *data, uint8_t count)
+ * Description: TBLRD*+ loop, 4 instruction cycles per byte.
+ *******************************************************************************/
+void flashRead(uint16_t address, uint8_t *data, uint8_t count)
+{
+    picSimAdvance((uint32_t)count * 2000);
+    for (; count; count--)
+        *data++ = flashSimMemory[address++ & (FLASH_SIZE - 1)];
+    
+} // end void flashRead(uint16_t address, uint8_t *data, uint8_t count) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashErase(uint16_t address)
+ * Description: Erases the 64 byte block holding (address).
+ *******************************************************************************/
+void flashErase(uint16_t address)
+{
+    address &= (FLASH_SIZE - 1) & ~(FLASH_ERASE_SIZE - 1);
+    if (address < flashSimProtect)
+        flashSimCount.protectedWrites++;
+    else
+        memset(&flashSimMemory[address], FLASH_ERASED, FLASH_ERASE_SIZE);
+    flashSimCount.erases++;
+    flashSimStall();
+    
+} // end void flashErase(uint16_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void flashWrite(uint16_t address, const uint8_t *data)
+ * Description: Writes the 32 byte block at (address); a bit is only cleared.
+ *******************************************************************************/
+void flashWrite(uint16_t address, const uint8_t *data)
+{
+    address &= (FLASH_SIZE - 1) & ~(FLASH_WRITE_SIZE - 1);
+    if (address < flashSimProtect)
+        flashSimCount.protectedWrites++;
+    else
+    {
+        for (uint8_t i = 0; i < FLASH_WRITE_SIZE; i++)
+            flashSimMemory[address + i] &= data[i];
+    }
+    flashSimCount.writes++;
+    flashSimStall();
+    
+} // end void flashWrite(uint16_t address, const uint8_t *data) function
+
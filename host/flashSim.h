@@ -0,0 +1,40 @@
+/* File:  flashSim.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the PIC18F4550 program memory (host/flashSim.c), behind flash.h.
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef FLASH_SIM_H
+#define	FLASH_SIM_H
+
+#include <stdint.h>
+
+#ifndef FLASH_SIM_STALL_NS
+    #define FLASH_SIM_STALL_NS      2000000 // Erase or write time, TIW (datasheet: 2 ms typical)
+#endif
+
+typedef struct
+{
+    uint32_t erases;
+    uint32_t writes;
+    uint32_t protectedWrites;           // Erases and writes refused below flashSimProtect
+    uint64_t stallNs;                   // CPU time spent stalled
+}flashSimStats;
+
+extern uint8_t flashSimMemory[];
+extern uint16_t flashSimProtect;        // Write protected below this address
+extern flashSimStats flashSimCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void flashSimIni(void);
+
+#endif	/* FLASH_SIM_H */
+
@@ -0,0 +1,544 @@
+/* File:  mcp2515Sim.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the MCP2515 (datasheet DS20001801J). Enough of the chip for the
+ * driver in can.c: the SPI instructions, immediate mode changes, TXREQ arbitration by TXP and
+ * buffer number, frame time from CNF1..CNF3 (nominal length, no stuff bits), filters and masks
+ * for standard and extended identifiers (not the data byte filtering), BUKT rollover, RXnOVR, loopback, and the INT (RB2) and RXnBF (RD0,
+ * RD1) pins, and the SOF signal on CLKOUT (RC2/CCP1). Frames from other nodes are queued with
+ * mcp2515SimInject(), received in normal and listen-only mode. In normal mode every transmission
+ * is acknowledged; error states and one shot mode are not modelled. With mcp2515SimBusBitNs set,
+ * the other nodes send at that bit time and a node at another bit rate only sees MERRF.
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <string.h>
+#include "../REGS2515.h"
+#include "mcp2515Sim.h"
+#include "picSim.h"
+
+#define SIM_INJECT_SIZE     64
+
+// Interrupt flags as in the datasheet (REGS2515.h has TX1IF/TX1IE wrong).
+#define SIM_RXIF(n)         (0x01 << (n))
+#define SIM_TXIF(n)         (0x04 << (n))
+#define SIM_ERRIF           0x20
+#define SIM_RXOVR(n)        (0x40 << (n))
+
+static uint8_t simReg[128];
+static uint8_t simState;                // Byte of the current instruction
+static uint8_t simInstruction;
+static uint8_t simAddress;
+static uint8_t simMask;
+static uint8_t simRxRead;               // READ RX BUFFER of RXBn + 1, cleared on CS rise
+
+static uint64_t simNow;
+static uint64_t simBusEnd;              // Frame on the bus until this time
+static int8_t simTxBuffer = -1;         // TX buffer on the bus, -1 none, -2 injected frame
+static mcp2515SimFrame simBusFrame;
+
+static mcp2515SimFrame simInject[SIM_INJECT_SIZE];
+static uint8_t simInjectHead;
+static uint8_t simInjectCount;
+
+mcp2515SimStats mcp2515SimCount;
+uint32_t mcp2515SimBusBitNs;
+void (*mcp2515SimTxHook)(const mcp2515SimFrame *frame, uint64_t endNs);
+void (*mcp2515SimRxHook)(const mcp2515SimFrame *frame, uint64_t endNs);
+void (*mcp2515SimStartHook)(const mcp2515SimFrame *frame, uint64_t startNs);
+
+
+/*******************************************************************************
+ * FUNCTION: static void simReset(void)
+ * Description: Power on / RESET instruction values; configuration mode.
+ *******************************************************************************/
+static void simReset(void)
+{
+    memset(simReg, 0, sizeof(simReg));
+    simReg[CANSTAT] = OPMODE_CONFIG;
+    simReg[CANCTRL] = 0x87;
+    simTxBuffer = -1;
+    simBusEnd = simNow;
+    
+} // end static void simReset(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void simPins(void)
+ * Description: Drives INT (RB2/INT2, active low) from CANINTE/CANINTF, setting INT2IF on the edge
+ * selected by INTEDG2, and the RXnBF pins (RD0/RD1) when BFPCTRL enables them as buffer full
+ * interrupts.
+ *******************************************************************************/
+static void simPins(void)
+{
+    uint8_t flags = simReg[CANINTF];
+    uint8_t bfp = simReg[BFPCTRL];
+    
+    uint8_t level = (flags & simReg[CANINTE]) ? 0 : 1;
+    
+    // INT2 edge, INTEDG2 = 0: falling.
+    if (PORTBbits.RB2 != level && INTCON2bits.INTEDG2 == level)
+        INTCON3bits.INT2IF = 1;
+    PORTBbits.RB2 = level;
+    
+    if ((bfp & (B0BFE | B0BFM)) == (B0BFE | B0BFM))
+        PORTDbits.RD0 = (flags & SIM_RXIF(0)) ? 0 : 1;
+    if ((bfp & (B1BFE | B1BFM)) == (B1BFE | B1BFM))
+        PORTDbits.RD1 = (flags & SIM_RXIF(1)) ? 0 : 1;
+    
+} // end static void simPins(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t simStatus(void)
+ * Description: READ STATUS byte.
+ *******************************************************************************/
+static uint8_t simStatus(void)
+{
+    uint8_t flags = simReg[CANINTF];
+    uint8_t status = flags & (SIM_RXIF(0) | SIM_RXIF(1));
+    
+    for (uint8_t n = 0; n < 3; n++)
+    {
+        if (simReg[TXB_BASE(n)] & TXREQ)
+            status |= 0x04 << (n << 1);
+        if (flags & SIM_TXIF(n))
+            status |= 0x08 << (n << 1);
+    }
+    
+    return status;
+    
+} // end static uint8_t simStatus(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void simWrite(uint8_t address, uint8_t data, uint8_t mask)
+ * Description: Register write (WRITE, BIT MODIFY, LOAD TX BUFFER). CANSTAT and CANCTRL appear
+ * at xEh/xFh of every row; a new REQOP takes effect at once.
+ *******************************************************************************/
+static void simWrite(uint8_t address, uint8_t data, uint8_t mask)
+{
+    address &= 0x7F;
+    if ((address & 0x0F) >= 0x0E)
+        address &= 0x0F;
+    
+    if (address == CANSTAT)
+        return;
+    
+    simReg[address] = (simReg[address] & ~mask) | (data & mask);
+    
+    if (address == CANCTRL)
+    {
+        simReg[CANSTAT] = (simReg[CANSTAT] & ~REQOP) | (simReg[CANCTRL] & REQOP);
+        if (simReg[CANCTRL] & ABAT)
+        {
+            for (uint8_t n = 0; n < 3; n++)
+                simReg[TXB_BASE(n)] &= ~TXREQ;
+        }
+    }
+    
+    if (address == CANINTF || address == CANINTE || address == BFPCTRL)
+        simPins();
+    
+} // end static void simWrite(uint8_t address, uint8_t data, uint8_t mask) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t simRead(uint8_t address)
+ * Description: Register read, with the CANSTAT/CANCTRL mirrors.
+ *******************************************************************************/
+static uint8_t simRead(uint8_t address)
+{
+    address &= 0x7F;
+    if ((address & 0x0F) >= 0x0E)
+        address &= 0x0F;
+    
+    return simReg[address];
+    
+} // end static uint8_t simRead(uint8_t address) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515SimSelect(uint8_t selected)
+ * Description: Chip select. A falling edge starts an instruction, a rising edge ends it and
+ * clears RXnIF after READ RX BUFFER.
+ *******************************************************************************/
+void mcp2515SimSelect(uint8_t selected)
+{
+    if (!selected && simRxRead)
+    {
+        simReg[CANINTF] &= ~SIM_RXIF(simRxRead - 1);
+        mcp2515SimCount.unloaded++;
+        simPins();
+    }
+    
+    simState = 0;
+    simRxRead = 0;
+    
+} // end void mcp2515SimSelect(uint8_t selected) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515SimExchange(uint8_t data)
+ * Description: One SPI byte while selected: returns the byte clocked out on SO.
+ *******************************************************************************/
+uint8_t mcp2515SimExchange(uint8_t data)
+{
+    uint8_t out = 0xFF;
+    
+    if (simState == 0)
+    {
+        simInstruction = data;
+        simState = 1;
+        
+        if (data == CAN_RESET)
+        {
+            simReset();
+            simPins();
+        }
+        else if ((data & 0xF8) == 0x80)           // RTS
+        {
+            for (uint8_t n = 0; n < 3; n++)
+            {
+                if (data & (1 << n))
+                    simReg[TXB_BASE(n)] |= TXREQ;
+            }
+        }
+        else if ((data & 0xF8) == 0x40)           // LOAD TX BUFFER
+        {
+            simAddress = TXB_BASE(data >> 1 & 0x03) + ((data & 0x01) ? BUF_D0 : BUF_SIDH);
+            simState = 3;
+        }
+        else if ((data & 0xF9) == 0x90)           // READ RX BUFFER
+        {
+            simAddress = RXB_BASE(data >> 2 & 0x01) + ((data & 0x02) ? BUF_D0 : BUF_SIDH);
+            simRxRead = (data >> 2 & 0x01) + 1;
+            simState = 4;
+        }
+        
+        return out;
+    }
+    
+    switch (simInstruction)
+    {
+        case CAN_READ:
+        case CAN_WRITE:
+        case CAN_BIT_MODIFY:
+            if (simState == 1)
+            {
+                simAddress = data;
+                simState = 2;
+            }
+            else if (simInstruction == CAN_READ)
+                out = simRead(simAddress++);
+            else if (simInstruction == CAN_WRITE)
+                simWrite(simAddress++, data, 0xFF);
+            else if (simState == 2)
+            {
+                simMask = data;
+                simState = 5;
+            }
+            else if (simState == 5)
+            {
+                simWrite(simAddress, data, simMask);
+                simState = 6;
+            }
+            break;
+            
+        case CAN_RD_STATUS:
+            out = simStatus();
+            break;
+            
+        case CAN_RX_STATUS:
+            out = ((simReg[CANINTF] & 0x03) << 6) | (simReg[RXB0CTRL] & 0x07);
+            break;
+            
+        default:
+            if (simState == 3)
+                simReg[simAddress++ & 0x7F] = data;
+            else if (simState == 4)
+                out = simReg[simAddress++ & 0x7F];
+            break;
+    }
+    
+    return out;
+    
+} // end uint8_t mcp2515SimExchange(uint8_t data) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint32_t mcp2515SimBitNs(void)
+ * Description: Bit time from CNF1..CNF3: (SYNC + PRSEG + PHSEG1 + PHSEG2) x TQ,
+ * TQ = 2 x (BRP + 1) x TOSC.
+ *******************************************************************************/
+uint32_t mcp2515SimBitNs(void)
+{
+    uint8_t cnf1 = simReg[CNF1];
+    uint8_t cnf2 = simReg[CNF2];
+    uint8_t cnf3 = simReg[CNF3];
+    uint32_t quanta = 1 + ((cnf2 & 0x07) + 1) + ((cnf2 >> 3 & 0x07) + 1) + ((cnf3 & 0x07) + 1);
+    
+    return quanta * 2 * ((cnf1 & BRP) + 1) * MCP2515_SIM_OSC_NS;
+    
+} // end uint32_t mcp2515SimBitNs(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t simIdentifier(uint8_t base)
+ * Description: 29 bit identifier of the SIDH/SIDL/EID8/EID0 registers at (base), standard
+ * identifier in bits 28..18.
+ *******************************************************************************/
+static uint32_t simIdentifier(uint8_t base)
+{
+    return ((uint32_t)simReg[base] << 21) | ((uint32_t)(simReg[base + 1] >> 5) << 18)
+           | ((uint32_t)(simReg[base + 1] & 0x03) << 16) | ((uint16_t)simReg[base + 2] << 8)
+           | simReg[base + 3];
+    
+} // end static uint32_t simIdentifier(uint8_t base) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t simAccept(uint8_t rxb, const mcp2515SimFrame *frame)
+ * Description: Acceptance test of RXBn: RXM = 11 takes everything, otherwise the identifier
+ * must match one of the buffer filters (RXF0/1 or RXF2..5) of the same type under its mask.
+ *******************************************************************************/
+static uint8_t simAccept(uint8_t rxb, const mcp2515SimFrame *frame)
+{
+    static const uint8_t filters[2][4] = {{0, 1, 0xFF, 0xFF}, {2, 3, 4, 5}};
+    uint32_t mask;
+    uint32_t id;
+    
+    if ((simReg[RXB_BASE(rxb)] & RXM) == RXM)
+        return 1;
+    
+    mask = simIdentifier(RXMn_BASE(rxb));
+    if (frame->extended)
+        id = frame->id;
+    else
+    {
+        id = frame->id << 18;
+        mask &= 0x1FFC0000;
+    }
+    
+    for (uint8_t i = 0; i < 4 && filters[rxb][i] != 0xFF; i++)
+    {
+        uint8_t base = RXFn_BASE(filters[rxb][i]);
+        
+        if (((simReg[base + 1] & EXIDE_SET) != 0) == (frame->extended != 0)
+            && ((simIdentifier(base) ^ id) & mask) == 0)
+            return 1;
+    }
+    
+    return 0;
+    
+} // end static uint8_t simAccept(uint8_t rxb, const mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void simReceive(const mcp2515SimFrame *frame)
+ * Description: Stores a frame from the bus in RXB0, RXB1 (directly or by BUKT rollover), or
+ * flags RXnOVR when the target buffer is still full.
+ *******************************************************************************/
+static void simReceive(const mcp2515SimFrame *frame)
+{
+    int8_t rxb = -1;
+    uint8_t base;
+    
+    if (simAccept(0, frame))
+    {
+        if (!(simReg[CANINTF] & SIM_RXIF(0)))
+            rxb = 0;
+        else if ((simReg[RXB0CTRL] & BUKT) && !(simReg[CANINTF] & SIM_RXIF(1)))
+            rxb = 1;
+        else
+        {
+            simReg[EFLG] |= SIM_RXOVR(0);
+            simReg[CANINTF] |= SIM_ERRIF;
+            mcp2515SimCount.overflow[0]++;
+        }
+    }
+    else if (simAccept(1, frame))
+    {
+        if (!(simReg[CANINTF] & SIM_RXIF(1)))
+            rxb = 1;
+        else
+        {
+            simReg[EFLG] |= SIM_RXOVR(1);
+            simReg[CANINTF] |= SIM_ERRIF;
+            mcp2515SimCount.overflow[1]++;
+        }
+    }
+    
+    if (rxb >= 0)
+    {
+        base = RXB_BASE(rxb);
+        if (frame->extended)
+        {
+            simReg[base + BUF_SIDH] = frame->id >> 21;
+            simReg[base + BUF_SIDL] = ((frame->id >> 13) & 0xE0) | EXIDE_SET | ((frame->id >> 16) & 0x03);
+            simReg[base + BUF_EID8] = frame->id >> 8;
+            simReg[base + BUF_EID0] = frame->id;
+            simReg[base + BUF_DLC] = frame->dlc & (DLC_RTR | 0x0F);
+        }
+        else
+        {
+            simReg[base + BUF_SIDH] = frame->id >> 3;
+            simReg[base + BUF_SIDL] = (frame->id << 5) | ((frame->dlc & DLC_RTR) ? SIDL_SRR : 0);
+            simReg[base + BUF_EID8] = 0;
+            simReg[base + BUF_EID0] = 0;
+            simReg[base + BUF_DLC] = frame->dlc & 0x0F;
+        }
+        memcpy(&simReg[base + BUF_D0], frame->data, 8);
+        simReg[base] = (simReg[base] & ~0x08) | ((frame->dlc & DLC_RTR) ? 0x08 : 0);
+        simReg[CANINTF] |= SIM_RXIF(rxb);
+        mcp2515SimCount.received++;
+        if (mcp2515SimRxHook)
+            mcp2515SimRxHook(frame, simNow);
+    }
+    
+    simPins();
+    
+} // end static void simReceive(const mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void simStartFrame(void)
+ * Description: Bus idle: starts the pending TX buffer of highest priority (TXP, then the
+ * highest buffer number), or else the next injected frame. Nominal frame length: 47 bits
+ * (standard) or 67 bits (extended) + 8 per data byte; remote frames carry no data. With the SOF
+ * signal on CLKOUT (CNF3.SOF, CANCTRL.CLKEN) the start of frame is a CCP1 capture edge.
+ *******************************************************************************/
+static void simStartFrame(void)
+{
+    uint8_t mode = simReg[CANSTAT] & REQOP;
+    int8_t best = -1;
+    uint8_t length;
+    
+    if (mode != OPMODE_NORMAL && mode != OPMODE_LOOPBACK && mode != OPMODE_LISTEN)
+        return;
+    
+    for (int8_t n = 2; n >= 0 && mode != OPMODE_LISTEN; n--)
+    {
+        uint8_t ctrl = simReg[TXB_BASE(n)];
+        
+        if ((ctrl & TXREQ) && (best < 0 || (ctrl & TXP) > (simReg[TXB_BASE(best)] & TXP)))
+            best = n;
+    }
+    
+    if (best >= 0)
+    {
+        uint8_t base = TXB_BASE(best);
+        
+        simBusFrame.extended = (simReg[base + BUF_SIDL] & EXIDE_SET) != 0;
+        simBusFrame.id = simIdentifier(base + BUF_SIDH);
+        if (!simBusFrame.extended)
+            simBusFrame.id >>= 18;
+        simBusFrame.dlc = simReg[base + BUF_DLC] & (DLC_RTR | 0x0F);
+        memcpy(simBusFrame.data, &simReg[base + BUF_D0], 8);
+        simTxBuffer = best;
+    }
+    else if (simInjectCount && mode != OPMODE_LOOPBACK)
+    {
+        simBusFrame = simInject[simInjectHead];
+        simInjectHead = (simInjectHead + 1) % SIM_INJECT_SIZE;
+        simInjectCount--;
+        simTxBuffer = -2;
+    }
+    else
+        return;
+    
+    if ((simReg[CNF3] & SOF_ENABLED) && (simReg[CANCTRL] & CLKEN))
+        picSimCapture(simNow);
+    if (mcp2515SimStartHook)
+        mcp2515SimStartHook(&simBusFrame, simNow);
+    
+    length = (simBusFrame.dlc & DLC_RTR) ? 0 : (simBusFrame.dlc & 0x0F);
+    if (length > 8)
+        length = 8;
+    simBusEnd = simNow + (uint64_t)((simBusFrame.extended ? 67 : 47) + 8 * length)
+                * ((simTxBuffer == -2 && mcp2515SimBusBitNs) ? mcp2515SimBusBitNs : mcp2515SimBitNs());
+    
+} // end static void simStartFrame(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void mcp2515SimRun(uint64_t nowNs)
+ * Description: Moves the bus up to (nowNs): completes the frame in progress and starts the
+ * next ones.
+ *******************************************************************************/
+void mcp2515SimRun(uint64_t nowNs)
+{
+    while (1)
+    {
+        if (simTxBuffer == -1)
+        {
+            simNow = (simBusEnd > simNow) ? simBusEnd : simNow;
+            if (simNow > nowNs)
+                break;
+            simStartFrame();
+            if (simTxBuffer == -1)
+                break;
+        }
+        
+        if (simBusEnd > nowNs)
+            break;
+        
+        simNow = simBusEnd;
+        if (simTxBuffer >= 0)
+        {
+            simReg[TXB_BASE(simTxBuffer)] &= ~TXREQ;
+            simReg[CANINTF] |= SIM_TXIF(simTxBuffer);
+            if ((simReg[CANSTAT] & REQOP) == OPMODE_LOOPBACK)
+                simReceive(&simBusFrame);
+            if (mcp2515SimTxHook)
+                mcp2515SimTxHook(&simBusFrame, simNow);
+        }
+        else if (mcp2515SimBusBitNs && mcp2515SimBusBitNs != mcp2515SimBitNs())
+            simReg[CANINTF] |= MERRF;
+        else
+            simReceive(&simBusFrame);
+        
+        simTxBuffer = -1;
+        simPins();
+    }
+    
+    simNow = nowNs;
+    
+} // end void mcp2515SimRun(uint64_t nowNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515SimInject(const mcp2515SimFrame *frame)
+ * Description: Queues a frame from another node; it goes on the bus when the bus is free and
+ * no TX buffer is pending. Returns 0 when the queue is full.
+ *******************************************************************************/
+uint8_t mcp2515SimInject(const mcp2515SimFrame *frame)
+{
+    if (simInjectCount == SIM_INJECT_SIZE)
+        return 0;
+    
+    simInject[(simInjectHead + simInjectCount) % SIM_INJECT_SIZE] = *frame;
+    simInjectCount++;
+    
+    return 1;
+    
+} // end uint8_t mcp2515SimInject(const mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t mcp2515SimRegister(uint8_t address)
+ * Description: Register value, for checks from the host program.
+ *******************************************************************************/
+uint8_t mcp2515SimRegister(uint8_t address)
+{
+    return simRead(address);
+    
+} // end uint8_t mcp2515SimRegister(uint8_t address) function
+
@@ -0,0 +1,58 @@
+/* File:  mcp2515Sim.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the MCP2515: registers, SPI instructions, operation modes, 
+ * transmission with bus timing, acceptance filters, loopback and the INT and RXnBF pins.
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef MCP2515_SIM_H
+#define	MCP2515_SIM_H
+
+#include <stdint.h>
+
+#define MCP2515_SIM_OSC_NS      125     // 8 MHz crystal, as on the FATEC board
+
+// Frame seen on the simulated bus.
+typedef struct
+{
+    uint32_t id;                        // 11 or 29 bit identifier
+    uint8_t extended;
+    uint8_t dlc;                        // Data length, plus 0x40 for a remote frame
+    uint8_t data[8];
+}mcp2515SimFrame;
+
+// Receive side counters.
+typedef struct
+{
+    uint32_t received;                  // Frames stored in RXB0/RXB1
+    uint32_t overflow[2];               // Frames lost on a full RXBn (RXnOVR)
+    uint32_t unloaded;                  // READ RX BUFFER instructions completed
+}mcp2515SimStats;
+
+extern mcp2515SimStats mcp2515SimCount;
+extern uint32_t mcp2515SimBusBitNs;     // Bit time of the other nodes, 0: the node's
+
+// Called for every frame the MCP2515 puts on the bus, at the end of the frame.
+extern void (*mcp2515SimTxHook)(const mcp2515SimFrame *frame, uint64_t endNs);
+// Called for every frame stored in a receive buffer.
+extern void (*mcp2515SimRxHook)(const mcp2515SimFrame *frame, uint64_t endNs);
+// Called at the start of frame of every frame on the bus, sent or injected.
+extern void (*mcp2515SimStartHook)(const mcp2515SimFrame *frame, uint64_t startNs);
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+void mcp2515SimSelect(uint8_t selected);
+uint8_t mcp2515SimExchange(uint8_t data);
+void mcp2515SimRun(uint64_t nowNs);
+uint8_t mcp2515SimInject(const mcp2515SimFrame *frame);
+uint32_t mcp2515SimBitNs(void);
+uint8_t mcp2515SimRegister(uint8_t address);
+
+#endif	/* MCP2515_SIM_H */
@@ -0,0 +1,125 @@
+/* File:  picLinux.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: The PIC18F4550 around the firmware modules run in real time on Linux, with
+ * canSocket.c in place of the driver: the registers they touch are plain variables, Timer1 and
+ * Timer0 count the monotonic clock, delayMS()/delayUS() sleep (delayMy.c on the target). There
+ * is no interrupt: isrDefer() does the work at once, its caller being the main program already.
+ * 
+ * Environment: gcc (host, Linux), see host/canSocketHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <time.h>
+#include "../hardware.h"
+#include "../busLoad.h"
+
+#define PIC_SFR_DEFINE(name)        volatile uint8_t name;
+#define PIC_SFR_BITS_DEFINE(name)   volatile name##bits_t name##bits;
+
+PIC_SFR_DEFINE(PORTA) PIC_SFR_DEFINE(PORTB) PIC_SFR_DEFINE(PORTC) PIC_SFR_DEFINE(PORTD)
+PIC_SFR_DEFINE(LATA) PIC_SFR_DEFINE(LATB) PIC_SFR_DEFINE(LATC) PIC_SFR_DEFINE(LATD)
+PIC_SFR_DEFINE(TRISA) PIC_SFR_DEFINE(TRISB) PIC_SFR_DEFINE(TRISC) PIC_SFR_DEFINE(TRISD) PIC_SFR_DEFINE(TRISE)
+PIC_SFR_DEFINE(OSCCON) PIC_SFR_DEFINE(SSPSTAT) PIC_SFR_DEFINE(SSPCON1) PIC_SFR_DEFINE(SSPBUF)
+PIC_SFR_DEFINE(ADCON0) PIC_SFR_DEFINE(ADCON1) PIC_SFR_DEFINE(ADCON2) PIC_SFR_DEFINE(ADRESH) PIC_SFR_DEFINE(ADRESL)
+PIC_SFR_DEFINE(INTCON) PIC_SFR_DEFINE(INTCON2) PIC_SFR_DEFINE(INTCON3) PIC_SFR_DEFINE(RCON)
+PIC_SFR_DEFINE(PIR1) PIC_SFR_DEFINE(PIR2) PIC_SFR_DEFINE(PIE1) PIC_SFR_DEFINE(PIE2) PIC_SFR_DEFINE(IPR1) PIC_SFR_DEFINE(IPR2)
+PIC_SFR_DEFINE(T0CON) PIC_SFR_DEFINE(T1CON) PIC_SFR_DEFINE(T3CON) PIC_SFR_DEFINE(TMR0H) PIC_SFR_DEFINE(TMR1H)
+PIC_SFR_DEFINE(TMR3L) PIC_SFR_DEFINE(TMR3H) PIC_SFR_DEFINE(CCP1CON) PIC_SFR_DEFINE(CCPR1L) PIC_SFR_DEFINE(CCPR1H)
+PIC_SFR_DEFINE(CCP2CON) PIC_SFR_DEFINE(CCPR2L) PIC_SFR_DEFINE(CCPR2H)
+PIC_SFR_DEFINE(EECON1) PIC_SFR_DEFINE(EECON2) PIC_SFR_DEFINE(EEADR) PIC_SFR_DEFINE(EEDATA)
+
+PIC_SFR_BITS_DEFINE(PORTA) PIC_SFR_BITS_DEFINE(PORTB) PIC_SFR_BITS_DEFINE(PORTC) PIC_SFR_BITS_DEFINE(PORTD)
+PIC_SFR_BITS_DEFINE(LATA) PIC_SFR_BITS_DEFINE(LATB) PIC_SFR_BITS_DEFINE(LATC) PIC_SFR_BITS_DEFINE(LATD)
+PIC_SFR_BITS_DEFINE(TRISA) PIC_SFR_BITS_DEFINE(TRISB) PIC_SFR_BITS_DEFINE(TRISC) PIC_SFR_BITS_DEFINE(TRISD)
+PIC_SFR_BITS_DEFINE(PIR1) PIC_SFR_BITS_DEFINE(PIE1) PIC_SFR_BITS_DEFINE(IPR1) PIC_SFR_BITS_DEFINE(PIR2) PIC_SFR_BITS_DEFINE(PIE2) PIC_SFR_BITS_DEFINE(IPR2)
+PIC_SFR_BITS_DEFINE(INTCON) PIC_SFR_BITS_DEFINE(INTCON2) PIC_SFR_BITS_DEFINE(INTCON3) PIC_SFR_BITS_DEFINE(SSPSTAT)
+PIC_SFR_BITS_DEFINE(RCON) PIC_SFR_BITS_DEFINE(EECON1) PIC_SFR_BITS_DEFINE(T1CON)
+
+static volatile uint8_t picTmr1l;
+static volatile uint8_t picTmr0l;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint64_t picLinuxNs(void)
+ * Description: Monotonic clock, ns.
+ *******************************************************************************/
+static uint64_t picLinuxNs(void)
+{
+    struct timespec now;
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    
+} // end static uint64_t picLinuxNs(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: volatile uint8_t *picSimTimer1(void); volatile uint8_t *picSimTimer0(void)
+ * Description: TMR1L and TMR0L accesses (see xc.h): latch the high byte and return the low byte
+ * of the 1 us Timer1 count and of the Timer0 count at the prescaler of T0CON (FOSC/4 = 2 MHz).
+ *******************************************************************************/
+volatile uint8_t *picSimTimer1(void)
+{
+    uint16_t micros = (uint16_t)(picLinuxNs() / 1000);
+    
+    TMR1H = micros >> 8;
+    picTmr1l = (uint8_t)micros;
+    
+    return &picTmr1l;
+    
+} // end volatile uint8_t *picSimTimer1(void) function
+
+volatile uint8_t *picSimTimer0(void)
+{
+    uint32_t tickNs = (T0CON & 0x08) ? 500 : (500u << ((T0CON & 0x07) + 1));
+    uint16_t ticks = (uint16_t)(picLinuxNs() / tickNs);
+    
+    TMR0H = ticks >> 8;
+    picTmr0l = (uint8_t)ticks;
+    
+    return &picTmr0l;
+    
+} // end volatile uint8_t *picSimTimer0(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void delayMS(uint16_t time); void delayUS(uint16_t time)
+ * Description: Sleeps.
+ *******************************************************************************/
+void delayMS(uint16_t time)
+{
+    struct timespec wait = { time / 1000, (long)(time % 1000) * 1000000 };
+    
+    nanosleep(&wait, 0);
+    
+} // end void delayMS(uint16_t time) function
+
+void delayUS(uint16_t time)
+{
+    struct timespec wait = { 0, (long)time * 1000 };
+    
+    nanosleep(&wait, 0);
+    
+} // end void delayUS(uint16_t time) function
+
+
+/*******************************************************************************
+ * FUNCTION: void isrDefer(uint8_t work)
+ * Description: The work of isrLow() (hardware.c), done at once.
+ *******************************************************************************/
+void isrDefer(uint8_t work)
+{
+#if BUS_LOAD
+    if (work & ISR_DEFER_BUS_LOAD)
+        busLoadService();
+#endif
+    (void)work;
+    
+} // end void isrDefer(uint8_t work) function
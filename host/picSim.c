@@ -0,0 +1,337 @@
+/* File:  picSim.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the PIC18F4550 around the firmware. Time is virtual: it moves
+ * only with SPI bytes (spiSim.c), Timer1 reads and delays, so CPU time is not counted. After
+ * every step the MCP2515 model runs up to the new time (it drives MCP_INT and INT2IF) and isr()
+ * or isrLow() is called like the hardware would, by priority (RCON.IPEN): a high priority source
+ * runs isr() with GIEH set, also inside isrLow(); a low priority one runs isrLow() with GIEH and
+ * GIEL set, outside both. The time from the INT2 flag to isr() is the interrupt latency, made of
+ * the sections that keep the interrupt out (GIE or INT2IE off, isr() busy): instruction time is
+ * not simulated. delayMS()/delayUS() replace delayMy.c.
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define PIC_SFR_DEFINE(name)        volatile uint8_t name;
+#define PIC_SFR_BITS_DEFINE(name)   volatile name##bits_t name##bits;
+
+PIC_SFR_DEFINE(PORTA) PIC_SFR_DEFINE(PORTB) PIC_SFR_DEFINE(PORTC) PIC_SFR_DEFINE(PORTD)
+PIC_SFR_DEFINE(LATA) PIC_SFR_DEFINE(LATB) PIC_SFR_DEFINE(LATC) PIC_SFR_DEFINE(LATD)
+PIC_SFR_DEFINE(TRISA) PIC_SFR_DEFINE(TRISB) PIC_SFR_DEFINE(TRISC) PIC_SFR_DEFINE(TRISD) PIC_SFR_DEFINE(TRISE)
+PIC_SFR_DEFINE(OSCCON) PIC_SFR_DEFINE(SSPSTAT) PIC_SFR_DEFINE(SSPCON1) PIC_SFR_DEFINE(SSPBUF)
+PIC_SFR_DEFINE(ADCON0) PIC_SFR_DEFINE(ADCON1) PIC_SFR_DEFINE(ADCON2) PIC_SFR_DEFINE(ADRESH) PIC_SFR_DEFINE(ADRESL)
+PIC_SFR_DEFINE(INTCON) PIC_SFR_DEFINE(INTCON2) PIC_SFR_DEFINE(INTCON3) PIC_SFR_DEFINE(RCON)
+PIC_SFR_DEFINE(PIR1) PIC_SFR_DEFINE(PIR2) PIC_SFR_DEFINE(PIE1) PIC_SFR_DEFINE(PIE2) PIC_SFR_DEFINE(IPR1) PIC_SFR_DEFINE(IPR2)
+PIC_SFR_DEFINE(T0CON) PIC_SFR_DEFINE(T1CON) PIC_SFR_DEFINE(T3CON) PIC_SFR_DEFINE(TMR0H) PIC_SFR_DEFINE(TMR1H)
+PIC_SFR_DEFINE(TMR3L) PIC_SFR_DEFINE(TMR3H) PIC_SFR_DEFINE(CCP1CON) PIC_SFR_DEFINE(CCPR1L) PIC_SFR_DEFINE(CCPR1H)
+PIC_SFR_DEFINE(CCP2CON) PIC_SFR_DEFINE(CCPR2L) PIC_SFR_DEFINE(CCPR2H)
+PIC_SFR_DEFINE(EECON1) PIC_SFR_DEFINE(EECON2) PIC_SFR_DEFINE(EEADR) PIC_SFR_DEFINE(EEDATA)
+
+PIC_SFR_BITS_DEFINE(PORTA) PIC_SFR_BITS_DEFINE(PORTB) PIC_SFR_BITS_DEFINE(PORTC) PIC_SFR_BITS_DEFINE(PORTD)
+PIC_SFR_BITS_DEFINE(LATA) PIC_SFR_BITS_DEFINE(LATB) PIC_SFR_BITS_DEFINE(LATC) PIC_SFR_BITS_DEFINE(LATD)
+PIC_SFR_BITS_DEFINE(TRISA) PIC_SFR_BITS_DEFINE(TRISB) PIC_SFR_BITS_DEFINE(TRISC) PIC_SFR_BITS_DEFINE(TRISD)
+PIC_SFR_BITS_DEFINE(PIR1) PIC_SFR_BITS_DEFINE(PIE1) PIC_SFR_BITS_DEFINE(IPR1) PIC_SFR_BITS_DEFINE(PIR2) PIC_SFR_BITS_DEFINE(PIE2) PIC_SFR_BITS_DEFINE(IPR2)
+PIC_SFR_BITS_DEFINE(INTCON) PIC_SFR_BITS_DEFINE(INTCON2) PIC_SFR_BITS_DEFINE(INTCON3) PIC_SFR_BITS_DEFINE(SSPSTAT)
+PIC_SFR_BITS_DEFINE(RCON) PIC_SFR_BITS_DEFINE(EECON1) PIC_SFR_BITS_DEFINE(T1CON)
+
+static uint64_t picNs;
+static uint8_t picInIsr;                // 0: main program, 1: isrLow(), 2: isr()
+static uint64_t picInt2Ns;              // INT2IF seen set at this time, 0: clear
+static uint64_t picLatencyMax;
+static uint64_t picLatencySum;
+static uint32_t picLatencyCount;
+static volatile uint8_t picTmr1l;
+static volatile uint8_t picTmr0l;
+static uint64_t picTmr1Wraps;
+static uint64_t picTmr3Ns;              // Next CCP2 special event trigger, 0: off
+static uint64_t picAdcNs;               // End of the running A/D conversion, 0: idle
+static uint64_t picAdcSampleNs;
+static uint8_t picAdcChannel;
+
+void (*picSimHook)(uint64_t nowNs);
+int32_t picSimPpm;
+uint16_t (*picSimAdcHook)(uint8_t channel, uint64_t ns);
+
+
+/*******************************************************************************
+ * FUNCTION: static uint64_t picSimLocalNs(uint64_t ns)
+ * Description: Time (ns) on the clock of the PIC, off by picSimPpm: the timers count it.
+ *******************************************************************************/
+static uint64_t picSimLocalNs(uint64_t ns)
+{
+    return ns + (uint64_t)(((int64_t)ns * picSimPpm) / 1000000);
+    
+} // end static uint64_t picSimLocalNs(uint64_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void picSimAdcStart(uint64_t ns)
+ * Description: A/D conversion from (ns): the acquisition time of ADCON2.ACQT, the input sampled
+ * at its end, then 11 TAD. TAD comes from ADCON2.ADCS (the RC clock taken as 1 us).
+ *******************************************************************************/
+static void picSimAdcStart(uint64_t ns)
+{
+    static const uint8_t acqt[8] = {0, 2, 4, 6, 8, 12, 16, 20};
+    static const uint8_t adcs[8] = {2, 8, 32, 8, 4, 16, 64, 8};
+    uint32_t tadNs = adcs[ADCON2 & 0x07] * 125;
+    
+    ADCON0 |= 0x02;
+    picAdcChannel = (ADCON0 >> 2) & 0x0F;
+    picAdcSampleNs = ns + (uint64_t)acqt[(ADCON2 >> 3) & 0x07] * tadNs;
+    picAdcNs = picAdcSampleNs + 11 * tadNs;
+    
+} // end static void picSimAdcStart(uint64_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void picSimAdc(void)
+ * Description: Timer3 and CCP2 in special event trigger mode (CCP2CON = 0x0B): every CCPR2 + 1
+ * Timer3 ticks CCP2IF is set and, with ADON and the A/D idle, a conversion starts. GO set by
+ * the firmware starts one too, GO cleared aborts it. At the end ADRES takes picSimAdcHook(), GO
+ * clears, ADIF is set.
+ *******************************************************************************/
+static void picSimAdc(void)
+{
+    uint32_t periodNs;
+    uint16_t value;
+    
+    if (picAdcNs && !(ADCON0 & 0x02))
+        picAdcNs = 0;
+    
+    if ((T3CON & 0x01) && (CCP2CON & 0x0F) == 0x0B)
+    {
+        periodNs = (((uint32_t)CCPR2H << 8 | CCPR2L) + 1) * (500u << ((T3CON >> 4) & 0x03));
+        if (!picTmr3Ns)
+            picTmr3Ns = picNs + periodNs;
+        while (picNs >= picTmr3Ns)
+        {
+            PIR2bits.CCP2IF = 1;
+            if ((ADCON0 & 0x01) && !picAdcNs)
+                picSimAdcStart(picTmr3Ns);
+            picTmr3Ns += periodNs;
+        }
+    }
+    else
+        picTmr3Ns = 0;
+    
+    if ((ADCON0 & 0x03) == 0x03 && !picAdcNs)
+        picSimAdcStart(picNs);
+    
+    if (picAdcNs && picNs >= picAdcNs)
+    {
+        value = picSimAdcHook ? picSimAdcHook(picAdcChannel, picAdcSampleNs) & 0x3FF : 0;
+        if (ADCON2 & 0x80)
+        {
+            ADRESH = value >> 8;
+            ADRESL = (uint8_t)value;
+        }
+        else
+        {
+            ADRESH = value >> 2;
+            ADRESL = (uint8_t)(value << 6);
+        }
+        ADCON0 &= ~0x02;
+        PIR1bits.ADIF = 1;
+        picAdcNs = 0;
+    }
+    
+} // end static void picSimAdc(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void picSimAdvance(uint32_t ns)
+ * Description: Moves the virtual clock, runs the MCP2515 model and the host side (picSimHook)
+ * and dispatches the interrupt.
+ *******************************************************************************/
+void picSimAdvance(uint32_t ns)
+{
+    uint8_t level = picInIsr;
+    uint8_t int2;
+    uint8_t ssp;
+    uint8_t tmr3;
+    uint8_t ccp1;
+    uint8_t tmr1;
+    uint8_t adc;
+    uint8_t high;
+    uint8_t low;
+    uint64_t wraps;
+    
+    picNs += ns;
+    mcp2515SimRun(picNs);
+    if (picSimHook)
+        picSimHook(picNs);
+    
+    wraps = picSimLocalNs(picNs) / 1000 >> 16;
+    if (wraps != picTmr1Wraps)
+    {
+        picTmr1Wraps = wraps;
+        if (T1CON & 0x01)
+            PIR1bits.TMR1IF = 1;
+    }
+    picSimAdc();
+    
+    if (!INTCON3bits.INT2IF)
+        picInt2Ns = 0;
+    else if (!picInt2Ns)
+        picInt2Ns = picNs;
+    
+    int2 = INTCON3bits.INT2IE && INTCON3bits.INT2IF;
+    ssp = PIE1bits.SSPIE && PIR1bits.SSPIF;
+    tmr3 = PIE2bits.TMR3IE && PIR2bits.TMR3IF;
+    ccp1 = PIE1bits.CCP1IE && PIR1bits.CCP1IF;
+    tmr1 = PIE1bits.TMR1IE && PIR1bits.TMR1IF;
+    adc = PIE1bits.ADIE && PIR1bits.ADIF;
+    if (RCONbits.IPEN)
+    {
+        high = (int2 && INTCON3bits.INT2IP) || (ssp && IPR1bits.SSPIP) || (tmr3 && IPR2bits.TMR3IP) ||
+               (ccp1 && IPR1bits.CCP1IP) || (tmr1 && IPR1bits.TMR1IP) || (adc && IPR1bits.ADIP);
+        low = (int2 && !INTCON3bits.INT2IP) || (ssp && !IPR1bits.SSPIP) || (tmr3 && !IPR2bits.TMR3IP) ||
+              (ccp1 && !IPR1bits.CCP1IP) || (tmr1 && !IPR1bits.TMR1IP) || (adc && !IPR1bits.ADIP);
+    }
+    else
+    {
+        high = int2 || ((ssp || tmr3 || ccp1 || tmr1 || adc) && INTCONbits.PEIE);
+        low = 0;
+    }
+    
+    if (INTCONbits.GIEH && high && level < 2)
+    {
+        if (int2)
+        {
+            uint64_t latency = picNs - picInt2Ns;
+    
+            picLatencySum += latency;
+            picLatencyCount++;
+            if (latency > picLatencyMax)
+                picLatencyMax = latency;
+        }
+        picInIsr = 2;
+        INTCONbits.GIEH = 0;
+        isr();
+        INTCONbits.GIEH = 1;
+        picInIsr = level;
+    }
+    else if (INTCONbits.GIEH && INTCONbits.GIEL && low && level < 1)
+    {
+        picInIsr = 1;
+        INTCONbits.GIEL = 0;
+        isrLow();
+        INTCONbits.GIEL = 1;
+        picInIsr = level;
+    }
+    
+} // end void picSimAdvance(uint32_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint64_t picSimNs(void)
+ * Description: Virtual time in nanoseconds.
+ *******************************************************************************/
+uint64_t picSimNs(void)
+{
+    return picNs;
+    
+} // end uint64_t picSimNs(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void picSimLatency(uint32_t *worstNs, uint32_t *meanNs)
+ * Description: Worst and mean time from INT2IF set to isr() servicing it.
+ *******************************************************************************/
+void picSimLatency(uint32_t *worstNs, uint32_t *meanNs)
+{
+    *worstNs = (uint32_t)picLatencyMax;
+    *meanNs = picLatencyCount ? (uint32_t)(picLatencySum / picLatencyCount) : 0;
+    
+} // end void picSimLatency(uint32_t *worstNs, uint32_t *meanNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: volatile uint8_t *picSimTimer1(void)
+ * Description: TMR1L access (see xc.h): latches TMR1H and returns the low byte of the 1 us
+ * Timer1 count (T1CON = 0x91). Writes through it are ignored. Timer1 sets TMR1IF when it wraps
+ * (picSimAdvance()).
+ *******************************************************************************/
+volatile uint8_t *picSimTimer1(void)
+{
+    uint16_t micros;
+    
+    picSimAdvance(PIC_SIM_TIMER_READ_NS);
+    micros = (uint16_t)(picSimLocalNs(picNs) / 1000);
+    TMR1H = micros >> 8;
+    picTmr1l = (uint8_t)micros;
+    
+    return &picTmr1l;
+    
+} // end volatile uint8_t *picSimTimer1(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: volatile uint8_t *picSimTimer0(void)
+ * Description: TMR0L access (see xc.h): latches TMR0H and returns the low byte of the Timer0
+ * count, 16 bit mode, at FOSC/4 (2 MHz) and the prescaler of T0CON. Writes are ignored.
+ *******************************************************************************/
+volatile uint8_t *picSimTimer0(void)
+{
+    uint32_t tickNs = (T0CON & 0x08) ? 500 : (500u << ((T0CON & 0x07) + 1));
+    uint16_t ticks;
+    
+    picSimAdvance(PIC_SIM_TIMER_READ_NS);
+    ticks = (uint16_t)(picSimLocalNs(picNs) / tickNs);
+    TMR0H = ticks >> 8;
+    picTmr0l = (uint8_t)ticks;
+    
+    return &picTmr0l;
+    
+} // end volatile uint8_t *picSimTimer0(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void picSimCapture(uint64_t ns)
+ * Description: Rising edge on RC2/CCP1 at (ns): with CCP1 in capture mode, every rising edge
+ * (CCP1CON = 0x05), CCPR1 takes Timer1 at that time and CCP1IF is set.
+ *******************************************************************************/
+void picSimCapture(uint64_t ns)
+{
+    uint16_t micros;
+    
+    if ((CCP1CON & 0x0F) != 0x05 || !TRISCbits.TRISC2)
+        return;
+    
+    micros = (uint16_t)(picSimLocalNs(ns) / 1000);
+    CCPR1H = micros >> 8;
+    CCPR1L = (uint8_t)micros;
+    PIR1bits.CCP1IF = 1;
+    
+} // end void picSimCapture(uint64_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: void delayMS(uint16_t time); void delayUS(uint16_t time)
+ * Description: Delays in virtual time (delayMy.c on the target).
+ *******************************************************************************/
+void delayMS(uint16_t time)
+{
+    for (uint16_t i = 0; i < time; i++)
+    {
+        picSimAdvance(1000000);
+    }
+    
+} // end void delayMS(uint16_t time) function
+
+void delayUS(uint16_t time)
+{
+    picSimAdvance((uint32_t)time * 1000);
+    
+} // end void delayUS(uint16_t time) function
+
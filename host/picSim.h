@@ -0,0 +1,43 @@
+/* File:  picSim.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host model of the PIC18F4550 around the firmware: registers, virtual clock,
+ * INT2 edge detection, the CCP1 capture, the A/D converter with its Timer3/CCP2 trigger and
+ * interrupt dispatch to isr() and isrLow() (hardware.c).
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef PIC_SIM_H
+#define	PIC_SIM_H
+
+#include <stdint.h>
+
+// SPI byte at FOSC/4 (SSPCON1.SSPM = 0) and 8 MHz; x4 for FOSC/16, x16 for FOSC/64.
+#define PIC_SIM_SPI_BYTE_NS     4000
+// Cost of a Timer1 read and of one pass of the delayMS()/delayUS() loops.
+#define PIC_SIM_TIMER_READ_NS   1000
+
+// Called on every clock step, after the MCP2515 model: the other nodes of a simulation.
+extern void (*picSimHook)(uint64_t nowNs);
+// Error of the PIC oscillator in ppm (the internal one is good to 1-2 %): Timer0, Timer1 and the
+// captures count the virtual time scaled by it.
+extern int32_t picSimPpm;
+// A/D input: the 10 bit result for (channel) sampled at (ns). Unset, the inputs read 0.
+extern uint16_t (*picSimAdcHook)(uint8_t channel, uint64_t ns);
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+void picSimAdvance(uint32_t ns);
+uint64_t picSimNs(void);
+void picSimLatency(uint32_t *worstNs, uint32_t *meanNs);
+void picSimCapture(uint64_t ns);
+void isr(void);
+void isrLow(void);
+
+#endif	/* PIC_SIM_H */
@@ -0,0 +1,154 @@
+/* File:  spiSim.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host replacement of spi.c with the same interface. Bytes go to the MCP2515
+ * model and take the time of the SPI clock set in SSPCON1. An asynchronous transfer runs to the
+ * end inside SPI_submit() with GIE off, like the SSP interrupt chain on the target; transfers
+ * queued meanwhile (from a callback) run after it, in order. The chip select follows CS (RA5),
+ * which mcp2515Reset() drives directly.
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "../hardware.h"
+#include "../spi.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+static spiTransfer *spiHead;
+static spiTransfer *spiTail;
+static uint8_t spiSelected;
+
+volatile uint32_t spiBytes;
+
+
+/*******************************************************************************
+ * Function static void SPI_sync(void);
+ * Passes the CS level to the MCP2515 model when it changed.
+ *******************************************************************************/
+static void SPI_sync(void)
+{
+    if (spiSelected != !CS)
+    {
+        spiSelected = !CS;
+        mcp2515SimSelect(spiSelected);
+    }
+    
+} // end function SPI_sync()
+
+
+/*******************************************************************************
+ * Function static uint8_t SPI_exchange(uint8_t data);
+ * One byte on the bus.
+ *******************************************************************************/
+static uint8_t SPI_exchange(uint8_t data)
+{
+    uint8_t received;
+    
+    SPI_sync();
+    received = mcp2515SimExchange(data);
+    spiBytes++;
+    picSimAdvance((uint32_t)PIC_SIM_SPI_BYTE_NS << (2 * (SSPCON1 & 0x03)));
+    
+    return received;
+    
+} // end function SPI_exchange()
+
+
+void SPI_ini()
+{
+    SSPCON1 = 0x30 | SPI_CLOCK;
+    CS = 1;
+    SPI_sync();
+    
+} // end function SPI_ini()
+
+void SPI_send(uint8_t data)
+{
+    SPI_exchange(data);
+    
+} // end function SPI_send()
+
+uint8_t SPI_receive()
+{
+    return SPI_exchange(0xFF);
+    
+} // end function SPI_receive()
+
+void SPI_begin(uint8_t cs)
+{
+    (void)cs;
+    SPI_sync();
+    CS = 0;
+    SPI_sync();
+    
+} // end function SPI_begin()
+
+void SPI_end(uint8_t cs)
+{
+    (void)cs;
+    CS = 1;
+    SPI_sync();
+    
+} // end function SPI_end()
+
+
+/*******************************************************************************
+ * Function void SPI_submit(spiTransfer *transfer);
+ * Queues the transfer; the first caller runs the queue until it is empty.
+ *******************************************************************************/
+void SPI_submit(spiTransfer *transfer)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    transfer->next = 0;
+    if (spiHead != 0)
+    {
+        spiTail->next = transfer;
+        spiTail = transfer;
+        return;
+    }
+    spiHead = transfer;
+    spiTail = transfer;
+    
+    INTCONbits.GIE = 0;
+    while (spiHead != 0)
+    {
+        spiTransfer *current = spiHead;
+        
+        SPI_begin(current->cs);
+        for (uint8_t i = 0; i < current->length; i++)
+        {
+            current->buffer[i] = SPI_exchange(current->buffer[i]);
+        }
+        SPI_end(current->cs);
+        
+        if (current->done != 0)
+            current->done(current);
+        spiHead = current->next;
+    }
+    INTCONbits.GIE = gie;
+    
+} // end function SPI_submit()
+
+
+uint8_t SPI_busy(void)
+{
+    return (spiHead != 0);
+    
+} // end function SPI_busy()
+
+void SPI_wait(void)
+{
+} // end function SPI_wait()
+
+void SPI_interrupt(void)
+{
+} // end function SPI_interrupt()
+
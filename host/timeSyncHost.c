@@ -0,0 +1,295 @@
+/* File:  timeSyncHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Network time (timeSync.c) against a perfect clock. The node runs the driver and
+ * timeSync.c on the MCP2515 model, with its oscillator off by -p ppm; the SOF signal of the model
+ * drives the CCP1 capture. Other nodes load the bus with random frames (-b percent), so the SYNC
+ * often waits for a frame or is followed by one back to back.
+ * 
+ * Slave build (default): the tool is the master, its clock the network time. It sends a SYNC
+ * every TIME_SYNC_PERIOD_MS and the FUP with the SYNC's start of frame 2 ms later. The node's
+ * timeSyncNow() is compared with the network time every millisecond once locked, and the
+ * instants of timeSyncDue() (every 10 ms) with the network time they fire at. The network time
+ * starts 30 s before its 32 bit wrap. The exit code is 1 when the error reaches 100 us, when
+ * fewer than 90 % of the SYNC/FUP pairs give a sample, or on a receive buffer overflow.
+ * Master build (-DTIME_SYNC_MASTER=1): the tool checks the time of each FUP the node sends
+ * against the node's Timer1 at the start of frame of the SYNC (exit code 1 also on overflows).
+ * 
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DTIME_SYNC=1 -DSPI_CLOCK=SPI_CLOCK_FOSC4 -o timeSyncHost host/timeSyncHost.c \
+ *       host/picSim.c host/spiSim.c host/mcp2515Sim.c timeSync.c canQueue.c can.c hardware.c timer.c \
+ *       && ./timeSyncHost
+ * Use:
+ *   ./timeSyncHost [-p ppm] [-b busLoadPercent] [-r 125|250|500] [-s seconds]
+ * 
+ * Environment: gcc (host).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../timeSync.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define HOST_STEP_NS            1000
+#define HOST_FUP_DELAY_NS       2000000     // Master software: FUP after the SYNC
+#define HOST_NET_START          (0xFFFFFFFFu - 30000000u)
+#define HOST_SAMPLE_US          10000       // timeSyncDue() period
+#define HOST_TARGET_US          100
+#define HOST_SAMPLES_PERCENT    90          // Slave: SYNC/FUP pairs that must give a sample
+
+static int32_t hostPpm = 15000;
+static uint32_t hostLoad = 30;
+static uint64_t hostTrafficNs;          // Next frame of the other nodes
+static uint64_t hostSyncNs;             // Next SYNC (slave build)
+static uint64_t hostSofNs;              // Start of frame of the last SYNC
+static uint8_t hostSofSeq;
+static uint64_t hostFupNs;              // FUP due, 0: none
+static uint32_t hostSyncs;
+static uint32_t hostFups;
+static uint32_t hostFupErrors;          // Master build: FUP time differs from the capture
+#if !TIME_SYNC_MASTER
+static uint8_t hostSeq;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t hostNet(uint64_t ns)
+ * Description: Network time of the tool (the master's clock), in us.
+ *******************************************************************************/
+static uint32_t hostNet(uint64_t ns)
+{
+    return HOST_NET_START + (uint32_t)(ns / 1000);
+    
+} // end static uint32_t hostNet(uint64_t ns) function
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t hostLocal(uint64_t ns)
+ * Description: Node's local time at (ns): Timer1 extended to 32 bits, counting the node's clock.
+ *******************************************************************************/
+static uint32_t hostLocal(uint64_t ns)
+{
+    return (uint32_t)((ns + (uint64_t)(((int64_t)ns * hostPpm) / 1000000)) / 1000);
+    
+} // end static uint32_t hostLocal(uint64_t ns) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs)
+ * Description: mcp2515SimStartHook: the start of frame of each SYNC, the tool's or the node's.
+ *******************************************************************************/
+static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs)
+{
+    if (frame->id == TIME_SYNC_IDH << 3 && frame->data[0] == TIME_SYNC_TYPE_SYNC)
+    {
+        hostSofNs = startNs;
+        hostSofSeq = frame->data[1];
+        hostFupNs = startNs + HOST_FUP_DELAY_NS;
+    }
+    
+} // end static void hostStart(const mcp2515SimFrame *frame, uint64_t startNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook, master build: checks each FUP of the node.
+ *******************************************************************************/
+static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    uint32_t sof;
+    
+    (void)endNs;
+    if (frame->id == TIME_SYNC_IDH << 3 && frame->data[0] == TIME_SYNC_TYPE_SYNC)
+        hostSyncs++;
+    if (frame->id != TIME_SYNC_IDH << 3 || frame->data[0] != TIME_SYNC_TYPE_FUP)
+        return;
+    
+    hostFups++;
+    sof = frame->data[2] | (frame->data[3] << 8) | (frame->data[4] << 16) | ((uint32_t)frame->data[5] << 24);
+    if (frame->data[1] != hostSofSeq || sof != hostLocal(hostSofNs))
+        hostFupErrors++;
+    
+} // end static void hostBusEnd(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void hostStep(uint64_t nowNs)
+ * Description: picSimHook: the frames of the other nodes and, in the slave build, the SYNC and
+ * FUP of the master. Traffic: random standard frames, identifiers 0x200-0x5FF, at -b percent of
+ * the bus on average.
+ *******************************************************************************/
+static void hostStep(uint64_t nowNs)
+{
+    if (hostLoad && nowNs >= hostTrafficNs)
+    {
+        mcp2515SimFrame frame = { 0x200 + (uint32_t)(rand() % 0x400), 0, (uint8_t)(rand() % 9), { 0 } };
+        uint64_t frameNs = (uint64_t)(47 + 8 * frame.dlc) * mcp2515SimBitNs();
+    
+        for (uint8_t i = 0; i < frame.dlc; i++)
+            frame.data[i] = (uint8_t)rand();
+        mcp2515SimInject(&frame);
+        hostTrafficNs = nowNs + frameNs * 100 / hostLoad * (50 + rand() % 101) / 100;
+    }
+    
+#if !TIME_SYNC_MASTER
+    if (nowNs >= hostSyncNs)
+    {
+        mcp2515SimFrame sync = { TIME_SYNC_IDH << 3, 0, TIME_SYNC_DLC, { TIME_SYNC_TYPE_SYNC, ++hostSeq } };
+    
+        mcp2515SimInject(&sync);
+        hostSyncs++;
+        hostSyncNs += (uint64_t)TIME_SYNC_PERIOD_MS * 1000000;
+    }
+    
+    if (hostFupNs && nowNs >= hostFupNs)
+    {
+        uint32_t net = hostNet(hostSofNs);
+        mcp2515SimFrame fup = { TIME_SYNC_IDH << 3, 0, TIME_SYNC_FUP_DLC, { TIME_SYNC_TYPE_FUP, hostSofSeq,
+                                (uint8_t)net, (uint8_t)(net >> 8), (uint8_t)(net >> 16), (uint8_t)(net >> 24) } };
+    
+        mcp2515SimInject(&fup);
+        hostFups++;
+        hostFupNs = 0;
+    }
+#endif
+    
+} // end static void hostStep(uint64_t nowNs) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_125K;
+    uint32_t seconds = 60;
+    uint64_t endNs;
+    uint32_t overflows;
+    dataFrame frame;
+#if !TIME_SYNC_MASTER
+    uint64_t measureNs = 0;
+    uint64_t lockNs = 0;
+    uint32_t next = 0;
+    uint32_t instants = 0;
+    int32_t instantWorst = 0;
+    uint32_t measures = 0;
+    int32_t worst = 0;
+    double sum = 0;
+#endif
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-p"))
+            hostPpm = atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-b"))
+            hostLoad = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-r"))
+            bitrate = (uint8_t)(atoi(argv[opt + 1]) / 250);
+        else if (!strcmp(argv[opt], "-s"))
+            seconds = (uint32_t)atoi(argv[opt + 1]);
+        else
+            break;
+    }
+    if (opt != argc || hostLoad > 90 || bitrate >= CAN_BITRATES)
+    {
+        fprintf(stderr, "use: %s [-p ppm] [-b busLoadPercent] [-r 125|250|500] [-s seconds]\n", argv[0]);
+        return 2;
+    }
+    
+    srand(1);
+    picSimPpm = hostPpm;
+    hardware_ini();
+    mcp2515ConfigBegin();
+    mcp2515SetBitrate(bitrate);
+    mcp2515ConfigEnd();
+    timeSyncIni();
+    
+    mcp2515SimStartHook = hostStart;
+    mcp2515SimTxHook = hostBusEnd;
+    picSimHook = hostStep;
+    hostSyncNs = picSimNs() + 5000000;
+    endNs = picSimNs() + (uint64_t)seconds * 1000000000;
+    
+    // Main loop of the node: the receive queue, the service and the measures.
+    while (picSimNs() < endNs)
+    {
+        while (canReceive(&frame))
+        {
+            if (frame.idh == TIME_SYNC_IDH && !frame.idl)
+                timeSyncHandler(&frame);
+        }
+        timeSyncService();
+    
+#if !TIME_SYNC_MASTER
+        if (timeSyncLocked() && picSimNs() >= measureNs)
+        {
+            uint32_t local = timeSyncLocal();
+            int32_t error = (int32_t)(timeSyncNet(local) - hostNet(picSimNs()));
+    
+            if (!lockNs)
+                lockNs = picSimNs();
+            if (error < 0)
+                error = -error;
+            if (error > worst)
+                worst = error;
+            sum += error;
+            measures++;
+            measureNs = picSimNs() + 1000000;
+        }
+        if (timeSyncDue(&next, HOST_SAMPLE_US))
+        {
+            int32_t late = (int32_t)(hostNet(picSimNs()) - (next - HOST_SAMPLE_US));
+    
+            if (late < 0)
+                late = -late;
+            if (late > instantWorst)
+                instantWorst = late;
+            instants++;
+        }
+#endif
+        picSimAdvance(HOST_STEP_NS);
+    }
+    overflows = mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1];
+    
+#if TIME_SYNC_MASTER
+    printf("time sync master, %u Kbps, clock %+d ppm, bus load %u%%, %u s\n", rates[bitrate], hostPpm, hostLoad, seconds);
+    printf("  SYNC sent         %8u\n", hostSyncs);
+    printf("  FUP sent          %8u     (time of the SYNC start of frame wrong in %u)\n", hostFups, hostFupErrors);
+    printf("  MCP2515 overflows %8u\n", overflows);
+    if (hostFups + 1 < hostSyncs || hostFupErrors || overflows)
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: every FUP carries the capture of its SYNC\n");
+#else
+    printf("time sync slave, %u Kbps, clock %+d ppm, bus load %u%%, %u s\n", rates[bitrate], hostPpm, hostLoad, seconds);
+    printf("  SYNC/FUP sent     %8u\n", hostSyncs);
+    printf("  samples taken     %8u     (ambiguous %u, outliers %u, unpaired %u)\n", timeSyncCount.samples,
+           timeSyncCount.ambiguous, timeSyncCount.outliers, timeSyncCount.unpaired);
+    printf("  MCP2515 overflows %8u\n", overflows);
+    printf("  locked after      %8.1f ms\n", lockNs / 1e6);
+    printf("  time error        %8d us worst, %.1f us mean  (%u measures, target < %u us)\n", worst,
+           measures ? sum / measures : 0, measures, HOST_TARGET_US);
+    printf("  sampling instants %8u     (worst %d us from the network time)\n", instants, instantWorst);
+    // The FUP of the last SYNC may not be out yet.
+    if (!measures || worst >= HOST_TARGET_US || overflows ||
+        (timeSyncCount.samples * 100u < (hostSyncs - 1) * HOST_SAMPLES_PERCENT))
+    {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("OK: network time within %d us\n", worst);
+#endif
+    
+    return 0;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,419 @@
+/* File:  traceReplay.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Replays a recorded bus log through the unmodified driver (can.c, hardware.c,
+ * timer.c) and the MCP2515 model, to see whether the firmware keeps up with a real bus.
+ * The frames of other nodes are injected with their original inter-arrival times, divided by
+ * the speed factor, while a main loop takes them with canReceive() and spends the given work
+ * time per frame. The log is read line by line, so captures of any size can be replayed.
+ *
+ * Log formats (detected per line, other lines are skipped):
+ *   candump -L:   (1436509052.249713) can0 123#11223344   (12345678#... extended, 123#R remote)
+ *   candump -ta:  (1436509052.249713)  can0  123   [4]  11 22 33 44
+ *   Vector ASC:   0.011314 1  123   Rx   d 4 11 22 33 44   (18FEF100x extended, "r" remote)
+ *
+ * Reports the frames lost in the MCP2515 (RX0OVR/RX1OVR) and in the receive queue, the worst
+ * and mean latency from the end of the frame on the bus to canReceive(), the INT2 interrupt
+ * latency (picSim.c), and the high-water marks of the receive buffers and of the receive queue. The exit code is 1 when a frame was
+ * lost. PIC instruction time is not simulated (see picSim.c); -w stands for it.
+ *
+ * Build, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -o traceReplay host/traceReplay.c host/picSim.c host/spiSim.c \
+ *       host/mcp2515Sim.c canQueue.c can.c hardware.c timer.c
+ * Use:
+ *   ./traceReplay [-s speed] [-b 125|250|500] [-w workUs] log|-
+ *
+ * Environment: gcc (host).
+ *
+ * Author: Antonio Aparecido Ariza Castilho;
+ *
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../hardware.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+
+#define REPLAY_LINE_SIZE        512
+#define REPLAY_PENDING_SIZE     256     // Frames in the receive buffers or queue, for the latency
+#define REPLAY_IDLE_NS          10000   // Main loop pass without a message
+
+typedef struct
+{
+    uint8_t idh;
+    uint8_t dlc;
+    uint8_t data[8];
+    uint64_t endNs;
+}replayPending;
+
+static replayPending replayQueue[REPLAY_PENDING_SIZE];
+static uint16_t replayHead;
+static uint16_t replayCount;
+
+static uint32_t replayReceived;
+static uint32_t replayUnmatched;
+static uint64_t replayLatencyMax;
+static uint64_t replayLatencySum;
+static uint32_t replayQueueHigh;
+static uint8_t replayBufferHigh;
+static uint64_t replayBusNs;
+
+
+/*******************************************************************************
+ * FUNCTION: static void replayStored(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimRxHook: remembers the frame and the time it reached a receive buffer,
+ * as the driver will see it (RXBnSIDH, data length, data), and samples the receive buffers in use.
+ *******************************************************************************/
+static void replayStored(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    replayPending *pending;
+    uint8_t lenght = frame->dlc & 0x0F;
+    uint8_t buffers;
+    
+    if (replayCount == REPLAY_PENDING_SIZE)
+    {
+        replayHead = (replayHead + 1) % REPLAY_PENDING_SIZE;
+        replayCount--;
+        replayUnmatched++;
+    }
+    
+    pending = &replayQueue[(replayHead + replayCount) % REPLAY_PENDING_SIZE];
+    pending->idh = frame->extended ? (uint8_t)(frame->id >> 21) : (uint8_t)(frame->id >> 3);
+    pending->dlc = (lenght > 8 ? 8 : lenght) | ((frame->dlc & DLC_RTR) ? CAN_RTR : 0);
+    memcpy(pending->data, frame->data, 8);
+    pending->endNs = endNs;
+    replayCount++;
+    
+    buffers = mcp2515SimRegister(CANINTF);
+    buffers = (buffers & 0x01) + ((buffers >> 1) & 0x01);
+    if (buffers > replayBufferHigh)
+        replayBufferHigh = buffers;
+    
+} // end static void replayStored(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void replayTaken(const dataFrame *frame)
+ * Description: A frame reached the application: finds it among the stored ones (the older ones
+ * it skips were dropped by the driver) and accounts its latency.
+ *******************************************************************************/
+static void replayTaken(const dataFrame *frame)
+{
+    uint8_t lenght = (frame->dlc & CAN_RTR) ? 0 : (frame->dlc & CAN_DLC_MASK);
+    
+    replayReceived++;
+    
+    while (replayCount)
+    {
+        replayPending *pending = &replayQueue[replayHead];
+        uint64_t latency = picSimNs() - pending->endNs;
+    
+        replayHead = (replayHead + 1) % REPLAY_PENDING_SIZE;
+        replayCount--;
+    
+        if (pending->idh == frame->idh && pending->dlc == frame->dlc
+            && memcmp(pending->data, frame->data, lenght) == 0)
+        {
+            replayLatencySum += latency;
+            if (latency > replayLatencyMax)
+                replayLatencyMax = latency;
+            return;
+        }
+    }
+    
+    replayUnmatched++;
+    
+} // end static void replayTaken(const dataFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void replayBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook: frames sent by the node itself also load the bus.
+ *******************************************************************************/
+static void replayBusEnd(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    uint8_t lenght = (frame->dlc & DLC_RTR) ? 0 : (frame->dlc & 0x0F);
+    
+    (void)endNs;
+    replayBusNs += (uint64_t)((frame->extended ? 67 : 47) + 8 * (lenght > 8 ? 8 : lenght)) * mcp2515SimBitNs();
+    
+} // end static void replayBusEnd(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void replayStep(uint32_t workNs)
+ * Description: One pass of the main loop: takes a message and works on it for (workNs), or idles.
+ * Samples the receive queue high-water mark.
+ *******************************************************************************/
+static void replayStep(uint32_t workNs)
+{
+    dataFrame frame;
+    uint32_t queued;
+    
+    if (canReceive(&frame))
+    {
+        replayTaken(&frame);
+        picSimAdvance(workNs);
+    }
+    else
+        picSimAdvance(REPLAY_IDLE_NS);
+    
+    queued = mcp2515SimCount.unloaded - replayReceived - canRtrAnswered - canRxOverflow;
+    if (queued > replayQueueHigh)
+        replayQueueHigh = queued;
+    
+} // end static void replayStep(uint32_t workNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t replayData(char *text, mcp2515SimFrame *frame)
+ * Description: Reads up to 8 hexadecimal data bytes separated by spaces (text) into (frame).
+ * Returns the number of bytes read.
+ *******************************************************************************/
+static uint8_t replayData(char *text, mcp2515SimFrame *frame)
+{
+    uint8_t count = 0;
+    char *end;
+    
+    while (count < 8)
+    {
+        unsigned long value;
+    
+        while (*text == ' ' || *text == '\t')
+            text++;
+        if (!isxdigit((unsigned char)text[0]) || !isxdigit((unsigned char)text[1]))
+            break;
+        value = strtoul(text, &end, 16);
+        if (end != text + 2)
+            break;
+        frame->data[count++] = (uint8_t)value;
+        text = end;
+    }
+    
+    return count;
+    
+} // end static uint8_t replayData(char *text, mcp2515SimFrame *frame) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t replayParse(char *line, double *time, mcp2515SimFrame *frame)
+ * Description: Decodes one log line. Returns 1 for a classic CAN frame, 0 for anything else
+ * (headers, error frames, CAN FD).
+ *******************************************************************************/
+static uint8_t replayParse(char *line, double *time, mcp2515SimFrame *frame)
+{
+    char *p = line;
+    char *end;
+    
+    memset(frame, 0, sizeof(*frame));
+    while (*p == ' ' || *p == '\t')
+        p++;
+    
+    if (*p == '(')
+    {
+        // candump: (time) interface frame
+        *time = strtod(p + 1, &end);
+        if (end == p + 1 || *end != ')')
+            return 0;
+        p = end + 1;
+        while (*p == ' ' || *p == '\t')
+            p++;
+        while (*p && *p != ' ' && *p != '\t')
+            p++;
+        while (*p == ' ' || *p == '\t')
+            p++;
+    
+        frame->id = strtoul(p, &end, 16);
+        frame->extended = (end - p) > 3;
+        if (*end == '#')
+        {
+            // -L: id#data, id#R[dlc]; id##flags is CAN FD
+            p = end + 1;
+            if (*p == '#')
+                return 0;
+            if (*p == 'R')
+            {
+                frame->dlc = DLC_RTR | (isdigit((unsigned char)p[1]) ? (p[1] - '0') : 0);
+                return 1;
+            }
+            for (frame->dlc = 0; frame->dlc < 8 && isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]); p += 2)
+            {
+                char byte[3] = {p[0], p[1], 0};
+    
+                frame->data[frame->dlc++] = (uint8_t)strtoul(byte, 0, 16);
+            }
+            return 1;
+        }
+    
+        // -ta: id [dlc] data, or "remote request"
+        p = strchr(end, '[');
+        if (end == p || p == 0 || !isdigit((unsigned char)p[1]))
+            return 0;
+        frame->dlc = p[1] - '0';
+        p = strchr(p, ']');
+        if (p == 0)
+            return 0;
+        if (strstr(p, "remote"))
+            frame->dlc |= DLC_RTR;
+        else
+            replayData(p + 1, frame);
+        return 1;
+    }
+    
+    // ASC: time channel id Rx|Tx d|r dlc data
+    *time = strtod(p, &end);
+    if (end == p || (*end != ' ' && *end != '\t'))
+        return 0;
+    p = end;
+    strtoul(p, &end, 10);
+    if (end == p)
+        return 0;
+    p = end;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    frame->id = strtoul(p, &end, 16);
+    if (end == p)
+        return 0;
+    frame->extended = (*end == 'x');
+    if (frame->extended)
+        end++;
+    if (*end != ' ' && *end != '\t')
+        return 0;
+    p = end;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (strncmp(p, "Rx", 2) && strncmp(p, "Tx", 2))
+        return 0;
+    p += 2;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    if (*p == 'r')
+    {
+        frame->dlc = DLC_RTR | (uint8_t)strtoul(p + 1, 0, 16);
+        return 1;
+    }
+    if (*p != 'd')
+        return 0;
+    frame->dlc = (uint8_t)strtoul(p + 1, &end, 16);
+    if (frame->dlc > 8)
+        return 0;
+    replayData(end, frame);
+    
+    return 1;
+    
+} // end static uint8_t replayParse(char *line, double *time, mcp2515SimFrame *frame) function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    char line[REPLAY_LINE_SIZE];
+    FILE *log;
+    double speed = 1.0;
+    double start = -1.0;
+    double time;
+    uint32_t workNs = 0;
+    uint8_t bitrate = CAN_BITRATE_500K;
+    uint32_t frames = 0;
+    uint32_t delayed = 0;
+    uint64_t lagMax = 0;
+    uint64_t first = 0;
+    uint32_t lost;
+    uint32_t isrWorst;
+    uint32_t isrMean;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-s"))
+            speed = atof(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-w"))
+            workNs = (uint32_t)(atof(argv[opt + 1]) * 1000);
+        else if (!strcmp(argv[opt], "-b"))
+        {
+            for (bitrate = 0; bitrate < CAN_BITRATES && rates[bitrate] != atoi(argv[opt + 1]); bitrate++);
+        }
+        else
+            break;
+    }
+    if (opt != argc - 1 || speed <= 0 || bitrate == CAN_BITRATES)
+    {
+        fprintf(stderr, "use: %s [-s speed] [-b 125|250|500] [-w workUs] log|-\n", argv[0]);
+        return 2;
+    }
+    log = strcmp(argv[opt], "-") ? fopen(argv[opt], "r") : stdin;
+    if (log == 0)
+    {
+        perror(argv[opt]);
+        return 2;
+    }
+    
+    hardware_ini();
+    mcp2515SetBitrate(bitrate);
+    mcp2515SimRxHook = replayStored;
+    mcp2515SimTxHook = replayBusEnd;
+    
+    while (fgets(line, sizeof(line), log))
+    {
+        mcp2515SimFrame frame;
+        uint64_t due;
+    
+        if (!replayParse(line, &time, &frame))
+            continue;
+    
+        if (start < 0)
+        {
+            start = time;
+            first = picSimNs();
+        }
+        due = first + (uint64_t)((time - start) * 1e9 / speed);
+    
+        while (picSimNs() < due)
+            replayStep(workNs);
+    
+        // The bus is saturated when the frames of the other nodes pile up in the model.
+        if (!mcp2515SimInject(&frame))
+        {
+            delayed++;
+            while (!mcp2515SimInject(&frame))
+                replayStep(workNs);
+            if (picSimNs() - due > lagMax)
+                lagMax = picSimNs() - due;
+        }
+        replayBusEnd(&frame, 0);
+        frames++;
+    }
+    if (log != stdin)
+        fclose(log);
+    
+    // Let the bus and the queue empty.
+    for (uint64_t end = picSimNs() + 100000000ull; picSimNs() < end; )
+        replayStep(workNs);
+    
+    lost = mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1] + canRxOverflow + replayUnmatched;
+    
+    printf("frames           %u replayed at %g x, %u Kbps, %.1f us work per frame\n",
+           frames, speed, rates[bitrate], workNs / 1000.0);
+    printf("bus load         %.1f %% over %.3f s\n",
+           (picSimNs() > first) ? 100.0 * replayBusNs / (picSimNs() - first) : 0.0, (picSimNs() - first) / 1e9);
+    printf("bus saturated    %u frames delayed, up to %.3f ms\n", delayed, lagMax / 1e6);
+    printf("received         %u\n", replayReceived);
+    printf("lost             %u (RX0OVR %u, RX1OVR %u, queue full %u, other %u)\n", lost,
+           mcp2515SimCount.overflow[0], mcp2515SimCount.overflow[1], canRxOverflow, replayUnmatched);
+    printf("latency          worst %.1f us, mean %.1f us\n", replayLatencyMax / 1000.0,
+           replayReceived ? replayLatencySum / 1000.0 / replayReceived : 0.0);
+    picSimLatency(&isrWorst, &isrMean);
+    printf("INT2 latency     worst %.1f us, mean %.1f us\n", isrWorst / 1000.0, isrMean / 1000.0);
+    printf("high-water       receive buffers %u of 2, receive queue %u of %u\n",
+           replayBufferHigh, replayQueueHigh, CAN_RX_QUEUE_SIZE - 1);
+    
+    return (lost != 0);
+    
+} // end int main(int argc, char **argv) function
+
@@ -0,0 +1,381 @@
+/* File:  usbCanHost.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Runs the USB-CAN adapter (usbCan.c) on the host: the unmodified adapter and driver
+ * against the MCP2515 model, with a simulated pair of bulk endpoints that takes at most
+ * USB_HOST_PACKETS_PER_MS IN packets per 1 ms USB frame (full speed bulk), and the PC side
+ * decoder (usbCanProto.c).
+ *
+ * Receive: the other nodes keep the bus at full load for the given time; every frame that ends
+ * on the bus must come out of the decoder once, in order, with its identifier and data.
+ * Transmit: the PC sends frames in OUT batches; they must reach the bus in the same order.
+ * Reports frames and packets per second, the frames lost, and the latency from the end of the
+ * frame on the bus to the decoder. The exit code is 1 when a frame was lost or out of order.
+ * PIC instruction time is not simulated (see picSim.c).
+ *
+ * Build and run, from the project folder:
+ *   gcc -O2 -fcommon -Ihost -DUSB_CAN=1 -DSPI_CLOCK=0 -o usbCanHost host/usbCanHost.c host/usbCanProto.c \
+ *       host/picSim.c host/spiSim.c host/mcp2515Sim.c usbCan.c busLoad.c canQueue.c can.c hardware.c \
+ *       timer.c && ./usbCanHost
+ * (-DBUS_LOAD=1 adds the bus load meter; the model sends no stuff bits, so the lower bound is the
+ * load it really had.)
+ * Use:
+ *   ./usbCanHost [-b 125|250|500] [-t ms] [-d dlc] [-p packetsPerMs]
+ *
+ * Environment: gcc (host).
+ *
+ * Author: Antonio Aparecido Ariza Castilho;
+ *
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hardware.h"
+#include "../usbCan.h"
+#include "picSim.h"
+#include "mcp2515Sim.h"
+#include "usbCanProto.h"
+
+#define USB_HOST_PACKETS_PER_MS 19      // Full speed bulk, 64 byte packets
+#define USB_HOST_PENDING_SIZE   1024    // Frames between the bus and the decoder
+#define USB_HOST_POLL_NS        1000    // usbCanPoll() pass
+#define USB_HOST_TX_FRAMES      5000
+
+typedef struct
+{
+    mcp2515SimFrame frame;
+    uint64_t endNs;
+}usbHostPending;
+
+static usbHostPending usbHostQueue[USB_HOST_PENDING_SIZE];
+static uint16_t usbHostHead;
+static uint16_t usbHostCount;
+
+static uint32_t usbHostPacketsPerMs = USB_HOST_PACKETS_PER_MS;
+static uint64_t usbHostFrameMs;
+static uint32_t usbHostFramePackets;
+static uint32_t usbHostPackets;
+static uint32_t usbHostBytes;
+
+static usbCanProtoDecoder usbHostDecoder;
+static uint64_t usbHostClockNs;         // Time of adapter clock 0
+static uint32_t usbHostReceived;
+static uint32_t usbHostSkipped;
+static uint32_t usbHostUnmatched;
+static uint64_t usbHostLatencyMax;
+static uint64_t usbHostLatencySum;
+static uint64_t usbHostStampMax;
+static uint64_t usbHostBusNs;           // Bus time of the frames stored
+static usbCanProtoStatus usbHostStatus;
+
+static usbCanProtoFrame usbHostTx[USB_HOST_TX_FRAMES];
+static uint16_t usbHostTxCount;
+static uint16_t usbHostTxSent;
+static uint16_t usbHostTxOnBus;
+static uint32_t usbHostTxDisorder;
+static uint64_t usbHostTxLastNs;
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t usbHostReady(void)
+ * Description: IN endpoint: the host controller polls it up to usbHostPacketsPerMs times a frame.
+ *******************************************************************************/
+static uint8_t usbHostReady(void)
+{
+    uint64_t ms = picSimNs() / 1000000;
+    
+    if (ms != usbHostFrameMs)
+    {
+        usbHostFrameMs = ms;
+        usbHostFramePackets = 0;
+    }
+    
+    return usbHostFramePackets < usbHostPacketsPerMs;
+    
+} // end static uint8_t usbHostReady(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostWrite(const uint8_t *packet, uint8_t length)
+ * Description: IN endpoint: the packet goes straight to the PC side decoder.
+ *******************************************************************************/
+static void usbHostWrite(const uint8_t *packet, uint8_t length)
+{
+    usbHostFramePackets++;
+    usbHostPackets++;
+    usbHostBytes += length;
+    
+    if (usbCanProtoDecode(&usbHostDecoder, packet, length))
+        usbHostUnmatched++;
+    
+} // end static void usbHostWrite(const uint8_t *packet, uint8_t length) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t usbHostRead(uint8_t *packet)
+ * Description: OUT endpoint: the next batch of the transmit list, when there is one.
+ *******************************************************************************/
+static uint8_t usbHostRead(uint8_t *packet)
+{
+    uint16_t used;
+    uint8_t length;
+    
+    if (usbHostTxSent == usbHostTxCount)
+        return 0;
+    
+    length = usbCanProtoFrames(packet, &usbHostTx[usbHostTxSent], usbHostTxCount - usbHostTxSent, &used);
+    usbHostTxSent += used;
+    
+    return length;
+    
+} // end static uint8_t usbHostRead(uint8_t *packet) function
+
+static const usbCanEndpoint usbHostEndpoint = {usbHostReady, usbHostWrite, usbHostRead};
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostStored(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimRxHook: the frame ended on the bus and reached a receive buffer.
+ *******************************************************************************/
+static void usbHostStored(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    if (usbHostCount == USB_HOST_PENDING_SIZE)
+    {
+        usbHostHead = (usbHostHead + 1) % USB_HOST_PENDING_SIZE;
+        usbHostCount--;
+        usbHostSkipped++;
+    }
+    
+    usbHostBusNs += (uint64_t)(47 + 8 * (frame->dlc & 0x0F)) * mcp2515SimBitNs();
+    usbHostQueue[(usbHostHead + usbHostCount) % USB_HOST_PENDING_SIZE].frame = *frame;
+    usbHostQueue[(usbHostHead + usbHostCount) % USB_HOST_PENDING_SIZE].endNs = endNs;
+    usbHostCount++;
+    
+} // end static void usbHostStored(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostFrame(const usbCanProtoFrame *frame, void *context)
+ * Description: Decoder: the frame must be the oldest one stored; the ones it skips were lost.
+ *******************************************************************************/
+static void usbHostFrame(const usbCanProtoFrame *frame, void *context)
+{
+    (void)context;
+    
+    while (usbHostCount)
+    {
+        usbHostPending *pending = &usbHostQueue[usbHostHead];
+        uint8_t rtr = (pending->frame.dlc & DLC_RTR) != 0;
+        uint8_t dlc = pending->frame.dlc & 0x0F;
+        uint8_t lenght = rtr ? 0 : (dlc > 8 ? 8 : dlc);
+    
+        usbHostHead = (usbHostHead + 1) % USB_HOST_PENDING_SIZE;
+        usbHostCount--;
+    
+        if (pending->frame.id == frame->id && rtr == frame->rtr && dlc == frame->dlc
+            && memcmp(pending->frame.data, frame->data, lenght) == 0)
+        {
+            uint64_t latency = picSimNs() - pending->endNs;
+            uint64_t stamp = usbHostClockNs + frame->timeUs * 1000;
+    
+            usbHostReceived++;
+            usbHostLatencySum += latency;
+            if (latency > usbHostLatencyMax)
+                usbHostLatencyMax = latency;
+            if (stamp > pending->endNs && stamp - pending->endNs > usbHostStampMax)
+                usbHostStampMax = stamp - pending->endNs;
+            return;
+        }
+        usbHostSkipped++;
+    }
+    
+    usbHostUnmatched++;
+    
+} // end static void usbHostFrame(const usbCanProtoFrame *frame, void *context) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostStatusIn(const usbCanProtoStatus *status, void *context)
+ * Description: Decoder: keeps the last status.
+ *******************************************************************************/
+static void usbHostStatusIn(const usbCanProtoStatus *status, void *context)
+{
+    (void)context;
+    usbHostStatus = *status;
+    
+} // end static void usbHostStatusIn(const usbCanProtoStatus *status, void *context) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostBusTx(const mcp2515SimFrame *frame, uint64_t endNs)
+ * Description: mcp2515SimTxHook: the adapter sent a frame, it must be the next one of the list.
+ *******************************************************************************/
+static void usbHostBusTx(const mcp2515SimFrame *frame, uint64_t endNs)
+{
+    const usbCanProtoFrame *expected = &usbHostTx[usbHostTxOnBus];
+    uint8_t lenght = expected->rtr ? 0 : expected->dlc;
+    
+    if (usbHostTxOnBus == usbHostTxCount || frame->id != expected->id
+        || ((frame->dlc & DLC_RTR) != 0) != expected->rtr || (frame->dlc & 0x0F) != expected->dlc
+        || memcmp(frame->data, expected->data, lenght))
+    {
+        usbHostTxDisorder++;
+    }
+    if (usbHostTxOnBus < usbHostTxCount)
+        usbHostTxOnBus++;
+    usbHostTxLastNs = endNs;
+    
+} // end static void usbHostBusTx(const mcp2515SimFrame *frame, uint64_t endNs) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbHostRandom(uint32_t *seed, uint16_t *id, uint8_t *dlc, uint8_t *data, int fixedDlc)
+ * Description: A test frame: random 11 bit identifier and data, (fixedDlc) bytes or 0..8.
+ *******************************************************************************/
+static void usbHostRandom(uint32_t *seed, uint16_t *id, uint8_t *dlc, uint8_t *data, int fixedDlc)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    *id = (*seed >> 16) & 0x07FF;
+    *seed = *seed * 1103515245u + 12345u;
+    *dlc = fixedDlc >= 0 ? (uint8_t)fixedDlc : (uint8_t)((*seed >> 16) % 9);
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        *seed = *seed * 1103515245u + 12345u;
+        data[i] = (uint8_t)(*seed >> 16);
+    }
+    memset(&data[*dlc], 0, 8 - *dlc);
+    
+} // end static void usbHostRandom() function
+
+
+int main(int argc, char **argv)
+{
+    static const uint16_t rates[CAN_BITRATES] = {125, 250, 500};
+    uint8_t bitrate = CAN_BITRATE_500K;
+    uint32_t timeMs = 1000;
+    int fixedDlc = -1;
+    uint32_t seed = 1;
+    uint32_t injected = 0;
+    uint32_t onBus;
+    uint32_t lost;
+    uint64_t start;
+    uint64_t busNs = 0;
+    usbCanProtoStatus load;
+    double seconds;
+    int opt;
+    
+    for (opt = 1; opt < argc - 1; opt += 2)
+    {
+        if (!strcmp(argv[opt], "-t"))
+            timeMs = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-d"))
+            fixedDlc = atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-p"))
+            usbHostPacketsPerMs = (uint32_t)atoi(argv[opt + 1]);
+        else if (!strcmp(argv[opt], "-b"))
+        {
+            for (bitrate = 0; bitrate < CAN_BITRATES && rates[bitrate] != atoi(argv[opt + 1]); bitrate++);
+        }
+        else
+            break;
+    }
+    if (opt != argc || bitrate == CAN_BITRATES || fixedDlc > 8 || timeMs == 0 || usbHostPacketsPerMs == 0)
+    {
+        fprintf(stderr, "use: %s [-b 125|250|500] [-t ms] [-d dlc] [-p packetsPerMs]\n", argv[0]);
+        return 2;
+    }
+    
+    hardware_ini();
+    mcp2515SetBitrate(bitrate);
+    mcp2515SimRxHook = usbHostStored;
+    mcp2515SimTxHook = usbHostBusTx;
+    usbHostDecoder.frame = usbHostFrame;
+    usbHostDecoder.status = usbHostStatusIn;
+    usbHostClockNs = picSimNs() - (uint64_t)timerMicros() * 1000;
+    usbCanIni(&usbHostEndpoint);
+    
+    // Receive: the inject queue of the model is kept full, so the bus never idles.
+    start = picSimNs();
+    while (picSimNs() - start < (uint64_t)timeMs * 1000000)
+    {
+        mcp2515SimFrame frame;
+        uint16_t id;
+    
+        memset(&frame, 0, sizeof(frame));
+        usbHostRandom(&seed, &id, &frame.dlc, frame.data, fixedDlc);
+        frame.id = id;
+        while (!mcp2515SimInject(&frame))
+        {
+            usbCanPoll();
+            picSimAdvance(USB_HOST_POLL_NS);
+        }
+        injected++;
+    }
+    seconds = (picSimNs() - start) / 1e9;
+    busNs = usbHostBusNs;
+    load = usbHostStatus;
+    
+    // Let the bus, the adapter and the endpoint empty (the status period included).
+    for (uint64_t end = picSimNs() + 100000000ull; picSimNs() < end; )
+    {
+        usbCanPoll();
+        picSimAdvance(USB_HOST_POLL_NS);
+    }
+    
+    onBus = mcp2515SimCount.received + mcp2515SimCount.overflow[0] + mcp2515SimCount.overflow[1];
+    lost = onBus - usbHostReceived;
+    
+    if (fixedDlc < 0)
+        printf("receive          %u Kbps, 0..8 data bytes, %u IN packets per ms\n", rates[bitrate], usbHostPacketsPerMs);
+    else
+        printf("receive          %u Kbps, %d data bytes, %u IN packets per ms\n", rates[bitrate], fixedDlc,
+               usbHostPacketsPerMs);
+    printf("frames           %u on the bus in %.3f s (%.0f frames/s, %.1f %% bus load)\n",
+           onBus, seconds, onBus / seconds, 100.0 * busNs / (seconds * 1e9));
+    printf("delivered        %u (%.0f frames/s), %u lost, %u unmatched\n",
+           usbHostReceived, usbHostReceived / seconds, lost, usbHostUnmatched);
+    printf("  MCP2515        %u + %u RXnOVR, queue %u, adapter status: %u + %u\n",
+           mcp2515SimCount.overflow[0], mcp2515SimCount.overflow[1], canRxOverflow,
+           usbHostStatus.queueOverflows, usbHostStatus.bufferOverflows);
+    printf("  USB            %u IN packets (%.0f/s, %.1f frames and %.1f bytes each), %u sequence gaps\n",
+           usbHostPackets, usbHostPackets / seconds, usbHostPackets ? (double)usbHostReceived / usbHostPackets : 0.0,
+           usbHostPackets ? (double)usbHostBytes / usbHostPackets : 0.0, usbHostDecoder.packetsLost);
+    if (load.busLoad != 0xFFFF)
+        printf("  bus load       %.1f %% reported by the adapter, %.1f %% without stuff bits\n",
+               load.busLoad / 10.0, load.busLoadMin / 10.0);
+    printf("latency          %.1f us mean, %.1f us worst (timestamp %.1f us after the frame, worst)\n",
+           usbHostReceived ? usbHostLatencySum / 1000.0 / usbHostReceived : 0.0, usbHostLatencyMax / 1000.0,
+           usbHostStampMax / 1000.0);
+    
+    // Transmit: the whole list is offered in OUT batches at once.
+    for (usbHostTxCount = 0; usbHostTxCount < USB_HOST_TX_FRAMES; usbHostTxCount++)
+    {
+        usbCanProtoFrame *frame = &usbHostTx[usbHostTxCount];
+    
+        memset(frame, 0, sizeof(*frame));
+        usbHostRandom(&seed, &frame->id, &frame->dlc, frame->data, fixedDlc);
+    }
+    busNs = 0;
+    for (uint16_t i = 0; i < usbHostTxCount; i++)
+    {
+        busNs += (uint64_t)(47 + 8 * usbHostTx[i].dlc) * mcp2515SimBitNs();
+    }
+    start = picSimNs();
+    while (usbHostTxOnBus < usbHostTxCount && picSimNs() - start < 10000000000ull)
+    {
+        usbCanPoll();
+        picSimAdvance(USB_HOST_POLL_NS);
+    }
+    seconds = (usbHostTxLastNs - start) / 1e9;
+    
+    printf("transmit         %u of %u frames on the bus, %u out of order, in %.3f s (%.0f frames/s, %.1f %% bus load)\n",
+           usbHostTxOnBus, usbHostTxCount, usbHostTxDisorder, seconds, usbHostTxOnBus / seconds,
+           100.0 * busNs / (usbHostTxLastNs - start));
+    
+    return (lost || usbHostUnmatched || usbHostTxDisorder || usbHostTxOnBus != usbHostTxCount) ? 1 : 0;
+    
+} // end int main(int argc, char **argv) function
@@ -0,0 +1,164 @@
+/* File:  usbCanProto.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: PC side of the USB-CAN adapter protocol (see usbCanProto.h).
+ * 
+ * Environment: gcc (host), see host/usbCanHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <string.h>
+#include "usbCanProto.h"
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t protoWord(const uint8_t *bytes)
+ * Description: Little endian 32 bit field.
+ *******************************************************************************/
+static uint32_t protoWord(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16)
+           | ((uint32_t)bytes[3] << 24);
+    
+} // end static uint32_t protoWord(const uint8_t *bytes) function
+
+
+/*******************************************************************************
+ * FUNCTION: int usbCanProtoDecode(usbCanProtoDecoder *decoder, const uint8_t *packet, uint8_t length)
+ * Description: Decodes an IN packet and calls the decoder callbacks. Frame records carry the low 16
+ * bits of the adapter clock; the rest comes from the previous record or status, which the adapter
+ * sends at least every USB_CAN_STATUS_MS. Returns 0, or -1 for a malformed packet.
+ *******************************************************************************/
+int usbCanProtoDecode(usbCanProtoDecoder *decoder, const uint8_t *packet, uint8_t length)
+{
+    uint8_t index = USB_CAN_HEADER_SIZE;
+    
+    if (length < USB_CAN_HEADER_SIZE || length > USB_CAN_PACKET_SIZE)
+        return -1;
+    
+    if (decoder->started && packet[2] != decoder->sequence)
+        decoder->packetsLost += (uint8_t)(packet[2] - decoder->sequence);
+    decoder->sequence = packet[2] + 1;
+    decoder->started = 1;
+    if (packet[3] & USB_CAN_FLAG_LOST)
+        decoder->lostFlags++;
+    if (packet[3] & USB_CAN_FLAG_ERROR)
+        decoder->errorFlags++;
+    
+    if (packet[0] == USB_CAN_IN_STATUS)
+    {
+        usbCanProtoStatus status;
+        uint64_t time;
+        
+        if (length < USB_CAN_STATUS_SIZE)
+            return -1;
+        time = (decoder->timeUs & ~0xFFFFFFFFull) | protoWord(&packet[4]);
+        if (time < decoder->timeUs)
+            time += 0x100000000ull;
+        decoder->timeUs = time;
+        
+        status.timeUs = time;
+        status.canstat = packet[8];
+        status.eflg = packet[9];
+        status.tec = packet[10];
+        status.rec = packet[11];
+        status.queueOverflows = packet[12] | (packet[13] << 8);
+        status.bufferOverflows = packet[14] | (packet[15] << 8);
+        status.received = protoWord(&packet[16]);
+        status.sent = protoWord(&packet[20]);
+        status.busLoad = packet[24] | (packet[25] << 8);
+        status.busLoadMin = packet[26] | (packet[27] << 8);
+        if (decoder->status)
+            decoder->status(&status, decoder->context);
+        return 0;
+    }
+    
+    if (packet[0] != USB_CAN_IN_FRAMES)
+        return -1;
+    
+    for (uint8_t i = 0; i < packet[1]; i++)
+    {
+        usbCanProtoFrame frame;
+        uint16_t id;
+        uint8_t lenght;
+        
+        if (index + 5 > length)
+            return -1;
+        
+        frame.timeUs = (decoder->timeUs & ~0xFFFFull) | packet[index] | (packet[index + 1] << 8);
+        if (frame.timeUs < decoder->timeUs)
+            frame.timeUs += 0x10000;
+        decoder->timeUs = frame.timeUs;
+        
+        id = packet[index + 2] | (packet[index + 3] << 8);
+        frame.id = id & 0x07FF;
+        frame.rtr = (id & USB_CAN_ID_RTR) != 0;
+        frame.dlc = packet[index + 4] & 0x0F;
+        lenght = frame.rtr ? 0 : (frame.dlc > 8 ? 8 : frame.dlc);
+        index += 5;
+        if (index + lenght > length)
+            return -1;
+        memset(frame.data, 0, sizeof(frame.data));
+        memcpy(frame.data, &packet[index], lenght);
+        index += lenght;
+        
+        if (decoder->frame)
+            decoder->frame(&frame, decoder->context);
+    }
+    
+    return 0;
+    
+} // end int usbCanProtoDecode(usbCanProtoDecoder *decoder, const uint8_t *packet, uint8_t length) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t usbCanProtoFrames(uint8_t *packet, const usbCanProtoFrame *frames, uint16_t count,
+ *                                     uint16_t *used)
+ * Description: Packs as many of the (count) frames as fit in one OUT packet; (*used) tells how
+ * many. Returns the packet length.
+ *******************************************************************************/
+uint8_t usbCanProtoFrames(uint8_t *packet, const usbCanProtoFrame *frames, uint16_t count, uint16_t *used)
+{
+    uint8_t length = 2;
+    uint16_t n;
+    
+    for (n = 0; n < count && n < 255; n++)
+    {
+        uint8_t lenght = frames[n].rtr ? 0 : (frames[n].dlc > 8 ? 8 : frames[n].dlc);
+        uint16_t id = (frames[n].id & 0x07FF) | (frames[n].rtr ? USB_CAN_ID_RTR : 0);
+        
+        if (length + 3 + lenght > USB_CAN_PACKET_SIZE)
+            break;
+        packet[length] = (uint8_t)id;
+        packet[length + 1] = (uint8_t)(id >> 8);
+        packet[length + 2] = frames[n].dlc & 0x0F;
+        memcpy(&packet[length + 3], frames[n].data, lenght);
+        length += 3 + lenght;
+    }
+    
+    packet[0] = USB_CAN_OUT_FRAMES;
+    packet[1] = (uint8_t)n;
+    *used = n;
+    
+    return length;
+    
+} // end uint8_t usbCanProtoFrames() function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t usbCanProtoCommand(uint8_t *packet, uint8_t type, uint8_t value)
+ * Description: Builds a command packet (USB_CAN_OUT_BITRATE, _MODE or _STATUS). Returns its length.
+ *******************************************************************************/
+uint8_t usbCanProtoCommand(uint8_t *packet, uint8_t type, uint8_t value)
+{
+    packet[0] = type;
+    packet[1] = value;
+    
+    return 2;
+    
+} // end uint8_t usbCanProtoCommand(uint8_t *packet, uint8_t type, uint8_t value) function
+
@@ -0,0 +1,65 @@
+/* File:  usbCanProto.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: PC side of the USB-CAN adapter protocol (packet layout in usbCan.h): decodes IN
+ * packets, rebuilding 64 bit timestamps, and builds OUT packets. No USB code: the caller moves
+ * the 64 byte packets (libusb, or the simulated endpoint of usbCanHost.c).
+ * 
+ * Environment: gcc (host), see host/usbCanHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef USB_CAN_PROTO_H
+#define	USB_CAN_PROTO_H
+
+#include <stdint.h>
+#include "../usbCan.h"
+
+typedef struct
+{
+    uint64_t timeUs;                    // Adapter clock
+    uint16_t id;                        // 11 bit identifier
+    uint8_t rtr;
+    uint8_t dlc;
+    uint8_t data[8];
+}usbCanProtoFrame;
+
+typedef struct
+{
+    uint64_t timeUs;
+    uint8_t canstat;
+    uint8_t eflg;
+    uint8_t tec;
+    uint8_t rec;
+    uint16_t queueOverflows;
+    uint16_t bufferOverflows;
+    uint32_t received;
+    uint32_t sent;
+    uint16_t busLoad;                   // Per mille, 0xFFFF when not measured
+    uint16_t busLoadMin;
+}usbCanProtoStatus;
+
+typedef struct
+{
+    void (*frame)(const usbCanProtoFrame *frame, void *context);
+    void (*status)(const usbCanProtoStatus *status, void *context);
+    void *context;
+    uint64_t timeUs;                    // Last time seen
+    uint8_t sequence;                   // Next IN sequence number expected
+    uint8_t started;
+    uint32_t packetsLost;               // Sequence gaps
+    uint32_t lostFlags;                 // Packets flagged USB_CAN_FLAG_LOST
+    uint32_t errorFlags;                // Packets flagged USB_CAN_FLAG_ERROR
+}usbCanProtoDecoder;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES 
+ **********************************************************************************************************************************************/
+int usbCanProtoDecode(usbCanProtoDecoder *decoder, const uint8_t *packet, uint8_t length);
+uint8_t usbCanProtoFrames(uint8_t *packet, const usbCanProtoFrame *frames, uint16_t count, uint16_t *used);
+uint8_t usbCanProtoCommand(uint8_t *packet, uint8_t type, uint8_t value);
+
+#endif	/* USB_CAN_PROTO_H */
@@ -0,0 +1,93 @@
+/* File:  xc.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Host replacement of the XC8 <xc.h>. The firmware sources are compiled with
+ * -Ihost, so the special function registers they use become variables of picSim.c and the
+ * compiler keywords disappear. Timer1 is read through picSimTimer1() (the virtual clock).
+ * 
+ * Environment: gcc (host), see host/benchHost.c for the build command.
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef HOST_XC_H
+#define	HOST_XC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Compiler keywords and intrinsics.
+#define __interrupt(...)
+#define __at(x)
+#define __persistent
+#define __near
+#define __eeprom
+#define NOP()
+#define CLRWDT()
+#define RESET()
+#define di()                    (INTCONbits.GIE = 0)
+#define ei()                    (INTCONbits.GIE = 1)
+
+// Bit views of the registers used by the firmware.
+typedef struct { unsigned RA0:1, RA1:1, RA2:1, RA3:1, RA4:1, RA5:1, RA6:1, RA7:1; } PORTAbits_t;
+typedef struct { unsigned RB0:1, RB1:1, RB2:1, RB3:1, RB4:1, RB5:1, RB6:1, RB7:1; } PORTBbits_t;
+typedef struct { unsigned RC0:1, RC1:1, RC2:1, RC3:1, RC4:1, RC5:1, RC6:1, RC7:1; } PORTCbits_t;
+typedef struct { unsigned RD0:1, RD1:1, RD2:1, RD3:1, RD4:1, RD5:1, RD6:1, RD7:1; } PORTDbits_t;
+typedef struct { unsigned LATA0:1, LATA1:1, LATA2:1, LATA3:1, LATA4:1, LATA5:1, LATA6:1, LATA7:1; } LATAbits_t;
+typedef struct { unsigned LATB0:1, LATB1:1, LATB2:1, LATB3:1, LATB4:1, LATB5:1, LATB6:1, LATB7:1; } LATBbits_t;
+typedef struct { unsigned LATC0:1, LATC1:1, LATC2:1, LATC3:1, LATC4:1, LATC5:1, LATC6:1, LATC7:1; } LATCbits_t;
+typedef struct { unsigned LATD0:1, LATD1:1, LATD2:1, LATD3:1, LATD4:1, LATD5:1, LATD6:1, LATD7:1; } LATDbits_t;
+typedef struct { unsigned TRISA0:1, TRISA1:1, TRISA2:1, TRISA3:1, TRISA4:1, TRISA5:1, TRISA6:1, TRISA7:1; } TRISAbits_t;
+typedef struct { unsigned TRISB0:1, TRISB1:1, TRISB2:1, TRISB3:1, TRISB4:1, TRISB5:1, TRISB6:1, TRISB7:1; } TRISBbits_t;
+typedef struct { unsigned TRISC0:1, TRISC1:1, TRISC2:1, TRISC3:1, TRISC4:1, TRISC5:1, TRISC6:1, TRISC7:1; } TRISCbits_t;
+typedef struct { unsigned TRISD0:1, TRISD1:1, TRISD2:1, TRISD3:1, TRISD4:1, TRISD5:1, TRISD6:1, TRISD7:1; } TRISDbits_t;
+typedef struct { unsigned TMR1IF:1, TMR2IF:1, CCP1IF:1, SSPIF:1, TXIF:1, RCIF:1, ADIF:1, SPPIF:1; } PIR1bits_t;
+typedef struct { unsigned TMR1IE:1, TMR2IE:1, CCP1IE:1, SSPIE:1, TXIE:1, RCIE:1, ADIE:1, SPPIE:1; } PIE1bits_t;
+typedef struct { unsigned TMR1IP:1, TMR2IP:1, CCP1IP:1, SSPIP:1, TXIP:1, RCIP:1, ADIP:1, SPPIP:1; } IPR1bits_t;
+typedef struct { unsigned CCP2IF:1, TMR3IF:1, HLVDIF:1, BCLIF:1, EEIF:1, USBIF:1, CMIF:1, OSCFIF:1; } PIR2bits_t;
+typedef struct { unsigned CCP2IE:1, TMR3IE:1, HLVDIE:1, BCLIE:1, EEIE:1, USBIE:1, CMIE:1, OSCFIE:1; } PIE2bits_t;
+typedef struct { unsigned CCP2IP:1, TMR3IP:1, HLVDIP:1, BCLIP:1, EEIP:1, USBIP:1, CMIP:1, OSCFIP:1; } IPR2bits_t;
+typedef union
+{
+    struct { unsigned RBIF:1, INT0IF:1, TMR0IF:1, RBIE:1, INT0IE:1, TMR0IE:1, PEIE:1, GIE:1; };
+    struct { unsigned :6, GIEL:1, GIEH:1; };
+} INTCONbits_t;
+typedef struct { unsigned RBIP:1, :1, TMR0IP:1, :1, INTEDG2:1, INTEDG1:1, INTEDG0:1, RBPU:1; } INTCON2bits_t;
+typedef struct { unsigned INT1IF:1, INT2IF:1, :1, INT1IE:1, INT2IE:1, :1, INT1IP:1, INT2IP:1; } INTCON3bits_t;
+typedef struct { unsigned BF:1, UA:1, R_W:1, S:1, P:1, D_A:1, CKE:1, SMP:1; } SSPSTATbits_t;
+typedef struct { unsigned IPEN:1, SBOREN:1, :1, RI:1, TO:1, PD:1, POR:1, BOR:1; } RCONbits_t;
+typedef struct { unsigned RD:1, WR:1, WREN:1, WRERR:1, FREE:1, :1, CFGS:1, EEPGD:1; } EECON1bits_t;
+typedef struct { unsigned TMR1ON:1, TMR1CS:1, T1SYNC:1, T1OSCEN:1, T1CKPS:2, T1RUN:1, RD16:1; } T1CONbits_t;
+
+#define PIC_SFR(name)           extern volatile uint8_t name;
+#define PIC_SFR_BITS(name)      extern volatile name##bits_t name##bits;
+
+PIC_SFR(PORTA) PIC_SFR(PORTB) PIC_SFR(PORTC) PIC_SFR(PORTD)
+PIC_SFR(LATA) PIC_SFR(LATB) PIC_SFR(LATC) PIC_SFR(LATD)
+PIC_SFR(TRISA) PIC_SFR(TRISB) PIC_SFR(TRISC) PIC_SFR(TRISD) PIC_SFR(TRISE)
+PIC_SFR(OSCCON) PIC_SFR(SSPSTAT) PIC_SFR(SSPCON1) PIC_SFR(SSPBUF)
+PIC_SFR(ADCON0) PIC_SFR(ADCON1) PIC_SFR(ADCON2) PIC_SFR(ADRESH) PIC_SFR(ADRESL)
+PIC_SFR(INTCON) PIC_SFR(INTCON2) PIC_SFR(INTCON3) PIC_SFR(RCON)
+PIC_SFR(PIR1) PIC_SFR(PIR2) PIC_SFR(PIE1) PIC_SFR(PIE2) PIC_SFR(IPR1) PIC_SFR(IPR2)
+PIC_SFR(T0CON) PIC_SFR(T1CON) PIC_SFR(T3CON) PIC_SFR(TMR0H) PIC_SFR(TMR1H)
+PIC_SFR(TMR3L) PIC_SFR(TMR3H) PIC_SFR(CCP1CON) PIC_SFR(CCPR1L) PIC_SFR(CCPR1H)
+PIC_SFR(CCP2CON) PIC_SFR(CCPR2L) PIC_SFR(CCPR2H)
+PIC_SFR(EECON1) PIC_SFR(EECON2) PIC_SFR(EEADR) PIC_SFR(EEDATA)
+
+PIC_SFR_BITS(PORTA) PIC_SFR_BITS(PORTB) PIC_SFR_BITS(PORTC) PIC_SFR_BITS(PORTD)
+PIC_SFR_BITS(LATA) PIC_SFR_BITS(LATB) PIC_SFR_BITS(LATC) PIC_SFR_BITS(LATD)
+PIC_SFR_BITS(TRISA) PIC_SFR_BITS(TRISB) PIC_SFR_BITS(TRISC) PIC_SFR_BITS(TRISD)
+PIC_SFR_BITS(PIR1) PIC_SFR_BITS(PIE1) PIC_SFR_BITS(IPR1) PIC_SFR_BITS(PIR2) PIC_SFR_BITS(PIE2) PIC_SFR_BITS(IPR2)
+PIC_SFR_BITS(INTCON) PIC_SFR_BITS(INTCON2) PIC_SFR_BITS(INTCON3) PIC_SFR_BITS(SSPSTAT)
+PIC_SFR_BITS(RCON) PIC_SFR_BITS(EECON1) PIC_SFR_BITS(T1CON)
+
+// Reading TMR1L latches TMR1H from the virtual clock (RD16 = 1), as on the PIC; TMR0L does
+// the same for TMR0H.
+#define TMR1L                   (*picSimTimer1())
+volatile uint8_t *picSimTimer1(void);
+#define TMR0L                   (*picSimTimer0())
+volatile uint8_t *picSimTimer0(void);
+
+#endif	/* HOST_XC_H */
@@ -14,44 +14,132 @@
 #include "config_bits.h"
 #include "can.h"
 #include "hardware.h"
+#include "canSignals.h"
+#include "usbCan.h"
+#include "canTx.h"
+#include "canDispatch.h"
+#include "boot.h"
+#include "timeSync.h"
+#include "adcStream.h"
+#include "canOpen.h"
+#include "canGen.h"
+#include "eeConfig.h"
+
+#if BOOTLOADER
+// Interrupt vectors of the application (linked with --codeoffset=0x2000, see boot.h).
+asm("PSECT bootVectors,class=CODE,space=0,abs,ovrld,delta=1");
+asm("ORG 0x0008");
+asm("GOTO 0x2008");
+asm("ORG 0x0018");
+asm("GOTO 0x2018");
+#endif
 
 uint8_t dataRead[8];
 uint8_t dataSend[8];
 
+// Messages sent by the demo: on change, with the limits from canSignals.dbc.
+canTxMessage txMessages[] =
+{
+    { 0, NODE_STATUS_IDH, NODE_STATUS_DLC, NODE_STATUS_DELAY_MS, NODE_STATUS_CYCLE_MS, NODE_STATUS_Changed, dataSend, { 0 }, 0, 0 },
+};
+
+#if CAN_GEN
+// Traffic generator mix: a few high rate identifiers, mostly 8 byte frames.
+const canGenId canGenIds[] =
+{
+    { 0x0A0, 60 }, { 0x0C8, 50 }, { 0x1F0, 40 }, { 0x2A0, 30 }, { 0x3A0, 20 }, { 0x4B0, 20 }, { 0x5C0, 20 }, { 0x6D0, 15 },
+};
+const canGenMix canGenMixDemo =
+{
+    canGenIds, sizeof(canGenIds) / sizeof(canGenIds[0]),
+    { 5, 5, 10, 5, 20, 5, 10, 5, 190 },
+    CAN_GEN_LOAD_PERMILLE, CAN_GEN_BURST, 0x1234,
+};
+#endif
+
+
+// NODE_COMMAND handler, bound in canDispatch.def.
+void nodeCommandHandler(const dataFrame *frame)
+{
+    for (uint8_t i = 0; i < (frame->dlc & CAN_DLC_MASK) && i < 8; i++)
+    {
+        dataRead[i] = frame->data[i];
+    }
+    
+} // end void nodeCommandHandler(const dataFrame *frame) function
+
 
 void main(void) 
 {
+    dataFrame received;
+    
+#if BOOTLOADER
+    bootRun();
+    asm("GOTO 0x2000");     // BOOT_APP_START: reset vector of the application
+#endif
+    
     hardware_ini();
     
-    dataSend[0] = 0xAB;
+#if CAN_BENCH
+    canBenchResult bench;
+    
+    canBenchRun(CAN_BENCH_TIME_MS, &bench);
+    canBenchReport(&bench);
+#endif
+    
+#if USB_CAN
+    usbCanIni(&usbCanUsbEndpoint);
+    while (1)
+    {
+        usbCanPoll();
+    }
+#endif
     
-    canMessageSend.dlc = 8;
-   
-    /*canMessageSend.idh = 0x20;   //0001 0100
-    canMessageSend.data[0]= 0xAA; //1010 1010
-    canMessageSend.data[1]= 0xAF; //1010 1111
-    canMessageSend.data[2]= 0xFA; //1111 1010
-    canMessageSend.data[3]= 0xAB; //1010 1011
-    canMessageSend.data[4]= 0xCE; //1100 1110
-    canMessageSend.data[5]= 0xAE; //1010 1110
-    canMessageSend.data[6]= 0xBE; //1011 1110
-    canMessageSend.data[7]= 0xFE; //1111 1110
+#if ADC_STREAM
+    adcStreamStart();
+    while (1)
+    {
+        adcStreamService();
+        while (canReceive(&received))
+        {
+            canDispatch(&received);
+        }
+    }
+#endif
     
-    /*canMessageSend.idh = 0x10;   //0000 1010
-    canMessageSend.data[0]= 0x20; //0001 0100
-    canMessageSend.data[1]= 0x30; //0001 1110
-    canMessageSend.data[2]= 0x40; //0010 1000
-    canMessageSend.data[3]= 0x50; //0011 0010
-    canMessageSend.data[4]= 0x60; //0011 1100
-    canMessageSend.data[5]= 0x70; //0100 0110
-    canMessageSend.data[6]= 0x80; //0101 0000
-    canMessageSend.data[7]= 0x90; //0101 1010*/
+#if CANOPEN
+#if EE_CONFIG
+    canOpenIni(eeConfig.node);
+#else
+    canOpenIni(CANOPEN_NODE_ID);
+#endif
+    while (1)
+    {
+        canOpenService();
+        while (canReceive(&received))
+        {
+            canDispatch(&received);
+        }
+    }
+#endif
+    
+#if CAN_GEN
+    canGenStart(&canGenMixDemo);
+    while (1)
+    {
+        canGenService();
+        while (canReceive(&received))
+        {
+            canGenCheck(&received);
+        }
+    }
+#endif
+    
+    NODE_STATUS_CounterSet(dataSend, 0xAB);
     
     while(1)
     {
-        //mcp2515MessageSend(&canMessageSend);
-        
-        canSend(0, 0x10, 8, dataSend);
+        canTxPoll(txMessages, sizeof(txMessages) / sizeof(txMessages[0]));
         
         //SPI_send(0xFE); //0b11111110
         
@@ -61,9 +149,19 @@ void main(void)
         //SPI_send(0xAA); //0b10101010
         
         LATBbits.LATB6 = 1;
-        canRead(0x20, dataRead);
+        while (canReceive(&received))
+        {
+            canDispatch(&received);
+        }
+        
+#if TIME_SYNC
+        timeSyncService();
+#endif
         
-        //mcp2515MessageRead(0x20, &canMessageReceived);
+#if MCP2515_SHADOW_VERIFY
+        if (mcp2515ShadowVerify() != 0)
+            LATBbits.LATB5 = 0;
+#endif
         
         delayMS(100);
         
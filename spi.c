@@ -17,19 +17,24 @@
 #include "config_bits.h"
 #include "spi.h"
 
+// Asynchronous transaction queue: the head is the transfer on the wire.
+static spiTransfer * volatile spiHead;
+static spiTransfer * volatile spiTail;
+static volatile uint8_t spiIndex;             // Byte of spiHead being clocked
+
+volatile uint32_t spiBytes;
+
 /*******************************************************************************
  * Function void SPI_ini();
  * Initialize SPI hardware
  *******************************************************************************/
 void SPI_ini()
 {
-    uint8_t dataFlushing;
-    
     // Master mode.
     // Sample at midle. Transmit on active-to-idle clock transition
     SSPSTAT = 0x00;  // 0b01000000 MSSP status register (SPI mode) pg. 196
-    // Enables serial port and configures SCK SDO SDI SS. SPI clock FOSC/16
-    SSPCON1 = 0x32; // 0b00100001 MSSP status register (SPI mode) pg. 197
+    // Enables serial port and configures SCK SDO SDI SS. SPI clock SPI_CLOCK (FOSC/64 by default)
+    SSPCON1 = 0x30 | SPI_CLOCK; // 0b0011 00xx MSSP status register (SPI mode) pg. 197
     
     ADCON0 = 0x01;    // Analog channel selected. Pg. 261
     ADCON1 = 0x0B;   // Analog ports will be limited to AN:AN0 (4 ports). Pg 262
@@ -45,7 +50,6 @@ void SPI_ini()
  *******************************************************************************/
 void SPI_send(uint8_t data)
 {
-    uint8_t dataFlushing;
     PIR1bits.SSPIF = 0; 
     //CS = 0;
     SSPBUF = data;
@@ -54,7 +58,8 @@ void SPI_send(uint8_t data)
     
     PIR1bits.SSPIF = 0; 
     //CS = 1;
-    dataFlushing = SSPBUF;
+    (void)SSPBUF;                   // Flushes the received byte (clears BF)
+    spiBytes++;
     
 } // end void SPI_send(uint8_t date).
 
@@ -72,6 +77,7 @@ uint8_t SPI_receive()
     while(!PIR1bits.SSPIF);
     PIR1bits.SSPIF = 0;
     data = SSPBUF;
+    spiBytes++;
     //CS = 1;
     return (data);
     
@@ -89,4 +95,148 @@ uint8_t SPI_dataIn()
   else
     return (0); // no data in SSPBUF register
   
-} // end function uint8_t SPI_dataIn.
\ No newline at end of file
+} // end function uint8_t SPI_dataIn.
+
+
+
+/*******************************************************************************
+ * Function static void SPI_select(uint8_t cs); static void SPI_deselect(uint8_t cs);
+ * Drive the chip select line (cs, SPI_CS_xxx).
+ *******************************************************************************/
+static void SPI_select(uint8_t cs)
+{
+    if (cs == SPI_CS_MCP2515)
+        CS = 0;
+    
+} // end function SPI_select()
+
+static void SPI_deselect(uint8_t cs)
+{
+    if (cs == SPI_CS_MCP2515)
+        CS = 1;
+    
+} // end function SPI_deselect()
+
+
+/*******************************************************************************
+ * Function void SPI_begin(uint8_t cs); void SPI_end(uint8_t cs);
+ * Frame a synchronous transaction (SPI_send()/SPI_receive()) on the chip select line (cs).
+ * SPI_begin() first lets the asynchronous queue finish, and the engine leaves SSPIE off
+ * while idle, so the synchronous bytes never reach SPI_interrupt().
+ *******************************************************************************/
+void SPI_begin(uint8_t cs)
+{
+    SPI_wait();
+    SPI_select(cs);
+    
+} // end function SPI_begin()
+
+void SPI_end(uint8_t cs)
+{
+    SPI_deselect(cs);
+    
+} // end function SPI_end()
+
+
+/*******************************************************************************
+ * Function static void SPI_start(void);
+ * Selects the device of the transfer at the head of the queue and sends its first byte.
+ *******************************************************************************/
+static void SPI_start(void)
+{
+    spiIndex = 0;
+    SPI_select(spiHead->cs);
+    PIR1bits.SSPIF = 0;
+    PIE1bits.SSPIE = 1;
+    SSPBUF = spiHead->buffer[0];
+    
+} // end function SPI_start()
+
+
+/*******************************************************************************
+ * Function void SPI_submit(spiTransfer *transfer);
+ * Queues an asynchronous transfer; it starts at once if the bus is idle. The descriptor and its
+ * buffer belong to the engine until (done) is called. Callable from the main program, from the
+ * INT2 interrupt and from a completion callback.
+ *******************************************************************************/
+void SPI_submit(spiTransfer *transfer)
+{
+    uint8_t gie = INTCONbits.GIE;
+    
+    transfer->next = 0;
+    
+    INTCONbits.GIE = 0;
+    if (spiHead == 0)
+    {
+        spiHead = transfer;
+        spiTail = transfer;
+        SPI_start();
+    }
+    else
+    {
+        spiTail->next = transfer;
+        spiTail = transfer;
+    }
+    INTCONbits.GIE = gie;
+    
+} // end function SPI_submit()
+
+
+/*******************************************************************************
+ * Function uint8_t SPI_busy(void);
+ * Returns 1 while asynchronous transfers are queued.
+ *******************************************************************************/
+uint8_t SPI_busy(void)
+{
+    return (spiHead != 0);
+    
+} // end function SPI_busy()
+
+
+/*******************************************************************************
+ * Function void SPI_wait(void);
+ * Waits for the asynchronous queue to empty. With interrupts off (inside an interrupt routine)
+ * the engine is driven from here by polling SSPIF.
+ *******************************************************************************/
+void SPI_wait(void)
+{
+    while (spiHead != 0)
+    {
+        if (!INTCONbits.GIE && PIR1bits.SSPIF)
+            SPI_interrupt();
+    }
+    
+} // end function SPI_wait()
+
+
+/*******************************************************************************
+ * Function void SPI_interrupt(void);
+ * SSP interrupt: stores the received byte in place and clocks the next one. At the end of a 
+ * transfer it releases the chip select, starts the next queued transfer (or turns SSPIE off
+ * when the queue is empty) and then calls the completion callback.
+ *******************************************************************************/
+void SPI_interrupt(void)
+{
+    spiTransfer *transfer = spiHead;
+    
+    PIR1bits.SSPIF = 0;
+    transfer->buffer[spiIndex] = SSPBUF;
+    spiBytes++;
+    
+    if (++spiIndex < transfer->length)
+    {
+        SSPBUF = transfer->buffer[spiIndex];
+        return;
+    }
+    
+    SPI_deselect(transfer->cs);
+    spiHead = transfer->next;
+    if (spiHead != 0)
+        SPI_start();                  // Keep the bus busy while the callback runs
+    else
+        PIE1bits.SSPIE = 0;
+    
+    if (transfer->done != 0)
+        transfer->done(transfer);     // May queue more transfers
+    
+} // end function SPI_interrupt()
@@ -1,3 +1,4 @@
+
 #ifndef SPI_H
 #define	SPI_H
 /****************************************************************************************
@@ -7,6 +8,34 @@
 #include "hardware.h"
 #include "delayMy.h"
 
+/****************************************************************************************
+ * Definitions
+ ****************************************************************************************/
+// SPI clock, SSPCON1.SSPM (FOSC 8 MHz: 2 MHz, 500 KHz, 125 KHz). The MCP2515 takes up to 10 MHz;
+// FOSC/64 is the original setting, FOSC/4 is needed to follow a fully loaded bus.
+#define SPI_CLOCK_FOSC4     0x00
+#define SPI_CLOCK_FOSC16    0x01
+#define SPI_CLOCK_FOSC64    0x02
+#ifndef SPI_CLOCK
+    #define SPI_CLOCK           SPI_CLOCK_FOSC64
+#endif
+
+// Chip select lines (see SPI_begin()).
+#define SPI_CS_MCP2515      0
+
+// Asynchronous transaction. The bytes of (buffer) are sent and replaced, in place, by the bytes
+// received, so a READ needs the instruction at buffer[0] and finds the registers from buffer[1].
+typedef struct spiTransfer
+{
+    uint8_t *buffer;
+    uint8_t length;
+    uint8_t cs;                                     // SPI_CS_xxx
+    void (*done)(struct spiTransfer *transfer);     // Called from the SSP interrupt, may be 0
+    struct spiTransfer *next;                       // Engine queue link
+} spiTransfer;
+
+extern volatile uint32_t spiBytes;      // Bytes clocked, synchronous and asynchronous
+
 /****************************************************************************************
  * Function prototypes
  ****************************************************************************************/
@@ -14,4 +43,12 @@ void SPI_ini();
 void SPI_send(uint8_t data);
 uint8_t SPI_receive();
 
-#endif /* SPI_H*/
\ No newline at end of file
+void SPI_begin(uint8_t cs);
+void SPI_end(uint8_t cs);
+
+void SPI_submit(spiTransfer *transfer);
+uint8_t SPI_busy(void);
+void SPI_wait(void);
+void SPI_interrupt(void);
+
+#endif /* SPI_H*/
@@ -0,0 +1,491 @@
+/* File:  timeSync.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Network time (see timeSync.h). Timer1 (1 us, timer.c) is extended to 32 bits by its
+ * overflow interrupt; CCP1 captures every start of frame into a small ring. A SYNC frame is
+ * matched with its start of frame when it is unloaded: the capture taken at least one SYNC frame
+ * length before the INT2 interrupt, and not more than the longest frame plus the accepted latency.
+ * The slave keeps a reference pair (local, network) and the rate between both clocks in Q24;
+ * the network time of any local time is the reference plus the elapsed local time, rate corrected.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "timeSync.h"
+#include "timer.h"
+#include "REGS2515.h"
+
+#define TIME_SYNC_SOF_MIN_BITS  111         // Standard frame, 8 bytes, without stuff bits
+#define TIME_SYNC_SOF_MAX_BITS  139         // Plus the worst case stuff bits
+#define TIME_SYNC_CLOCK_PERCENT 3           // Local clock error allowed for in the window
+#define TIME_SYNC_TX_FAILED     0x70        // TXBnCTRL: ABTF, MLOA, TXERR
+#define TIME_SYNC_RATE_MAX      0x00080000  // Q24, 3.1 %: beyond the oscillator tolerance
+#define TIME_SYNC_MISSES        3
+
+#define TIME_SYNC_FREE          0           // No network time
+#define TIME_SYNC_PHASE         1           // One sample: phase known, rate not yet
+#define TIME_SYNC_LOCKED        2
+
+timeSyncStats timeSyncCount;
+
+static volatile uint16_t timeSyncHigh;                  // Timer1 overflows: local time bits 31..16
+static volatile uint32_t timeSyncSof[TIME_SYNC_CAPTURES];
+static volatile uint8_t timeSyncSofNext;
+static volatile uint32_t timeSyncRxTime;                // Local time of the last INT2 interrupt
+static uint16_t timeSyncFrameMinUs;
+static uint16_t timeSyncFrameMaxUs;
+
+// Stamp of the last SYNC received, for its FUP.
+static volatile uint32_t timeSyncRxSof;
+static volatile uint8_t timeSyncRxSeq;
+static volatile uint8_t timeSyncRxValid;
+
+#if TIME_SYNC_MASTER
+static volatile uint8_t timeSyncTxArmed;                // The next start of frame is the SYNC's
+static volatile uint32_t timeSyncTxSof;
+static uint8_t timeSyncTxPending;
+static uint8_t timeSyncSeq;
+static uint16_t timeSyncLastMs;
+#else
+static uint32_t timeSyncRefLocal;
+static uint32_t timeSyncRefNet;
+static int32_t timeSyncRate;                            // (network - local) / local, Q24
+static uint8_t timeSyncState;
+static uint8_t timeSyncMisses;
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncIni(void)
+ * Description: CCP1 captures every rising edge of RC2 on Timer1, CCP1 and the Timer1 overflow
+ * interrupt at high priority. The SYNC frame window comes from the bit timing in CNF1-CNF3, in
+ * local time (the oscillator error widens it), so it is called again after a bit rate change. The master raises its transmit buffer to the
+ * highest priority: no other buffer of this node goes out between the request and the SYNC.
+ *******************************************************************************/
+void timeSyncIni(void)
+{
+    uint8_t cnf1 = mcp2515ReadRegister(CNF1);
+    uint8_t cnf2 = mcp2515ReadRegister(CNF2);
+    uint8_t cnf3 = mcp2515ReadRegister(CNF3);
+    uint8_t ps1 = ((cnf2 & PHSEG1) >> 3) + 1;
+    uint8_t ps2 = (cnf2 & BTLMODE) ? ((cnf3 & PHSEG2) + 1) : (ps1 > 2 ? ps1 : 2);
+    uint8_t quanta = 1 + (cnf2 & PRSEG) + 1 + ps1 + ps2;
+    uint16_t bitNs = (uint16_t)(2 * ((cnf1 & BRP) + 1) * quanta) * 125;     // 8 MHz oscillator
+    
+    timeSyncFrameMinUs = (uint16_t)(((uint32_t)bitNs * TIME_SYNC_SOF_MIN_BITS * (100 - TIME_SYNC_CLOCK_PERCENT)) / 100000);
+    timeSyncFrameMaxUs = (uint16_t)(((uint32_t)bitNs * TIME_SYNC_SOF_MAX_BITS * (100 + TIME_SYNC_CLOCK_PERCENT)) / 100000) +
+                         TIME_SYNC_LATENCY_US;
+    
+    TRISCbits.TRISC2 = 1;
+    CCP1CON = 0x05;                 // 0b00 00 0101 capture mode, every rising edge. Pg. 141
+    IPR1bits.CCP1IP = 1;
+    IPR1bits.TMR1IP = 1;
+    PIR1bits.CCP1IF = 0;
+    PIE1bits.CCP1IE = 1;
+    PIE1bits.TMR1IE = 1;
+    
+#if TIME_SYNC_MASTER
+    mcp2515BitChange(TXB_BASE(TIME_SYNC_TXB), TXP, TXP_HIGHEST);
+    timeSyncLastMs = timerMillis();
+#endif
+    
+} // end void timeSyncIni(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncInterrupt(void)
+ * Description: CCP1 and Timer1 overflow, from isr(). A capture taken just before an overflow
+ * still pending (TMR1IF set, capture in the upper half) belongs to the old high word.
+ *******************************************************************************/
+void timeSyncInterrupt(void)
+{
+    if (PIR1bits.CCP1IF)
+    {
+        uint16_t capture = ((uint16_t)CCPR1H << 8) | CCPR1L;
+        uint16_t high = timeSyncHigh;
+        uint32_t sof;
+    
+        PIR1bits.CCP1IF = 0;
+        if (PIR1bits.TMR1IF && (capture < 0x8000))
+            high++;
+        sof = ((uint32_t)high << 16) | capture;
+    
+        timeSyncSof[timeSyncSofNext] = sof;
+        timeSyncSofNext = (timeSyncSofNext + 1) & (TIME_SYNC_CAPTURES - 1);
+#if TIME_SYNC_MASTER
+        if (timeSyncTxArmed)
+        {
+            timeSyncTxSof = sof;
+            timeSyncTxArmed = 0;
+        }
+#endif
+    }
+    
+    if (PIR1bits.TMR1IF)
+    {
+        PIR1bits.TMR1IF = 0;
+        timeSyncHigh++;
+    }
+    
+} // end void timeSyncInterrupt(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint32_t timeSyncLocal(void)
+ * Description: Local time, Timer1 extended to 32 bits (wraps every 71 minutes), in us.
+ *******************************************************************************/
+uint32_t timeSyncLocal(void)
+{
+    uint8_t gie = INTCONbits.GIEH;
+    uint16_t micros;
+    uint16_t high;
+    
+    INTCONbits.GIEH = 0;
+    micros = timerMicros();
+    high = timeSyncHigh;
+    if (PIR1bits.TMR1IF && (micros < 0x8000))
+        high++;
+    INTCONbits.GIEH = gie;
+    
+    return ((uint32_t)high << 16) | micros;
+    
+} // end uint32_t timeSyncLocal(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncRxMark(void)
+ * Description: Takes the time of the INT2 interrupt, from isr() before the receive buffers
+ * are read: the end of the frames being unloaded is before it.
+ *******************************************************************************/
+void timeSyncRxMark(void)
+{
+    timeSyncRxTime = timeSyncLocal();
+    
+} // end void timeSyncRxMark(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncStamp(const dataFrame *frame)
+ * Description: Receive path (can.c), for the frames of TIME_SYNC_IDH: finds the start of frame
+ * of a SYNC. The newest capture between the shortest SYNC and the longest SYNC plus the latency
+ * before the INT2 interrupt is taken. A newer capture that could be a whole frame old by now
+ * means the SYNC may have ended after the interrupt (read in the same service): the sample is
+ * dropped instead of guessed.
+ *******************************************************************************/
+void timeSyncStamp(const dataFrame *frame)
+{
+    uint32_t now;
+    uint32_t best = 0xFFFFFFFF;
+    uint8_t doubt = 0;
+    
+    if ((frame->data[0] != TIME_SYNC_TYPE_SYNC) || (frame->dlc != TIME_SYNC_DLC))
+        return;
+    
+    now = timeSyncLocal();
+    for (uint8_t i = 0; i < TIME_SYNC_CAPTURES; i++)
+    {
+        uint32_t age = timeSyncRxTime - timeSyncSof[i];
+    
+        if ((age >= timeSyncFrameMinUs) && (age <= timeSyncFrameMaxUs))
+        {
+            if (age < best)
+                best = age;
+        }
+        else if ((age < timeSyncFrameMinUs) || (age & 0x80000000))
+        {
+            if ((now - timeSyncSof[i]) >= timeSyncFrameMinUs)
+                doubt = 1;
+        }
+    }
+    
+    timeSyncRxSeq = frame->data[1];
+    timeSyncRxSof = timeSyncRxTime - best;
+    timeSyncRxValid = (best != 0xFFFFFFFF) && !doubt;
+    if (!timeSyncRxValid)
+        timeSyncCount.ambiguous++;
+    
+} // end void timeSyncStamp(const dataFrame *frame) function
+
+
+#if !TIME_SYNC_MASTER
+/*******************************************************************************
+ * FUNCTION: static int32_t timeSyncRatio(int32_t num, uint32_t den)
+ * Description: (num) / (den) in Q24, |num| < (den) < 2^31, by shift and subtract: no 64 bit
+ * arithmetic on the PIC18.
+ *******************************************************************************/
+static int32_t timeSyncRatio(int32_t num, uint32_t den)
+{
+    uint32_t rest = (num < 0) ? (uint32_t)-num : (uint32_t)num;
+    uint32_t quotient = 0;
+    
+    for (uint8_t i = 0; i < 24; i++)
+    {
+        rest <<= 1;
+        quotient <<= 1;
+        if (rest >= den)
+        {
+            rest -= den;
+            quotient |= 1;
+        }
+    }
+    
+    return (num < 0) ? -(int32_t)quotient : (int32_t)quotient;
+    
+} // end static int32_t timeSyncRatio(int32_t num, uint32_t den) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void timeSyncSample(uint32_t local, uint32_t master)
+ * Description: Slave: a SYNC start of frame in local and in network time. The first sample
+ * sets the phase; from the second on, the rate is measured over the interval since the last
+ * one and the reference moves to the new sample.
+ *******************************************************************************/
+static void timeSyncSample(uint32_t local, uint32_t master)
+{
+    int32_t elapsed = (int32_t)(local - timeSyncRefLocal);
+    int32_t error;
+    int32_t rate;
+    
+    if ((timeSyncState == TIME_SYNC_FREE) || (elapsed <= 0) || (elapsed > (int32_t)TIME_SYNC_HOLDOVER_MS * 1000))
+    {
+        timeSyncRefLocal = local;
+        timeSyncRefNet = master;
+        timeSyncState = TIME_SYNC_PHASE;
+        return;
+    }
+    
+    error = (int32_t)(master - timeSyncNet(local));
+    if ((timeSyncState == TIME_SYNC_LOCKED) && ((error > TIME_SYNC_OUTLIER_US) || (error < -TIME_SYNC_OUTLIER_US)))
+    {
+        timeSyncCount.outliers++;
+        if (++timeSyncMisses >= TIME_SYNC_MISSES)
+            timeSyncState = TIME_SYNC_FREE;
+        return;
+    }
+    
+    rate = (int32_t)(master - timeSyncRefNet) - elapsed;
+    if ((rate >= elapsed) || (rate <= -elapsed))
+        rate = TIME_SYNC_RATE_MAX;
+    else
+        rate = timeSyncRatio(rate, (uint32_t)elapsed);
+    timeSyncRefLocal = local;
+    timeSyncRefNet = master;
+    if ((rate >= TIME_SYNC_RATE_MAX) || (rate <= -TIME_SYNC_RATE_MAX))
+    {
+        timeSyncState = TIME_SYNC_PHASE;
+        return;
+    }
+    
+    timeSyncRate = rate;
+    timeSyncState = TIME_SYNC_LOCKED;
+    timeSyncMisses = 0;
+    timeSyncCount.samples++;
+    
+} // end static void timeSyncSample(uint32_t local, uint32_t master) function
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncHandler(const dataFrame *frame)
+ * Description: Handler of TIME_SYNC_IDH (canDispatch.def). A slave pairs each FUP with the
+ * stamp of its SYNC; the master ignores the frames (another master on the bus).
+ *******************************************************************************/
+void timeSyncHandler(const dataFrame *frame)
+{
+#if !TIME_SYNC_MASTER
+    uint8_t gie;
+    uint8_t valid;
+    uint8_t seq;
+    uint32_t local;
+    uint32_t master;
+    
+    if ((frame->data[0] != TIME_SYNC_TYPE_FUP) || (frame->dlc != TIME_SYNC_FUP_DLC))
+        return;
+    
+    gie = INTCONbits.GIEH;
+    INTCONbits.GIEH = 0;
+    valid = timeSyncRxValid;
+    seq = timeSyncRxSeq;
+    local = timeSyncRxSof;
+    timeSyncRxValid = 0;
+    INTCONbits.GIEH = gie;
+    
+    if (seq != frame->data[1])
+    {
+        timeSyncCount.unpaired++;
+        return;
+    }
+    if (!valid)
+        return;
+    
+    master = ((uint32_t)frame->data[5] << 24) | ((uint32_t)frame->data[4] << 16) |
+             ((uint16_t)frame->data[3] << 8) | frame->data[2];
+    timeSyncSample(local, master);
+#else
+    (void)frame;
+#endif
+    
+} // end void timeSyncHandler(const dataFrame *frame) function
+
+
+#if TIME_SYNC_MASTER
+/*******************************************************************************
+ * FUNCTION: static void timeSyncSend(void)
+ * Description: Master: loads the SYNC without requesting it, arms the capture and requests it,
+ * so the first start of frame after the request is the SYNC's (highest identifier priority on
+ * the bus and highest TXP in the node).
+ *******************************************************************************/
+static void timeSyncSend(void)
+{
+    uint8_t raw[5 + TIME_SYNC_DLC] = { TIME_SYNC_IDH, 0x00, 0x00, 0x00, TIME_SYNC_DLC, TIME_SYNC_TYPE_SYNC };
+    
+    raw[6] = ++timeSyncSeq;
+    mcp2515WriteBurst(TXB_BASE(TIME_SYNC_TXB) + BUF_SIDH, raw, sizeof(raw));
+    timeSyncTxArmed = 1;
+    mcp2515RequestToSend(TIME_SYNC_TXB);
+    timeSyncTxPending = 1;
+    
+} // end static void timeSyncSend(void) function
+#endif
+
+
+/*******************************************************************************
+ * FUNCTION: void timeSyncService(void)
+ * Description: Main loop. Master: a SYNC every TIME_SYNC_PERIOD_MS and, once it is out, its
+ * FUP. Slave: gives the network time up after TIME_SYNC_HOLDOVER_MS without a sample. Call it
+ * at least every 524 ms (timerMillis()).
+ *******************************************************************************/
+void timeSyncService(void)
+{
+#if TIME_SYNC_MASTER
+    uint8_t ctrl;
+    
+    if (timeSyncTxPending)
+    {
+        ctrl = mcp2515ReadRegister(TXB_BASE(TIME_SYNC_TXB));
+        if (ctrl & TXREQ)
+            return;
+    
+        timeSyncTxPending = 0;
+        if (!(ctrl & TIME_SYNC_TX_FAILED) && !timeSyncTxArmed)
+        {
+            uint8_t fup[TIME_SYNC_FUP_DLC];
+            uint32_t sof = timeSyncTxSof;
+    
+            fup[0] = TIME_SYNC_TYPE_FUP;
+            fup[1] = timeSyncSeq;
+            fup[2] = (uint8_t)sof;
+            fup[3] = (uint8_t)(sof >> 8);
+            fup[4] = (uint8_t)(sof >> 16);
+            fup[5] = (uint8_t)(sof >> 24);
+            mcp2515TxLoad(TIME_SYNC_TXB, TIME_SYNC_IDH, TIME_SYNC_FUP_DLC, fup);
+        }
+        timeSyncTxArmed = 0;
+        return;
+    }
+    
+    if ((uint16_t)(timerMillis() - timeSyncLastMs) < TIME_SYNC_PERIOD_MS)
+        return;
+    timeSyncLastMs += TIME_SYNC_PERIOD_MS;
+    
+    if (!(mcp2515ReadRegister(TXB_BASE(TIME_SYNC_TXB)) & TXREQ))
+        timeSyncSend();
+#else
+    if ((timeSyncState != TIME_SYNC_FREE) && ((timeSyncLocal() - timeSyncRefLocal) > (uint32_t)TIME_SYNC_HOLDOVER_MS * 1000))
+        timeSyncState = TIME_SYNC_FREE;
+#endif
+    
+} // end void timeSyncService(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint32_t timeSyncNet(uint32_t local)
+ * Description: Network time of a local time (timeSyncLocal()), in us. The rate correction is
+ * split in two products that fit in 32 bits: elapsed times up to the holdover (2^23 us).
+ *******************************************************************************/
+uint32_t timeSyncNet(uint32_t local)
+{
+#if TIME_SYNC_MASTER
+    return local;
+#else
+    int32_t elapsed = (int32_t)(local - timeSyncRefLocal);
+    uint32_t span = (elapsed < 0) ? (uint32_t)-elapsed : (uint32_t)elapsed;
+    uint32_t rate = (timeSyncRate < 0) ? (uint32_t)-timeSyncRate : (uint32_t)timeSyncRate;
+    uint32_t correction;
+    
+    if (span > 0x007FFFFF)
+        span = 0x007FFFFF;
+    correction = (((span >> 12) * rate) >> 12) + (((span & 0x0FFF) * rate) >> 24);
+    if ((elapsed < 0) != (timeSyncRate < 0))
+        return timeSyncRefNet + (uint32_t)elapsed - correction;
+    
+    return timeSyncRefNet + (uint32_t)elapsed + correction;
+#endif
+    
+} // end uint32_t timeSyncNet(uint32_t local) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t timeSyncLocked(void)
+ * Description: Returns 1 while timeSyncNow() is the network time: always on the master, on a
+ * slave from the second sample on.
+ *******************************************************************************/
+uint8_t timeSyncLocked(void)
+{
+#if TIME_SYNC_MASTER
+    return 1;
+#else
+    return (timeSyncState == TIME_SYNC_LOCKED);
+#endif
+    
+} // end uint8_t timeSyncLocked(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint32_t timeSyncNow(void)
+ * Description: Network time, in us.
+ *******************************************************************************/
+uint32_t timeSyncNow(void)
+{
+    return timeSyncNet(timeSyncLocal());
+    
+} // end uint32_t timeSyncNow(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: uint8_t timeSyncDue(uint32_t *next, uint32_t period)
+ * Description: Synchronized sampling: returns 1 once the network time reaches (*next) and
+ * moves it (period) us on. With (*next) = 0 the first instant is the next multiple of (period),
+ * the same on every node; instants already missed are skipped. Returns 0 without network time.
+ *******************************************************************************/
+uint8_t timeSyncDue(uint32_t *next, uint32_t period)
+{
+    uint32_t now;
+    
+    if (!timeSyncLocked())
+        return 0;
+    
+    now = timeSyncNow();
+    if (*next == 0)
+    {
+        *next = (now / period + 1) * period;
+        return 0;
+    }
+    if ((int32_t)(now - *next) < 0)
+        return 0;
+    
+    *next += period;
+    if ((int32_t)(now - *next) >= 0)
+        *next = (now / period + 1) * period;
+    
+    return 1;
+    
+} // end uint8_t timeSyncDue(uint32_t *next, uint32_t period) function
+
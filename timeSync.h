@@ -0,0 +1,104 @@
+/* File:  timeSync.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Network time. The MCP2515 puts the start of frame of every message on the bus out
+ * on its CLKOUT/SOF pin (CNF3.SOF and CANCTRL.CLKEN, see mcp2515Start()), and CCP1 captures the
+ * edge on Timer1: each frame gets a 1 us timestamp, whatever the interrupt latency. One node, the
+ * master, sends its clock over CAN in two steps, as the CANopen TIME and the AUTOSAR time
+ * synchronisation over CAN do; the other nodes follow it in phase and rate, so every node reads
+ * the same network time, to a few microseconds, and can sample at the same instants.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef TIME_SYNC_H
+#define	TIME_SYNC_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+
+// Defines and Macros
+// TIME_SYNC = 1 starts the capture in hardware_ini() and stamps the SYNC frames in the receive
+// path (can.c); timeSyncService() must then run in the main loop. The MCP2515 pin 3 (CLKOUT/SOF)
+// is wired to RC2/CCP1 (pin 17), and the INT2 interrupt has to be enabled (canInterruptEnable()).
+// Use SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h), as the bootloader: at FOSC/64 the receive buffers overflow
+// on a busy bus, and a SYNC lost or read too late is dropped.
+#ifndef TIME_SYNC
+    #define TIME_SYNC               0
+#endif
+#ifndef TIME_SYNC_MASTER
+    #define TIME_SYNC_MASTER        0       // 1: this node's clock is the network time
+#endif
+// 0x040, SYNC and FUP: above every application message, and clear of NODE_STATUS (canSignals.dbc)
+// and of the CANopen NMT and SYNC (0x000, 0x080). canDispatch.def binds the same identifier.
+#ifndef TIME_SYNC_IDH
+    #define TIME_SYNC_IDH           0x08
+#endif
+#ifndef TIME_SYNC_TXB
+    #define TIME_SYNC_TXB           0       // Master: transmit buffer, raised to the highest TXP
+#endif
+#ifndef TIME_SYNC_PERIOD_MS
+    #define TIME_SYNC_PERIOD_MS     1000
+#endif
+// Longest time from the end of a SYNC frame to its INT2 interrupt still accepted. Past it, and
+// whenever another start of frame could be the SYNC's, the sample is dropped.
+#ifndef TIME_SYNC_LATENCY_US
+    #define TIME_SYNC_LATENCY_US    500
+#endif
+// A sample further than this from the network time already followed is dropped; three in a row
+// and the slave starts over (new master, master reset).
+#ifndef TIME_SYNC_OUTLIER_US
+    #define TIME_SYNC_OUTLIER_US    100
+#endif
+// Without a sample for this long the slave stops claiming the network time.
+#ifndef TIME_SYNC_HOLDOVER_MS
+    #define TIME_SYNC_HOLDOVER_MS   8000
+#endif
+
+/* Protocol, identifier TIME_SYNC_IDH, multi-byte fields little endian.
+ * SYNC: [0] TIME_SYNC_TYPE_SYNC, [1] sequence, [2..7] 0. Eight bytes, so the next frame starts at
+ *       least 111 bits after the SYNC's start of frame.
+ * FUP:  [0] TIME_SYNC_TYPE_FUP, [1] sequence of the SYNC, [2] master network time, in us, at the
+ *       start of frame of that SYNC (32 bits). Sent once the SYNC is out, only when its start of
+ *       frame was captured unambiguously.
+ * A slave takes the local time of the SYNC's start of frame and the master's from the FUP: the
+ * offset gives the phase, two samples the rate (the internal oscillator is only good to 1-2 %). */
+#define TIME_SYNC_TYPE_SYNC     0x10
+#define TIME_SYNC_TYPE_FUP      0x18
+#define TIME_SYNC_DLC           8
+#define TIME_SYNC_FUP_DLC       6
+#define TIME_SYNC_CAPTURES      4           // Start of frame captures kept (power of 2)
+
+typedef struct
+{
+    uint16_t samples;                   // SYNC/FUP pairs taken
+    uint16_t ambiguous;                 // SYNC dropped: no start of frame, or more than one, fits
+    uint16_t outliers;                  // Pairs away from the followed time by TIME_SYNC_OUTLIER_US
+    uint16_t unpaired;                  // FUP without the stamp of its SYNC
+}timeSyncStats;
+
+extern timeSyncStats timeSyncCount;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void timeSyncIni(void);
+void timeSyncInterrupt(void);
+void timeSyncRxMark(void);
+void timeSyncStamp(const dataFrame *frame);
+void timeSyncHandler(const dataFrame *frame);
+void timeSyncService(void);
+uint32_t timeSyncLocal(void);
+uint32_t timeSyncNet(uint32_t local);
+uint8_t timeSyncLocked(void);
+uint32_t timeSyncNow(void);
+uint8_t timeSyncDue(uint32_t *next, uint32_t period);
+
+#endif	/* TIME_SYNC_H */
+
@@ -0,0 +1,100 @@
+/* File:  timer.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Free running microsecond timebase (Timer1) and millisecond count (Timer0).
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "config_bits.h"
+#include "timer.h"
+
+static uint16_t timerMillisLast;        // Timer0 at the last timerMillis()
+static uint8_t timerMillisRest;         // Timer0 ticks not yet counted as a millisecond
+static uint16_t timerMillisCount;
+
+/*******************************************************************************
+ * Function void timerIni(void);
+ * Starts Timer1 as a 16 bit free running counter of 1 us ticks.
+ * FOSC 8 MHz -> FOSC/4 = 2 MHz, prescaler 1:2 -> 1 MHz.
+ * Timer0 counts 8 us ticks for timerMillis(): prescaler 1:16 -> 125 KHz, 524 ms period.
+ *******************************************************************************/
+void timerIni(void)
+{
+    T1CON = 0x91;   // 0b1 0 01 0 0 0 1 RD16 = 1; T1CKPS = 1:2; internal clock; TMR1ON = 1. Pg. 131
+    TMR1H = 0;
+    TMR1L = 0;
+    PIR1bits.TMR1IF = 0;
+    
+    T0CON = 0x83;   // 0b1 0 0 0 0 011 TMR0ON = 1; 16 bit; internal clock; prescaler 1:16. Pg. 125
+    TMR0H = 0;
+    TMR0L = 0;
+    INTCONbits.TMR0IF = 0;
+    
+} // end function timerIni()
+
+
+/*******************************************************************************
+ * Function uint16_t timerMicros(void);
+ * Returns the Timer1 count in microseconds. It wraps every 65.536 ms, so intervals are
+ * measured as (timerMicros() - start) in 16 bit arithmetic.
+ *******************************************************************************/
+uint16_t timerMicros(void)
+{
+    uint8_t low = TMR1L;   // Reading TMR1L latches TMR1H (RD16 = 1)
+    
+    return (((uint16_t)TMR1H << 8) | low);
+    
+} // end function uint16_t timerMicros(void)
+
+
+/*******************************************************************************
+ * Function uint8_t timerMillisTick(uint16_t *last);
+ * Counts milliseconds in polling loops longer than the 65 ms Timer1 period: returns 1 and
+ * moves (*last) forward 1000 us each time a millisecond has passed since (*last), which
+ * starts as a timerMicros() value.
+ *******************************************************************************/
+uint8_t timerMillisTick(uint16_t *last)
+{
+    if ((uint16_t)(timerMicros() - *last) >= 1000)
+    {
+        *last += 1000;
+        return 1;
+    }
+    
+    return 0;
+    
+} // end function uint8_t timerMillisTick(uint16_t *last)
+
+
+/*******************************************************************************
+ * Function uint16_t timerMillis(void);
+ * Returns a count of milliseconds that wraps every 65.5 s, so intervals are measured as
+ * (timerMillis() - start) in 16 bit arithmetic. The Timer0 ticks are collected at each
+ * call: call it at least every 524 ms (loops with long delays included).
+ *******************************************************************************/
+uint16_t timerMillis(void)
+{
+    uint8_t low = TMR0L;   // Reading TMR0L latches TMR0H (16 bit mode)
+    uint16_t now = ((uint16_t)TMR0H << 8) | low;
+    uint16_t ticks = now - timerMillisLast;
+    
+    timerMillisLast = now;
+    timerMillisCount += ticks / 125;
+    timerMillisRest += (uint8_t)(ticks % 125);
+    if (timerMillisRest >= 125)
+    {
+        timerMillisRest -= 125;
+        timerMillisCount++;
+    }
+    
+    return timerMillisCount;
+    
+} // end function uint16_t timerMillis(void)
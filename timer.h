@@ -0,0 +1,32 @@
+/* File:  timer.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: Free running microsecond timebase (Timer1).
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef TIMER_H
+#define	TIMER_H
+
+/****************************************************************************************
+ * Includes
+ ****************************************************************************************/
+#include <xc.h>
+#include "config_bits.h"
+
+/****************************************************************************************
+ * Function prototypes
+ ****************************************************************************************/
+void timerIni(void);
+uint16_t timerMicros(void);
+uint8_t timerMillisTick(uint16_t *last);
+uint16_t timerMillis(void);
+
+#endif	/* TIMER_H */
+
@@ -0,0 +1,278 @@
+#!/usr/bin/env python3
+# File:  dbcgen.py                                     * Date: 10/19/2026
+# ******************************************************************************
+# Description: Build-time generator of CAN signal pack/unpack functions.
+#
+# Reads the BO_ (message) and SG_ (signal) lines of a DBC file and writes a C
+# header and source with one get/set function per signal. Every function is
+# straight-line shift/mask code for that signal's bit position, length and byte
+# order; nothing is interpreted at run time. Scale and offset are emitted as
+# macros so the application decides where floating point is worth it.
+#
+# Transmit policy attributes (BA_ lines) feed canTxPoll() (canTx.h):
+#   BA_ "GenMsgCycleTime" BO_ <id> <ms>;        -> <MSG>_CYCLE_MS, heartbeat period
+#   BA_ "GenMsgDelayTime" BO_ <id> <ms>;        -> <MSG>_DELAY_MS, minimum interval
+#   BA_ "GenSigDeadband" SG_ <id> <signal> <v>; -> change smaller than v (physical) ignored
+# and every message gets <MSG>_Changed(sent, data), its change detector.
+#
+# Usage: python3 tools/dbcgen.py canSignals.dbc canSignals
+#        (writes canSignals.h and canSignals.c; run by .build-pre in Makefile)
+#
+# Author: Antonio Aparecido Ariza Castilho;
+#
+# MIT License  (see at: LICENSE em github)
+# Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+# ******************************************************************************
+
+import os
+import re
+import sys
+
+BO_RE = re.compile(r'^BO_\s+(\d+)\s+(\w+)\s*:\s*(\d+)\s+(\w+)')
+SG_RE = re.compile(r'^\s*SG_\s+(\w+)\s*:\s*(\d+)\|(\d+)@([01])([+-])\s*'
+                   r'\(([^,]+),([^)]+)\)\s*\[([^|]*)\|([^\]]*)\]\s*"([^"]*)"')
+BA_BO_RE = re.compile(r'^BA_\s+"(GenMsgCycleTime|GenMsgDelayTime)"\s+BO_\s+(\d+)\s+(\d+)\s*;')
+BA_SG_RE = re.compile(r'^BA_\s+"GenSigDeadband"\s+SG_\s+(\d+)\s+(\w+)\s+([-+.\deE]+)\s*;')
+
+
+class Signal:
+    def __init__(self, name, start, length, intel, signed, scale, offset, unit):
+        self.name = name
+        self.start = start
+        self.length = length
+        self.intel = intel
+        self.signed = signed
+        self.scale = scale
+        self.offset = offset
+        self.unit = unit
+        self.deadband = 0
+
+    def bit_positions(self):
+        """Frame bit position (byte * 8 + bit) of every value bit, LSB first."""
+        if self.intel:
+            return [self.start + i for i in range(self.length)]
+        # Motorola: start is the MSB, counting down and wrapping to the next byte.
+        positions = []
+        pos = self.start
+        for _ in range(self.length):
+            positions.append(pos)
+            pos = pos + 15 if pos % 8 == 0 else pos - 1
+        return list(reversed(positions))
+
+    def chunks(self):
+        """(byte, first byte bit, first value bit, width) runs of contiguous bits."""
+        result = []
+        for value_bit, pos in enumerate(self.bit_positions()):
+            byte, bit = divmod(pos, 8)
+            last = result[-1] if result else None
+            if last and last[0] == byte and last[1] + last[3] == bit and last[2] + last[3] == value_bit:
+                result[-1] = (byte, last[1], last[2], last[3] + 1)
+            else:
+                result.append((byte, bit, value_bit, 1))
+        return result
+
+    def ctype(self):
+        for bits in (8, 16, 32):
+            if self.length <= bits:
+                return ('int%d_t' if self.signed else 'uint%d_t') % bits
+        raise ValueError('signal %s longer than 32 bits' % self.name)
+
+
+class Message:
+    def __init__(self, frame_id, name, dlc):
+        self.frame_id = frame_id
+        self.name = name
+        self.dlc = dlc
+        self.signals = []
+        self.cycle = 0
+        self.delay = 0
+
+
+def parse(path):
+    messages = []
+    attributes = []     # BA_ lines follow the messages in a DBC file
+    with open(path) as dbc:
+        for line in dbc:
+            bo = BO_RE.match(line)
+            if bo:
+                messages.append(Message(int(bo.group(1)) & 0x7FF, bo.group(2), int(bo.group(3))))
+                continue
+            sg = SG_RE.match(line)
+            if sg and messages:
+                messages[-1].signals.append(Signal(
+                    sg.group(1), int(sg.group(2)), int(sg.group(3)), sg.group(4) == '1',
+                    sg.group(5) == '-', float(sg.group(6)), float(sg.group(7)), sg.group(10)))
+                continue
+            attributes.append(line)
+    by_id = dict((message.frame_id, message) for message in messages)
+    for line in attributes:
+        ba = BA_BO_RE.match(line)
+        if ba and int(ba.group(2)) & 0x7FF in by_id:
+            setattr(by_id[int(ba.group(2)) & 0x7FF], 'cycle' if ba.group(1) == 'GenMsgCycleTime' else 'delay',
+                    int(ba.group(3)))
+            continue
+        ba = BA_SG_RE.match(line)
+        if ba and int(ba.group(1)) & 0x7FF in by_id:
+            for signal in by_id[int(ba.group(1)) & 0x7FF].signals:
+                if signal.name == ba.group(2):
+                    signal.deadband = int(round(float(ba.group(3)) / signal.scale))
+    for message in messages:
+        for signal in message.signals:
+            if max(signal.bit_positions()) >= message.dlc * 8 or min(signal.bit_positions()) < 0:
+                raise ValueError('%s.%s does not fit in %d bytes' % (message.name, signal.name, message.dlc))
+    return messages
+
+
+def number(value):
+    text = repr(value)
+    return text[:-2] if text.endswith('.0') else text
+
+
+def emit_header(messages, base):
+    guard = os.path.basename(base).upper() + '_H'
+    out = []
+    out.append('/* File:  %s.h  (generated by tools/dbcgen.py, do not edit)' % os.path.basename(base))
+    out.append(' * ******************************************************************************')
+    out.append(' * Description: CAN signal pack/unpack functions.')
+    out.append(' *******************************************************************************/')
+    out.append('')
+    out.append('#ifndef %s' % guard)
+    out.append('#define\t%s' % guard)
+    out.append('')
+    out.append('#include <xc.h>')
+    out.append('')
+    for message in messages:
+        prefix = message.name
+        out.append('// %s: identifier 0x%03X, %d bytes' % (message.name, message.frame_id, message.dlc))
+        out.append('#define %s_ID            0x%03X' % (prefix, message.frame_id))
+        out.append('#define %s_IDH           0x%02X    // SIDH byte used by canSend()/canRead()' % (prefix, message.frame_id >> 3))
+        out.append('#define %s_DLC           %d' % (prefix, message.dlc))
+        out.append('#define %s_CYCLE_MS      %d     // Heartbeat, 0 = on change only' % (prefix, message.cycle))
+        out.append('#define %s_DELAY_MS      %d     // Minimum interval between transmissions' % (prefix, message.delay))
+        out.append('uint8_t %s_Changed(const uint8_t *sent, const uint8_t *data);' % prefix)
+        for signal in message.signals:
+            name = '%s_%s' % (prefix, signal.name)
+            out.append('#define %s_SCALE         %s' % (name, number(signal.scale)))
+            out.append('#define %s_OFFSET        %s' % (name, number(signal.offset)))
+            out.append('#define %s_TO_PHYS(raw)  ((raw) * %s + %s)%s' % (name, number(signal.scale), number(signal.offset),
+                                                                    '   // ' + signal.unit if signal.unit else ''))
+            if signal.scale == int(signal.scale):
+                out.append('#define %s_FROM_PHYS(phys) ((%s)(((phys) - %s) / %s))' % (name, signal.ctype(), number(signal.offset), number(signal.scale)))
+            else:
+                # A fractional scale rounds to the nearest raw value; truncating would lose one step on 0.29 / 0.01.
+                out.append('#define %s_FROM_PHYS(phys) ((%s)(((phys) - %s) / %s + (((phys) < %s) ? -0.5 : 0.5)))'
+                           % (name, signal.ctype(), number(signal.offset), number(signal.scale), number(signal.offset)))
+            out.append('%s %sGet(const uint8_t *data);' % (signal.ctype(), name))
+            out.append('void %sSet(uint8_t *data, %s value);' % (name, signal.ctype()))
+        out.append('')
+    out.append('#endif\t/* %s */' % guard)
+    out.append('')
+    return '\n'.join(out)
+
+
+def emit_source(messages, base):
+    out = []
+    out.append('/* File:  %s.c  (generated by tools/dbcgen.py, do not edit)' % os.path.basename(base))
+    out.append(' * ******************************************************************************')
+    out.append(' * Description: CAN signal pack/unpack functions.')
+    out.append(' *******************************************************************************/')
+    out.append('')
+    out.append('#include <xc.h>')
+    out.append('#include "%s.h"' % os.path.basename(base))
+    for message in messages:
+        for signal in message.signals:
+            name = '%s_%s' % (message.name, signal.name)
+            raw = signal.ctype().lstrip('u').join(('u', ''))
+            bits = int(raw[4:-2])
+            chunks = signal.chunks()
+
+            out.append('')
+            out.append('// %s: %d|%d@%d%s' % (name, signal.start, signal.length,
+                                               1 if signal.intel else 0, '-' if signal.signed else '+'))
+            out.append('%s %sGet(const uint8_t *data)' % (signal.ctype(), name))
+            out.append('{')
+            terms = []
+            for byte, bit, value_bit, width in chunks:
+                term = 'data[%d]' % byte
+                if bit:
+                    term = '(%s >> %d)' % (term, bit)
+                if bit + width < 8:
+                    term = '(%s & 0x%02X)' % (term, (1 << width) - 1)
+                term = '((%s)%s' % (raw, term)
+                term += ' << %d)' % value_bit if value_bit else ')'
+                terms.append(term)
+            out.append('    %s value = %s;' % (raw, '\n        | '.join(terms)))
+            if signal.signed and signal.length < bits:
+                sign = 1 << (signal.length - 1)
+                out.append('    if (value & 0x%X)' % sign)
+                out.append('        value |= 0x%X;' % (((1 << bits) - 1) & ~((1 << signal.length) - 1)))
+            out.append('    return (%s)value;' % signal.ctype())
+            out.append('}')
+
+            out.append('')
+            out.append('void %sSet(uint8_t *data, %s value)' % (name, signal.ctype()))
+            out.append('{')
+            out.append('    %s raw = (%s)value;' % (raw, raw))
+            for byte, bit, value_bit, width in chunks:
+                part = '(uint8_t)raw'
+                if value_bit:
+                    part = '(uint8_t)(raw >> %d)' % value_bit
+                if bit:
+                    part = '(uint8_t)(%s << %d)' % (part, bit)
+                mask = ((1 << width) - 1) << bit
+                if mask == 0xFF:
+                    out.append('    data[%d] = %s;' % (byte, part))
+                else:
+                    out.append('    data[%d] = (data[%d] & 0x%02X) | (%s & 0x%02X);' % (byte, byte, 0xFF & ~mask, part, mask))
+            out.append('}')
+
+        emit_changed(message, out)
+    out.append('')
+    return '\n'.join(out)
+
+
+def emit_changed(message, out):
+    """Change detector: signals with a deadband compare values, the others compare their bits."""
+    masks = [0] * message.dlc
+    for signal in message.signals:
+        if not signal.deadband:
+            for pos in signal.bit_positions():
+                masks[pos // 8] |= 1 << (pos % 8)
+
+    out.append('')
+    out.append('// %s: change detector for canTxPoll()' % message.name)
+    out.append('uint8_t %s_Changed(const uint8_t *sent, const uint8_t *data)' % message.name)
+    out.append('{')
+    for signal in message.signals:
+        if signal.deadband:
+            name = '%s_%s' % (message.name, signal.name)
+            out.append('    int32_t %s = (int32_t)%sGet(data) - %sGet(sent);' % (signal.name, name, name))
+    for signal in message.signals:
+        if signal.deadband:
+            out.append('    if (%s > %d || %s < -%d)   // Deadband' % (signal.name, signal.deadband, signal.name, signal.deadband))
+            out.append('        return 1;')
+    for byte, mask in enumerate(masks):
+        if mask == 0xFF:
+            out.append('    if (sent[%d] != data[%d])' % (byte, byte))
+            out.append('        return 1;')
+        elif mask:
+            out.append('    if ((sent[%d] ^ data[%d]) & 0x%02X)' % (byte, byte, mask))
+            out.append('        return 1;')
+    out.append('    return 0;')
+    out.append('}')
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: dbcgen.py <file.dbc> <output base name>\n')
+        return 1
+    messages = parse(argv[1])
+    with open(argv[2] + '.h', 'w') as header:
+        header.write(emit_header(messages, argv[2]))
+    with open(argv[2] + '.c', 'w') as source:
+        source.write(emit_source(messages, argv[2]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,295 @@
+#!/usr/bin/env python3
+# File:  dispatchgen.py                                     * Date: 10/19/2026
+# ******************************************************************************
+# Description: Build-time generator of the CAN receive dispatch table.
+#
+# Reads the identifier -> handler bindings of the application and writes a C
+# header and source with canDispatch(), which finds the handler of a received
+# frame through a perfect hash: two 8 bit hashes of the identifier (8x8 products,
+# one MULWF each on the PIC18), the first selecting a displacement, the second
+# plus that displacement selecting the slot. Every frame costs the same, with 2
+# or 200 identifiers; the multipliers and displacements are searched here.
+#
+# Bindings file, one per line ('#' starts a comment):
+#   <11 bit identifier> <handler>      e.g. 0x100 nodeCommandHandler
+#   default <handler>                  identifiers without a binding (optional)
+#   include <header>                   defines the flags of the conditions
+#   if <C condition>                   the lines up to "endif" count when the
+#   endif                              condition holds, e.g. "if TIME_SYNC"
+# Handlers: void handler(const dataFrame *frame). With conditions, the source has
+# one table per combination of them, under #if: a build links the handlers of its
+# own bindings only.
+#
+# Usage: python3 tools/dispatchgen.py canDispatch.def canDispatch
+#        (writes canDispatch.h and canDispatch.c; run by .build-pre in Makefile)
+#
+# Author: Antonio Aparecido Ariza Castilho;
+#
+# MIT License  (see at: LICENSE em github)
+# Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+# ******************************************************************************
+
+import os
+import random
+import sys
+
+MAX_SLOTS = 256
+MAX_CONDITIONS = 4
+TRIES = 2000
+
+
+def parse(path):
+    """(bindings, defaults, conditions, includes); bindings and defaults carry the index of
+    their condition, None when they always count."""
+    bindings = []
+    defaults = []
+    conditions = []
+    includes = []
+    condition = None
+    with open(path) as source:
+        for number, line in enumerate(source, 1):
+            text = line.split('#')[0].strip()
+            fields = text.split()
+            if not fields:
+                continue
+            if fields[0] == 'if' and len(fields) > 1:
+                if condition is not None:
+                    raise ValueError('%s:%d: "if" inside "if"' % (path, number))
+                if text[2:].strip() not in conditions:
+                    conditions.append(text[2:].strip())
+                condition = conditions.index(text[2:].strip())
+                continue
+            if fields == ['endif']:
+                if condition is None:
+                    raise ValueError('%s:%d: "endif" without "if"' % (path, number))
+                condition = None
+                continue
+            if len(fields) != 2:
+                raise ValueError('%s:%d: expected "<identifier> <handler>"' % (path, number))
+            if fields[0] == 'include':
+                includes.append(fields[1])
+                continue
+            if fields[0] == 'default':
+                defaults.append((fields[1], condition))
+                continue
+            frame_id = int(fields[0], 0)
+            if frame_id > 0x7FF:
+                raise ValueError('%s:%d: 0x%X is not an 11 bit identifier' % (path, number, frame_id))
+            bindings.append((frame_id, fields[1], condition))
+    if condition is not None:
+        raise ValueError('%s: "if" without "endif"' % path)
+    if not bindings and not defaults:
+        raise ValueError('%s: no bindings' % path)
+    if len(conditions) > MAX_CONDITIONS:
+        raise ValueError('%s: more than %d conditions' % (path, MAX_CONDITIONS))
+    return bindings, defaults, conditions, includes
+
+
+def variants(path, bindings, defaults, conditions):
+    """[(#if expression or None, bindings, default)], one per combination of the conditions."""
+    out = []
+    for combination in range(1 << len(conditions)):
+        holds = [bool(combination >> c & 1) for c in range(len(conditions))]
+        active = [(i, h) for i, h, c in bindings if c is None or holds[c]]
+        handlers = [h for h, c in defaults if c is None or holds[c]]
+        ids = [i for i, h in active]
+        for frame_id in set(ids):
+            if ids.count(frame_id) > 1:
+                raise ValueError('%s: 0x%03X bound twice' % (path, frame_id))
+        if len(handlers) > 1:
+            raise ValueError('%s: more than one default' % path)
+        if len(active) > MAX_SLOTS:
+            raise ValueError('%s: more than %d bindings' % (path, MAX_SLOTS))
+        expression = ' && '.join(('(%s)' if h else '!(%s)') % c for c, h in zip(conditions, holds)) or None
+        out.append((expression, active, handlers[0] if handlers else None))
+    return out
+
+
+def hashes(frame_id, m):
+    lo, hi = frame_id & 0xFF, frame_id >> 8
+    x = ((lo * m[0]) & 0xFF) + ((hi * m[1]) & 0xFF) & 0xFF
+    y = ((lo * m[2]) & 0xFF) + ((hi * m[3]) & 0xFF) & 0xFF
+    return x, y
+
+
+def search(ids):
+    """(slot bits, bucket bits, multipliers, displacements, slot of each id)."""
+    rng = random.Random(0)      # Same input, same tables
+    slot_bits = max(0, (len(ids) - 1).bit_length())
+    while slot_bits <= 8:
+        size = 1 << slot_bits
+        bucket_bits = max(0, slot_bits - 1)
+        for _ in range(TRIES):
+            m = [rng.randrange(1, 256, 2) for _ in range(4)]
+            keys = [hashes(i, m) for i in ids]
+            if len(set(keys)) != len(keys):
+                continue
+            buckets = {}
+            for index, (x, y) in enumerate(keys):
+                buckets.setdefault(x >> (8 - bucket_bits), []).append(index)
+            displace = [0] * (1 << bucket_bits)
+            slots = [None] * len(ids)
+            used = set()
+            # Largest buckets first, each takes the first displacement that fits all its members.
+            for bucket in sorted(buckets, key=lambda b: -len(buckets[b])):
+                for d in range(size):
+                    taken = [(keys[i][1] + d) & (size - 1) for i in buckets[bucket]]
+                    if len(set(taken)) == len(taken) and not used.intersection(taken):
+                        displace[bucket] = d
+                        used.update(taken)
+                        for i, slot in zip(buckets[bucket], taken):
+                            slots[i] = slot
+                        break
+                else:
+                    break
+            else:
+                return slot_bits, bucket_bits, m, displace, slots
+        slot_bits += 1
+    raise ValueError('no perfect hash found for %d identifiers' % len(ids))
+
+
+def emit_header(variants, tables, handlers, includes, base):
+    guard = os.path.basename(base).upper() + '_H'
+    out = []
+    out.append('/* File:  %s.h  (generated by tools/dispatchgen.py, do not edit)' % os.path.basename(base))
+    out.append(' * ******************************************************************************')
+    out.append(' * Description: CAN receive dispatch table.')
+    out.append(' *******************************************************************************/')
+    out.append('')
+    out.append('#ifndef %s' % guard)
+    out.append('#define\t%s' % guard)
+    out.append('')
+    out.append('#include <xc.h>')
+    out.append('#include "can.h"')
+    for header in includes:
+        out.append('#include "%s"' % header)
+    out.append('')
+    for index, ((expression, bindings, default), table) in enumerate(zip(variants, tables)):
+        if expression:
+            out.append('#%s %s' % ('if' if not index else 'elif', expression))
+        out.append('#define CAN_DISPATCH_IDS        %d' % len(bindings))
+        out.append('#define CAN_DISPATCH_SLOTS      %d' % ((1 << table[0]) if table else 0))
+    if variants[0][0]:
+        out.append('#endif')
+    out.append('')
+    out.append('typedef void (*canHandler)(const dataFrame *frame);')
+    out.append('')
+    out.append('// Handlers, defined by the application')
+    for handler in handlers:
+        out.append('void %s(const dataFrame *frame);' % handler)
+    out.append('')
+    out.append('uint8_t canDispatch(const dataFrame *frame);')
+    out.append('')
+    out.append('#endif\t/* %s */' % guard)
+    out.append('')
+    return '\n'.join(out)
+
+
+def emit_table(bindings, default, table):
+    out = []
+    if not table:
+        out.append('/* No identifier bound: every frame goes to the default handler. */')
+        out.append('uint8_t canDispatch(const dataFrame *frame)')
+        out.append('{')
+        out.append('    %s(frame);' % default if default else '    (void)frame;')
+        out.append('    return 0;')
+        out.append('}')
+        return out
+
+    slot_bits, bucket_bits, m, displace, slots = table
+    size = 1 << slot_bits
+    entries = ['{ 0xFFFF, 0 }'] * size
+    for (frame_id, handler), slot in zip(bindings, slots):
+        entries[slot] = '{ 0x%03X, %s }' % (frame_id, handler)
+
+    out.append('static const uint8_t canDispatchDisplace[%d] =' % len(displace))
+    out.append('{')
+    for i in range(0, len(displace), 16):
+        out.append('    ' + ', '.join('%d' % d for d in displace[i:i + 16]) + ',')
+    out.append('};')
+    out.append('')
+    out.append('static const canDispatchEntry canDispatchTable[%d] =' % size)
+    out.append('{')
+    for entry in entries:
+        out.append('    %s,' % entry)
+    out.append('};')
+    out.append('')
+    out.append('/* Finds the handler of (frame) and calls it. Returns 1 when the identifier has a binding.')
+    if bucket_bits:
+        out.append(' * x = lo * %d + hi * %d, y = lo * %d + hi * %d (8 bit), slot = y + displace[x >> %d]. */'
+                   % (m[0], m[1], m[2], m[3], 8 - bucket_bits))
+    else:
+        out.append(' * y = lo * %d + hi * %d (8 bit), slot = y + displace[0]. */' % (m[2], m[3]))
+    out.append('uint8_t canDispatch(const dataFrame *frame)')
+    out.append('{')
+    out.append('    uint8_t lo = (uint8_t)(frame->idh << 3) | (frame->idl >> 5);')
+    out.append('    uint8_t hi = frame->idh >> 5;')
+    if bucket_bits:
+        out.append('    uint8_t x = (uint8_t)(lo * %d) + (uint8_t)(hi * %d);' % (m[0], m[1]))
+        slot = '(uint8_t)(y + canDispatchDisplace[x >> %d])' % (8 - bucket_bits)
+    else:
+        slot = '(uint8_t)(y + canDispatchDisplace[0])'
+    out.append('    uint8_t y = (uint8_t)(lo * %d) + (uint8_t)(hi * %d);' % (m[2], m[3]))
+    out.append('    const canDispatchEntry *entry = &canDispatchTable[%s & 0x%02X];' % (slot, size - 1))
+    out.append('')
+    out.append('    if (entry->id == (((uint16_t)hi << 8) | lo))')
+    out.append('    {')
+    out.append('        entry->handler(frame);')
+    out.append('        return 1;')
+    out.append('    }')
+    if default:
+        out.append('    %s(frame);' % default)
+    out.append('    return 0;')
+    out.append('}')
+    return out
+
+
+def emit_source(variants, tables, base):
+    out = []
+    out.append('/* File:  %s.c  (generated by tools/dispatchgen.py, do not edit)' % os.path.basename(base))
+    out.append(' * ******************************************************************************')
+    if len(variants) == 1:
+        out.append(' * Description: CAN receive dispatch table, %d identifiers in %d slots.'
+                   % (len(variants[0][1]), (1 << tables[0][0]) if tables[0] else 0))
+    else:
+        out.append(' * Description: CAN receive dispatch tables, one per combination of the conditions.')
+    out.append(' *******************************************************************************/')
+    out.append('')
+    out.append('#include <xc.h>')
+    out.append('#include "%s.h"' % os.path.basename(base))
+    out.append('')
+    out.append('typedef struct')
+    out.append('{')
+    out.append('    uint16_t id;                        // 0xFFFF: free slot')
+    out.append('    canHandler handler;')
+    out.append('}canDispatchEntry;')
+    out.append('')
+    for index, ((expression, bindings, default), table) in enumerate(zip(variants, tables)):
+        if expression:
+            out.append('#%s %s' % ('if' if not index else 'elif', expression))
+            out.append('')
+        out.extend(emit_table(bindings, default, table))
+        out.append('')
+    if variants[0][0]:
+        out.append('#endif')
+        out.append('')
+    return '\n'.join(out)
+
+
+def main(argv):
+    if len(argv) != 3:
+        sys.stderr.write('usage: dispatchgen.py <bindings file> <output base name>\n')
+        return 1
+    bindings, defaults, conditions, includes = parse(argv[1])
+    table_of = variants(argv[1], bindings, defaults, conditions)
+    tables = [search([b[0] for b in v[1]]) if v[1] else None for v in table_of]
+    handlers = sorted(set([b[1] for b in bindings] + [d[0] for d in defaults]))
+    with open(argv[2] + '.h', 'w') as header:
+        header.write(emit_header(table_of, tables, handlers, includes, argv[2]))
+    with open(argv[2] + '.c', 'w') as source:
+        source.write(emit_source(table_of, tables, argv[2]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
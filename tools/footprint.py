@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+# File:  footprint.py                                       * Date: 10/19/2026
+# ******************************************************************************
+# Description: RAM and flash footprint of each module, from the XC8 map file of a
+# build, checked against a budget.
+#
+# XC8 compiles the whole program at once, so the map has no per-file psects: each
+# symbol of the symbol table is sized by the distance to the next one in its psect,
+# and given to the module that defines it (the "Module Function" table of the map
+# for functions, the top level definitions of the *.c files for the rest; XC8 calls
+# a C object x "_x", a local "function@x"). Shown apart: "(stack)", the compiled
+# stack (autos and parameters, overlaid); "(idata)", the initial values of the data
+# psects; "(runtime)", the startup code. Program memory above 0x200000
+# (configuration words, ID, EEPROM) is not flash.
+#
+# Budget file, one per line ('#' starts a comment; '-' is no limit):
+#   <module> <RAM bytes> <flash bytes>    e.g. can 256 12288
+#   total <RAM bytes> <flash bytes>       the whole image
+#
+# Usage: python3 tools/footprint.py [-v] <map file> [budget file] [sources folder]
+#        (-v: the symbols of each module; run by 'make footprint', see Makefile)
+#        Exit code 1 when a budget is exceeded.
+#
+# Author: Antonio Aparecido Ariza Castilho;
+#
+# MIT License  (see at: LICENSE em github)
+# Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+# ******************************************************************************
+
+import glob
+import os
+import re
+import sys
+
+FLASH_END = 0x200000
+STACK = '(stack)'
+INIT = '(idata)'
+RUNTIME = '(runtime)'
+OTHER = '(other)'
+
+PSECT = re.compile(r'^\s*(?:\S+\s+)??(\w+)\s+([0-9A-Fa-f]+)\s+([0-9A-Fa-f]+)\s+([0-9A-Fa-f]+)'
+                   r'\s+([0-9A-Fa-f]+)\s+(\d+)(?:\s+\d+)?\s*$')
+SYMBOL = re.compile(r'(\S+)\s+(\w+)\s+([0-9A-Fa-f]+)(?=\s|$)')
+C_SYMBOL = re.compile(r'^(\?|_|\w+@)')   # C objects, locals, parameters; not the assembler labels
+FUNCTION = re.compile(r'^\s+(\S+)\s+[A-Z]\w*\s+[0-9A-Fa-f]+\s+[0-9A-Fa-f]+\s+\d+\s*$')
+
+
+def read_map(path):
+    psects = []
+    symbols = []
+    functions = {}
+    section = None
+    module = None
+    with open(path, encoding='latin-1') as source:
+        for line in source:
+            if re.search(r'\bName\s+Link\s+Load\s+Length\s+Selector\s+Space', line):
+                section = 'psects'
+                continue
+            if re.search(r'\bSymbol Table\b', line):
+                section = 'symbols'
+                continue
+            if re.search(r'\bModule\s+Function\s+Class\s+Link\s+Load\s+Size', line):
+                section = 'modules'
+                continue
+            if section == 'psects':
+                fields = PSECT.match(line)
+                if fields:
+                    psects.append((fields.group(1), int(fields.group(2), 16), int(fields.group(4), 16),
+                                   int(fields.group(6))))
+                elif re.search(r'\bTOTAL\b|\bCLASS\b|UNUSED', line):
+                    section = None
+            elif section == 'symbols':
+                for name, psect, address in SYMBOL.findall(line):
+                    symbols.append((name, psect, int(address, 16)))
+                if re.search(r'Function Details|Module\s+Function', line):
+                    section = None
+            elif section == 'modules':
+                fields = FUNCTION.match(line)
+                if fields and module:
+                    functions[c_name(fields.group(1))] = module
+                elif re.match(r'^(\S+\.c|shared)\s*$', line):
+                    module = module_name(line.strip())
+    if not psects:
+        raise ValueError('%s: no psect table, not an XC8 map file' % path)
+    return psects, symbols, functions
+
+
+def module_name(path):
+    if path == 'shared':
+        return RUNTIME
+    return os.path.splitext(os.path.basename(path))[0]
+
+
+def c_name(symbol):
+    name = symbol.lstrip('?').split('@')[0]
+    return name[1:] if name.startswith('_') else name
+
+
+def definitions(path):
+    # Top level objects and functions of a C file: a light parser, enough for this code.
+    with open(path, encoding='latin-1') as source:
+        text = source.read()
+    text = re.sub(r'/\*.*?\*/|//[^\n]*', ' ', text, flags=re.S)
+    text = re.sub(r'"(\\.|[^"\\])*"|\'(\\.|[^\'\\])*\'', '0', text)
+    text = re.sub(r'^\s*#(.*\\\n)*.*$', '', text, flags=re.M)
+    text = re.sub(r'\b__(at|interrupt)\s*\([^)]*\)', '', text)
+    names = set()
+    statement = ''
+    depth = 0
+    body = False
+    for char in text:
+        if depth:
+            if char == '{':
+                depth += 1
+            elif char == '}':
+                depth -= 1
+                if not depth and body:
+                    statement = ''
+            continue
+        if char == '{':
+            depth = 1
+            body = '=' not in statement and '(' in statement
+            if body:
+                function = re.search(r'(\w+)\s*\($', statement.split('(')[0] + '(')
+                if function and not statement.lstrip().startswith('typedef'):
+                    names.add(function.group(1))
+            continue
+        if char != ';':
+            statement += char
+            continue
+        words = statement.split()
+        statement_text = statement
+        statement = ''
+        if not words or words[0] in ('extern', 'typedef') or '(' in statement_text.split('=')[0]:
+            continue
+        for declarator in re.split(r',(?![^(\[]*[)\]])', statement_text):
+            declarator = re.sub(r'\[[^\]]*\]', '', declarator.split('=')[0])
+            name = re.findall(r'\w+', declarator)
+            if name:
+                names.add(name[-1])
+    return names
+
+
+def read_sources(folder):
+    modules = {}
+    for path in sorted(glob.glob(os.path.join(folder, '*.c'))):
+        for name in definitions(path):
+            modules.setdefault(name, module_name(path))
+    return modules
+
+
+def read_budget(path):
+    budget = {}
+    with open(path) as source:
+        for number, line in enumerate(source, 1):
+            fields = line.split('#')[0].split()
+            if not fields:
+                continue
+            if len(fields) != 3:
+                raise ValueError('%s:%d: expected "<module> <RAM bytes> <flash bytes>"' % (path, number))
+            budget[fields[0]] = tuple(None if f == '-' else int(f, 0) for f in fields[1:])
+    return budget
+
+
+def attribute(psects, symbols, modules):
+    # Returns {module: [RAM, flash]} and {module: [(bytes, symbol, 'RAM'|'flash')]}.
+    usage = {}
+    details = {}
+    for name, link, length, space in psects:
+        memory = 'RAM' if space else 'flash'
+        if not length or (space == 0 and link >= FLASH_END):
+            continue
+        end = link + length
+        inside = sorted((a, s) for s, p, a in symbols
+                        if p == name and link <= a < end and C_SYMBOL.match(s) and not re.match(r'^__[LHpS]', s))
+        if name.startswith('cstack'):
+            inside = [(link, STACK)]
+        elif name.startswith('idata'):
+            inside = [(link, INIT)]
+        elif not inside:
+            inside = [(link, RUNTIME)]              # Startup code, vectors
+        elif inside[0][0] > link:
+            inside.insert(0, (link, OTHER))
+        for index, (address, symbol) in enumerate(inside):
+            size = (inside[index + 1][0] if index + 1 < len(inside) else end) - address
+            if not size:
+                continue
+            if symbol in (STACK, INIT, RUNTIME, OTHER):
+                module = symbol
+            else:
+                module = modules.get(c_name(symbol), RUNTIME if symbol.startswith('__') else OTHER)
+            usage.setdefault(module, [0, 0])[space == 0] += size
+            details.setdefault(module, []).append((size, symbol, memory))
+    return usage, details
+
+
+def report(usage, details, budget, verbose):
+    failures = []
+    total = [sum(u[0] for u in usage.values()), sum(u[1] for u in usage.values())]
+    rows = sorted(usage.items(), key=lambda item: (-item[1][0] - item[1][1], item[0]))
+    print('%-20s %8s %8s   %s' % ('module', 'RAM', 'flash', 'budget (RAM/flash)'))
+    for module, used in rows + [('total', total)]:
+        limit = budget.get(module, (None, None))
+        marks = []
+        for index, memory in enumerate(('RAM', 'flash')):
+            if limit[index] is not None and used[index] > limit[index]:
+                failures.append('%s: %s %d bytes, budget %d' % (module, memory, used[index], limit[index]))
+                marks.append('OVER')
+        text = '/'.join('-' if l is None else str(l) for l in limit) if module in budget else ''
+        print(('%-20s %8d %8d   %s %s' % (module, used[0], used[1], text, ' '.join(marks))).rstrip())
+        if verbose and module in details:
+            for size, symbol, memory in sorted(details[module], reverse=True):
+                print('    %-36s %5s %6d' % (symbol, memory, size))
+    for module in sorted(set(budget) - set(usage) - {'total'}):
+        print('%-20s (no symbols in the map)' % module)
+    for failure in failures:
+        sys.stderr.write('footprint.py: over budget: %s\n' % failure)
+    return 1 if failures else 0
+
+
+def main(argv):
+    verbose = '-v' in argv[1:]
+    args = [a for a in argv[1:] if a != '-v']
+    if not 1 <= len(args) <= 3:
+        sys.stderr.write('usage: footprint.py [-v] <map file> [budget file] [sources folder]\n')
+        return 2
+    psects, symbols, functions = read_map(args[0])
+    modules = read_sources(args[2] if len(args) > 2 else '.')
+    modules.update(functions)
+    budget = read_budget(args[1]) if len(args) > 1 else {}
+    usage, details = attribute(psects, symbols, modules)
+    return report(usage, details, budget, verbose)
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,431 @@
+/* File:  usbCan.c                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: USB-CAN adapter mode (packet layout in usbCan.h). usbCanPoll() is the whole main
+ * loop: it moves OUT frames to the free transmit buffers as they empty, packs the receive queue
+ * into IN packets, up to USB_CAN_IN_PACKETS of them while the host is not reading (after that the
+ * receive queue fills and canRxOverflow counts the loss), and sends a part filled packet after
+ * USB_CAN_BATCH_US. Frames are stamped when taken from the receive queue.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+// Includes
+#include <xc.h>
+#include "usbCan.h"
+
+#define USB_CAN_RECORD_MAX      13      // IN frame record with 8 data bytes
+
+static const usbCanEndpoint *usbCanPort;
+
+// IN packets: usbCanInClosed packets from usbCanInSend wait for the endpoint, the next one is filled.
+static uint8_t usbCanIn[USB_CAN_IN_PACKETS][USB_CAN_PACKET_SIZE];
+static uint8_t usbCanInLength[USB_CAN_IN_PACKETS];     // 0: not started
+static uint8_t usbCanInSend;
+static uint8_t usbCanInClosed;
+static uint8_t usbCanSequence;
+static uint8_t usbCanFlags;
+static uint16_t usbCanBatchStart;
+
+// OUT packet being sent: usbCanOutCount frame records left from usbCanOutIndex.
+static uint8_t usbCanOut[USB_CAN_PACKET_SIZE];
+static uint8_t usbCanOutLength;
+static uint8_t usbCanOutIndex;
+static uint8_t usbCanOutCount;
+static uint8_t usbCanTxKey;                     // (TXP << 2) | buffer of the last frame loaded
+
+static uint16_t usbCanClockLow;
+static uint16_t usbCanClockHigh;
+static uint16_t usbCanStatusLast;
+static uint8_t usbCanStatusMs;
+static uint8_t usbCanStatusWanted;
+static uint8_t usbCanOverflowSeen;
+
+static uint16_t usbCanBufferOverflows;
+static uint32_t usbCanRxFrames;
+static uint32_t usbCanTxFrames;
+
+
+/*******************************************************************************
+ * FUNCTION: void usbCanIni(const usbCanEndpoint *endpoint)
+ * Description: Starts the adapter on the bulk endpoints (endpoint). The CAN driver is already
+ * running (hardware_ini()).
+ *******************************************************************************/
+void usbCanIni(const usbCanEndpoint *endpoint)
+{
+    usbCanPort = endpoint;
+    mcp2515BitChange(RXB0CTRL, BUKT, BUKT);   // Both receive buffers take any frame
+    usbCanClockLow = timerMicros();
+    usbCanStatusLast = usbCanClockLow;
+    usbCanOverflowSeen = canRxOverflow;
+    usbCanStatusWanted = 1;
+    
+} // end void usbCanIni(const usbCanEndpoint *endpoint) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint32_t usbCanClock(void)
+ * Description: Timer1 extended to 32 bits; usbCanPoll() runs well within the 65 ms wrap.
+ *******************************************************************************/
+static uint32_t usbCanClock(void)
+{
+    uint16_t now = timerMicros();
+    
+    if (now < usbCanClockLow)
+        usbCanClockHigh++;
+    usbCanClockLow = now;
+    
+    return (((uint32_t)usbCanClockHigh << 16) | now);
+    
+} // end static uint32_t usbCanClock(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t *usbCanOpen(uint8_t type)
+ * Description: Returns the IN packet being filled, starting it as (type) when it is empty, or 0
+ * when every packet waits for the endpoint.
+ *******************************************************************************/
+static uint8_t *usbCanOpen(uint8_t type)
+{
+    uint8_t fill = (usbCanInSend + usbCanInClosed) % USB_CAN_IN_PACKETS;
+    uint8_t *packet = usbCanIn[fill];
+    
+    if (usbCanInClosed == USB_CAN_IN_PACKETS)
+        return 0;
+    
+    if (usbCanInLength[fill] == 0)
+    {
+        packet[0] = type;
+        packet[1] = 0;
+        packet[2] = usbCanSequence++;
+        packet[3] = 0;
+        usbCanInLength[fill] = USB_CAN_HEADER_SIZE;
+    }
+    
+    return packet;
+    
+} // end static uint8_t *usbCanOpen(uint8_t type) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbCanClose(void)
+ * Description: Queues the packet being filled for the endpoint, with the pending flags.
+ *******************************************************************************/
+static void usbCanClose(void)
+{
+    uint8_t fill = (usbCanInSend + usbCanInClosed) % USB_CAN_IN_PACKETS;
+    
+    if ((usbCanInClosed == USB_CAN_IN_PACKETS) || (usbCanInLength[fill] <= USB_CAN_HEADER_SIZE))
+        return;
+    
+    usbCanIn[fill][3] = usbCanFlags;
+    usbCanFlags = 0;
+    usbCanInClosed++;
+    
+} // end static void usbCanClose(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static uint8_t *usbCanLength(void)
+ * Description: Returns the length of the IN packet being filled.
+ *******************************************************************************/
+static uint8_t *usbCanLength(void)
+{
+    return &usbCanInLength[(usbCanInSend + usbCanInClosed) % USB_CAN_IN_PACKETS];
+    
+} // end static uint8_t *usbCanLength(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbCanStatus(void)
+ * Description: Sends a status packet after the frames already packed. Overflows of the receive
+ * buffers are counted here from EFLG, at most one per status period.
+ *******************************************************************************/
+static void usbCanStatus(void)
+{
+    uint8_t *packet;
+    uint8_t *length;
+    uint32_t now;
+    uint8_t eflg;
+    
+    usbCanClose();
+    packet = usbCanOpen(USB_CAN_IN_STATUS);
+    if (packet == 0)
+        return;
+    length = usbCanLength();
+    
+    now = usbCanClock();
+    eflg = mcp2515ReadRegister(EFLG);
+    if (eflg & (RX1OVR | RX0OVR))
+    {
+        usbCanBufferOverflows++;
+        usbCanFlags |= USB_CAN_FLAG_LOST;
+        mcp2515BitChange(EFLG, (RX1OVR | RX0OVR), 0x00);
+    }
+    
+    packet[4] = (uint8_t)now;
+    packet[5] = (uint8_t)(now >> 8);
+    packet[6] = (uint8_t)(now >> 16);
+    packet[7] = (uint8_t)(now >> 24);
+    packet[8] = mcp2515ReadRegister(CANSTAT);
+    packet[9] = eflg;
+    packet[10] = mcp2515ReadRegister(TEC);
+    packet[11] = mcp2515ReadRegister(REC);
+    packet[12] = canRxOverflow;
+    packet[13] = 0;
+    packet[14] = (uint8_t)usbCanBufferOverflows;
+    packet[15] = (uint8_t)(usbCanBufferOverflows >> 8);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        packet[16 + i] = (uint8_t)(usbCanRxFrames >> (i << 3));
+        packet[20 + i] = (uint8_t)(usbCanTxFrames >> (i << 3));
+    }
+#if BUS_LOAD
+    {
+        busLoadReport load;
+    
+        busLoadGet(&load);
+        packet[24] = (uint8_t)load.permille;
+        packet[25] = (uint8_t)(load.permille >> 8);
+        packet[26] = (uint8_t)load.permilleMin;
+        packet[27] = (uint8_t)(load.permilleMin >> 8);
+    }
+#else
+    for (uint8_t i = 24; i < USB_CAN_STATUS_SIZE; i++)
+    {
+        packet[i] = 0xFF;
+    }
+#endif
+    *length = USB_CAN_STATUS_SIZE;
+    
+    usbCanClose();
+    usbCanStatusWanted = 0;
+    
+} // end static void usbCanStatus(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbCanCommand(void)
+ * Description: Reads an OUT packet: a batch of frames is kept for usbCanTransmit(), commands are
+ * executed at once.
+ *******************************************************************************/
+static void usbCanCommand(void)
+{
+    usbCanOutLength = usbCanPort->read(usbCanOut);
+    if (usbCanOutLength < 2)
+        return;
+    
+    switch (usbCanOut[0])
+    {
+        case USB_CAN_OUT_FRAMES:
+            usbCanOutIndex = 2;
+            usbCanOutCount = usbCanOut[1];
+            break;
+    
+        case USB_CAN_OUT_BITRATE:
+            if (usbCanOut[1] < CAN_BITRATES)
+                mcp2515SetBitrate(usbCanOut[1]);
+            else
+                usbCanFlags |= USB_CAN_FLAG_ERROR;
+            break;
+    
+        case USB_CAN_OUT_MODE:
+            if (((usbCanOut[1] != OPMODE_NORMAL) && (usbCanOut[1] != OPMODE_LISTEN)
+                 && (usbCanOut[1] != OPMODE_LOOPBACK)) || (mcp2515SetMode(usbCanOut[1]) != MCP2515_OK))
+            {
+                usbCanFlags |= USB_CAN_FLAG_ERROR;
+            }
+            break;
+    
+        case USB_CAN_OUT_STATUS:
+            usbCanStatusWanted = 1;
+            break;
+    
+        default:
+            usbCanFlags |= USB_CAN_FLAG_ERROR;
+            break;
+    }
+    
+} // end static void usbCanCommand(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbCanTransmit(void)
+ * Description: Loads the frames of the OUT batch in the transmit buffers that are free, without
+ * waiting for the busy ones (CAN_RTR_TXB stays for remote answers while registered). The MCP2515
+ * sends the pending buffer of highest TXP first, then the highest buffer number, so each frame
+ * gets a (TXP, buffer) below the one loaded before it and the bus order is the batch order; the
+ * frames wait for the buffers to empty when no lower one is free.
+ *******************************************************************************/
+static void usbCanTransmit(void)
+{
+    while (usbCanOutCount)
+    {
+        uint8_t *record = &usbCanOut[usbCanOutIndex];
+        uint8_t status = mcp2515ReadStatus();
+        uint8_t txb = 0xFF;
+        uint8_t dlc;
+        uint8_t lenght;
+    
+        if (!(status & (STAT_TXnREQ(0) | STAT_TXnREQ(1) | STAT_TXnREQ(2))))
+            usbCanTxKey = (TXP_HIGHEST << 2) + 3;
+        for (uint8_t key = usbCanTxKey; key; )
+        {
+            uint8_t i = --key & 0x03;
+    
+            if ((i == 3) || ((i == CAN_RTR_TXB) && canRtrCount))
+                continue;
+            if (status & STAT_TXnREQ(i))
+                break;
+            txb = i;
+            usbCanTxKey = key;
+            break;
+        }
+        if (txb == 0xFF)
+            return;
+    
+        mcp2515BitChange(TXB_BASE(txb), TXP, usbCanTxKey >> 2);
+        dlc = record[2] & CAN_DLC_MASK;
+        if (dlc > DLC_8)
+            dlc = DLC_8;
+        lenght = dlc;
+        if (record[1] & (USB_CAN_ID_RTR >> 8))
+        {
+            dlc |= CAN_RTR;
+            lenght = 0;
+        }
+        if ((uint8_t)(usbCanOutIndex + 3 + lenght) > usbCanOutLength)
+        {
+            usbCanFlags |= USB_CAN_FLAG_ERROR;
+            usbCanOutCount = 0;
+            return;
+        }
+    
+        // 11 bit identifier: SIDH = id >> 3, SIDL = id << 5.
+        mcp2515TxLoadId(txb, (uint8_t)((((uint16_t)(record[1] & 0x07) << 8) | record[0]) >> 3),
+                        (uint8_t)(record[0] << 5), dlc, &record[3]);
+        usbCanTxFrames++;
+        usbCanOutIndex += 3 + lenght;
+        usbCanOutCount--;
+    }
+    
+} // end static void usbCanTransmit(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: static void usbCanReceive(void)
+ * Description: Packs the receive queue into IN packets while there is room.
+ *******************************************************************************/
+static void usbCanReceive(void)
+{
+    dataFrame frame;
+    uint8_t *packet;
+    uint8_t *length;
+    uint16_t id;
+    uint16_t now;
+    uint8_t lenght;
+    
+    while (usbCanInClosed < USB_CAN_IN_PACKETS)
+    {
+        length = usbCanLength();
+        if (*length > (USB_CAN_PACKET_SIZE - USB_CAN_RECORD_MAX))
+        {
+            usbCanClose();
+            continue;
+        }
+    
+        if (!canReceive(&frame))
+            break;
+    
+        packet = usbCanOpen(USB_CAN_IN_FRAMES);
+        now = (uint16_t)usbCanClock();
+        if (*length == USB_CAN_HEADER_SIZE)
+            usbCanBatchStart = now;
+    
+        id = ((uint16_t)frame.idh << 3) | (frame.idl >> 5);
+        if (frame.dlc & CAN_RTR)
+        {
+            id |= USB_CAN_ID_RTR;
+            lenght = 0;
+        }
+        else
+            lenght = frame.dlc & CAN_DLC_MASK;
+    
+        packet += *length;
+        packet[0] = (uint8_t)now;
+        packet[1] = (uint8_t)(now >> 8);
+        packet[2] = (uint8_t)id;
+        packet[3] = (uint8_t)(id >> 8);
+        packet[4] = frame.dlc & CAN_DLC_MASK;
+        for (uint8_t i = 0; i < lenght; i++)
+        {
+            packet[5 + i] = frame.data[i];
+        }
+        *length += 5 + lenght;
+        usbCanIn[(usbCanInSend + usbCanInClosed) % USB_CAN_IN_PACKETS][1]++;
+        usbCanRxFrames++;
+    }
+    
+} // end static void usbCanReceive(void) function
+
+
+/*******************************************************************************
+ * FUNCTION: void usbCanPoll(void)
+ * Description: One pass of the adapter; call it continuously.
+ *******************************************************************************/
+void usbCanPoll(void)
+{
+    uint8_t *length;
+    
+    // Transmit: finish the current OUT batch before reading the next packet.
+    if (usbCanOutCount == 0)
+        usbCanCommand();
+    usbCanTransmit();
+    
+    // Receive.
+    if (canRxOverflow != usbCanOverflowSeen)
+    {
+        usbCanOverflowSeen = canRxOverflow;
+        usbCanFlags |= USB_CAN_FLAG_LOST;
+    }
+    usbCanReceive();
+    
+    length = usbCanLength();
+    if ((usbCanInClosed < USB_CAN_IN_PACKETS) && (*length > USB_CAN_HEADER_SIZE)
+        && ((uint16_t)((uint16_t)usbCanClock() - usbCanBatchStart) >= USB_CAN_BATCH_US))
+    {
+        usbCanClose();
+    }
+    
+#if BUS_LOAD
+    busLoadPoll();
+#endif
+    
+    // Status, periodic or asked for.
+    while (timerMillisTick(&usbCanStatusLast))
+    {
+        if (++usbCanStatusMs >= USB_CAN_STATUS_MS)
+        {
+            usbCanStatusMs = 0;
+            usbCanStatusWanted = 1;
+        }
+    }
+    if (usbCanStatusWanted)
+        usbCanStatus();
+    
+    // Send.
+    while (usbCanInClosed && usbCanPort->ready())
+    {
+        usbCanPort->write(usbCanIn[usbCanInSend], usbCanInLength[usbCanInSend]);
+        usbCanInLength[usbCanInSend] = 0;
+        usbCanInSend = (usbCanInSend + 1) % USB_CAN_IN_PACKETS;
+        usbCanInClosed--;
+    }
+    
+} // end void usbCanPoll(void) function
+
@@ -0,0 +1,84 @@
+/* File:  usbCan.h                                     * Date: 10/19/2026
+ * ******************************************************************************
+ * Description: USB-CAN adapter mode: protocol layer between the CAN driver and a pair of 64 byte
+ * bulk endpoints. Received frames are batched with timestamps in IN packets, OUT packets carry
+ * batches of frames to send and commands, and a status packet reports the bus state and the
+ * overflow counts.
+ * 
+ * Environment: MPLAB v6.05, XC8 v2.40, PIC18F4550, MCP2515 e TJA1050.
+ *                     Placa de desenvolvimento FATEC (FATEC board, http://fatecsantoandre.edu.br/).
+ * 
+ * Author: Antonio Aparecido Ariza Castilho;
+ * 
+ * MIT License  (see at: LICENSE em github)
+ * Copyright (c) 2021 Antonio Castilho <https://github.com/AntonioCastilho>
+ *******************************************************************************/
+
+#ifndef USB_CAN_H
+#define	USB_CAN_H
+
+// Includes
+#include <xc.h>
+#include "can.h"
+#include "busLoad.h"
+
+// Defines and Macros
+// USB_CAN = 1 runs the adapter instead of the demo (main.c). The endpoint (usbCanUsbEndpoint) comes
+// from the USB device stack glue, which is not part of this project; a 500 Kbps bus at full load
+// also needs SPI_CLOCK = SPI_CLOCK_FOSC4 (spi.h).
+#ifndef USB_CAN
+    #define USB_CAN                 0
+#endif
+#ifndef USB_CAN_IN_PACKETS
+    #define USB_CAN_IN_PACKETS      4       // IN packets held while the host does not read
+#endif
+#ifndef USB_CAN_BATCH_US
+    #define USB_CAN_BATCH_US        1000    // A part filled IN packet waits at most this long
+#endif
+#ifndef USB_CAN_STATUS_MS
+    #define USB_CAN_STATUS_MS       50      // Status period, it also carries the high timestamp bits
+#endif
+
+#define USB_CAN_PACKET_SIZE     64      // Full speed bulk endpoint
+#define USB_CAN_HEADER_SIZE     4
+#define USB_CAN_STATUS_SIZE     28
+
+/* Packets. Multi-byte fields are little endian.
+ * Every packet: [0] type, [1] record count, [2] IN sequence number, [3] flags.
+ * USB_CAN_IN_FRAMES:  records { time (2, us, low half of the status time), id (2), dlc (1), data }
+ * USB_CAN_IN_STATUS:  time (4, us), CANSTAT, EFLG, TEC, REC, queue overflows (2, canRxOverflow),
+ *                     receive buffer overflows (2, RXnOVR seen), frames received (4), sent (4),
+ *                     bus load and its lower bound (2 + 2, per mille, busLoad.h; 0xFFFF without BUS_LOAD)
+ * USB_CAN_OUT_FRAMES: records { id (2), dlc (1), data }
+ * USB_CAN_OUT_BITRATE: [1] CAN_BITRATE_xxx;  USB_CAN_OUT_MODE: [1] OPMODE_NORMAL, _LISTEN or
+ * _LOOPBACK;  USB_CAN_OUT_STATUS: asks for a status packet.
+ * id: 11 bit standard identifier, USB_CAN_ID_RTR for a remote frame (dlc without data). */
+#define USB_CAN_IN_FRAMES       0x01
+#define USB_CAN_IN_STATUS       0x02
+#define USB_CAN_OUT_FRAMES      0x81
+#define USB_CAN_OUT_BITRATE     0x82
+#define USB_CAN_OUT_MODE        0x83
+#define USB_CAN_OUT_STATUS      0x84
+
+#define USB_CAN_ID_RTR          0x8000
+#define USB_CAN_FLAG_LOST       0x01    // Frames were lost since the previous packet
+#define USB_CAN_FLAG_ERROR      0x02    // Last OUT command failed
+
+// Bulk endpoints, set by the USB device stack glue.
+typedef struct
+{
+    uint8_t (*ready)(void);                                 // The IN endpoint takes a packet
+    void (*write)(const uint8_t *packet, uint8_t length);   // Sends an IN packet
+    uint8_t (*read)(uint8_t *packet);                       // OUT packet length, 0 when none
+}usbCanEndpoint;
+
+extern const usbCanEndpoint usbCanUsbEndpoint;
+
+/***********************************************************************************************************************************************
+ * FUNCTION PROTOTYPES
+ **********************************************************************************************************************************************/
+void usbCanIni(const usbCanEndpoint *endpoint);
+void usbCanPoll(void);
+
+#endif	/* USB_CAN_H */
+